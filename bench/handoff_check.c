@@ -0,0 +1,260 @@
+/* ----- ----- ----- ----- */
+// handoff_check.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/19
+// Update Date: 2026/10/19
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+/*
+ * 熱升級交接的自我檢查：待派佇列已滿、外呼通道還有排隊的外呼時交出核心狀態，
+ * 確認新行程接手後沒有任何外呼遺失、請求 ID、訂閱者與目的樓層票都還在，
+ * 且同一份事件日誌裡升級前的紀錄都還在。全部通過回傳 0，否則印出原因並回傳 1。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/core/building.h"
+#include "../src/core/checkpoint.h"
+#include "../src/core/core_log.h"
+#include "../src/core/elevator.h"
+#include "../src/core/eta.h"
+#include "../src/core/event_journal.h"
+#include "../src/core/request_queue.h"
+#include "../src/core/scheduler.h"
+#include "../src/core/server_core.h"
+#include "../src/core/server_events.h"
+
+#define CARS 4
+#define EXTRA_CALLS 200   // 超出待派佇列的外呼數
+#define TRACKED_CALLS 6   // 已派車、有訂閱者的外呼數
+#define DEST_RIDERS 5     // 同一層等車的目的樓層乘客
+#define JOURNAL_CALLS 4   // 熱升級前後各寫進日誌的外呼數
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); ++g_failures; } \
+} while (0)
+
+static uint32_t le32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 解開交接內容的 checkpoint 區段；回傳待派佇列長度，
+ * *tracked / *tickets 為排程器追蹤中的外呼數與目的樓層票數 */
+static int decode_handoff(const unsigned char* buf, int len, RequestQueue* pending, int* tracked, int* tickets)
+{
+    static Elevator cars[MAX_ELEVATORS];
+    static unsigned char* car_mem = NULL;
+    const size_t car_bytes = Elevator_storage_size(BUILDING_DEFAULT_FLOORS);
+    if (!car_mem) {
+        car_mem = (unsigned char*)malloc(car_bytes * MAX_ELEVATORS);
+        if (!car_mem) return -1;
+        for (int i = 0; i < MAX_ELEVATORS; ++i) Elevator_attach(&cars[i], car_mem + car_bytes * (size_t)i, BUILDING_DEFAULT_FLOORS);
+    }
+    int count = MAX_ELEVATORS;
+    uint32_t tick = 0;
+    if (len < 4) return -1;
+    int slen = (int)le32(buf);
+    SchedulerState* sched = Scheduler_create(eta_default_cache(), 0, BUILDING_DEFAULT_FLOORS);
+    if (!sched) return -1;
+    rq_init(pending);
+    int rc = checkpoint_decode(buf + 4, slen, cars, &count, pending, sched, &tick);
+    if (rc == 0 && tracked && tickets) {
+        // 區段：版本 | 外呼數 | 外呼（24 bytes + 每位訂閱者 8 bytes）| 票數 | 票
+        static unsigned char sec[SCHED_STATE_MAX_BYTES];
+        int n = Scheduler_encode_state(sched, sec, (int)sizeof(sec));
+        *tracked = (n >= 8) ? (int)le32(sec + 4) : -1;
+        const unsigned char* p = sec + 8;
+        for (int k = 0; k < *tracked; ++k) p += 24 + 8 * le32(p + 20);
+        *tickets = (n >= (int)(p - sec) + 4) ? (int)le32(p) : -1;
+    }
+    Scheduler_destroy(sched);
+    return (rc == 0) ? rq_count(pending) : -1;
+}
+
+/* 匯入 out 到新初始化的核心後再匯出，內容應完全相同 */
+static int reexport_matches(const unsigned char* out, int len, unsigned char* again)
+{
+    if (server_core_init(CARS) != 0 || server_core_import_state(out, len) != 0) return 0;
+    int len2 = server_core_export_state(again, SERVER_CORE_HANDOFF_MAX);
+    return len2 == len && memcmp(out, again, (size_t)len) == 0;
+}
+
+/* 待派佇列已滿：多出來的外呼留在通道裡，跟著狀態一起交接 */
+static void check_full_pending(unsigned char* out, unsigned char* again)
+{
+    static RequestQueue pending;
+    const int total = MAX_REQUESTS + EXTRA_CALLS;
+
+    /* 舊行程：外呼全部排進通道，交接前核心只能收下 MAX_REQUESTS 筆 */
+    if (server_core_init(CARS) != 0) { CHECK(0, "init"); return; }
+    for (int k = 0; k < total; ++k) {
+        int floor = 1 + k % (BUILDING_DEFAULT_FLOORS - 1);
+        int rc;
+        if (k % 3 == 0) rc = server_events_push_destination(floor, 0, k, (unsigned)k + 1);
+        else rc = server_events_push_outside_tracked(floor, DIR_DOWN, k, (unsigned)k + 1);
+        CHECK(rc == 0, "push call %d", k);
+    }
+
+    int len = server_core_export_state(out, SERVER_CORE_HANDOFF_MAX);
+    CHECK(len > 0, "export returned %d", len);
+    if (len <= 0) return;
+
+    int taken = decode_handoff(out, len, &pending, NULL, NULL);
+    int left = server_events_lane_count(EVT_LANE_HALL);
+    CHECK(taken == MAX_REQUESTS, "pending holds %d, expected %d", taken, MAX_REQUESTS);
+    CHECK(taken + left == total, "old side kept %d + %d of %d calls", taken, left, total);
+    for (int k = 0; k < taken; ++k) {
+        const PendingRequest* r = &pending.items[(pending.head + k) % MAX_REQUESTS];
+        CHECK(r->request_id == (unsigned)r->source_id + 1, "pending call %d lost its request id", r->source_id);
+    }
+
+    /* 新行程：外呼回到通道、順序不變 */
+    CHECK(reexport_matches(out, len, again), "re-export differs after taking over a full pending queue");
+    CHECK(server_events_lane_count(EVT_LANE_HALL) == left,
+          "new side queued %d calls, expected %d", server_events_lane_count(EVT_LANE_HALL), left);
+    for (int k = taken; k < total; ++k) {
+        ServerEvent* ev = NULL;
+        if (server_events_try_pop_lane(EVT_LANE_HALL, &ev) != 0 || !ev) {
+            CHECK(0, "call %d missing from the hall lane", k);
+            break;
+        }
+        CHECK(ev->v.outside_call.client_id == k, "lane order: got client %d, expected %d",
+              ev->v.outside_call.client_id, k);
+        CHECK(ev->v.outside_call.to_floor == (k % 3 == 0 ? 0 : -1), "call %d lost its destination", k);
+        CHECK(ev->v.outside_call.request_id == (unsigned)k + 1, "queued call %d lost its request id", k);
+        server_events_free(ev);
+    }
+    printf("full pending: %d calls, %d pending, %d queued\n", total, taken, left);
+}
+
+/* 已派車的外呼：訂閱者（請求 ID）在排程器裡，也要跟著交接 */
+static void check_tracked_calls(unsigned char* out, unsigned char* again)
+{
+    static RequestQueue pending;
+    if (server_core_init(CARS) != 0) { CHECK(0, "init"); return; }
+    for (int k = 0; k < TRACKED_CALLS; ++k) {
+        CHECK(server_events_push_outside_tracked(10 + 5 * k, DIR_DOWN, k, 1000u + (unsigned)k) == 0, "push call %d", k);
+    }
+    server_core_step();
+    server_core_step();
+
+    int len = server_core_export_state(out, SERVER_CORE_HANDOFF_MAX);
+    CHECK(len > 0, "export returned %d", len);
+    if (len <= 0) return;
+    int tracked = 0, tickets = 0;
+    int queued = decode_handoff(out, len, &pending, &tracked, &tickets);
+    CHECK(queued == 0, "%d calls still pending after two ticks", queued);
+    CHECK(tracked == TRACKED_CALLS, "%d tracked calls in the handoff, expected %d", tracked, TRACKED_CALLS);
+    CHECK(reexport_matches(out, len, again), "re-export differs after taking over assigned calls");
+    printf("tracked calls: %d assigned with subscribers\n", tracked);
+}
+
+/* 目的樓層外呼：派車後的票（誰搭哪台、去哪層）要跟著交接，上車後才轉成內呼 */
+static void check_destination_tickets(unsigned char* out, unsigned char* again)
+{
+    static RequestQueue pending;
+    if (server_core_init(CARS) != 0) { CHECK(0, "init"); return; }
+    for (int k = 0; k < DEST_RIDERS; ++k) {
+        CHECK(server_events_push_destination(60, 5 + 10 * (k % 3), k, 2000u + (unsigned)k) == 0, "push rider %d", k);
+    }
+    server_core_step();
+    server_core_step();
+
+    int len = server_core_export_state(out, SERVER_CORE_HANDOFF_MAX);
+    CHECK(len > 0, "export returned %d", len);
+    if (len <= 0) return;
+    int tracked = 0, tickets = 0;
+    decode_handoff(out, len, &pending, &tracked, &tickets);
+    CHECK(tickets == DEST_RIDERS, "%d destination tickets in the handoff, expected %d", tickets, DEST_RIDERS);
+    CHECK(reexport_matches(out, len, again), "re-export differs after taking over destination tickets");
+    printf("destination tickets: %d riders waiting\n", tickets);
+}
+
+/* 讀出日誌裡每筆外呼的 client id；回傳筆數，-1 = 日誌壞了 */
+static int journal_clients(const char* path, int* ids, int max)
+{
+    EventJournalReader* r = event_journal_reader_open(path, NULL);
+    if (!r) return -1;
+    JournalRecord rec;
+    int n = 0, rc;
+    while ((rc = event_journal_read(r, &rec)) == 1) {
+        if (rec.event.type == EVT_OUTSIDE_CALL && n < max) ids[n++] = rec.event.v.outside_call.client_id;
+    }
+    event_journal_reader_close(r);
+    return (rc < 0) ? -1 : n;
+}
+
+/* 同一個 --journal 路徑：舊行程交接前寫完的紀錄不能被新行程蓋掉，新行程接著往下寫 */
+static void check_journal_survives(unsigned char* out)
+{
+    static const char* path = "handoff_check.evj";
+    char kept[64];
+    int ids[JOURNAL_CALLS * 2];
+    remove(path);
+
+    /* 舊行程 */
+    if (server_core_init(CARS) != 0 || server_core_enable_journal(path) != 0) { CHECK(0, "old side journal"); return; }
+    for (int k = 0; k < JOURNAL_CALLS; ++k) {
+        CHECK(server_events_push_outside(8 + 3 * k, DIR_DOWN, k) == 0, "push call %d", k);
+    }
+    server_core_step();
+    server_core_step();
+    int len = server_core_export_state(out, SERVER_CORE_HANDOFF_MAX);
+    CHECK(len > 0, "export returned %d", len);
+    int before = journal_clients(path, ids, JOURNAL_CALLS * 2);
+    CHECK(before == JOURNAL_CALLS, "old side journaled %d calls before the handoff, expected %d", before, JOURNAL_CALLS);
+    server_core_mark_handed_off();
+    server_core_stop();
+    if (len <= 0) return;
+
+    /* 新行程：接手後用同一個路徑開日誌 */
+    if (server_core_init(CARS) != 0 || server_core_import_state(out, len) != 0) { CHECK(0, "new side import"); return; }
+    CHECK(server_core_enable_journal(path) == 0, "new side cannot open the journal");
+    for (int k = 0; k < JOURNAL_CALLS; ++k) {
+        CHECK(server_events_push_outside(40 + 3 * k, DIR_UP, JOURNAL_CALLS + k) == 0, "push call %d", JOURNAL_CALLS + k);
+    }
+    server_core_step();
+    server_core_stop();
+
+    int after = journal_clients(path, ids, JOURNAL_CALLS * 2);
+    CHECK(after == 2 * JOURNAL_CALLS, "journal holds %d calls after the upgrade, expected %d", after, 2 * JOURNAL_CALLS);
+    for (int k = 0; k < after; ++k) CHECK(ids[k] == k, "journal record %d is client %d", k, ids[k]);
+    snprintf(kept, sizeof(kept), "%s.1", path);
+    FILE* fp = fopen(kept, "rb");
+    CHECK(!fp, "the journal was moved aside instead of continued");
+    if (fp) {
+        fclose(fp);
+        remove(kept);
+    }
+    remove(path);
+    printf("journal: %d calls before the upgrade, %d in total\n", before, after);
+}
+
+int main(void)
+{
+    core_log_set_enabled(0);
+    unsigned char* out = (unsigned char*)malloc(SERVER_CORE_HANDOFF_MAX);
+    unsigned char* again = (unsigned char*)malloc(SERVER_CORE_HANDOFF_MAX);
+    if (!out || !again) { printf("FAIL: out of memory\n"); return 1; }
+
+    check_full_pending(out, again);
+    check_tracked_calls(out, again);
+    check_destination_tickets(out, again);
+    check_journal_survives(out);
+
+    free(out);
+    free(again);
+    if (g_failures) {
+        printf("handoff_check: %d failure(s)\n", g_failures);
+        return 1;
+    }
+    printf("handoff_check: ok\n");
+    return 0;
+}
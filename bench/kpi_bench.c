@@ -0,0 +1,274 @@
+/* ----- ----- ----- ----- */
+// kpi_bench.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+/*
+ * 派車品質基準測試：每個排程策略 × 每種交通模式，以虛擬時間無頭執行核心，
+ * 統計等待時間、旅程時間、每趟停靠次數與每模擬小時 CPU 時間，輸出 JSON。
+ *
+ * 乘客由 passenger.h 逐人模擬：開門時同方向的乘客依序上車並按內呼（受電梯載客量限制，
+ * 每人進出都要時間並延長開門），抵達目的樓層下車。
+ * --destination：乘客在大廳輸入目的樓層（CALL <from> <to>），只搭核心回覆 BOARD 指定的電梯，
+ * 目的樓層已由核心登記，上車不再按內呼。
+ * --optimize N：背景最佳化每個 tick 在核心執行緒搜尋 N 步（0 = 用背景執行緒，結果不保證可重現）。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/core/core_log.h"
+#include "../src/core/core_notify.h"
+#include "../src/core/passenger.h"
+#include "../src/core/scheduler.h"
+#include "../src/core/server_core.h"
+#include "../src/core/server_events.h"
+#include "../src/core/traffic_model.h"
+
+#define DEFAULT_FLOORS 20
+#define DEFAULT_CARS 4
+#define DEFAULT_RATE_PER_MIN 40.0
+#define DEFAULT_DURATION_S 3600.0
+#define DEFAULT_SEED 20251122ull
+#define DEFAULT_CAPACITY 13      // 每台額定載客人數（約 1000 kg）
+#define DEFAULT_BOARD_S 1.0      // 每人進電梯的時間（秒）
+#define DEFAULT_ALIGHT_S 1.0     // 每人出電梯的時間（秒）
+#define DRAIN_MAX_S 1800.0       // 到達結束後最多再跑 30 分鐘讓乘客送完
+
+typedef struct {
+    const char* policy;
+    const char* pattern;
+    int floors;
+    int cars;
+    int capacity;
+    double rate_per_min;
+    int passengers;
+    int served;
+    double avg_wait_s;
+    double p95_wait_s;
+    double avg_journey_s;
+    double p95_journey_s;
+    double avg_stops_per_trip;
+    unsigned long left_behind;    // 客滿沒搭上的人次
+    unsigned peak_in_building;    // 同時在大樓裡（等待 + 乘坐）的最多人數
+    unsigned long redispatched;   // 改派到別台電梯的外呼數
+    unsigned long planned;        // 依最佳化計畫改派的外呼數
+    unsigned long escalated;      // 等待超過 SLO 被強制改派的外呼數
+    double max_call_wait_s;       // 外呼最長等待（按下到電梯清掉外呼）
+    double sim_hours;
+    double cpu_s;
+    double cpu_s_per_sim_hour;
+} KpiResult;
+
+static PaxSimConfig g_pax = { DEFAULT_BOARD_S, DEFAULT_ALIGHT_S, 0 };
+static int g_capacity = DEFAULT_CAPACITY;
+
+typedef struct {
+    PaxSim* sim;
+    double now_s;
+} ArrivalSink;
+
+static void sim_add_passenger(const TrafficArrival* a, void* user)
+{
+    ArrivalSink* sink = (ArrivalSink*)user;
+    pax_sim_arrive(sink->sim, a->from_floor, a->to_floor, sink->now_s);
+}
+
+/* ---------------------------
+   One scenario
+   --------------------------- */
+
+static void run_scenario(SchedulerPolicy policy, TrafficPattern pattern, int floors, int car_count,
+                         double rate_per_min, double duration_s, unsigned long long seed, KpiResult* out)
+{
+    BuildingDesc desc;
+    building_desc_default(&desc, floors, car_count);
+    for (int c = 0; c < desc.max_cars; ++c) desc.car[c].capacity = g_capacity;
+    server_core_init_desc(1, &desc);
+    Scheduler_set_policy(policy);
+    Elevator* cars = server_core_get_elevators();
+    car_count = server_core_get_elevator_count();
+
+    ArrivalSink sink;
+    sink.sim = pax_sim_create(&g_pax, floors, cars, car_count, NULL);
+    sink.now_s = 0.0;
+    if (!sink.sim) {
+        printf("[BENCH] Cannot create passenger simulation\n");
+        exit(1);
+    }
+
+    TrafficModel tm;
+    traffic_init(&tm, pattern, floors, 0, rate_per_min, duration_s, seed);
+
+    clock_t c0 = clock();
+    const double dt = SERVER_CORE_DEFAULT_TICK_SECONDS;
+    PaxStats st;
+    for (;;) {
+        sink.now_s = server_core_get_tick() * dt;
+        pax_sim_get_stats(sink.sim, &st);
+        if (sink.now_s < duration_s) {
+            traffic_drive_until(&tm, sink.now_s, sim_add_passenger, &sink);
+        } else if (st.live == 0 || sink.now_s >= duration_s + DRAIN_MAX_S) {
+            break;
+        }
+        server_core_step();
+        sink.now_s = server_core_get_tick() * dt;
+        if (g_pax.destination) {
+            CoreNotice n;
+            while (core_notify_pop(&n) == 0) pax_sim_on_notice(sink.sim, &n);
+        }
+        pax_sim_observe(sink.sim, sink.now_s, dt);
+    }
+    clock_t c1 = clock();
+    pax_sim_get_stats(sink.sim, &st);
+
+    memset(out, 0, sizeof(*out));
+    out->policy = Scheduler_policy_name(policy);
+    out->pattern = traffic_pattern_name(pattern);
+    out->floors = floors;
+    out->cars = car_count;
+    out->capacity = g_capacity;
+    out->rate_per_min = rate_per_min;
+    out->passengers = (int)st.arrived;
+    out->served = (int)st.served;
+    if (st.served > 0) {
+        out->avg_wait_s = st.sum_wait_s / st.served;
+        out->avg_journey_s = st.sum_journey_s / st.served;
+        out->avg_stops_per_trip = st.sum_stops / st.served;
+        out->p95_wait_s = pax_sim_wait_percentile(sink.sim, 0.95);
+        out->p95_journey_s = pax_sim_journey_percentile(sink.sim, 0.95);
+    }
+    out->left_behind = st.left_behind;
+    out->peak_in_building = st.peak_live;
+    SchedulerRedispatchStats rd;
+    Scheduler_get_redispatch_stats(&rd);
+    out->redispatched = rd.moved;
+    out->planned = rd.planned;
+    SchedulerSloStats slo;
+    Scheduler_get_slo_stats(&slo);
+    out->escalated = slo.escalated;
+    out->max_call_wait_s = slo.max_wait_s;
+    out->sim_hours = sink.now_s / 3600.0;
+    out->cpu_s = (double)(c1 - c0) / CLOCKS_PER_SEC;
+    out->cpu_s_per_sim_hour = (out->sim_hours > 0.0) ? out->cpu_s / out->sim_hours : 0.0;
+
+    pax_sim_destroy(sink.sim);
+}
+
+/* ---------------------------
+   Output
+   --------------------------- */
+
+static void write_json(FILE* fp, const KpiResult* r, int n, unsigned long long seed, double duration_s)
+{
+    fprintf(fp, "{\n  \"benchmark\": \"dispatch_kpi\",\n  \"seed\": %llu,\n  \"duration_s\": %.0f,\n  \"results\": [\n",
+            seed, duration_s);
+    for (int i = 0; i < n; ++i) {
+        fprintf(fp,
+                "    {\"policy\": \"%s\", \"pattern\": \"%s\", \"floors\": %d, \"cars\": %d, \"capacity\": %d, \"rate_per_min\": %.1f, "
+                "\"passengers\": %d, \"served\": %d, \"avg_wait_s\": %.3f, \"p95_wait_s\": %.3f, "
+                "\"avg_journey_s\": %.3f, \"p95_journey_s\": %.3f, \"avg_stops_per_trip\": %.3f, "
+                "\"left_behind\": %lu, \"peak_in_building\": %u, "
+                "\"redispatched\": %lu, \"planned\": %lu, \"escalated\": %lu, \"max_call_wait_s\": %.3f, \"sim_hours\": %.3f, \"cpu_s\": %.4f, \"cpu_s_per_sim_hour\": %.4f}%s\n",
+                r[i].policy, r[i].pattern, r[i].floors, r[i].cars, r[i].capacity, r[i].rate_per_min,
+                r[i].passengers, r[i].served, r[i].avg_wait_s, r[i].p95_wait_s,
+                r[i].avg_journey_s, r[i].p95_journey_s, r[i].avg_stops_per_trip,
+                r[i].left_behind, r[i].peak_in_building,
+                r[i].redispatched, r[i].planned, r[i].escalated, r[i].max_call_wait_s, r[i].sim_hours, r[i].cpu_s, r[i].cpu_s_per_sim_hour, (i + 1 < n) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s [--floors N] [--cars N] [--rate PAX_PER_MIN] [--duration S] [--seed N]\n", prog);
+    printf("          [--pattern uppeak|downpeak|lunch|interfloor] [--json FILE]\n");
+    printf("          [--redispatch CALLS_PER_TICK] [--hysteresis S] [--wait-slo S] [--park]\n");
+    printf("          [--no-traffic-modes] [--destination]\n");
+    printf("          [--capacity PAX (0 = unlimited)] [--board S] [--alight S]\n");
+    printf("          [--horizon S] [--rollout-workers N] [--optimize ITERS_PER_TICK (0 = thread)]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int floors = DEFAULT_FLOORS;
+    int cars = DEFAULT_CARS;
+    double rate = DEFAULT_RATE_PER_MIN;
+    double duration = DEFAULT_DURATION_S;
+    unsigned long long seed = DEFAULT_SEED;
+    int only_pattern = -1;
+    const char* json_path = "bench_kpi.json";
+    int redispatch = SCHED_REDISPATCH_DEFAULT_BUDGET;
+    double hysteresis = SCHED_REDISPATCH_DEFAULT_HYSTERESIS_S;
+    double wait_slo = SCHED_DEFAULT_WAIT_SLO_S;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--floors") == 0 && i + 1 < argc) floors = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cars") == 0 && i + 1 < argc) cars = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--pattern") == 0 && i + 1 < argc) only_pattern = traffic_pattern_from_name(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else if (strcmp(argv[i], "--redispatch") == 0 && i + 1 < argc) redispatch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hysteresis") == 0 && i + 1 < argc) hysteresis = atof(argv[++i]);
+        else if (strcmp(argv[i], "--wait-slo") == 0 && i + 1 < argc) wait_slo = atof(argv[++i]);
+        else if (strcmp(argv[i], "--park") == 0) Scheduler_set_parking(1);
+        else if (strcmp(argv[i], "--no-traffic-modes") == 0) Scheduler_set_traffic_modes(0);
+        else if (strcmp(argv[i], "--destination") == 0) g_pax.destination = 1;
+        else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) g_capacity = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) g_pax.board_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alight") == 0 && i + 1 < argc) g_pax.alight_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--horizon") == 0 && i + 1 < argc) Scheduler_set_rollout(atof(argv[++i]), 0);
+        else if (strcmp(argv[i], "--rollout-workers") == 0 && i + 1 < argc) Scheduler_set_rollout(0.0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--optimize") == 0 && i + 1 < argc) server_core_set_optimizer(atoi(argv[++i]));
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (floors < 2 || floors > MAX_FLOORS || cars < 1 || cars > MAX_ELEVATORS || rate <= 0.0 || duration <= 0.0 ||
+        g_capacity < 0 || g_pax.board_s < 0.0 || g_pax.alight_s < 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    core_log_set_enabled(0);
+    Scheduler_set_redispatch(redispatch, hysteresis);
+    Scheduler_set_wait_slo(wait_slo);
+
+    KpiResult results[SCHED_POLICY_COUNT * TRAFFIC_PATTERN_COUNT];
+    int n = 0;
+
+    printf("%-10s %-11s %7s %7s %9s %9s %9s %9s %9s %7s %6s %7s %6s %5s %10s\n",
+           "policy", "pattern", "pax", "served", "avg_wait", "p95_wait", "max_wait", "avg_jrny", "p95_jrny",
+           "stops", "left", "moved", "plan", "slo", "cpu_s/h");
+    for (int p = 0; p < SCHED_POLICY_COUNT; ++p) {
+        for (int t = 0; t < TRAFFIC_PATTERN_COUNT; ++t) {
+            if (only_pattern >= 0 && t != only_pattern) continue;
+            KpiResult* r = &results[n++];
+            run_scenario((SchedulerPolicy)p, (TrafficPattern)t, floors, cars, rate, duration, seed, r);
+            printf("%-10s %-11s %7d %7d %9.2f %9.2f %9.2f %9.2f %9.2f %7.2f %6lu %7lu %6lu %5lu %10.4f\n",
+                   r->policy, r->pattern, r->passengers, r->served, r->avg_wait_s, r->p95_wait_s,
+                   r->max_call_wait_s, r->avg_journey_s, r->p95_journey_s, r->avg_stops_per_trip,
+                   r->left_behind, r->redispatched, r->planned, r->escalated, r->cpu_s_per_sim_hour);
+            fflush(stdout);
+        }
+    }
+
+    FILE* fp = fopen(json_path, "w");
+    if (!fp) {
+        printf("[BENCH] Cannot write %s\n", json_path);
+        return 1;
+    }
+    write_json(fp, results, n, seed, duration);
+    fclose(fp);
+    printf("[BENCH] Results written to %s\n", json_path);
+    return 0;
+}
@@ -0,0 +1,484 @@
+/* ----- ----- ----- ----- */
+// load_client.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+/*
+ * 本機壓力測試用戶端（Linux）：同時開啟大量 ROLE BUTTON 與 ROLE GUARD + WATCH 連線，
+ * 以交通模型產生的到達序列開迴路送出 CALL / INSIDE（不等回覆），統計：
+ *   - 回覆延遲百分位（送出指令到收到對應回覆）
+ *   - 實際達成的指令 / 秒
+ *   - 廣播延遲：外呼送出後多久出現在 WATCH 廣播的狀態列中，以及廣播間隔
+ * 逐步提高 --rate 即可找到伺服器的飽和點。
+ */
+
+#ifdef _WIN32
+#error "load_client is Linux only (epoll)"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/core/platform.h"
+#include "../src/core/traffic_model.h"
+
+#define DEFAULT_PORT 5555
+#define DEFAULT_BUTTONS 1000
+#define DEFAULT_GUARDS 50
+#define DEFAULT_RATE 200.0        // 每秒外呼數
+#define DEFAULT_DURATION 20.0
+#define DEFAULT_FLOORS 20
+#define DEFAULT_CARS 2
+#define INBUF_LEN 8192
+#define PENDING_CAP 256            // 每條連線未回覆指令的上限
+#define VIS_CAP 65536              // 等待出現在廣播中的外呼
+#define VIS_TIMEOUT_NS 10000000000LL
+
+typedef enum { CONN_BUTTON, CONN_GUARD } ConnRole;
+
+typedef struct {
+    int fd;
+    ConnRole role;
+    int floor;
+    char inbuf[INBUF_LEN];
+    int inlen;
+    long long pending[PENDING_CAP];   // 送出時間（ns），依序對應回覆
+    int p_head;
+    int p_count;
+    long long last_batch_ns;          // GUARD：上一次廣播起始時間
+} Conn;
+
+/* 可成長的樣本陣列 */
+typedef struct {
+    double* v;
+    int n;
+    int cap;
+} Samples;
+
+/* 等待在廣播中出現的外呼 */
+typedef struct {
+    int floor;
+    int dir;          // 1 = up, -1 = down
+    long long sent_ns;
+} VisProbe;
+
+typedef struct {
+    long long sent;
+    long long replies;
+    long long ok;
+    long long rejected;
+    long long bad;
+    long long send_blocked;
+    long long unmatched;
+    long long broadcast_lines;
+    long long vis_timeouts;
+    Samples reply_ms;
+    Samples vis_ms;
+    Samples period_ms;
+} LoadStats;
+
+static Conn* g_conns = NULL;
+static int g_conn_count = 0;
+static LoadStats g_st;
+static VisProbe g_vis[VIS_CAP];
+static int g_vis_count = 0;
+
+/* ---------------------------
+   Helpers
+   --------------------------- */
+
+static void samples_add(Samples* s, double x)
+{
+    if (s->n == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 4096;
+        s->v = (double*)realloc(s->v, sizeof(double) * (size_t)s->cap);
+    }
+    s->v[s->n++] = x;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double samples_pct(Samples* s, double q)
+{
+    if (s->n == 0) return 0.0;
+    int idx = (int)(q * (s->n - 1) + 0.5);
+    return s->v[idx];
+}
+
+static void raise_fd_limit(int want)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return;
+    if ((rlim_t)want > rl.rlim_cur) {
+        rl.rlim_cur = ((rlim_t)want < rl.rlim_max) ? (rlim_t)want : rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+/* 送出一行；記錄送出時間以配對回覆。非阻塞寫不進去就算 send_blocked */
+static int conn_send(Conn* c, const char* line, int track)
+{
+    if (c->fd < 0) return -1;
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf), "%s\r\n", line);
+    int w = (int)send(c->fd, buf, (size_t)n, MSG_NOSIGNAL);
+    if (w != n) {
+        g_st.send_blocked++;
+        return -1;
+    }
+    if (track) {
+        if (c->p_count < PENDING_CAP) {
+            c->pending[(c->p_head + c->p_count) % PENDING_CAP] = platform_time_ns();
+            c->p_count++;
+        }
+        g_st.sent++;
+    }
+    return 0;
+}
+
+static int connect_one(const struct sockaddr_in* addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+/* ---------------------------
+   Reply / broadcast handling
+   --------------------------- */
+
+static int is_reply(const char* line)
+{
+    return strncmp(line, "CALL_", 5) == 0 || strncmp(line, "INSIDE_", 7) == 0 ||
+           strncmp(line, "ROLE_", 5) == 0 || strncmp(line, "WATCH_OK", 8) == 0 ||
+           strncmp(line, "UNWATCH_OK", 10) == 0 || strncmp(line, "UNKNOWN_CMD", 11) == 0;
+}
+
+/* 狀態列 "[E0] cur=.. | up:3,5, down:7, inside:..."：在 up / down 清單中找樓層 */
+static int status_has_call(const char* line, int floor, int dir)
+{
+    const char* p = strstr(line, dir > 0 ? "up:" : "down:");
+    if (!p) return 0;
+    p += (dir > 0) ? 3 : 5;
+    while (*p >= '0' && *p <= '9') {
+        int f = (int)strtol(p, (char**)&p, 10);
+        if (f == floor) return 1;
+        if (*p == ',') ++p;
+    }
+    return 0;
+}
+
+/* 只用第一個 GUARD 的廣播解析可見延遲，其餘只統計間隔 */
+static void on_status_line(Conn* c, const char* line, long long now, int first_guard)
+{
+    g_st.broadcast_lines++;
+    if (strncmp(line, "[E0]", 4) == 0) {
+        if (c->last_batch_ns) samples_add(&g_st.period_ms, (now - c->last_batch_ns) / 1e6);
+        c->last_batch_ns = now;
+    }
+    if (!first_guard) return;
+
+    int w = 0;
+    for (int k = 0; k < g_vis_count; ++k) {
+        VisProbe* v = &g_vis[k];
+        if (status_has_call(line, v->floor, v->dir)) {
+            samples_add(&g_st.vis_ms, (now - v->sent_ns) / 1e6);
+            continue;
+        }
+        if (now - v->sent_ns > VIS_TIMEOUT_NS) {
+            g_st.vis_timeouts++;   // 可能在下一次廣播前就已經被服務
+            continue;
+        }
+        g_vis[w++] = *v;
+    }
+    g_vis_count = w;
+}
+
+static void on_line(Conn* c, const char* line, long long now, int first_guard)
+{
+    if (is_reply(line)) {
+        if (c->p_count == 0) {
+            g_st.unmatched++;
+            return;
+        }
+        long long t = c->pending[c->p_head];
+        c->p_head = (c->p_head + 1) % PENDING_CAP;
+        c->p_count--;
+        g_st.replies++;
+        samples_add(&g_st.reply_ms, (now - t) / 1e6);
+        if (strstr(line, "_OK") || strstr(line, "_DUPLICATE")) g_st.ok++;
+        else if (strstr(line, "_REJECT")) g_st.rejected++;
+        else g_st.bad++;
+        return;
+    }
+    if (c->role == CONN_GUARD && line[0] == '[') on_status_line(c, line, now, first_guard);
+}
+
+static void on_readable(Conn* c, int first_guard)
+{
+    for (;;) {
+        int space = INBUF_LEN - 1 - c->inlen;
+        if (space <= 0) {
+            c->inlen = 0;   // 過長的行直接丟棄
+            space = INBUF_LEN - 1;
+        }
+        ssize_t n = recv(c->fd, c->inbuf + c->inlen, (size_t)space, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {   // 伺服器關閉連線
+            close(c->fd);
+            c->fd = -1;
+            return;
+        }
+        c->inlen += (int)n;
+        c->inbuf[c->inlen] = '\0';
+
+        long long now = platform_time_ns();
+        char* start = c->inbuf;
+        char* eol;
+        while ((eol = strchr(start, '\n')) != NULL) {
+            *eol = '\0';
+            if (eol > start && eol[-1] == '\r') eol[-1] = '\0';
+            on_line(c, start, now, first_guard);
+            start = eol + 1;
+        }
+        int rem = (int)(c->inbuf + c->inlen - start);
+        memmove(c->inbuf, start, (size_t)rem);
+        c->inlen = rem;
+    }
+}
+
+/* ---------------------------
+   Traffic
+   --------------------------- */
+
+typedef struct {
+    int floors;
+    int cars;
+    double inside_ratio;
+    int* floor_rr;        // 每層樓輪流使用的按鈕連線
+    int** floor_conns;
+    int* floor_conn_count;
+    unsigned int rng;
+} Driver;
+
+static unsigned int drv_rand(Driver* d)
+{
+    d->rng = d->rng * 1103515245u + 12345u;
+    return (d->rng >> 8) & 0xFFFFFFu;
+}
+
+/* 一位乘客到達：該樓層的按鈕面板送 CALL，部分乘客再送 INSIDE */
+static void drive_arrival(const TrafficArrival* a, void* user)
+{
+    Driver* d = (Driver*)user;
+    int from = a->from_floor, to = a->to_floor;
+    if (from == to || d->floor_conn_count[from] == 0) return;
+
+    int ci = d->floor_conns[from][d->floor_rr[from]++ % d->floor_conn_count[from]];
+    char line[64];
+    snprintf(line, sizeof(line), "CALL %d %d", from, to);
+    if (conn_send(&g_conns[ci], line, 1) == 0 && g_vis_count < VIS_CAP) {
+        VisProbe* v = &g_vis[g_vis_count++];
+        v->floor = from;
+        v->dir = (to > from) ? 1 : -1;
+        v->sent_ns = platform_time_ns();
+    }
+
+    if ((drv_rand(d) % 1000) < (unsigned)(d->inside_ratio * 1000.0)) {
+        snprintf(line, sizeof(line), "INSIDE %d %d", (int)(drv_rand(d) % (unsigned)d->cars), to);
+        conn_send(&g_conns[ci], line, 1);
+    }
+}
+
+/* ---------------------------
+   Main
+   --------------------------- */
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s [--host IP] [--port N] [--buttons N] [--guards N] [--rate CALLS_PER_S]\n", prog);
+    printf("          [--duration S] [--floors N] [--cars N] [--inside-ratio R]\n");
+    printf("          [--pattern uppeak|downpeak|lunch|interfloor] [--seed N]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    const char* host = "127.0.0.1";
+    int port = DEFAULT_PORT;
+    int buttons = DEFAULT_BUTTONS, guards = DEFAULT_GUARDS;
+    double rate = DEFAULT_RATE, duration = DEFAULT_DURATION;
+    int floors = DEFAULT_FLOORS, cars = DEFAULT_CARS;
+    double inside_ratio = 0.5;
+    int pattern = TRAFFIC_INTERFLOOR;
+    unsigned long long seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) host = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--buttons") == 0 && i + 1 < argc) buttons = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--guards") == 0 && i + 1 < argc) guards = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration = atof(argv[++i]);
+        else if (strcmp(argv[i], "--floors") == 0 && i + 1 < argc) floors = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cars") == 0 && i + 1 < argc) cars = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--inside-ratio") == 0 && i + 1 < argc) inside_ratio = atof(argv[++i]);
+        else if (strcmp(argv[i], "--pattern") == 0 && i + 1 < argc) pattern = traffic_pattern_from_name(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (buttons < 1 || guards < 0 || rate <= 0.0 || duration <= 0.0 || floors < 2 ||
+        floors > MAX_FLOORS || cars < 1 || pattern < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    raise_fd_limit(buttons + guards + 64);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        printf("[LOAD] Bad host %s\n", host);
+        return 1;
+    }
+
+    int epfd = epoll_create1(0);
+    g_conns = (Conn*)calloc((size_t)(buttons + guards), sizeof(Conn));
+    Driver drv;
+    memset(&drv, 0, sizeof(drv));
+    drv.floors = floors;
+    drv.cars = cars;
+    drv.inside_ratio = inside_ratio;
+    drv.rng = (unsigned int)seed;
+    drv.floor_rr = (int*)calloc((size_t)floors, sizeof(int));
+    drv.floor_conn_count = (int*)calloc((size_t)floors, sizeof(int));
+    drv.floor_conns = (int**)calloc((size_t)floors, sizeof(int*));
+    for (int f = 0; f < floors; ++f) drv.floor_conns[f] = (int*)malloc(sizeof(int) * (size_t)(buttons / floors + 1));
+
+    // 建立連線：按鈕面板平均分配到各樓層
+    long long t_conn = platform_time_ns();
+    int first_guard = -1;
+    for (int i = 0; i < buttons + guards; ++i) {
+        int fd = connect_one(&addr);
+        if (fd < 0) {
+            printf("[LOAD] connect #%d failed: %s\n", i, strerror(errno));
+            break;
+        }
+        Conn* c = &g_conns[g_conn_count];
+        c->fd = fd;
+        if (i < buttons) {
+            char line[64];
+            c->role = CONN_BUTTON;
+            c->floor = i % floors;
+            drv.floor_conns[c->floor][drv.floor_conn_count[c->floor]++] = g_conn_count;
+            snprintf(line, sizeof(line), "ROLE BUTTON %d", c->floor);
+            conn_send(c, line, 0);
+            c->pending[c->p_count++] = platform_time_ns();   // ROLE_OK 也會回覆
+        } else {
+            c->role = CONN_GUARD;
+            c->floor = -1;
+            if (first_guard < 0) first_guard = g_conn_count;
+            conn_send(c, "ROLE GUARD", 0);
+            conn_send(c, "WATCH", 0);
+            c->pending[c->p_count++] = platform_time_ns();
+            c->pending[c->p_count++] = platform_time_ns();
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)g_conn_count;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        g_conn_count++;
+    }
+    printf("[LOAD] %d connections open in %.1f ms\n", g_conn_count, (platform_time_ns() - t_conn) / 1e6);
+    if (g_conn_count == 0) return 1;
+
+    // 等握手回覆都到，並把 ROLE / WATCH 的回覆從統計中排除
+    struct epoll_event events[512];
+    long long settle_until = platform_time_ns() + 2000000000LL;
+    while (platform_time_ns() < settle_until) {
+        int n = epoll_wait(epfd, events, 512, 50);
+        for (int k = 0; k < n; ++k) on_readable(&g_conns[events[k].data.u32], 0);
+        if (n == 0 && g_st.replies >= (long long)buttons + 2LL * guards) break;
+    }
+    memset(&g_st, 0, sizeof(g_st));
+    g_vis_count = 0;
+    for (int i = 0; i < g_conn_count; ++i) g_conns[i].last_batch_ns = 0;
+
+    // 開迴路送出：到達時間由交通模型決定，不等待回覆
+    TrafficModel tm;
+    traffic_init(&tm, (TrafficPattern)pattern, floors, 0, rate * 60.0, duration, seed);
+    long long t0 = platform_time_ns();
+    long long t_end = t0 + (long long)(duration * 1e9);
+    long long drain_end = t_end + 2000000000LL;
+    for (;;) {
+        long long now = platform_time_ns();
+        if (now >= drain_end) break;
+        if (now < t_end) traffic_drive_until(&tm, (now - t0) / 1e9, drive_arrival, &drv);
+
+        int n = epoll_wait(epfd, events, 512, 1);
+        for (int k = 0; k < n; ++k) {
+            int idx = (int)events[k].data.u32;
+            on_readable(&g_conns[idx], idx == first_guard);
+        }
+    }
+    double elapsed = duration;
+
+    qsort(g_st.reply_ms.v, (size_t)g_st.reply_ms.n, sizeof(double), cmp_double);
+    qsort(g_st.vis_ms.v, (size_t)g_st.vis_ms.n, sizeof(double), cmp_double);
+    qsort(g_st.period_ms.v, (size_t)g_st.period_ms.n, sizeof(double), cmp_double);
+    long long outstanding = 0;
+    for (int i = 0; i < g_conn_count; ++i) outstanding += g_conns[i].p_count;
+
+    printf("[LOAD] buttons=%d guards=%d target=%.1f calls/s pattern=%s duration=%.0fs\n",
+           buttons, guards, rate, traffic_pattern_name((TrafficPattern)pattern), duration);
+    printf("[LOAD] commands sent=%lld (%.1f/s) replies=%lld (%.1f/s) ok=%lld reject=%lld bad=%lld\n",
+           g_st.sent, g_st.sent / elapsed, g_st.replies, g_st.replies / elapsed,
+           g_st.ok, g_st.rejected, g_st.bad);
+    printf("[LOAD] unanswered=%lld send_blocked=%lld unmatched=%lld\n",
+           outstanding, g_st.send_blocked, g_st.unmatched);
+    printf("[LOAD] reply latency ms: p50=%.3f p90=%.3f p99=%.3f p999=%.3f max=%.3f\n",
+           samples_pct(&g_st.reply_ms, 0.50), samples_pct(&g_st.reply_ms, 0.90),
+           samples_pct(&g_st.reply_ms, 0.99), samples_pct(&g_st.reply_ms, 0.999),
+           samples_pct(&g_st.reply_ms, 1.0));
+    printf("[LOAD] broadcast period ms: p50=%.1f p99=%.1f max=%.1f (lines=%lld)\n",
+           samples_pct(&g_st.period_ms, 0.50), samples_pct(&g_st.period_ms, 0.99),
+           samples_pct(&g_st.period_ms, 1.0), g_st.broadcast_lines);
+    printf("[LOAD] call->broadcast lag ms: p50=%.1f p99=%.1f (seen=%d, served before shown=%lld)\n",
+           samples_pct(&g_st.vis_ms, 0.50), samples_pct(&g_st.vis_ms, 0.99),
+           g_st.vis_ms.n, g_st.vis_timeouts);
+
+    for (int i = 0; i < g_conn_count; ++i) {
+        if (g_conns[i].fd >= 0) close(g_conns[i].fd);
+    }
+    close(epfd);
+    return 0;
+}
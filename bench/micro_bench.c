@@ -0,0 +1,481 @@
+/* ----- ----- ----- ----- */
+// micro_bench.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+/*
+ * 核心基本操作的微基準測試：暖機、重複量測，輸出每次操作的奈秒數（平均 / 標準差 / 最小）。
+ * 參數：樓層數、電梯數、佇列深度（每台電梯的停靠數與待派佇列長度），可給逗號分隔的清單做掃描，
+ * 用來找出哪個操作的成本隨規模超線性成長。
+ *
+ * 注意：電梯依 --floors 設定樓層數，ETA 與旗標掃描只看實際樓層；停靠位元集合、路線表與結構大小
+ * 仍以 MAX_FLOORS 為上限，要看上限的影響請以 -DMAX_FLOORS=N 重新編譯。
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/core/core_log.h"
+#include "../src/core/elevator.h"
+#include "../src/core/eta.h"
+#include "../src/core/platform.h"
+#include "../src/core/request_queue.h"
+#include "../src/core/scheduler.h"
+#include "../src/core/server_events.h"
+#include "../src/network/protocol.h"
+
+#define MAX_SWEEP 16
+#define DEFAULT_REPS 15
+#define DEFAULT_WARMUP 3
+#define MIN_BATCH_NS 2000000LL   // 每次量測至少 2 ms，避免計時器解析度影響
+#define STATUS_BUF_LEN 256       // 與 remote_server 的 STATUS 緩衝相同
+
+typedef struct {
+    int floors;
+    int cars;
+    int depth;
+    Elevator elevators[MAX_ELEVATORS];
+    Elevator probe;
+    unsigned char* car_mem;   // 電梯與 probe 的旗標 / 路線（依掃描中最高的樓層數配置）
+    RequestQueue queue;
+    unsigned int rng;
+    long long sink;   // 防止編譯器把結果最佳化掉
+} BenchCtx;
+
+typedef struct {
+    const char* name;
+    void (*setup)(BenchCtx* ctx);
+    void (*run)(BenchCtx* ctx, long long iters);
+} MicroBench;
+
+/* ---------------------------
+   Helpers
+   --------------------------- */
+
+static unsigned int next_rand(BenchCtx* ctx)
+{
+    ctx->rng = ctx->rng * 1103515245u + 12345u;
+    return (ctx->rng >> 8) & 0xFFFFFFu;
+}
+
+/* 每台電梯放 depth 個隨機停靠（內呼 / 上 / 下輪流），並讓它處於行駛中 */
+static void setup_cars(BenchCtx* ctx)
+{
+    ctx->rng = 12345u;
+    for (int c = 0; c < ctx->cars; ++c) {
+        Elevator* e = &ctx->elevators[c];
+        Elevator_init(e, c, (c * ctx->floors) / ctx->cars);
+        Elevator_configure(e, ctx->floors, 0.0, 0.0, NULL);
+        for (int k = 0; k < ctx->depth; ++k) {
+            int f = (int)(next_rand(ctx) % (unsigned)ctx->floors);
+            elevator_add_request_flag(e, f, (RequestType)(k % 3));
+        }
+        e->task_state = TASK_MOVING;
+        e->direction = (c & 1) ? DIR_DOWN : DIR_UP;
+    }
+}
+
+static PendingRequest make_call(BenchCtx* ctx)
+{
+    PendingRequest r;
+    r.floor = (int)(next_rand(ctx) % (unsigned)ctx->floors);
+    r.type = (r.floor == 0 || (r.floor < ctx->floors - 1 && (next_rand(ctx) & 1))) ? REQ_CALL_UP : REQ_CALL_DOWN;
+    r.source_id = -1;
+    r.to_floor = -1;
+    r.enqueue_s = 0.0;
+    r.request_id = 0;
+    return r;
+}
+
+static void setup_queue(BenchCtx* ctx)
+{
+    setup_cars(ctx);
+    rq_init(&ctx->queue);
+    for (int k = 0; k < ctx->depth && k < MAX_REQUESTS - 1; ++k) rq_push(&ctx->queue, make_call(ctx));
+}
+
+/* ---------------------------
+   Benchmarks
+   --------------------------- */
+
+/* Elevator_step：輪流推進每台電梯；電梯閒置時補一個內呼讓它持續有事做 */
+static void run_elevator_step(BenchCtx* ctx, long long iters)
+{
+    for (long long i = 0; i < iters; ++i) {
+        Elevator* e = &ctx->elevators[i % ctx->cars];
+        if (e->task_state == TASK_IDLE) {
+            elevator_add_request_flag(e, (int)(next_rand(ctx) % (unsigned)ctx->floors), REQ_INSIDE);
+        }
+        Elevator_step(e, 0.1);
+    }
+    ctx->sink += ctx->elevators[0].current_floor;
+}
+
+/* pick_next_target_flag：每次換樓層 / 方向出發，快取路線對不上 => 每次都重建路線 */
+static void setup_pick(BenchCtx* ctx)
+{
+    setup_cars(ctx);
+    Elevator_copy(&ctx->probe, &ctx->elevators[0]);
+}
+
+static void run_pick(BenchCtx* ctx, long long iters)
+{
+    Elevator* e = &ctx->probe;
+    for (long long i = 0; i < iters; ++i) {
+        e->current_floor = (int)(i % ctx->floors);
+        e->direction = (i & 1) ? DIR_DOWN : DIR_UP;
+        ctx->sink += pick_next_target_flag(e) + e->target_floor;
+    }
+}
+
+/* pick_next_target_flag：照快取路線走下一段（電梯關門選層的常見情況） */
+static void setup_pick_planned(BenchCtx* ctx)
+{
+    setup_cars(ctx);
+    Elevator_copy(&ctx->probe, &ctx->elevators[0]);
+    pick_next_target_flag(&ctx->probe);  // 先建好路線
+}
+
+static void run_pick_planned(BenchCtx* ctx, long long iters)
+{
+    Elevator* e = &ctx->probe;
+    int floor = e->route.start_floor;
+    Direction dir = (Direction)e->route.start_dir;
+    for (long long i = 0; i < iters; ++i) {
+        if (e->route.head >= e->route.count || e->route.legs[e->route.head].target < 0) {
+            e->route.head = 0;
+            e->current_floor = floor;
+            e->direction = dir;
+        }
+        ctx->sink += pick_next_target_flag(e) + e->target_floor;
+        e->current_floor = e->target_floor;
+    }
+}
+
+static void run_estimate_cost(BenchCtx* ctx, long long iters)
+{
+    double acc = 0.0;
+    for (long long i = 0; i < iters; ++i) {
+        acc += Scheduler_estimate_cost(&ctx->elevators[i % ctx->cars], (int)(i % ctx->floors));
+    }
+    ctx->sink += (long long)acc;
+}
+
+/* try_assign_one：佇列維持 depth 筆（每次補一筆再派一筆）；
+ * 派出去的外呼若是新增的旗標就清掉，讓每台電梯的停靠數維持在 depth 左右 */
+static void run_assign_one(BenchCtx* ctx, long long iters)
+{
+    for (long long i = 0; i < iters; ++i) {
+        PendingRequest r = make_call(ctx);
+        bool was_set[MAX_ELEVATORS];
+        for (int c = 0; c < ctx->cars; ++c) {
+            const Elevator* e = &ctx->elevators[c];
+            was_set[c] = (r.type == REQ_CALL_UP) ? e->call_up[r.floor] : e->call_down[r.floor];
+        }
+        rq_push(&ctx->queue, r);
+        ctx->sink += Scheduler_assign_one(&ctx->queue, ctx->elevators, ctx->cars);
+        for (int c = 0; c < ctx->cars; ++c) {
+            if (was_set[c]) continue;
+            Elevator* e = &ctx->elevators[c];
+            if (r.type == REQ_CALL_UP) e->call_up[r.floor] = false;
+            else e->call_down[r.floor] = false;
+            Elevator_mark_stops_changed(e);
+        }
+    }
+}
+
+/* 同上，改用 ETA 派車策略 */
+static void run_assign_eta(BenchCtx* ctx, long long iters)
+{
+    Scheduler_set_policy(SCHED_POLICY_ETA);
+    run_assign_one(ctx, iters);
+    Scheduler_set_policy(SCHED_POLICY_GREEDY);
+}
+
+/* 同上，改用 rollout 派車策略（每次派車對每台候選電梯各模擬一次） */
+static void run_assign_rollout(BenchCtx* ctx, long long iters)
+{
+    Scheduler_set_policy(SCHED_POLICY_ROLLOUT);
+    run_assign_one(ctx, iters);
+    Scheduler_set_policy(SCHED_POLICY_GREEDY);
+}
+
+/* eta_compute：每次都完整模擬一台電梯的停靠路線（快取失效時的成本） */
+static void run_eta_compute(BenchCtx* ctx, long long iters)
+{
+    double up[MAX_FLOORS], down[MAX_FLOORS];
+    double acc = 0.0;
+    for (long long i = 0; i < iters; ++i) {
+        eta_compute(&ctx->elevators[i % ctx->cars], 0.1, up, down);
+        acc += up[i % ctx->floors];
+    }
+    ctx->sink += (long long)acc;
+}
+
+/* eta_car：電梯狀態不變，查詢都從快取回答 */
+static void setup_eta_cache(BenchCtx* ctx)
+{
+    setup_cars(ctx);
+    eta_reset();
+}
+
+static void run_eta_query(BenchCtx* ctx, long long iters)
+{
+    double acc = 0.0;
+    for (long long i = 0; i < iters; ++i) {
+        acc += eta_car(&ctx->elevators[i % ctx->cars], (int)(i % ctx->floors), (i & 1) ? DIR_DOWN : DIR_UP);
+    }
+    ctx->sink += (long long)acc;
+}
+
+static void run_rq_push_pop(BenchCtx* ctx, long long iters)
+{
+    PendingRequest r = make_call(ctx), out;
+    for (long long i = 0; i < iters; ++i) {
+        r.floor = (int)(i % ctx->floors);
+        rq_push(&ctx->queue, r);
+        rq_pop(&ctx->queue, &out);
+        ctx->sink += out.floor;
+    }
+}
+
+/* server_events：佇列預先放 depth 筆，每次 push 一筆再 try_pop 一筆（含 malloc / free 與鎖） */
+static void setup_events(BenchCtx* ctx)
+{
+    setup_cars(ctx);
+    server_events_init();
+    for (int k = 0; k < ctx->depth; ++k) server_events_push_outside(k % ctx->floors, DIR_UP, -1);
+}
+
+static void run_events_outside(BenchCtx* ctx, long long iters)
+{
+    ServerEvent* ev = NULL;
+    for (long long i = 0; i < iters; ++i) {
+        server_events_push_outside((int)(i % ctx->floors), DIR_UP, -1);
+        if (server_events_try_pop(&ev) == 0 && ev) {
+            ctx->sink += ev->type;
+            server_events_free(ev);
+        }
+    }
+}
+
+static void run_events_inside(BenchCtx* ctx, long long iters)
+{
+    ServerEvent* ev = NULL;
+    for (long long i = 0; i < iters; ++i) {
+        server_events_push_inside((int)(i % ctx->cars), (int)(i % ctx->floors), -1);
+        if (server_events_try_pop(&ev) == 0 && ev) {
+            ctx->sink += ev->type;
+            server_events_free(ev);
+        }
+    }
+}
+
+static void run_status_line(BenchCtx* ctx, long long iters)
+{
+    char buf[STATUS_BUF_LEN];
+    for (long long i = 0; i < iters; ++i) {
+        Elevator_status_line(&ctx->elevators[i % ctx->cars], buf, sizeof(buf));
+        ctx->sink += buf[0];
+    }
+}
+
+static const char* const k_lines[] = {
+    "CALL 3 UP",
+    "CALL 12 7",
+    "INSIDE 2 15",
+    "ROLE BUTTON 4",
+    "STATUS",
+    "call 9 down",
+    "WATCH",
+    "BOGUS 1 2 3",
+};
+
+static void run_parse(BenchCtx* ctx, long long iters)
+{
+    ProtocolCommand pc;
+    const int n = (int)(sizeof(k_lines) / sizeof(k_lines[0]));
+    for (long long i = 0; i < iters; ++i) {
+        ctx->sink += protocol_parse_line(k_lines[i % n], &pc) + pc.a;
+    }
+}
+
+static const MicroBench k_benches[] = {
+    { "elevator_step",        setup_cars,   run_elevator_step  },
+    { "pick_next_target",     setup_pick,   run_pick           },
+    { "pick_planned",         setup_pick_planned, run_pick_planned },
+    { "estimate_cost",        setup_cars,   run_estimate_cost  },
+    { "try_assign_one",       setup_queue,  run_assign_one     },
+    { "try_assign_eta",       setup_queue,  run_assign_eta     },
+    { "try_assign_rollout",   setup_queue,  run_assign_rollout },
+    { "eta_compute",          setup_cars,   run_eta_compute    },
+    { "eta_query_cached",     setup_eta_cache, run_eta_query   },
+    { "rq_push_pop",          setup_queue,  run_rq_push_pop    },
+    { "events_outside",       setup_events, run_events_outside },
+    { "events_inside",        setup_events, run_events_inside  },
+    { "status_line",          setup_cars,   run_status_line    },
+    { "parse_command",        setup_cars,   run_parse          },
+};
+
+/* ---------------------------
+   Harness
+   --------------------------- */
+
+typedef struct {
+    double mean_ns;
+    double stddev_ns;
+    double min_ns;
+    long long iters;
+} BenchStats;
+
+static long long time_batch(const MicroBench* b, BenchCtx* ctx, long long iters)
+{
+    long long t0 = platform_time_ns();
+    b->run(ctx, iters);
+    return platform_time_ns() - t0;
+}
+
+static void measure(const MicroBench* b, BenchCtx* ctx, int reps, int warmup, BenchStats* out)
+{
+    b->setup(ctx);
+
+    // 校準：批次加倍直到一次量測超過 MIN_BATCH_NS
+    long long iters = 64;
+    while (time_batch(b, ctx, iters) < MIN_BATCH_NS && iters < (1LL << 30)) iters *= 2;
+
+    for (int w = 0; w < warmup; ++w) time_batch(b, ctx, iters);
+
+    double sum = 0.0, sum_sq = 0.0, min_ns = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        double ns = (double)time_batch(b, ctx, iters) / (double)iters;
+        sum += ns;
+        sum_sq += ns * ns;
+        if (ns < min_ns) min_ns = ns;
+    }
+    double mean = sum / reps;
+    double var = (reps > 1) ? (sum_sq - sum * mean) / (reps - 1) : 0.0;
+    out->mean_ns = mean;
+    out->stddev_ns = (var > 0.0) ? sqrt(var) : 0.0;
+    out->min_ns = min_ns;
+    out->iters = iters;
+}
+
+/* "4,8,16" => 陣列，回傳個數 */
+static int parse_list(const char* s, int* out, int cap)
+{
+    int n = 0;
+    while (*s && n < cap) {
+        char* end;
+        long v = strtol(s, &end, 10);
+        if (end == s) return -1;
+        out[n++] = (int)v;
+        s = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return -1;
+    }
+    return n;
+}
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s [--floors LIST] [--cars LIST] [--depth LIST] [--reps N] [--warmup N]\n", prog);
+    printf("          [--only NAME] [--csv FILE] [--rollout-workers N]\n");
+    printf("  LIST is comma separated, e.g. --floors 10,50,100 (floors <= %d, cars <= %d)\n",
+           MAX_FLOORS, MAX_ELEVATORS);
+}
+
+int main(int argc, char* argv[])
+{
+    int floors[MAX_SWEEP] = {20}, cars[MAX_SWEEP] = {4}, depth[MAX_SWEEP] = {8};
+    int nf = 1, nc = 1, nd = 1;
+    int reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+    const char* only = NULL;
+    const char* csv_path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--floors") == 0 && i + 1 < argc) nf = parse_list(argv[++i], floors, MAX_SWEEP);
+        else if (strcmp(argv[i], "--cars") == 0 && i + 1 < argc) nc = parse_list(argv[++i], cars, MAX_SWEEP);
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) nd = parse_list(argv[++i], depth, MAX_SWEEP);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) only = argv[++i];
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) csv_path = argv[++i];
+        else if (strcmp(argv[i], "--rollout-workers") == 0 && i + 1 < argc) Scheduler_set_rollout(0.0, atoi(argv[++i]));
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nf <= 0 || nc <= 0 || nd <= 0 || reps < 1 || warmup < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    for (int i = 0; i < nf; ++i) if (floors[i] < 2 || floors[i] > MAX_FLOORS) { print_usage(argv[0]); return 1; }
+    for (int i = 0; i < nc; ++i) if (cars[i] < 1 || cars[i] > MAX_ELEVATORS) { print_usage(argv[0]); return 1; }
+    for (int i = 0; i < nd; ++i) if (depth[i] < 0 || depth[i] >= MAX_REQUESTS) { print_usage(argv[0]); return 1; }
+
+    core_log_set_enabled(0);
+
+    FILE* csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            printf("[BENCH] Cannot write %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "bench,floors,cars,depth,iters,mean_ns,stddev_ns,min_ns\n");
+    }
+
+    BenchCtx* ctx = (BenchCtx*)calloc(1, sizeof(BenchCtx));
+    if (!ctx) return 1;
+    int max_floors = floors[0];
+    for (int i = 1; i < nf; ++i) if (floors[i] > max_floors) max_floors = floors[i];
+    const size_t car_bytes = Elevator_storage_size(max_floors);
+    ctx->car_mem = (unsigned char*)malloc(car_bytes * (MAX_ELEVATORS + 1));
+    if (!ctx->car_mem) {
+        free(ctx);
+        return 1;
+    }
+    for (int c = 0; c < MAX_ELEVATORS; ++c) Elevator_attach(&ctx->elevators[c], ctx->car_mem + car_bytes * (size_t)c, max_floors);
+    Elevator_attach(&ctx->probe, ctx->car_mem + car_bytes * MAX_ELEVATORS, max_floors);
+
+    printf("MAX_FLOORS=%d reps=%d warmup=%d\n", MAX_FLOORS, reps, warmup);
+    printf("%-18s %6s %4s %5s %10s %10s %10s %10s\n",
+           "bench", "floors", "cars", "depth", "iters", "ns/op", "stddev", "min");
+    const int nb = (int)(sizeof(k_benches) / sizeof(k_benches[0]));
+    for (int b = 0; b < nb; ++b) {
+        if (only && strcmp(only, k_benches[b].name) != 0) continue;
+        for (int fi = 0; fi < nf; ++fi) {
+            for (int ci = 0; ci < nc; ++ci) {
+                for (int di = 0; di < nd; ++di) {
+                    BenchStats st;
+                    ctx->floors = floors[fi];
+                    ctx->cars = cars[ci];
+                    ctx->depth = depth[di];
+                    measure(&k_benches[b], ctx, reps, warmup, &st);
+                    printf("%-18s %6d %4d %5d %10lld %10.1f %10.1f %10.1f\n",
+                           k_benches[b].name, ctx->floors, ctx->cars, ctx->depth,
+                           st.iters, st.mean_ns, st.stddev_ns, st.min_ns);
+                    if (csv) {
+                        fprintf(csv, "%s,%d,%d,%d,%lld,%.2f,%.2f,%.2f\n",
+                                k_benches[b].name, ctx->floors, ctx->cars, ctx->depth,
+                                st.iters, st.mean_ns, st.stddev_ns, st.min_ns);
+                    }
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    if (csv) fclose(csv);
+    // 印出 sink 讓結果不會被最佳化掉
+    printf("[BENCH] done (checksum %lld)\n", ctx->sink);
+    free(ctx->car_mem);
+    free(ctx);
+    return 0;
+}
@@ -0,0 +1,454 @@
+/* ----- ----- ----- ----- */
+// trace_replay.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+/*
+ * 重播以 --trace 擷取的用戶端流量（Linux）。
+ * 每條擷取到的連線對應一條新連線，依原本的時間點（可用 --speed 加速，0 = 全速）
+ * 依序送出指令；同一條連線內的順序保持不變。結束後把收到的回覆與擷取時的回覆逐行比對。
+ *
+ * 狀態列（"[E..."，例如 STATUS 的回覆）與當下電梯位置有關，預設不列入比對（--strict 才比）。
+ */
+
+#ifdef _WIN32
+#error "trace_replay is Linux only"
+#endif
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/core/platform.h"
+
+#define LINE_MAX_LEN 512
+#define INBUF_LEN 8192
+#define CLOSE_GRACE_MS 2000     // 關閉前最多等待回覆的時間
+#define MAX_DIFFS_SHOWN 20
+
+typedef enum { EV_CONNECT, EV_SEND, EV_CLOSE } ReplayEventType;
+
+/* 依時間排序的重播動作 */
+typedef struct {
+    long long t_ms;
+    int seq;          // 檔案中的順序（同時間時維持原順序）
+    int conn;         // g_conns 索引
+    ReplayEventType type;
+    char* line;       // EV_SEND
+} ReplayEvent;
+
+typedef struct {
+    char** v;
+    int n;
+    int cap;
+} LineList;
+
+typedef struct {
+    int trace_id;
+    int fd;
+    int closing;
+    long long close_deadline_ms;
+    LineList expected;   // 擷取時的回覆
+    LineList actual;     // 重播時收到的回覆
+    char inbuf[INBUF_LEN];
+    int inlen;
+    int sent;
+} ReplayConn;
+
+static ReplayConn* g_conns = NULL;
+static int g_conn_count = 0;
+static int g_conn_cap = 0;
+static ReplayEvent* g_events = NULL;
+static int g_event_count = 0;
+static int g_event_cap = 0;
+
+/* ---------------------------
+   Helpers
+   --------------------------- */
+
+static void list_add(LineList* l, const char* s)
+{
+    if (l->n == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 16;
+        l->v = (char**)realloc(l->v, sizeof(char*) * (size_t)l->cap);
+    }
+    l->v[l->n++] = strdup(s);
+}
+
+static int find_conn(int trace_id, int create)
+{
+    // 擷取中 id 單調遞增，從尾端找通常一步就中
+    for (int i = g_conn_count - 1; i >= 0; --i) {
+        if (g_conns[i].trace_id == trace_id) return i;
+    }
+    if (!create) return -1;
+    if (g_conn_count == g_conn_cap) {
+        g_conn_cap = g_conn_cap ? g_conn_cap * 2 : 256;
+        g_conns = (ReplayConn*)realloc(g_conns, sizeof(ReplayConn) * (size_t)g_conn_cap);
+    }
+    ReplayConn* c = &g_conns[g_conn_count];
+    memset(c, 0, sizeof(*c));
+    c->trace_id = trace_id;
+    c->fd = -1;
+    return g_conn_count++;
+}
+
+static void add_event(long long t, int conn, ReplayEventType type, const char* line)
+{
+    if (g_event_count == g_event_cap) {
+        g_event_cap = g_event_cap ? g_event_cap * 2 : 1024;
+        g_events = (ReplayEvent*)realloc(g_events, sizeof(ReplayEvent) * (size_t)g_event_cap);
+    }
+    ReplayEvent* e = &g_events[g_event_count];
+    e->t_ms = t;
+    e->seq = g_event_count;
+    e->conn = conn;
+    e->type = type;
+    e->line = line ? strdup(line) : NULL;
+    g_event_count++;
+}
+
+static int cmp_event(const void* a, const void* b)
+{
+    const ReplayEvent* x = (const ReplayEvent*)a;
+    const ReplayEvent* y = (const ReplayEvent*)b;
+    if (x->t_ms != y->t_ms) return (x->t_ms > y->t_ms) - (x->t_ms < y->t_ms);
+    return x->seq - y->seq;
+}
+
+/* 與電梯當下狀態或時間點有關的行（STATUS 回覆、非同步通知） */
+static int is_volatile(const char* line)
+{
+    if (line[0] == '[' && line[1] == 'E') return 1;
+    // 呼叫生命週期通知與告警是非同步推送的，時間點每次都不同
+    return strncmp(line, "ASSIGNED ", 9) == 0 || strncmp(line, "ARRIVING ", 9) == 0 ||
+           strncmp(line, "SERVED ", 7) == 0 || strncmp(line, "ALERT ", 6) == 0;
+}
+
+/* 非嚴格模式下不比 CALL_OK 的請求 ID（跨連線的交錯順序不同，ID 就不同） */
+static int same_line(const char* want, const char* got, int strict)
+{
+    if (strict || strncmp(want, "CALL_OK", 7) != 0) return strcmp(want, got) == 0;
+    return strncmp(got, "CALL_OK", 7) == 0;
+}
+
+/* ---------------------------
+   Trace loading
+   --------------------------- */
+
+static int load_trace(const char* path)
+{
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    char buf[LINE_MAX_LEN + 64];
+    int lineno = 0;
+    while (fgets(buf, sizeof(buf), fp)) {
+        lineno++;
+        if (buf[0] == '#' || buf[0] == '\n') continue;
+        size_t len = strlen(buf);
+        if (len && buf[len - 1] == '\n') buf[--len] = '\0';
+
+        long long t;
+        int id, n = 0;
+        char kind;
+        if (sscanf(buf, "%lld %d %c%n", &t, &id, &kind, &n) != 3) {
+            printf("[REPLAY] %s:%d: malformed line skipped\n", path, lineno);
+            continue;
+        }
+        const char* text = buf + n;
+        if (*text == ' ') ++text;
+
+        int ci = find_conn(id, kind == '+');
+        if (ci < 0) continue;   // 擷取開始前就存在的連線
+        switch (kind) {
+            case '+': add_event(t, ci, EV_CONNECT, NULL); break;
+            case '>': add_event(t, ci, EV_SEND, text); break;
+            case '-': add_event(t, ci, EV_CLOSE, NULL); break;
+            case '<': list_add(&g_conns[ci].expected, text); break;
+            default: break;
+        }
+    }
+    fclose(fp);
+    qsort(g_events, (size_t)g_event_count, sizeof(ReplayEvent), cmp_event);
+    return 0;
+}
+
+/* ---------------------------
+   Network
+   --------------------------- */
+
+static int connect_one(const struct sockaddr_in* addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+static void conn_close(ReplayConn* c)
+{
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+    c->closing = 0;
+}
+
+/* 送出一整行（非阻塞 socket，寫不完就等到可寫） */
+static int send_all(int fd, const char* data, int len)
+{
+    while (len > 0) {
+        ssize_t w = send(fd, data, (size_t)len, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            struct pollfd p = { fd, POLLOUT, 0 };
+            poll(&p, 1, 100);
+            continue;
+        }
+        data += w;
+        len -= (int)w;
+    }
+    return 0;
+}
+
+static void conn_read(ReplayConn* c)
+{
+    for (;;) {
+        int space = INBUF_LEN - 1 - c->inlen;
+        if (space <= 0) {
+            c->inlen = 0;
+            space = INBUF_LEN - 1;
+        }
+        ssize_t n = recv(c->fd, c->inbuf + c->inlen, (size_t)space, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            conn_close(c);
+            return;
+        }
+        c->inlen += (int)n;
+        c->inbuf[c->inlen] = '\0';
+        char* start = c->inbuf;
+        char* eol;
+        while ((eol = strchr(start, '\n')) != NULL) {
+            *eol = '\0';
+            if (eol > start && eol[-1] == '\r') eol[-1] = '\0';
+            list_add(&c->actual, start);
+            start = eol + 1;
+        }
+        int rem = (int)(c->inbuf + c->inlen - start);
+        memmove(c->inbuf, start, (size_t)rem);
+        c->inlen = rem;
+    }
+}
+
+/* 等待中的關閉：回覆收齊或逾時就關 */
+static void check_close(ReplayConn* c, long long now)
+{
+    if (!c->closing || c->fd < 0) return;
+    if (c->actual.n >= c->expected.n || now >= c->close_deadline_ms) conn_close(c);
+}
+
+/* 收資料，最多等 timeout_ms */
+static void pump(struct pollfd* pfds, int* map, int timeout_ms)
+{
+    int n = 0;
+    for (int i = 0; i < g_conn_count; ++i) {
+        if (g_conns[i].fd < 0) continue;
+        pfds[n].fd = g_conns[i].fd;
+        pfds[n].events = POLLIN;
+        pfds[n].revents = 0;
+        map[n++] = i;
+    }
+    if (n == 0) {
+        if (timeout_ms > 0) platform_sleep_ms(timeout_ms);
+        return;
+    }
+    if (poll(pfds, (nfds_t)n, timeout_ms) <= 0) return;
+    long long now = platform_time_ms();
+    for (int k = 0; k < n; ++k) {
+        if (!pfds[k].revents) continue;
+        ReplayConn* c = &g_conns[map[k]];
+        conn_read(c);
+        check_close(c, now);
+    }
+}
+
+/* ---------------------------
+   Diff
+   --------------------------- */
+
+/* 跳過不比對的行，回傳下一個要比對的索引 */
+static int next_cmp(const LineList* l, int i, int strict)
+{
+    while (i < l->n && !strict && is_volatile(l->v[i])) ++i;
+    return i;
+}
+
+static long long diff_conn(const ReplayConn* c, int strict, int* shown)
+{
+    long long mismatches = 0;
+    int i = next_cmp(&c->expected, 0, strict);
+    int j = next_cmp(&c->actual, 0, strict);
+    while (i < c->expected.n || j < c->actual.n) {
+        const char* want = (i < c->expected.n) ? c->expected.v[i] : "<missing>";
+        const char* got = (j < c->actual.n) ? c->actual.v[j] : "<missing>";
+        if (!same_line(want, got, strict)) {
+            mismatches++;
+            if (*shown < MAX_DIFFS_SHOWN) {
+                printf("  conn %d: expected \"%s\" got \"%s\"\n", c->trace_id, want, got);
+                (*shown)++;
+            }
+        }
+        if (i < c->expected.n) i = next_cmp(&c->expected, i + 1, strict);
+        if (j < c->actual.n) j = next_cmp(&c->actual, j + 1, strict);
+    }
+    return mismatches;
+}
+
+/* ---------------------------
+   Main
+   --------------------------- */
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s <trace> [--host IP] [--port N] [--speed X] [--strict]\n", prog);
+    printf("  --speed 1 = original timing, 10 = ten times faster, 0 = as fast as possible\n");
+}
+
+int main(int argc, char* argv[])
+{
+    const char* trace_path = NULL;
+    const char* host = "127.0.0.1";
+    int port = 5555;
+    double speed = 1.0;
+    int strict = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) host = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--strict") == 0) strict = 1;
+        else if (argv[i][0] != '-' && !trace_path) trace_path = argv[i];
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!trace_path || speed < 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (load_trace(trace_path) != 0) {
+        printf("[REPLAY] Cannot read %s\n", trace_path);
+        return 1;
+    }
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)g_conn_count + 64) {
+        rl.rlim_cur = ((rlim_t)g_conn_count + 64 < rl.rlim_max) ? (rlim_t)g_conn_count + 64 : rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        printf("[REPLAY] Bad host %s\n", host);
+        return 1;
+    }
+
+    struct pollfd* pfds = (struct pollfd*)malloc(sizeof(struct pollfd) * (size_t)(g_conn_count + 1));
+    int* map = (int*)malloc(sizeof(int) * (size_t)(g_conn_count + 1));
+    long long commands = 0, connect_failed = 0;
+    long long t0 = platform_time_ms();
+
+    for (int k = 0; k < g_event_count; ++k) {
+        ReplayEvent* e = &g_events[k];
+        ReplayConn* c = &g_conns[e->conn];
+
+        // 依比例等到事件時間，等待期間持續收回覆
+        if (speed > 0.0) {
+            long long due = t0 + (long long)(e->t_ms / speed);
+            for (long long now = platform_time_ms(); now < due; now = platform_time_ms()) {
+                pump(pfds, map, (int)(due - now));
+            }
+        }
+
+        switch (e->type) {
+            case EV_CONNECT:
+                c->fd = connect_one(&addr);
+                if (c->fd < 0) connect_failed++;
+                break;
+            case EV_SEND:
+                if (c->fd >= 0) {
+                    char buf[LINE_MAX_LEN + 3];
+                    int n = snprintf(buf, sizeof(buf), "%s\r\n", e->line);
+                    if (send_all(c->fd, buf, n) == 0) {
+                        c->sent++;
+                        commands++;
+                    }
+                }
+                break;
+            case EV_CLOSE:
+                c->closing = 1;
+                c->close_deadline_ms = platform_time_ms() + CLOSE_GRACE_MS;
+                check_close(c, platform_time_ms());
+                break;
+        }
+        if (speed == 0.0 && (k & 63) == 0) pump(pfds, map, 0);
+    }
+    long long t_sent = platform_time_ms();
+
+    // 收尾：等剩下的回覆，全部收齊或逾時為止
+    long long deadline = platform_time_ms() + CLOSE_GRACE_MS;
+    for (;;) {
+        int waiting = 0;
+        for (int i = 0; i < g_conn_count; ++i) {
+            if (g_conns[i].fd >= 0 && g_conns[i].actual.n < g_conns[i].expected.n) waiting = 1;
+        }
+        if (!waiting || platform_time_ms() >= deadline) break;
+        pump(pfds, map, 10);
+    }
+    long long t_done = platform_time_ms();
+
+    long long expected = 0, received = 0, mismatches = 0;
+    int shown = 0, bad_conns = 0;
+    printf("[REPLAY] Diff against captured replies%s:\n", strict ? " (strict)" : "");
+    for (int i = 0; i < g_conn_count; ++i) {
+        ReplayConn* c = &g_conns[i];
+        expected += c->expected.n;
+        received += c->actual.n;
+        long long m = diff_conn(c, strict, &shown);
+        mismatches += m;
+        if (m) bad_conns++;
+        if (c->fd >= 0) conn_close(c);
+    }
+    if (shown == 0) printf("  (no differences)\n");
+
+    double secs = (t_done - t0) / 1000.0;
+    printf("[REPLAY] connections=%d (connect failed %lld) commands=%lld speed=%s\n",
+           g_conn_count, connect_failed, commands, speed > 0.0 ? "scaled" : "max");
+    printf("[REPLAY] send phase %lld ms, total %lld ms, %.1f commands/s\n",
+           t_sent - t0, t_done - t0, secs > 0.0 ? commands / secs : 0.0);
+    printf("[REPLAY] replies expected=%lld received=%lld mismatched=%lld in %d connections\n",
+           expected, received, mismatches, bad_conns);
+    return mismatches ? 2 : 0;
+}
@@ -0,0 +1,126 @@
+@echo off
+:: ===============================
+::  build_bench.bat - Build benchmarks (optimised)
+::  Author: DragonTaki
+:: ===============================
+cd /d %~dp0
+
+:: Setup VS environment
+call "C:\Program Files (x86)\Microsoft Visual Studio\2022\BuildTools\VC\Auxiliary\Build\vcvars64.bat"
+
+:: Create folders
+if not exist build mkdir build
+if not exist build\bench_obj mkdir build\bench_obj
+
+:: Clean old files
+del /q build\bench_obj\*.obj 2>nul
+
+echo.
+echo ==============================
+echo  Compiling src/core/*.c (/O2) ...
+echo ==============================
+
+for /R src\core %%F in (*.c) do (
+    echo Compiling %%F
+    cl ^
+     /TC ^
+     /W4 ^
+     /O2 ^
+     /utf-8 ^
+     /I"." ^
+     /I"src\core" ^
+     /c "%%F" ^
+     /Fo"build\bench_obj\%%~nF.obj" >nul
+
+    if errorlevel 1 (
+        echo Compile failed on %%F
+        exit /b 1
+    )
+)
+
+cl ^
+ /TC ^
+ /W4 ^
+ /O2 ^
+ /utf-8 ^
+ /I"." ^
+ /I"src\core" ^
+ /c src\network\protocol.c ^
+ /Fo"build\bench_obj\protocol.obj" >nul
+
+if errorlevel 1 (
+    echo Compile failed on src\network\protocol.c
+    exit /b 1
+)
+
+echo.
+echo ==============================
+echo  Building bench\kpi_bench.exe ...
+echo ==============================
+
+cl ^
+ /TC ^
+ /W4 ^
+ /O2 ^
+ /utf-8 ^
+ /I"." ^
+ /I"src\core" ^
+ bench\kpi_bench.c ^
+ build\bench_obj\*.obj ^
+ /Fo"build\kpi_bench.obj" ^
+ /Fe:build\kpi_bench.exe ^
+ ws2_32.lib
+
+if errorlevel 1 (
+    echo Build kpi_bench.exe failed.
+    exit /b 1
+)
+
+echo.
+echo ==============================
+echo  Building bench\micro_bench.exe ...
+echo ==============================
+
+cl ^
+ /TC ^
+ /W4 ^
+ /O2 ^
+ /utf-8 ^
+ /I"." ^
+ /I"src\core" ^
+ bench\micro_bench.c ^
+ build\bench_obj\*.obj ^
+ /Fo"build\micro_bench.obj" ^
+ /Fe:build\micro_bench.exe ^
+ ws2_32.lib
+
+if errorlevel 1 (
+    echo Build micro_bench.exe failed.
+    exit /b 1
+)
+
+echo.
+echo ==============================
+echo  Building bench\handoff_check.exe ...
+echo ==============================
+
+cl ^
+ /TC ^
+ /W4 ^
+ /O2 ^
+ /utf-8 ^
+ /I"." ^
+ /I"src\core" ^
+ bench\handoff_check.c ^
+ build\bench_obj\*.obj ^
+ /Fo"build\handoff_check.obj" ^
+ /Fe:build\handoff_check.exe ^
+ ws2_32.lib
+
+if errorlevel 1 (
+    echo Build handoff_check.exe failed.
+    exit /b 1
+)
+
+echo.
+echo Build successful: build\kpi_bench.exe build\micro_bench.exe build\handoff_check.exe
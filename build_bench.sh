@@ -0,0 +1,48 @@
+# ----- ----- ----- -----
+# build_bench.sh
+# Do not distribute or modify
+# Author: DragonTaki (https://github.com/DragonTaki)
+# Create Date: 2026/10/18
+# Update Date: 2026/10/18
+# Version: v1.0
+# ----- ----- ----- -----
+
+#!/bin/bash
+
+# ----- Config -----
+CC="${CC:-gcc}"
+# 額外旗標可由環境變數帶入，例如 EXTRA_CFLAGS="-DMAX_FLOORS=400" 觀察樓層上限的影響
+CFLAGS="-std=gnu11 -O2 -Wall -Wextra -Wno-unused-parameter -I. -Isrc/core $EXTRA_CFLAGS"
+OBJ_DIR="build/bench_obj"
+
+# Exit immediately on error
+set -e
+cd "$(dirname "$0")"
+
+mkdir -p "$OBJ_DIR"
+rm -f "$OBJ_DIR"/*.o
+
+echo "===== Compiling src/core/*.c ====="
+for f in src/core/*.c; do
+    echo "Compiling $f"
+    $CC $CFLAGS -c "$f" -o "$OBJ_DIR/$(basename "$f" .c).o"
+done
+
+$CC $CFLAGS -c src/network/protocol.c -o "$OBJ_DIR/protocol.o"
+
+echo "===== Building build/kpi_bench ====="
+$CC $CFLAGS bench/kpi_bench.c "$OBJ_DIR"/*.o -o build/kpi_bench -lpthread -lm
+
+echo "===== Building build/micro_bench ====="
+$CC $CFLAGS bench/micro_bench.c "$OBJ_DIR"/*.o -o build/micro_bench -lpthread -lm
+
+echo "===== Building build/load_client ====="
+$CC $CFLAGS bench/load_client.c "$OBJ_DIR"/traffic_model.o "$OBJ_DIR"/server_events.o "$OBJ_DIR"/platform_posix.o -o build/load_client -lpthread -lm -lrt
+
+echo "===== Building build/trace_replay ====="
+$CC $CFLAGS bench/trace_replay.c "$OBJ_DIR"/platform_posix.o -o build/trace_replay -lpthread -lrt
+
+echo "===== Building build/handoff_check ====="
+$CC $CFLAGS bench/handoff_check.c "$OBJ_DIR"/*.o -o build/handoff_check -lpthread -lm
+
+echo "Build successful: build/kpi_bench build/micro_bench build/load_client build/trace_replay build/handoff_check"
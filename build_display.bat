@@ -0,0 +1,20 @@
+@echo off
+cd /d %~dp0
+call "C:\Program Files (x86)\Microsoft Visual Studio\2022\BuildTools\VC\Auxiliary\Build\vcvars64.bat"
+
+if not exist build mkdir build
+
+cl ^
+ /TC ^
+ /W4 ^
+ /Od ^
+ /Zi ^
+ /utf-8 ^
+ /I"." ^
+ /I"src\core" ^
+ display_client.c ^
+ src\core\status_shm.c ^
+ src\core\platform_win.c ^
+ /Fe:build\display_client.exe ^
+ /Fd:build\display_client.pdb ^
+ ws2_32.lib
@@ -0,0 +1,81 @@
+/* ----- ----- ----- ----- */
+// display_client.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+/* 同主機樓層顯示器範例：直接讀取 server 的共享記憶體狀態，不需要 TCP 連線 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/core/platform.h"
+#include "src/core/status_shm.h"
+
+#define POLL_MS 100
+
+static const char* state_name(int s) {
+    switch (s) {
+        case TASK_IDLE:         return "IDLE";
+        case TASK_PREPARE:      return "PREPARE";
+        case TASK_MOVING:       return "MOVING";
+        case TASK_ARRIVED:      return "ARRIVED";
+        case TASK_DOOR_OPENING: return "OPENING";
+        case TASK_DOOR_OPEN:    return "DOOR_OPEN";
+        case TASK_DOOR_CLOSING: return "CLOSING";
+        default:                return "ERROR";
+    }
+}
+
+/* 印出一台電梯：樓層、方向燈、門、所有停靠樓層 */
+static void print_car(const StatusShmCar* c, int floors) {
+    const char* arrow = (c->direction == DIR_UP) ? "^" : (c->direction == DIR_DOWN) ? "v" : "-";
+    printf("  E%d  floor %3d %s  target %3d  %-9s", c->id, c->current_floor, arrow, c->target_floor, state_name(c->task_state));
+    if (c->task_state == TASK_DOOR_OPEN) printf(" (%d ms)", c->door_remaining_ms);
+    printf("  stops:");
+    for (int f = 0; f < floors; ++f) {
+        int up = STATUS_SHM_BIT(c->call_up, f);
+        int down = STATUS_SHM_BIT(c->call_down, f);
+        int in = STATUS_SHM_BIT(c->inside, f);
+        if (up || down || in) printf(" %d%s%s%s", f, up ? "^" : "", down ? "v" : "", in ? "*" : "");
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = STATUS_SHM_DEFAULT_NAME;
+    int once = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--once") == 0) once = 1;
+        else name = argv[i];
+    }
+
+    StatusShmReader* r = status_shm_reader_open(name);
+    if (!r) {
+        printf("[DISPLAY] Cannot open status segment %s (is the server running with --status-shm?)\n", name);
+        return 1;
+    }
+
+    StatusShmSegment snap;
+    for (;;) {
+        int rc = status_shm_read(r, &snap);
+        if (rc == 1) {
+            int floors = (int)snap.header.floor_count;
+            if (floors > MAX_FLOORS) floors = MAX_FLOORS;
+            printf("=== tick %u ===\n", (unsigned)snap.header.tick);
+            for (unsigned i = 0; i < snap.header.car_count; ++i) print_car(&snap.cars[i], floors);
+            fflush(stdout);
+            if (once) break;
+        } else if (rc < 0) {
+            printf("[DISPLAY] Segment busy, retrying\n");
+        }
+        platform_sleep_ms(POLL_MS);
+    }
+
+    status_shm_reader_close(r);
+    return 0;
+}
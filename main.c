@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/22
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #define _CRT_SECURE_NO_WARNINGS
@@ -12,11 +12,55 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "src/core/building.h"
+#include "src/core/core_log.h"
 #include "src/core/elevator.h"
 #include "src/core/platform.h"
+#include "src/core/scheduler.h"
+#include "src/core/server_core.h"
 
-/* Forward: implemented in remote_server.c */
-void run_remote_server(int port);
+#include "src/network/remote_server.h"
+
+static void print_usage(const char* prog) {
+    printf("Usage:\n");
+    printf("  %s [port] [--journal <file>] [--checkpoint <file>] [--trajectory <file>]\n", prog);
+    printf("        [--upgrade-socket <path>] [--takeover <path>] [--status-shm [name]] [--quiet]\n");
+    printf("        [--trace <file>] [--policy greedy|eta|rollout] [--redispatch <calls/tick>] [--wait-slo <s>]\n");
+    printf("        [--buildings <n>] [--workers <n>] [--building <file>] [--park] [--demand <file>]\n");
+    printf("        [--no-traffic-modes] [--rollout-horizon <s>] [--rollout-workers <n>] [--optimize]\n");
+    printf("  %s replay <journal> [--trajectory <file>] [--policy greedy|eta|rollout] [--redispatch <calls/tick>]\n", prog);
+    printf("        [--building <file>] [--no-traffic-modes]\n");
+}
+
+/* 重播模式：以虛擬時間全速重跑事件日誌 */
+static int run_replay(const char* journal_path, const char* traj_path, const BuildingDesc* desc) {
+    FILE* traj = NULL;
+    if (traj_path) {
+        traj = fopen(traj_path, "w");
+        if (!traj) {
+            printf("[MAIN] Cannot open trajectory file %s\n", traj_path);
+            return 1;
+        }
+    }
+
+    core_log_set_enabled(0);
+    server_core_init_desc(1, desc);
+    server_core_set_trajectory_log(traj);
+
+    long long t0 = platform_time_ms();
+    int n = server_core_replay(journal_path);
+    long long t1 = platform_time_ms();
+
+    server_core_set_trajectory_log(NULL);
+    if (traj) fclose(traj);
+
+    if (n < 0) {
+        printf("[MAIN] Replay failed: %s\n", journal_path);
+        return 1;
+    }
+    printf("[MAIN] Replayed %d events, %u ticks in %lld ms\n", n, (unsigned)server_core_get_tick(), t1 - t0);
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
     /* configure elevator set here */
@@ -24,12 +68,176 @@ int main(int argc, char* argv[]) {
 
     /* choose port (optional argument) */
     int port = 5555;
-    if (argc >= 2) {
-        port = atoi(argv[1]);
-        if (port <= 0) port = 5555;
+    const char* journal_path = NULL;
+    const char* checkpoint_path = NULL;
+    const char* traj_path = NULL;
+    const char* replay_path = NULL;
+    const char* upgrade_path = NULL;
+    const char* trace_path = NULL;
+    const char* demand_path = NULL;
+    int takeover = 0;
+    int status_shm = 0;
+    const char* status_shm_name = NULL;
+    int buildings = 1;
+    int workers = 0;
+    BuildingDesc desc;
+    building_desc_default(&desc, BUILDING_DEFAULT_FLOORS, elevator_count);
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--trajectory") == 0 && i + 1 < argc) {
+            traj_path = argv[++i];
+        } else if (strcmp(argv[i], "--upgrade-socket") == 0 && i + 1 < argc) {
+            upgrade_path = argv[++i];
+        } else if (strcmp(argv[i], "--takeover") == 0 && i + 1 < argc) {
+            upgrade_path = argv[++i];
+            takeover = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            // 派車策略（重播時要與錄製時相同，軌跡才會一致）
+            const char* name = argv[++i];
+            int p = 0;
+            while (p < SCHED_POLICY_COUNT && strcmp(name, Scheduler_policy_name((SchedulerPolicy)p)) != 0) ++p;
+            if (p == SCHED_POLICY_COUNT) {
+                printf("[MAIN] Unknown policy %s\n", name);
+                print_usage(argv[0]);
+                return 1;
+            }
+            Scheduler_set_policy((SchedulerPolicy)p);
+        } else if (strcmp(argv[i], "--rollout-horizon") == 0 && i + 1 < argc) {
+            // rollout 策略往前模擬幾秒
+            Scheduler_set_rollout(atof(argv[++i]), 0);
+        } else if (strcmp(argv[i], "--rollout-workers") == 0 && i + 1 < argc) {
+            // rollout 策略每次派車用幾條執行緒（含 core 執行緒）
+            Scheduler_set_rollout(0.0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--optimize") == 0) {
+            // 背景執行緒持續改善整體外呼指派，核心在 tick 之間套用（結果依 CPU 餘裕而定，重播不保證一致）
+            server_core_set_optimizer(0);
+        } else if (strcmp(argv[i], "--redispatch") == 0 && i + 1 < argc) {
+            // 每個 tick 重新評估幾筆已指派的外呼（0 = 關閉；重播時同樣要與錄製時相同）
+            Scheduler_set_redispatch(atoi(argv[++i]), -1.0);
+        } else if (strcmp(argv[i], "--wait-slo") == 0 && i + 1 < argc) {
+            // 外呼等待超過幾秒就強制改派並告警（0 = 關閉）
+            Scheduler_set_wait_slo(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--buildings") == 0 && i + 1 < argc) {
+            // 同一行程內跑多棟獨立大樓（ROLE ... B<n> 指定大樓）
+            buildings = atoi(argv[++i]);
+            if (buildings < 1 || buildings > MAX_BUILDINGS) {
+                printf("[MAIN] --buildings must be 1..%d\n", MAX_BUILDINGS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--building") == 0 && i + 1 < argc) {
+            // 大樓描述（樓層數、電梯數、各台速率 / 開門時間 / 停靠樓層）；重播時要與錄製時相同
+            if (building_desc_load(argv[++i], &desc) != 0) return 1;
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            // 多棟大樓時的工作執行緒數（0 = 依 CPU 數）
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-traffic-modes") == 0) {
+            // 不自動判斷交通型態（固定一般模式；重播時同樣要與錄製時相同）
+            Scheduler_set_traffic_modes(0);
+        } else if (strcmp(argv[i], "--park") == 0) {
+            // 預測停靠：閒置電梯移到預估接下來會被呼叫的樓層（重播時同樣要與錄製時相同）
+            Scheduler_set_parking(1);
+        } else if (strcmp(argv[i], "--demand") == 0 && i + 1 < argc) {
+            // 各樓層到達率存檔（重啟後沿用學到的需求）
+            demand_path = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            core_log_set_enabled(0);  // 關閉每個請求 / 連線的記錄（壓力測試用）
+        } else if (strcmp(argv[i], "--status-shm") == 0) {
+            status_shm = 1;
+            if (i + 1 < argc && argv[i + 1][0] == '/') status_shm_name = argv[++i];
+        } else if (argv[i][0] != '-') {
+            port = atoi(argv[i]);
+            if (port <= 0) port = 5555;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 日誌、存檔、共享記憶體、軌跡與熱升級都只涵蓋單一大樓
+    if (buildings > 1 && (replay_path || journal_path || checkpoint_path || upgrade_path || status_shm || traj_path ||
+                          demand_path)) {
+        printf("[MAIN] --buildings > 1 cannot be combined with replay, --journal, --checkpoint, --trajectory,\n");
+        printf("       --status-shm, --demand, --upgrade-socket or --takeover\n");
+        return 1;
+    }
+
+    if (replay_path) {
+        return run_replay(replay_path, traj_path, &desc);
     }
 
-    server_core_init(elevator_count);
+    if (server_core_init_desc(buildings, &desc) != 0) {
+        printf("[MAIN] Cannot initialise %d buildings\n", buildings);
+        return 1;
+    }
+    server_core_set_workers(workers);
+    printf("[MAIN] Building: %d floors, %d cars (%d shafts)\n", desc.floors, desc.cars, desc.max_cars);
+    if (buildings > 1) printf("[MAIN] Campus mode: %d buildings\n", buildings);
+
+    /* 熱升級：從舊行程接手核心狀態與所有連線 */
+    if (takeover && remote_server_takeover(upgrade_path) != 0) {
+        printf("[MAIN] Takeover from %s failed\n", upgrade_path);
+        return 1;
+    }
+    if (upgrade_path) remote_server_enable_upgrade(upgrade_path);
+
+    if (trace_path) {
+        if (remote_server_enable_trace(trace_path) != 0) {
+            printf("[MAIN] Cannot open trace file %s\n", trace_path);
+            return 1;
+        }
+        printf("[MAIN] Capturing client traffic to %s\n", trace_path);
+    }
+
+    if (checkpoint_path) {
+        int rc = server_core_enable_checkpoint(checkpoint_path, 0);
+        if (rc < 0) {
+            printf("[MAIN] Cannot open checkpoint %s\n", checkpoint_path);
+            return 1;
+        }
+        printf("[MAIN] Checkpointing core state to %s (%s)\n", checkpoint_path,
+               rc ? "restored" : (takeover ? "taken over" : "fresh"));
+    }
+
+    /* 日誌從存檔還原 / 接手後的狀態開始記，要在它們之後開啟 */
+    if (journal_path) {
+        if (server_core_enable_journal(journal_path) != 0) {
+            printf("[MAIN] Cannot open journal %s\n", journal_path);
+            return 1;
+        }
+        printf("[MAIN] Journaling accepted events to %s\n", journal_path);
+    }
+
+    if (status_shm) {
+        if (server_core_enable_status_shm(status_shm_name) != 0) {
+            printf("[MAIN] Cannot create status shared memory\n");
+            return 1;
+        }
+        printf("[MAIN] Publishing status to shared memory %s\n",
+               status_shm_name ? status_shm_name : "(default)");
+    }
+
+    if (demand_path) {
+        int rc = server_core_enable_demand(demand_path);
+        if (rc < 0) {
+            printf("[MAIN] Cannot use demand model %s\n", demand_path);
+            return 1;
+        }
+        printf("[MAIN] Learning hall-call demand in %s (%s)\n", demand_path, rc ? "restored" : "fresh");
+    }
+
+    FILE* traj = NULL;
+    if (traj_path) {
+        traj = fopen(traj_path, "w");
+        server_core_set_trajectory_log(traj);
+    }
 
     /* 設定狀態回呼（未實作） */
     // server_core_set_status_callback(my_status_handler);
@@ -47,6 +255,11 @@ int main(int argc, char* argv[]) {
     server_core_stop();
     server_core_join();
 
+    if (traj) {
+        server_core_set_trajectory_log(NULL);
+        fclose(traj);
+    }
+
     printf("[MAIN] Server stopped. Exiting.\n");
     return 0;
 }
@@ -0,0 +1,263 @@
+/* ----- ----- ----- ----- */
+// building.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include "building.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_MAX_LEN 512
+
+/* 單台電梯在設定檔中覆寫過的欄位 */
+#define SET_SPEED  0x1u
+#define SET_DOOR   0x2u
+#define SET_START  0x4u
+#define SET_SERVES 0x8u
+#define SET_CAPACITY 0x10u
+
+static void served_all(uint64_t* served, int floors) {
+    memset(served, 0, sizeof(uint64_t) * STOPSET_WORDS);
+    for (int f = 0; f < floors; ++f) served[f >> 6] |= (uint64_t)1 << (f & 63);
+}
+
+void building_desc_default(BuildingDesc* d, int floors, int cars)
+{
+    if (!d) return;
+    if (floors < 2) floors = 2;
+    if (floors > MAX_FLOORS) floors = MAX_FLOORS;
+    if (cars < 1) cars = 1;
+    if (cars > MAX_ELEVATORS) cars = MAX_ELEVATORS;
+    memset(d, 0, sizeof(*d));
+    d->floors = floors;
+    d->cars = cars;
+    d->max_cars = (cars + BUILDING_DEFAULT_SPARE_CARS < MAX_ELEVATORS) ? cars + BUILDING_DEFAULT_SPARE_CARS : MAX_ELEVATORS;
+    for (int i = 0; i < d->max_cars; ++i) {
+        CarDesc* c = &d->car[i];
+        c->speed_fps = DEFAULT_SPEED_FPS;
+        c->door_open_s = DEFAULT_DOOR_OPEN_S;
+        c->start_floor = (BUILDING_DEFAULT_START_FLOOR < floors) ? BUILDING_DEFAULT_START_FLOOR : 0;
+        served_all(c->served, floors);
+    }
+}
+
+/* ---------------------------
+   Config file
+   --------------------------- */
+
+static int parse_int(const char* s, int* out) {
+    char* end = NULL;
+    long v = strtol(s, &end, 10);
+    if (!s[0] || *end) return -1;
+    *out = (int)v;
+    return 0;
+}
+
+static int parse_double(const char* s, double* out) {
+    char* end = NULL;
+    double v = strtod(s, &end);
+    if (!s[0] || *end) return -1;
+    *out = v;
+    return 0;
+}
+
+/* "0,20-39" => 設定 served 的位元（不檢查上限，讀完整個檔案才知道樓層數） */
+static int parse_serves(char* s, uint64_t* served) {
+    memset(served, 0, sizeof(uint64_t) * STOPSET_WORDS);
+    for (char* tok = strtok(s, ","); tok; tok = strtok(NULL, ",")) {
+        int lo, hi;
+        char* dash = strchr(tok, '-');
+        if (dash) {
+            *dash = '\0';
+            if (parse_int(tok, &lo) != 0 || parse_int(dash + 1, &hi) != 0) return -1;
+        } else {
+            if (parse_int(tok, &lo) != 0) return -1;
+            hi = lo;
+        }
+        if (lo < 0 || hi < lo || hi >= MAX_FLOORS) return -1;
+        for (int f = lo; f <= hi; ++f) served[f >> 6] |= (uint64_t)1 << (f & 63);
+    }
+    return 0;
+}
+
+/* 切出下一個以空白分隔的字詞 */
+static char* next_word(char** p) {
+    char* s = *p;
+    while (*s && isspace((unsigned char)*s)) ++s;
+    if (!*s) return NULL;
+    char* w = s;
+    while (*s && !isspace((unsigned char)*s)) ++s;
+    if (*s) *s++ = '\0';
+    *p = s;
+    return w;
+}
+
+/* 讀取大樓設定檔 */
+int building_desc_load(const char* path, BuildingDesc* d)
+{
+    if (!path || !d) return -1;
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        printf("[BUILDING] cannot open %s\n", path);
+        return -1;
+    }
+
+    BuildingDesc out;
+    memset(&out, 0, sizeof(out));
+    out.floors = BUILDING_DEFAULT_FLOORS;
+    out.cars = 0;
+    CarDesc def;
+    memset(&def, 0, sizeof(def));
+    def.speed_fps = DEFAULT_SPEED_FPS;
+    def.door_open_s = DEFAULT_DOOR_OPEN_S;
+    def.start_floor = BUILDING_DEFAULT_START_FLOOR;
+    unsigned set[MAX_ELEVATORS] = {0};
+    int max_car = -1;
+
+    char line[LINE_MAX_LEN];
+    int lineno = 0;
+    const char* err = NULL;
+    while (!err && fgets(line, sizeof(line), fp)) {
+        ++lineno;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char* p = line;
+        char* key = next_word(&p);
+        if (!key) continue;
+        char* val = next_word(&p);
+        if (!val) {
+            err = "missing value";
+            break;
+        }
+
+        if (strcmp(key, "floors") == 0) {
+            if (parse_int(val, &out.floors) != 0 || out.floors < 2 || out.floors > MAX_FLOORS) err = "floors out of range";
+        } else if (strcmp(key, "cars") == 0) {
+            if (parse_int(val, &out.cars) != 0 || out.cars < 1 || out.cars > MAX_ELEVATORS) err = "cars out of range";
+        } else if (strcmp(key, "max_cars") == 0) {
+            if (parse_int(val, &out.max_cars) != 0 || out.max_cars < 1 || out.max_cars > MAX_ELEVATORS) err = "max_cars out of range";
+        } else if (strcmp(key, "speed") == 0) {
+            if (parse_double(val, &def.speed_fps) != 0 || def.speed_fps <= 0.0) err = "speed must be > 0";
+        } else if (strcmp(key, "door") == 0) {
+            if (parse_double(val, &def.door_open_s) != 0 || def.door_open_s <= 0.0) err = "door must be > 0";
+        } else if (strcmp(key, "start") == 0) {
+            if (parse_int(val, &def.start_floor) != 0 || def.start_floor < 0) err = "bad start floor";
+        } else if (strcmp(key, "capacity") == 0) {
+            if (parse_int(val, &def.capacity) != 0 || def.capacity < 0) err = "capacity must be >= 0";
+        } else if (strcmp(key, "car") == 0) {
+            int i;
+            if (parse_int(val, &i) != 0 || i < 0 || i >= MAX_ELEVATORS) {
+                err = "car index out of range";
+                break;
+            }
+            if (i > max_car) max_car = i;
+            CarDesc* c = &out.car[i];
+            char* k;
+            while (!err && (k = next_word(&p)) != NULL) {
+                char* v = next_word(&p);
+                if (!v) err = "missing value";
+                else if (strcmp(k, "speed") == 0) {
+                    if (parse_double(v, &c->speed_fps) != 0 || c->speed_fps <= 0.0) err = "speed must be > 0";
+                    set[i] |= SET_SPEED;
+                } else if (strcmp(k, "door") == 0) {
+                    if (parse_double(v, &c->door_open_s) != 0 || c->door_open_s <= 0.0) err = "door must be > 0";
+                    set[i] |= SET_DOOR;
+                } else if (strcmp(k, "start") == 0) {
+                    if (parse_int(v, &c->start_floor) != 0 || c->start_floor < 0) err = "bad start floor";
+                    set[i] |= SET_START;
+                } else if (strcmp(k, "capacity") == 0) {
+                    if (parse_int(v, &c->capacity) != 0 || c->capacity < 0) err = "capacity must be >= 0";
+                    set[i] |= SET_CAPACITY;
+                } else if (strcmp(k, "serves") == 0) {
+                    if (parse_serves(v, c->served) != 0) err = "bad serves list";
+                    set[i] |= SET_SERVES;
+                } else {
+                    err = "unknown car setting";
+                }
+            }
+        } else {
+            err = "unknown setting";
+        }
+    }
+    fclose(fp);
+
+    // 樓層數 / 電梯數確定之後才能檢查各台電梯
+    if (!err) {
+        lineno = 0;
+        if (out.cars == 0) out.cars = (max_car >= 0) ? max_car + 1 : 1;
+        if (out.max_cars == 0) {
+            out.max_cars = out.cars + BUILDING_DEFAULT_SPARE_CARS;
+            if (out.max_cars > MAX_ELEVATORS) out.max_cars = MAX_ELEVATORS;
+            if (out.max_cars <= max_car) out.max_cars = max_car + 1;
+        }
+        if (out.cars > out.max_cars) err = "cars > max_cars";
+        if (max_car >= out.max_cars) err = "car index >= max_cars";
+        if (def.start_floor >= out.floors) err = "start floor outside the building";
+    }
+    for (int i = 0; !err && i < out.max_cars; ++i) {
+        CarDesc* c = &out.car[i];
+        if (!(set[i] & SET_SPEED)) c->speed_fps = def.speed_fps;
+        if (!(set[i] & SET_DOOR)) c->door_open_s = def.door_open_s;
+        if (!(set[i] & SET_START)) c->start_floor = def.start_floor;
+        if (!(set[i] & SET_CAPACITY)) c->capacity = def.capacity;
+        if (!(set[i] & SET_SERVES)) served_all(c->served, out.floors);
+        if (c->start_floor >= out.floors) err = "car start floor outside the building";
+
+        int any = 0;
+        for (int f = 0; f < MAX_FLOORS; ++f) {
+            if (!StopSet_get(c->served, f)) continue;
+            if (f >= out.floors) err = "served floor outside the building";
+            any = 1;
+        }
+        if (!any) err = "car serves no floor";
+    }
+
+    if (err) {
+        if (lineno > 0) printf("[BUILDING] %s:%d: %s\n", path, lineno, err);
+        else printf("[BUILDING] %s: %s\n", path, err);
+        return -1;
+    }
+    *d = out;
+    return 0;
+}
+
+/* ---------------------------
+   Cars
+   --------------------------- */
+
+void building_configure_car(const BuildingDesc* d, int car, Elevator* e)
+{
+    if (!d || !e || car < 0 || car >= d->max_cars) return;
+    const CarDesc* c = &d->car[car];
+    Elevator_init(e, car, c->start_floor);
+    Elevator_configure(e, d->floors, c->speed_fps, c->door_open_s, c->served);
+    e->capacity = c->capacity;
+}
+
+void building_apply_car(const BuildingDesc* d, int car, Elevator* e)
+{
+    if (!d || !e || car < 0 || car >= d->max_cars) return;
+    // 存檔來自較高的大樓 => 位置已不合法，只能從頭開始
+    if (e->current_floor < 0 || e->current_floor >= d->floors || e->target_floor >= d->floors) {
+        building_configure_car(d, car, e);
+        return;
+    }
+    const CarDesc* c = &d->car[car];
+    Elevator_configure(e, d->floors, c->speed_fps, c->door_open_s, c->served);
+    e->capacity = c->capacity;
+}
+
+int building_floor_served(const BuildingDesc* d, int floor)
+{
+    if (!d || floor < 0 || floor >= d->floors) return 0;
+    for (int i = 0; i < d->cars; ++i) {
+        if (StopSet_get(d->car[i].served, floor)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* ----- ----- ----- ----- */
+// building.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elevator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Runtime description of one building: floor count, car count and per-car
+ * speed, door time, start floor and served floors. MAX_FLOORS /
+ * MAX_ELEVATORS are only compile-time ceilings; every per-building table in
+ * the core is sized from the description.
+ *
+ * Config file (one setting per line, '#' starts a comment):
+ *
+ *     floors 40
+ *     cars 6
+ *     max_cars 8                # shafts: cars that can be added at runtime
+ *     speed 2.0                 # defaults for every car
+ *     door 3.0
+ *     start 1
+ *     capacity 13               # rated passengers (0 = not limited)
+ *     car 2 speed 4 door 2 start 0 capacity 20 serves 0,20-39
+ *
+ * Building-wide settings apply to every car that does not override them on
+ * its own `car <index>` line (index < max_cars); `serves` defaults to every
+ * floor. max_cars defaults to cars + BUILDING_DEFAULT_SPARE_CARS.
+ */
+
+#define BUILDING_DEFAULT_FLOORS 100  // 沒有設定檔時的樓層數（與原本的固定上限相同）
+#define BUILDING_DEFAULT_START_FLOOR 1
+#define BUILDING_DEFAULT_SPARE_CARS 2  // 預留可在執行中加入的電梯數
+
+/* 單台電梯的設定 */
+typedef struct {
+    double speed_fps;                // 運行速率（層 / 秒）
+    double door_open_s;              // 每次停靠開門時長（秒）
+    int start_floor;                 // 啟動時所在樓層
+    int capacity;                    // 額定載客人數（0 = 不限）
+    uint64_t served[STOPSET_WORDS];  // 可停靠的樓層（bit f = 第 f 層）
+} CarDesc;
+
+/* 大樓描述 */
+typedef struct {
+    int floors;                      // 樓層數（2 .. MAX_FLOORS）
+    int cars;                        // 啟動時的電梯數（1 .. max_cars）
+    int max_cars;                    // 電梯井數：執行中最多可加到幾台（<= MAX_ELEVATORS，各表依此配置）
+    CarDesc car[MAX_ELEVATORS];      // 只有前 max_cars 台有效
+} BuildingDesc;
+
+/* Every car uses the default speed / door time, starts at floor 1, has no
+ * capacity limit and serves every floor. `floors` / `cars` are clamped to the ceilings;
+ * max_cars = cars + BUILDING_DEFAULT_SPARE_CARS (clamped).
+ */
+void building_desc_default(BuildingDesc* d, int floors, int cars);
+
+/* Load a config file. Returns 0, or -1 (with the offending line printed)
+ * if the file cannot be read or a setting is invalid; *d is only written on
+ * success.
+ */
+int building_desc_load(const char* path, BuildingDesc* d);
+
+/* Initialise `e` as car `car` of the building (id = car, car < max_cars),
+ * including its capacity. */
+void building_configure_car(const BuildingDesc* d, int car, Elevator* e);
+
+/* Re-apply the car's speed, door time, capacity and served floors to a car restored
+ * from a snapshot, keeping its position and calls on served floors.
+ */
+void building_apply_car(const BuildingDesc* d, int car, Elevator* e);
+
+/* Whether any car of the building stops at `floor`. */
+int building_floor_served(const BuildingDesc* d, int floor);
+
+/* ---------------------------
+   Arena layout
+   --------------------------- */
+
+/* One allocation per building: lay the tables out twice with the same
+ * sequence of building_arena_take calls, first with base = NULL to measure
+ * (takes return NULL), then into malloc(used) bytes.
+ */
+typedef struct {
+    unsigned char* base;
+    size_t used;
+} BuildingArena;
+
+#define BUILDING_ARENA_ALIGN 16
+
+static inline void* building_arena_take(BuildingArena* a, size_t bytes) {
+    size_t at = (a->used + (BUILDING_ARENA_ALIGN - 1)) & ~(size_t)(BUILDING_ARENA_ALIGN - 1);
+    a->used = at + bytes;
+    return a->base ? a->base + at : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUILDING_H */
@@ -0,0 +1,358 @@
+/* ----- ----- ----- ----- */
+// checkpoint.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include "checkpoint.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+/*
+ * 檔案配置：
+ *   [0, 64)              檔頭：magic | version | slot_size | 保留
+ *   [16, 32) / [32, 48)  slot 描述：u64 seq | u32 len | u32 crc（crc 涵蓋 seq、len 與資料）
+ *   [64, 64+S)           slot 0 資料
+ *   [64+S, 64+2S)        slot 1 資料
+ */
+#define CKP_HEADER_SIZE 64
+#define CKP_DESC_OFFSET 16
+#define CKP_DESC_SIZE 16
+#define CKP_SLOT_SIZE (((CHECKPOINT_MAX_PAYLOAD) + 63) / 64 * 64)
+#define CKP_FILE_SIZE (CKP_HEADER_SIZE + 2 * CKP_SLOT_SIZE)
+
+#define CKP_BITSET_BYTES(floors) (((floors) + 7) / 8)  // 依大樓樓層數（存在快照檔頭）
+#define CKP_PENDING_SIZE 28   // floor | type | source | to_floor | f64 enqueue_s | request_id
+#define CKP_V3_PENDING_SIZE 24  // v2 / v3 沒有 request_id
+#define CKP_CAR_SIZE 48       // id | floor | target | state | dir | f64 door | f64 speed | f64 accum | u32 flags
+#define CKP_V2_CAR_SIZE 44    // v1 / v2 沒有 flags
+#define CKP_CAR_IN_SERVICE 0x1u
+#define CKP_V1_TICK_S 0.1     // v1 存檔（熱升級時舊版送來的狀態）只會來自 0.1 秒 tick 的核心
+
+struct CheckpointFile {
+    PlatformMap* map;
+    unsigned char* base;
+    uint64_t seq;       // 目前有效 slot 的序號
+    int current_slot;   // 目前有效 slot（-1 表示沒有）
+};
+
+/* ---------------------------
+   Encoding helpers
+   --------------------------- */
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    put_u32(p, (uint32_t)(v & 0xFFFFFFFFu));
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static void put_f64(unsigned char* p, double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    put_u64(p, v);
+}
+
+static double get_f64(const unsigned char* p) {
+    uint64_t v = get_u64(p);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+static void put_bits(unsigned char* p, const bool* flags, int floors) {
+    memset(p, 0, CKP_BITSET_BYTES(floors));
+    for (int f = 0; f < floors; ++f) {
+        if (flags[f]) p[f >> 3] |= (unsigned char)(1u << (f & 7));
+    }
+}
+
+static void get_bits(const unsigned char* p, bool* flags, int floors) {
+    for (int f = 0; f < floors; ++f) {
+        flags[f] = (p[f >> 3] >> (f & 7)) & 1u;
+    }
+}
+
+/* CRC32（IEEE），查表於第一次使用時建立 */
+static uint32_t crc32_update(uint32_t crc, const unsigned char* p, size_t n) {
+    static uint32_t table[256];
+    static int table_ready = 0;
+    if (!table_ready) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+        table_ready = 1;
+    }
+    crc = ~crc;
+    while (n--) crc = table[(crc ^ *p++) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
+
+/* ---------------------------
+   Snapshot encode / decode
+   --------------------------- */
+
+/* 將核心狀態編碼進 out */
+int checkpoint_encode(const Elevator* elevators, int count, const RequestQueue* pending,
+                      const SchedulerState* sched, uint32_t tick, unsigned char* out, int cap)
+{
+    if (!elevators || !pending || !out || count < 0 || count > MAX_ELEVATORS) return -1;
+    // 同一棟大樓各台電梯的樓層數相同
+    int floors = (count > 0) ? elevators[0].floors : MAX_FLOORS;
+    const int bits = CKP_BITSET_BYTES(floors);
+    int need = 16 + count * (CKP_CAR_SIZE + 3 * bits) + 4 + pending->count * CKP_PENDING_SIZE + 4;
+    if (need > cap) return -1;
+
+    unsigned char* p = out;
+    put_u32(p, CHECKPOINT_VERSION);
+    put_u32(p + 4, (uint32_t)count);
+    put_u32(p + 8, (uint32_t)floors);
+    put_u32(p + 12, tick);
+    p += 16;
+
+    for (int i = 0; i < count; ++i) {
+        const Elevator* e = &elevators[i];
+        put_u32(p, (uint32_t)e->id);
+        put_u32(p + 4, (uint32_t)e->current_floor);
+        put_u32(p + 8, (uint32_t)e->target_floor);
+        put_u32(p + 12, (uint32_t)e->task_state);
+        put_u32(p + 16, (uint32_t)e->direction);
+        put_f64(p + 20, e->door_timer_s);
+        put_f64(p + 28, e->speed_fps);
+        put_f64(p + 36, Elevator_get_accum_time(e));
+        put_u32(p + 44, e->in_service ? CKP_CAR_IN_SERVICE : 0u);
+        p += CKP_CAR_SIZE;
+        put_bits(p, e->call_up, floors);
+        put_bits(p + bits, e->call_down, floors);
+        put_bits(p + 2 * bits, e->inside, floors);
+        p += 3 * bits;
+    }
+
+    // pending queue 依 FIFO 順序寫出
+    put_u32(p, (uint32_t)pending->count);
+    p += 4;
+    for (int k = 0; k < pending->count; ++k) {
+        const PendingRequest* r = &pending->items[(pending->head + k) % MAX_REQUESTS];
+        put_u32(p, (uint32_t)r->floor);
+        put_u32(p + 4, (uint32_t)r->type);
+        put_u32(p + 8, (uint32_t)r->source_id);
+        put_u32(p + 12, (uint32_t)r->to_floor);
+        put_f64(p + 16, r->enqueue_s);
+        put_u32(p + 24, r->request_id);
+        p += CKP_PENDING_SIZE;
+    }
+
+    // 排程器追蹤的外呼（訂閱者的請求 ID 等），長度在前
+    int slen = 0;
+    if (sched) {
+        slen = Scheduler_encode_state(sched, p + 4, cap - (int)(p + 4 - out));
+        if (slen < 0) return -1;
+    }
+    put_u32(p, (uint32_t)slen);
+    p += 4 + slen;
+    return (int)(p - out);
+}
+
+/* 由 in 解碼核心狀態 */
+int checkpoint_decode(const unsigned char* in, int len, Elevator* elevators, int* count,
+                      RequestQueue* pending, SchedulerState* sched, uint32_t* tick)
+{
+    if (!in || !elevators || !count || !pending || len < 16) return -1;
+    // v1 的 pending 沒有進佇列時間（每筆 16 bytes），還原時以存檔當下的 tick 代替
+    // 樓層數存在檔頭：任何不超過上限的樓層數都能還原（固定 100 層時期的快照也一樣）
+    uint32_t version = get_u32(in);
+    if (version < 1 || version > CHECKPOINT_VERSION) return -1;
+    const int floors = (int)get_u32(in + 8);
+    if (floors < 1 || floors > MAX_FLOORS) return -1;
+    const int bits = CKP_BITSET_BYTES(floors);
+    const int pending_size = (version == 1) ? 16 : ((version >= 4) ? CKP_PENDING_SIZE : CKP_V3_PENDING_SIZE);
+    const int car_fixed = (version >= 3) ? CKP_CAR_SIZE : CKP_V2_CAR_SIZE;
+
+    int n = (int)get_u32(in + 4);
+    int capacity = (*count > 0 && *count <= MAX_ELEVATORS) ? *count : MAX_ELEVATORS;
+    if (n <= 0 || n > capacity) return -1;
+    const int car_size = car_fixed + 3 * bits;
+    if (len < 16 + n * car_size + 4) return -1;
+    int qn = (int)get_u32(in + 16 + n * car_size);
+    if (qn < 0 || qn > MAX_REQUESTS || len < 16 + n * car_size + 4 + qn * pending_size) return -1;
+    // v4 起 pending 之後是排程器區段
+    const unsigned char* sec = in + 16 + n * car_size + 4 + qn * pending_size;
+    int sec_len = 0;
+    if (version >= 4) {
+        if (len < (int)(sec - in) + 4) return -1;
+        sec_len = (int)get_u32(sec);
+        sec += 4;
+        if (sec_len < 0 || sec_len > len - (int)(sec - in)) return -1;
+    }
+
+    const unsigned char* p = in + 16;
+    for (int i = 0; i < n; ++i) {
+        Elevator* e = &elevators[i];
+        Elevator_init(e, (int)get_u32(p), (int)get_u32(p + 4));
+        e->target_floor = (int)get_u32(p + 8);
+        e->task_state = (TaskState)(int)get_u32(p + 12);
+        e->direction = (Direction)(int)get_u32(p + 16);
+        e->door_timer_s = get_f64(p + 20);
+        Elevator_configure(e, floors, get_f64(p + 28), 0.0, NULL);
+        Elevator_set_accum_time(e, get_f64(p + 36));
+        if (version >= 3) e->in_service = (get_u32(p + 44) & CKP_CAR_IN_SERVICE) != 0;
+        p += car_fixed;
+        // 存檔來自較高的大樓 => 只讀得下電梯儲存空間容納的樓層（之後由 building_apply_car 處理）
+        get_bits(p, e->call_up, e->floors);
+        get_bits(p + bits, e->call_down, e->floors);
+        get_bits(p + 2 * bits, e->inside, e->floors);
+        Elevator_mark_stops_changed(e);
+        p += 3 * bits;
+    }
+
+    rq_init(pending);
+    p += 4;
+    for (int k = 0; k < qn; ++k) {
+        PendingRequest r;
+        r.floor = (int)get_u32(p);
+        r.type = (RequestType)(int)get_u32(p + 4);
+        r.source_id = (int)get_u32(p + 8);
+        r.to_floor = (int)get_u32(p + 12);
+        r.enqueue_s = (version == 1) ? get_u32(in + 12) * CKP_V1_TICK_S : get_f64(p + 16);
+        r.request_id = (version >= 4) ? get_u32(p + 24) : 0u;  // 舊版沒有訂閱
+        rq_push(pending, r);
+        p += pending_size;
+    }
+    if (sched && sec_len > 0 && Scheduler_decode_state(sched, sec, sec_len, elevators, n) != 0) return -1;
+
+    *count = n;
+    if (tick) *tick = get_u32(in + 12);
+    return 0;
+}
+
+/* ---------------------------
+   Double-slot file
+   --------------------------- */
+
+static unsigned char* slot_desc(CheckpointFile* cf, int slot) {
+    return cf->base + CKP_DESC_OFFSET + slot * CKP_DESC_SIZE;
+}
+
+static unsigned char* slot_data(CheckpointFile* cf, int slot) {
+    return cf->base + CKP_HEADER_SIZE + (size_t)slot * CKP_SLOT_SIZE;
+}
+
+static uint32_t slot_crc(uint64_t seq, uint32_t len, const unsigned char* data) {
+    unsigned char hdr[12];
+    put_u64(hdr, seq);
+    put_u32(hdr + 8, len);
+    uint32_t crc = crc32_update(0, hdr, sizeof(hdr));
+    return crc32_update(crc, data, len);
+}
+
+/* slot 是否完整有效 */
+static int slot_valid(CheckpointFile* cf, int slot, uint64_t* seq) {
+    const unsigned char* d = slot_desc(cf, slot);
+    uint64_t s = get_u64(d);
+    uint32_t len = get_u32(d + 8);
+    if (s == 0 || len == 0 || len > CKP_SLOT_SIZE) return 0;
+    if (slot_crc(s, len, slot_data(cf, slot)) != get_u32(d + 12)) return 0;
+    *seq = s;
+    return 1;
+}
+
+/* 開啟（或建立）存檔檔案 */
+CheckpointFile* checkpoint_open(const char* path)
+{
+    PlatformMap* map = platform_map_file(path, CKP_FILE_SIZE);
+    if (!map) return NULL;
+
+    CheckpointFile* cf = (CheckpointFile*)calloc(1, sizeof(CheckpointFile));
+    if (!cf) {
+        platform_map_close(map);
+        return NULL;
+    }
+    cf->map = map;
+    cf->base = (unsigned char*)platform_map_data(map);
+    cf->current_slot = -1;
+
+    // 新檔或格式不同 => 重設檔頭（舊內容視為無效）
+    if (memcmp(cf->base, CHECKPOINT_MAGIC, 4) != 0 ||
+        get_u32(cf->base + 4) != CHECKPOINT_VERSION ||
+        get_u32(cf->base + 8) != (uint32_t)CKP_SLOT_SIZE) {
+        memset(cf->base, 0, CKP_HEADER_SIZE);
+        memcpy(cf->base, CHECKPOINT_MAGIC, 4);
+        put_u32(cf->base + 4, CHECKPOINT_VERSION);
+        put_u32(cf->base + 8, (uint32_t)CKP_SLOT_SIZE);
+        platform_map_flush(cf->map, 0, CKP_HEADER_SIZE);
+        return cf;
+    }
+
+    for (int s = 0; s < 2; ++s) {
+        uint64_t seq;
+        if (slot_valid(cf, s, &seq) && seq > cf->seq) {
+            cf->seq = seq;
+            cf->current_slot = s;
+        }
+    }
+    return cf;
+}
+
+/* 寫入非目前使用中的 slot，最後才更新描述，確保中途當機不會破壞舊存檔 */
+int checkpoint_write(CheckpointFile* cf, const Elevator* elevators, int count,
+                     const RequestQueue* pending, const SchedulerState* sched, uint32_t tick)
+{
+    if (!cf) return -1;
+    int slot = (cf->current_slot == 0) ? 1 : 0;
+    unsigned char* data = slot_data(cf, slot);
+
+    int len = checkpoint_encode(elevators, count, pending, sched, tick, data, CKP_SLOT_SIZE);
+    if (len < 0) return -1;
+    if (platform_map_flush(cf->map, CKP_HEADER_SIZE + (size_t)slot * CKP_SLOT_SIZE, (size_t)len) != 0) return -1;
+
+    uint64_t seq = cf->seq + 1;
+    unsigned char* d = slot_desc(cf, slot);
+    put_u64(d, seq);
+    put_u32(d + 8, (uint32_t)len);
+    put_u32(d + 12, slot_crc(seq, (uint32_t)len, data));
+    if (platform_map_flush(cf->map, CKP_DESC_OFFSET + slot * CKP_DESC_SIZE, CKP_DESC_SIZE) != 0) return -1;
+
+    cf->seq = seq;
+    cf->current_slot = slot;
+    return 0;
+}
+
+/* 讀回最新的有效存檔 */
+int checkpoint_load(CheckpointFile* cf, Elevator* elevators, int* count,
+                    RequestQueue* pending, SchedulerState* sched, uint32_t* tick)
+{
+    if (!cf) return -1;
+    if (cf->current_slot < 0) return 0;
+    uint32_t len = get_u32(slot_desc(cf, cf->current_slot) + 8);
+    if (checkpoint_decode(slot_data(cf, cf->current_slot), (int)len, elevators, count, pending, sched, tick) != 0) {
+        return -1;
+    }
+    return 1;
+}
+
+void checkpoint_close(CheckpointFile* cf)
+{
+    if (!cf) return;
+    platform_map_close(cf->map);
+    free(cf);
+}
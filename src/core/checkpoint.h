@@ -0,0 +1,86 @@
+/* ----- ----- ----- ----- */
+// checkpoint.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "elevator.h"
+#include "request_queue.h"
+#include "scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Versioned binary snapshot of the full core state: every car (position,
+ * state machine, door timer, motion accumulator, in-service flag, call flags
+ * as bitsets), the
+ * pending hall-call queue with request ids, the hall calls the scheduler
+ * tracks (Scheduler_encode_state) and the core tick. The bitsets are sized by the
+ * building's floor count, stored in the header. Door times and served floors
+ * come from the building description and are not stored; re-apply them
+ * after a restore (building_apply_car).
+ *
+ * On disk the snapshot lives in a memory-mapped file with two slots. A write
+ * always goes to the slot that is not current, and the slot descriptor
+ * (sequence number + length + CRC32) is written last, so a crash in the
+ * middle of a write leaves the previous slot intact.
+ */
+
+#define CHECKPOINT_MAGIC "ECKP"
+#define CHECKPOINT_VERSION 5  /* v2: pending requests carry their enqueue time; v3: per-car flags (in service);
+                                 v4: request ids and the scheduler section; v5: destination tickets */
+
+/* Upper bound of one encoded snapshot. */
+#define CHECKPOINT_MAX_PAYLOAD \
+    (16 + MAX_ELEVATORS * (20 + 28 + 3 * ((MAX_FLOORS + 7) / 8)) + 4 + MAX_REQUESTS * 28 + 4 + SCHED_STATE_MAX_BYTES)
+
+typedef struct CheckpointFile CheckpointFile;
+
+/* Map (or create) a checkpoint file. Returns NULL on error. */
+CheckpointFile* checkpoint_open(const char* path);
+
+/* Encode the state into the inactive slot and make it current.
+ * Returns 0 on success, -1 on error.
+ */
+int checkpoint_write(CheckpointFile* cf, const Elevator* elevators, int count,
+                     const RequestQueue* pending, const SchedulerState* sched, uint32_t tick);
+
+/* Restore the newest valid slot. *count holds the capacity of `elevators`
+ * on entry (<= 0 = MAX_ELEVATORS) and the restored car count on return.
+ * The cars need their storage attached (Elevator_attach); calls above the
+ * floors it holds are dropped. Returns 1 if state was restored, 0 if the file holds no valid snapshot,
+ * -1 on error. On 0 / -1 the outputs are left untouched. `sched` must be
+ * freshly reset; it may be NULL (here and below) to leave the scheduler
+ * section out.
+ */
+int checkpoint_load(CheckpointFile* cf, Elevator* elevators, int* count,
+                    RequestQueue* pending, SchedulerState* sched, uint32_t* tick);
+
+void checkpoint_close(CheckpointFile* cf);
+
+/* Buffer-level encoding, shared with anything else that needs to move core
+ * state around. checkpoint_encode returns the encoded length or -1 if cap is
+ * too small; checkpoint_decode returns 0 on success or -1 on a malformed or
+ * incompatible buffer (more cars than *count allows, as for checkpoint_load).
+ * Buffers of older versions decode without request ids and tracked calls
+ * (before v4) or destination tickets (v4).
+ */
+int checkpoint_encode(const Elevator* elevators, int count, const RequestQueue* pending,
+                      const SchedulerState* sched, uint32_t tick, unsigned char* out, int cap);
+int checkpoint_decode(const unsigned char* in, int len, Elevator* elevators, int* count,
+                      RequestQueue* pending, SchedulerState* sched, uint32_t* tick);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,17 @@
+/* ----- ----- ----- ----- */
+// core_log.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "core_log.h"
+
+int g_core_log_enabled = 1;
+
+/* 開關核心除錯輸出 */
+void core_log_set_enabled(int enabled) {
+    g_core_log_enabled = enabled ? 1 : 0;
+}
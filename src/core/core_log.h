@@ -0,0 +1,33 @@
+/* ----- ----- ----- ----- */
+// core_log.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef CORE_LOG_H
+#define CORE_LOG_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Global switch for the core debug output ([ELEV_*], [SCHED], [CORE] lines).
+ * Enabled by default; headless runs (replay, benchmarks) turn it off so the
+ * simulation is not bound by console speed.
+ */
+extern int g_core_log_enabled;
+
+void core_log_set_enabled(int enabled);
+
+#define CORE_LOG(...) do { if (g_core_log_enabled) printf(__VA_ARGS__); } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORE_LOG_H */
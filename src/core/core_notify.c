@@ -0,0 +1,69 @@
+/* ----- ----- ----- ----- */
+// core_notify.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "core_notify.h"
+
+#include "platform.h"
+
+/* 環形佇列（核心寫、網路讀） */
+static CoreNotice g_ring[CORE_NOTIFY_CAPACITY];
+static int g_head = 0;
+static int g_count = 0;
+static unsigned long g_dropped = 0;
+static PlatformMutex* g_lock = NULL;
+
+void core_notify_init(void)
+{
+    if (!g_lock) g_lock = platform_mutex_create();
+    platform_mutex_lock(g_lock);
+    g_head = 0;
+    g_count = 0;
+    g_dropped = 0;
+    platform_mutex_unlock(g_lock);
+}
+
+int core_notify_push(const CoreNotice* n)
+{
+    if (!n || !g_lock) return -1;
+    platform_mutex_lock(g_lock);
+    // 佇列滿了（沒人在讀）=> 丟掉新的，計數
+    if (g_count >= CORE_NOTIFY_CAPACITY) {
+        g_dropped++;
+        platform_mutex_unlock(g_lock);
+        return -1;
+    }
+    g_ring[(g_head + g_count) % CORE_NOTIFY_CAPACITY] = *n;
+    g_count++;
+    platform_mutex_unlock(g_lock);
+    return 0;
+}
+
+int core_notify_pop(CoreNotice* out)
+{
+    if (!out || !g_lock) return -1;
+    platform_mutex_lock(g_lock);
+    if (g_count == 0) {
+        platform_mutex_unlock(g_lock);
+        return -1;
+    }
+    *out = g_ring[g_head];
+    g_head = (g_head + 1) % CORE_NOTIFY_CAPACITY;
+    g_count--;
+    platform_mutex_unlock(g_lock);
+    return 0;
+}
+
+unsigned long core_notify_dropped(void)
+{
+    if (!g_lock) return 0;
+    platform_mutex_lock(g_lock);
+    unsigned long d = g_dropped;
+    platform_mutex_unlock(g_lock);
+    return d;
+}
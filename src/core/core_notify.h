@@ -0,0 +1,74 @@
+/* ----- ----- ----- ----- */
+// core_notify.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef CORE_NOTIFY_H
+#define CORE_NOTIFY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Notices from the core thread to the network thread (the reverse direction
+ * of server_events). The core pushes without blocking; the network loop
+ * drains the queue on every poll round and turns notices into lines for the
+ * clients concerned. When the queue is full (nobody draining, e.g. headless
+ * benchmarks) new notices are dropped and counted.
+ *
+ * Call-lifecycle notices (ASSIGNED / ARRIVING / SERVED) carry the client id
+ * and request id they belong to; the core only produces them for requests
+ * whose client subscribed (request_id != 0). NOTICE_BOARD answers a
+ * destination call (request_id != 0) with the car to board, again whenever
+ * the passenger is moved to another car.
+ */
+
+#define CORE_NOTIFY_CAPACITY 4096
+
+/* 通知種類 */
+typedef enum {
+    NOTICE_WAIT_SLO = 1,   // 外呼等待超過 SLO，已升級處理（給所有警衛）
+    NOTICE_ASSIGNED,       // 外呼已指派（或改派）給 car，eta_s 為預估到達秒數
+    NOTICE_ARRIVING,       // car 已鎖定這層，正在靠站
+    NOTICE_SERVED,         // car 已在這層開門服務
+    NOTICE_FLEET,          // 車隊調整結果（給該大樓所有警衛）：op / result
+    NOTICE_BOARD           // 目的樓層派車：請搭 car 前往 to_floor（不論是否訂閱）
+} CoreNoticeType;
+
+typedef struct {
+    CoreNoticeType type;
+    int building;     // 大樓 ID（單一大樓時為 0）
+    double at_s;      // 核心虛擬時間（秒）
+    int floor;
+    int dir;          // DIR_UP / DIR_DOWN
+    int car;          // 負責的電梯（-1 = 沒有可用電梯）
+    double wait_s;    // 目前已等待的秒數
+    double eta_s;     // NOTICE_ASSIGNED：預估到達秒數（< 0 = 無法估計）
+    int client_id;    // 生命週期通知的對象（server_events 的 client id）
+    unsigned request_id;  // 網路層發給該請求的 ID
+    int op;           // NOTICE_FLEET：FleetOp
+    int result;       // NOTICE_FLEET：ELEV_OK 或 ElevError
+    int to_floor;     // NOTICE_BOARD：目的樓層
+} CoreNotice;
+
+/* Empty the queue and reset the drop counter. */
+void core_notify_init(void);
+
+/* Queue a notice (any thread). Returns 0, or -1 if the queue was full. */
+int core_notify_push(const CoreNotice* n);
+
+/* Take the oldest notice. Returns 0, or -1 if the queue is empty. */
+int core_notify_pop(CoreNotice* out);
+
+/* Notices dropped because the queue was full, since core_notify_init. */
+unsigned long core_notify_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORE_NOTIFY_H */
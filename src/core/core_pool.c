@@ -0,0 +1,260 @@
+/* ----- ----- ----- ----- */
+// core_pool.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "core_pool.h"
+#include <stdlib.h>
+
+#include "platform.h"
+
+/* 每個 worker 一條雙端佇列：自己從尾端取，別人從頭端偷 */
+typedef struct {
+    PlatformMutex* lock;
+    int* items;
+    int head;  // 下一個被偷的位置
+    int tail;  // 下一個放入的位置（[head, tail) 為待執行）
+} PoolDeque;
+
+struct CorePool;
+
+typedef struct {
+    struct CorePool* pool;
+    int index;
+} PoolWorker;
+
+struct CorePool {
+    int workers;            // 含呼叫端
+    int max_tasks;
+    PoolDeque* deques;
+    PoolWorker* slots;
+    PlatformThread** threads;  // workers - 1 條背景執行緒
+
+    PlatformMutex* lock;    // 保護以下欄位
+    PlatformCond* work_cond;
+    PlatformCond* done_cond;
+    unsigned long round;    // 每次 core_pool_run 加 1，worker 據此得知有新工作
+    int remaining;          // 本輪尚未完成的工作數（0 = 沒有進行中的一輪）
+    int active;             // 正在本輪中執行的背景 worker 數
+    int stop;
+    core_pool_task_fn fn;
+    void* arg;
+
+    unsigned long steals;
+};
+
+/* 自己的佇列：從尾端取（最後放入的先做） */
+static int deque_pop_tail(PoolDeque* d, int* out)
+{
+    int ok = 0;
+    platform_mutex_lock(d->lock);
+    if (d->tail > d->head) {
+        *out = d->items[--d->tail];
+        ok = 1;
+    }
+    platform_mutex_unlock(d->lock);
+    return ok;
+}
+
+/* 別人的佇列：從頭端偷 */
+static int deque_steal_head(PoolDeque* d, int* out)
+{
+    int ok = 0;
+    platform_mutex_lock(d->lock);
+    if (d->tail > d->head) {
+        *out = d->items[d->head++];
+        ok = 1;
+    }
+    platform_mutex_unlock(d->lock);
+    return ok;
+}
+
+/* 執行到所有佇列都空為止，回報本 worker 完成的數量 */
+static void run_tasks(CorePool* pool, int self, core_pool_task_fn fn, void* arg)
+{
+    int done = 0;
+    unsigned long stolen = 0;
+    int task;
+    for (;;) {
+        if (!deque_pop_tail(&pool->deques[self], &task)) {
+            // 從下一個 worker 開始輪流偷，避免大家都擠同一條
+            int found = 0;
+            for (int k = 1; k < pool->workers && !found; ++k) {
+                found = deque_steal_head(&pool->deques[(self + k) % pool->workers], &task);
+            }
+            if (!found) break;
+            stolen++;
+        }
+        fn(task, arg);
+        done++;
+    }
+
+    platform_mutex_lock(pool->lock);
+    pool->steals += stolen;
+    pool->remaining -= done;
+    if (self != 0) pool->active--;
+    if (pool->remaining == 0 && pool->active == 0) platform_cond_broadcast(pool->done_cond);
+    platform_mutex_unlock(pool->lock);
+}
+
+static void* worker_fn(void* p)
+{
+    PoolWorker* w = (PoolWorker*)p;
+    CorePool* pool = w->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        platform_mutex_lock(pool->lock);
+        // 只在一輪進行中才加入：晚醒的 worker 不會碰到下一輪正在填的佇列
+        while (!pool->stop && (pool->round == seen || pool->remaining == 0)) {
+            platform_cond_wait(pool->work_cond, pool->lock);
+        }
+        if (pool->stop) {
+            platform_mutex_unlock(pool->lock);
+            break;
+        }
+        seen = pool->round;
+        pool->active++;
+        core_pool_task_fn fn = pool->fn;
+        void* arg = pool->arg;
+        platform_mutex_unlock(pool->lock);
+
+        run_tasks(pool, w->index, fn, arg);
+    }
+    return NULL;
+}
+
+/* 建立工作池 */
+CorePool* core_pool_create(int workers, int max_tasks)
+{
+    if (workers < 1) workers = 1;
+    if (max_tasks < 1) max_tasks = 1;
+
+    CorePool* pool = (CorePool*)calloc(1, sizeof(CorePool));
+    if (!pool) return NULL;
+    pool->workers = workers;
+    pool->max_tasks = max_tasks;
+    pool->deques = (PoolDeque*)calloc((size_t)workers, sizeof(PoolDeque));
+    pool->slots = (PoolWorker*)calloc((size_t)workers, sizeof(PoolWorker));
+    pool->threads = (PlatformThread**)calloc((size_t)workers, sizeof(PlatformThread*));
+    pool->lock = platform_mutex_create();
+    pool->work_cond = platform_cond_create();
+    pool->done_cond = platform_cond_create();
+    if (!pool->deques || !pool->slots || !pool->threads || !pool->lock || !pool->work_cond || !pool->done_cond) {
+        core_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (int i = 0; i < workers; ++i) {
+        // 一輪最多 max_tasks 個工作，全部分給同一條也放得下
+        pool->deques[i].items = (int*)malloc(sizeof(int) * (size_t)max_tasks);
+        pool->deques[i].lock = platform_mutex_create();
+        if (!pool->deques[i].items || !pool->deques[i].lock) {
+            core_pool_destroy(pool);
+            return NULL;
+        }
+        pool->slots[i].pool = pool;
+        pool->slots[i].index = i;
+    }
+
+    // worker 0 是呼叫端本身
+    for (int i = 1; i < workers; ++i) {
+        pool->threads[i] = platform_thread_create(worker_fn, &pool->slots[i]);
+        if (!pool->threads[i]) {
+            core_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/* 結束並釋放工作池 */
+void core_pool_destroy(CorePool* pool)
+{
+    if (!pool) return;
+    if (pool->lock) {
+        platform_mutex_lock(pool->lock);
+        pool->stop = 1;
+        if (pool->work_cond) platform_cond_broadcast(pool->work_cond);
+        platform_mutex_unlock(pool->lock);
+    }
+    if (pool->threads) {
+        for (int i = 1; i < pool->workers; ++i) {
+            if (pool->threads[i]) platform_thread_join(pool->threads[i]);
+        }
+    }
+    if (pool->deques) {
+        for (int i = 0; i < pool->workers; ++i) {
+            if (pool->deques[i].lock) platform_mutex_destroy(pool->deques[i].lock);
+            free(pool->deques[i].items);
+        }
+    }
+    if (pool->done_cond) platform_cond_destroy(pool->done_cond);
+    if (pool->work_cond) platform_cond_destroy(pool->work_cond);
+    if (pool->lock) platform_mutex_destroy(pool->lock);
+    free(pool->threads);
+    free(pool->slots);
+    free(pool->deques);
+    free(pool);
+}
+
+/* 執行一輪工作並等待全部完成 */
+int core_pool_run(CorePool* pool, int tasks, core_pool_task_fn fn, void* arg)
+{
+    if (!pool || !fn || tasks > pool->max_tasks) return -1;
+    if (tasks <= 0) return 0;
+
+    // 單執行緒：直接依序執行
+    if (pool->workers == 1) {
+        for (int t = 0; t < tasks; ++t) fn(t, arg);
+        platform_mutex_lock(pool->lock);
+        pool->round++;
+        platform_mutex_unlock(pool->lock);
+        return 0;
+    }
+
+    // 輪流分配到各 worker 的佇列
+    for (int i = 0; i < pool->workers; ++i) {
+        PoolDeque* d = &pool->deques[i];
+        platform_mutex_lock(d->lock);
+        d->head = d->tail = 0;
+        for (int t = i; t < tasks; t += pool->workers) d->items[d->tail++] = t;
+        platform_mutex_unlock(d->lock);
+    }
+
+    platform_mutex_lock(pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->remaining = tasks;
+    pool->round++;
+    platform_cond_broadcast(pool->work_cond);
+    platform_mutex_unlock(pool->lock);
+
+    run_tasks(pool, 0, fn, arg);
+
+    // 屏障：等所有工作完成，且加入本輪的 worker 都已離開佇列
+    platform_mutex_lock(pool->lock);
+    while (pool->remaining > 0 || pool->active > 0) {
+        platform_cond_wait(pool->done_cond, pool->lock);
+    }
+    platform_mutex_unlock(pool->lock);
+    return 0;
+}
+
+int core_pool_workers(const CorePool* pool)
+{
+    return pool ? pool->workers : 0;
+}
+
+void core_pool_get_stats(CorePool* pool, unsigned long* rounds, unsigned long* steals)
+{
+    if (!pool) return;
+    platform_mutex_lock(pool->lock);
+    if (rounds) *rounds = pool->round;
+    if (steals) *steals = pool->steals;
+    platform_mutex_unlock(pool->lock);
+}
@@ -0,0 +1,55 @@
+/* ----- ----- ----- ----- */
+// core_pool.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef CORE_POOL_H
+#define CORE_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed pool of worker threads that runs rounds of independent tasks (one
+ * task per building per tick in a campus core).
+ *
+ * core_pool_run spreads task indices round-robin over one deque per worker.
+ * A worker pops its own deque from the tail and, once it is empty, steals
+ * from the head of the others, so a building with a heavy tick does not
+ * hold up the tasks queued behind it. The calling thread takes part as
+ * worker 0 and core_pool_run returns only after every task of the round
+ * has finished (a barrier per round).
+ */
+typedef struct CorePool CorePool;
+
+typedef void (*core_pool_task_fn)(int task, void* arg);
+
+/* workers: total threads including the caller (clamped to >= 1; 1 runs every
+ * task on the caller). max_tasks: largest task count passed to core_pool_run.
+ * Returns NULL on error.
+ */
+CorePool* core_pool_create(int workers, int max_tasks);
+
+/* Joins the worker threads. Must not be called while a round is running. */
+void core_pool_destroy(CorePool* pool);
+
+/* Run fn(0..tasks-1, arg) across the pool and wait for all of them.
+ * Rounds must not overlap (one caller thread). Returns 0, or -1 if tasks
+ * exceeds max_tasks.
+ */
+int core_pool_run(CorePool* pool, int tasks, core_pool_task_fn fn, void* arg);
+
+int core_pool_workers(const CorePool* pool);
+
+/* Rounds run and tasks taken from another worker's deque since creation. */
+void core_pool_get_stats(CorePool* pool, unsigned long* rounds, unsigned long* steals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORE_POOL_H */
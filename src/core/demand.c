@@ -0,0 +1,305 @@
+/* ----- ----- ----- ----- */
+// demand.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "demand.h"
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "building.h"
+
+#define DEMAND_MAGIC "EDMD"
+#define DEMAND_VERSION 1
+
+struct DemandModel {
+    int floors;
+    double day_offset_s;      // tick 0 時的一天中秒數
+    long window;              // 目前計數中的時段序號（從 core 時間 0 起算的第幾格，-1 = 尚未開始）
+    double window_start_s;    // 本時段開始觀測的 core 時間（啟動在時段中間時晚於時段起點）
+    float* count;             // [floor * 2 + dir] 本時段的外呼數
+    float* rate;              // [(bucket * floors + floor) * 2 + dir] EWMA（次 / 小時）
+    unsigned char* seen;      // [bucket] 是否已有觀測值
+};
+
+/* ---------------------------
+   Layout
+   --------------------------- */
+
+static size_t model_layout(BuildingArena* a, DemandModel** out, int floors)
+{
+    DemandModel* m = (DemandModel*)building_arena_take(a, sizeof(DemandModel));
+    float* count = (float*)building_arena_take(a, sizeof(float) * 2 * (size_t)floors);
+    float* rate = (float*)building_arena_take(a, sizeof(float) * 2 * (size_t)floors * DEMAND_BUCKETS);
+    unsigned char* seen = (unsigned char*)building_arena_take(a, DEMAND_BUCKETS);
+    if (m) {
+        memset(m, 0, sizeof(*m));
+        m->floors = floors;
+        m->count = count;
+        m->rate = rate;
+        m->seen = seen;
+    }
+    if (out) *out = m;
+    return a->used;
+}
+
+size_t demand_size(int floors)
+{
+    BuildingArena a = { NULL, 0 };
+    return model_layout(&a, NULL, floors);
+}
+
+DemandModel* demand_init_at(void* mem, int floors)
+{
+    if (!mem || floors < 1) return NULL;
+    BuildingArena a = { (unsigned char*)mem, 0 };
+    DemandModel* m = NULL;
+    model_layout(&a, &m, floors);
+    demand_reset(m);
+    return m;
+}
+
+void demand_reset(DemandModel* m)
+{
+    if (!m) return;
+    m->window = -1;
+    m->window_start_s = 0.0;
+    memset(m->count, 0, sizeof(float) * 2 * (size_t)m->floors);
+    memset(m->rate, 0, sizeof(float) * 2 * (size_t)m->floors * DEMAND_BUCKETS);
+    memset(m->seen, 0, DEMAND_BUCKETS);
+}
+
+void demand_set_day_offset(DemandModel* m, double seconds_of_day)
+{
+    if (!m) return;
+    m->day_offset_s = fmod(seconds_of_day, DEMAND_DAY_S);
+    if (m->day_offset_s < 0.0) m->day_offset_s += DEMAND_DAY_S;
+    // 時段的切法跟著變 => 本時段的計數作廢
+    m->window = -1;
+    memset(m->count, 0, sizeof(float) * 2 * (size_t)m->floors);
+}
+
+/* ---------------------------
+   Estimation
+   --------------------------- */
+
+/* core 時間 => 從 core 時間 0 起算的時段序號（跨日遞增） */
+static long window_of(const DemandModel* m, double now_s)
+{
+    return (long)floor((m->day_offset_s + now_s) / DEMAND_BUCKET_S);
+}
+
+static int bucket_of_window(long w)
+{
+    return (int)(w % DEMAND_BUCKETS);
+}
+
+/* 結束目前時段：觀測夠久才折進該時段的 EWMA */
+static int fold_window(DemandModel* m, double end_s)
+{
+    int folded = 0;
+    double observed = end_s - m->window_start_s;
+    if (m->window >= 0 && observed >= DEMAND_MIN_WINDOW_S) {
+        const int b = bucket_of_window(m->window);
+        float* r = m->rate + (size_t)b * m->floors * 2;
+        const double per_hour = 3600.0 / observed;
+        for (int i = 0; i < 2 * m->floors; ++i) {
+            double v = m->count[i] * per_hour;
+            r[i] = m->seen[b] ? (float)(DEMAND_ALPHA * v + (1.0 - DEMAND_ALPHA) * r[i]) : (float)v;
+        }
+        m->seen[b] = 1;
+        folded = 1;
+    }
+    memset(m->count, 0, sizeof(float) * 2 * (size_t)m->floors);
+    return folded;
+}
+
+int demand_advance(DemandModel* m, double now_s)
+{
+    if (!m) return 0;
+    long w = window_of(m, now_s);
+    if (m->window < 0) {
+        m->window = w;
+        m->window_start_s = now_s;
+        return 0;
+    }
+    if (w == m->window) return 0;
+    // core 一直在跑，所以中間沒有外呼的時段也是觀測值（0 次）
+    int folded = 0;
+    while (m->window < w) {
+        double end_s = (m->window + 1) * DEMAND_BUCKET_S - m->day_offset_s;
+        folded += fold_window(m, end_s);
+        m->window++;
+        m->window_start_s = end_s;
+    }
+    return folded;
+}
+
+void demand_record(DemandModel* m, int floor, int dir_index, double now_s)
+{
+    if (!m || floor < 0 || floor >= m->floors || dir_index < 0 || dir_index > 1) return;
+    demand_advance(m, now_s);
+    m->count[floor * 2 + dir_index] += 1.0f;
+}
+
+double demand_rate(const DemandModel* m, int floor, double now_s)
+{
+    if (!m || floor < 0 || floor >= m->floors) return 0.0;
+    double tod = m->day_offset_s + now_s;
+    long w = window_of(m, now_s);
+    int b = bucket_of_window(w);
+    int nb = (b + 1) % DEMAND_BUCKETS;
+    double frac = (tod - w * DEMAND_BUCKET_S) / DEMAND_BUCKET_S;  // 時段進行到哪
+
+    // 已學到的：本時段與下一時段依進度混合（越接近下一時段越看下一時段）
+    double learned = 0.0, weight = 0.0;
+    if (m->seen[b]) {
+        const float* r = m->rate + ((size_t)b * m->floors + floor) * 2;
+        learned += (1.0 - frac) * (r[0] + r[1]);
+        weight += 1.0 - frac;
+    }
+    if (m->seen[nb]) {
+        const float* r = m->rate + ((size_t)nb * m->floors + floor) * 2;
+        learned += frac * (r[0] + r[1]);
+        weight += frac;
+    }
+
+    // 即時：本時段目前為止的速率
+    double observed = (m->window == w) ? now_s - m->window_start_s : 0.0;
+    int live_ok = observed >= DEMAND_MIN_WINDOW_S;
+    double live = live_ok ? (m->count[floor * 2] + m->count[floor * 2 + 1]) * 3600.0 / observed : 0.0;
+
+    if (weight <= 0.0) return live;
+    learned /= weight;
+    return live_ok ? 0.5 * (learned + live) : learned;
+}
+
+int demand_top_floors(const DemandModel* m, double now_s, int* out, int max)
+{
+    if (!m || !out || max <= 0) return 0;
+    if (max > MAX_FLOORS) max = MAX_FLOORS;
+    int n = 0;
+    double top[MAX_FLOORS];
+    for (int f = 0; f < m->floors; ++f) {
+        double r = demand_rate(m, f, now_s);
+        if (r <= 0.0) continue;
+        // 插入排序（max 很小）：沒滿就加在尾端，滿了只取代最後一名
+        int k;
+        if (n < max) k = n++;
+        else if (r > top[max - 1]) k = max - 1;
+        else continue;
+        while (k > 0 && top[k - 1] < r) {
+            top[k] = top[k - 1];
+            out[k] = out[k - 1];
+            --k;
+        }
+        top[k] = r;
+        out[k] = f;
+    }
+    return n;
+}
+
+/* ---------------------------
+   Persistence
+   --------------------------- */
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 檔案：magic | version | floors | buckets | 每個時段 u32 seen + floors * 2 個 f32 */
+int demand_save(const DemandModel* m, const char* path)
+{
+    if (!m || !path) return -1;
+    char tmp[1024];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) return -1;
+
+    unsigned char hdr[16];
+    memcpy(hdr, DEMAND_MAGIC, 4);
+    put_u32(hdr + 4, DEMAND_VERSION);
+    put_u32(hdr + 8, (uint32_t)m->floors);
+    put_u32(hdr + 12, DEMAND_BUCKETS);
+    int ok = fwrite(hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+    unsigned char buf[4];
+    for (int b = 0; ok && b < DEMAND_BUCKETS; ++b) {
+        put_u32(buf, m->seen[b]);
+        ok = fwrite(buf, 1, 4, fp) == 4;
+        const float* r = m->rate + (size_t)b * m->floors * 2;
+        for (int i = 0; ok && i < 2 * m->floors; ++i) {
+            uint32_t v;
+            memcpy(&v, &r[i], sizeof(v));
+            put_u32(buf, v);
+            ok = fwrite(buf, 1, 4, fp) == 4;
+        }
+    }
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) {
+        remove(tmp);
+        return -1;
+    }
+    // Windows 的 rename 不會覆蓋既有檔案
+    if (rename(tmp, path) != 0) {
+        remove(path);
+        if (rename(tmp, path) != 0) return -1;
+    }
+    return 0;
+}
+
+int demand_load(DemandModel* m, const char* path)
+{
+    if (!m || !path) return -1;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return (errno == ENOENT) ? 0 : -1;
+
+    unsigned char hdr[16];
+    if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) || memcmp(hdr, DEMAND_MAGIC, 4) != 0 ||
+        get_u32(hdr + 4) != DEMAND_VERSION || (int)get_u32(hdr + 8) != m->floors ||
+        get_u32(hdr + 12) != DEMAND_BUCKETS) {
+        fclose(fp);
+        return -1;
+    }
+    // 先讀到暫存區，檔案完整才套用
+    float* rate = (float*)malloc(sizeof(float) * 2 * (size_t)m->floors * DEMAND_BUCKETS);
+    if (!rate) {
+        fclose(fp);
+        return -1;
+    }
+    unsigned char seen[DEMAND_BUCKETS];
+    unsigned char buf[4];
+    int ok = 1;
+    for (int b = 0; ok && b < DEMAND_BUCKETS; ++b) {
+        ok = fread(buf, 1, 4, fp) == 4;
+        seen[b] = ok && get_u32(buf) != 0;
+        float* r = rate + (size_t)b * m->floors * 2;
+        for (int i = 0; ok && i < 2 * m->floors; ++i) {
+            ok = fread(buf, 1, 4, fp) == 4;
+            uint32_t v = get_u32(buf);
+            memcpy(&r[i], &v, sizeof(v));
+            if (!(r[i] >= 0.0f)) ok = 0;  // 負數 / NaN
+        }
+    }
+    fclose(fp);
+    if (ok) {
+        memcpy(m->rate, rate, sizeof(float) * 2 * (size_t)m->floors * DEMAND_BUCKETS);
+        memcpy(m->seen, seen, DEMAND_BUCKETS);
+    }
+    free(rate);
+    return ok ? 1 : -1;
+}
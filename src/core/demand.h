@@ -0,0 +1,76 @@
+/* ----- ----- ----- ----- */
+// demand.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef DEMAND_H
+#define DEMAND_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Online hall-call arrival-rate estimator of one building.
+ *
+ * The day is split into DEMAND_BUCKETS time-of-day buckets. Accepted hall
+ * calls are counted per floor and direction while a bucket is running; when
+ * the bucket ends its rate (calls / hour) is folded into that bucket's EWMA,
+ * so the model learns "what floor 1 looks like at 08:45" over several days.
+ * Predictions blend the learned rate of the current and the next bucket with
+ * the live rate of the bucket in progress.
+ *
+ * Time is core virtual time (seconds since tick 0) plus a day offset, the
+ * time of day at tick 0 (0 = midnight, the default for benchmarks).
+ */
+
+#define DEMAND_BUCKETS 96           // 15 分鐘一格
+#define DEMAND_BUCKET_S 900.0
+#define DEMAND_DAY_S 86400.0
+#define DEMAND_ALPHA 0.3            // 新一天的觀測值佔的權重
+#define DEMAND_MIN_WINDOW_S 60.0    // 少於這麼久的觀測不折進 EWMA、也不當即時速率
+
+typedef struct DemandModel DemandModel;
+
+/* Lay a model for `floors` floors out in caller-owned memory of
+ * demand_size() bytes (16-byte aligned, e.g. a building arena). */
+size_t demand_size(int floors);
+DemandModel* demand_init_at(void* mem, int floors);
+
+/* Forget everything learned (the day offset is kept). */
+void demand_reset(DemandModel* m);
+
+/* Time of day (seconds) at core time 0. */
+void demand_set_day_offset(DemandModel* m, double seconds_of_day);
+
+/* Count one accepted hall call (dir_index 0 = UP, 1 = DOWN) at core time now_s. */
+void demand_record(DemandModel* m, int floor, int dir_index, double now_s);
+
+/* Close every bucket that ended before now_s. Returns the number of buckets
+ * folded into the EWMA (a good moment to persist the model). */
+int demand_advance(DemandModel* m, double now_s);
+
+/* Predicted calls / hour at `floor` (both directions) around now_s. */
+double demand_rate(const DemandModel* m, int floor, double now_s);
+
+/* Up to `max` floors with the highest predicted rate (> 0), busiest first.
+ * Returns how many were written to out. */
+int demand_top_floors(const DemandModel* m, double now_s, int* out, int max);
+
+/* Persist / restore the learned rates (not the bucket in progress).
+ * demand_save writes a temporary file and renames it over `path`.
+ * demand_load returns 1 if restored, 0 if the file does not exist, -1 if it
+ * is malformed or was written for another floor count. */
+int demand_save(const DemandModel* m, const char* path);
+int demand_load(DemandModel* m, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEMAND_H */
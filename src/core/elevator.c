@@ -3,53 +3,125 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "core_log.h"
 #include "elevator.h"
 #include "status.h"
 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
 const double DEFAULT_SPEED_FPS = 1.0 / 1.0;  // 移動 1 層樓 / 每 1 秒
 const double DEFAULT_DOOR_OPEN_S = 1.0;      // 電梯開門時長（秒）
 
-/* 電梯移動時間儲存 */
-/* 0.1s => 0.5s => 直到 1.0s => 減 1 秒 & 移動一層樓 */
-static double g_accum_time[MAX_ELEVATORS] = {0.0};
-
 /* ---------------------------
    Flag-based helpers
    --------------------------- */
 
 /* 判斷指定樓層是否有任何請求(內/外呼) */
 static inline int has_request_on_floor(const Elevator* e, int floor) {
-    if (!e || floor < 0 || floor >= MAX_FLOORS) return 0;
+    if (!e || floor < 0 || floor >= e->floors) return 0;
     return (e->inside[floor] || e->call_up[floor] || e->call_down[floor]) ? 1 : 0;
 }
 
+/* 停靠旗標有變動 => 換新版本 */
+// keep_route：電梯照路線自己清掉的旗標（路線本來就預期會清），路線仍然有效
+static void bump_stops_version(Elevator* e, int keep_route) {
+    int route_ok = (e->route.version == e->stops_version);
+    e->stops_version++;
+    if (keep_route && route_ok) e->route.version = e->stops_version;
+}
+
+static inline void bit_set(uint64_t* b, int f) {
+    b[f >> 6] |= (uint64_t)1 << (f & 63);
+}
+
+/* 由 bool 旗標重建位元集合 */
+static void stops_from_flags(StopSet* s, const Elevator* e) {
+    for (int w = 0; w < STOPSET_WORDS; ++w) s->up[w] = s->down[w] = s->inside[w] = 0;
+    for (int f = 0; f < e->floors; ++f) {
+        if (e->call_up[f]) bit_set(s->up, f);
+        if (e->call_down[f]) bit_set(s->down, f);
+        if (e->inside[f]) bit_set(s->inside, f);
+    }
+}
+
+/* 旗標陣列對應的位元集合 */
+static uint64_t* stop_bits(Elevator* e, const bool* flags) {
+    if (flags == e->call_up) return e->stops.up;
+    if (flags == e->call_down) return e->stops.down;
+    return e->stops.inside;
+}
+
+/* 設定 / 清除單一旗標，順便更新位元集合、請求數與停靠樓層數 */
+static void set_stop_flag(Elevator* e, bool* flags, int floor) {
+    if (flags[floor]) return;
+    if (!has_request_on_floor(e, floor)) e->stop_floors++;
+    flags[floor] = true;
+    bit_set(stop_bits(e, flags), floor);
+    e->request_count++;
+}
+
+static int clear_stop_flag(Elevator* e, bool* flags, int floor) {
+    if (!flags[floor]) return 0;
+    flags[floor] = false;
+    StopSet_clear(stop_bits(e, flags), floor);
+    e->request_count--;
+    if (!has_request_on_floor(e, floor)) e->stop_floors--;
+    return 1;
+}
+
+/* 外部直接改了旗標 => 重新同步位元集合與計數，路線作廢 */
+void Elevator_mark_stops_changed(Elevator* e) {
+    if (!e) return;
+    stops_from_flags(&e->stops, e);
+    e->request_count = 0;
+    e->stop_floors = 0;
+    for (int f = 0; f < e->floors; ++f) {
+        e->request_count += e->inside[f] + e->call_up[f] + e->call_down[f];
+        e->stop_floors += has_request_on_floor(e, f);
+    }
+    bump_stops_version(e, 0);
+}
+
 /* 判斷電梯是否仍有任務 */
 int elevator_has_stops(const Elevator* e) {
     if (!e) return 0;
-    for (int f = 0; f < MAX_FLOORS; ++f) {
-        if (e->inside[f] || e->call_up[f] || e->call_down[f]) return 1;
-    }
-    return 0;
+    return e->stop_floors > 0;
 }
 
 /* 電梯抵達樓層後，清除內呼請求*/
 static void remove_served_flags_on_arrival(Elevator* e, int floor, Direction arrival_dir) {
-    if (!e || floor < 0 || floor >= MAX_FLOORS) return;
+    if (!e || floor < 0 || floor >= e->floors) return;
 
     // 永遠清掉這一層的內呼，代表有人在這層下電梯
-    e->inside[floor] = false;
+    if (clear_stop_flag(e, e->inside, floor)) bump_stops_version(e, 1);
+
+    CORE_LOG("[ELEV_DEBUG] E%d remove_served_at_floor -> up=%d down=%d inside=%d (floor=%d)\n",
+             e->id, e->call_up[floor], e->call_down[floor], e->inside[floor], floor);
+}
 
-    printf("[ELEV_DEBUG] E%d remove_served_at_floor -> up=%d down=%d inside=%d (floor=%d)\n",
-           e->id, e->call_up[floor], e->call_down[floor], e->inside[floor], floor);
+/* 關門後決定往哪個方向出發 => 本層同方向的外呼乘客已上車，清掉該外呼 */
+// 在關門時清（而非離開樓層時），關門後才按的同層外呼不會被當成已服務
+static void clear_departing_call(Elevator* e) {
+    int f = e->current_floor;
+    if (f < 0 || f >= e->floors) return;
+    bool* calls = (e->direction == DIR_UP) ? e->call_up : (e->direction == DIR_DOWN) ? e->call_down : NULL;
+    if (calls && clear_stop_flag(e, calls, f)) {
+        bump_stops_version(e, 1);
+        CORE_LOG("[ELEV_DEBUG] E%d cleared call_%s at floor %d on departure\n",
+                 e->id, (e->direction == DIR_UP) ? "up" : "down", f);
+    }
 }
 
 /* 加入內/外呼請求 */
@@ -58,27 +130,40 @@ static void remove_served_flags_on_arrival(Elevator* e, int floor, Direction arr
 // return 1：重複請求
 int elevator_add_request_flag(Elevator *e, int floor, RequestType type) {
     if (!e) return ELEV_ERR_INVALID;
-    if (floor < 0 || floor >= MAX_FLOORS) return ELEV_ERR_INVALID;
+    if (!Elevator_serves(e, floor)) return ELEV_ERR_INVALID;  // 樓層超出大樓或這台不停
 
+    bool* flags;
     switch (type) {
-        case REQ_CALL_UP:
-            if (e->call_up[floor]) return ELEV_DUPLICATE;
-            e->call_up[floor] = true;
-            return ELEV_OK;
-
-        case REQ_CALL_DOWN:
-            if (e->call_down[floor]) return ELEV_DUPLICATE;
-            e->call_down[floor] = true;
-            return ELEV_OK;
+        case REQ_CALL_UP:   flags = e->call_up; break;
+        case REQ_CALL_DOWN: flags = e->call_down; break;
+        case REQ_INSIDE:    flags = e->inside; break;
+        default:
+            return ELEV_ERR_INVALID;
+    }
+    if (flags[floor]) return ELEV_DUPLICATE;
+    // 新增的停靠可能插在路線中間 => 路線作廢，下次選層時重建
+    set_stop_flag(e, flags, floor);
+    bump_stops_version(e, 0);
+    return ELEV_OK;
+}
 
-        case REQ_INSIDE:
-            if (e->inside[floor]) return ELEV_DUPLICATE;
-            e->inside[floor] = true;
-            return ELEV_OK;
+/* 撤回尚未服務的請求（例如外呼改派給別台） */
+int elevator_remove_request_flag(Elevator* e, int floor, RequestType type) {
+    if (!e) return ELEV_ERR_INVALID;
+    if (floor < 0 || floor >= e->floors) return ELEV_ERR_INVALID;
 
+    bool* flags;
+    switch (type) {
+        case REQ_CALL_UP:   flags = e->call_up; break;
+        case REQ_CALL_DOWN: flags = e->call_down; break;
+        case REQ_INSIDE:    flags = e->inside; break;
         default:
             return ELEV_ERR_INVALID;
     }
+    if (!clear_stop_flag(e, flags, floor)) return ELEV_IGNORED;
+    // 路線少了一站 => 作廢重建
+    bump_stops_version(e, 0);
+    return ELEV_OK;
 }
 
 /* 內呼 => 直接加進該電梯樓層請求 */
@@ -87,74 +172,234 @@ int Elevator_push_inside_request(Elevator* e, int dest_floor, int client_id) {
     return elevator_add_request_flag(e, dest_floor, REQ_INSIDE);
 }
 
-/* 選取下一個目標樓層 */
-/* 如果同向已無目標，則反轉電梯方向 */
-PickResult pick_next_target_flag(Elevator* e) {
-    if (!e) return PICK_ERROR;
-    int cur = e->current_floor;
+/* ---------------------------
+   Stop sets & route
+   --------------------------- */
 
-    // 如果電梯向上
-    if (e->direction == DIR_UP) {
-        // 先找同向（向上）
-        for (int f = cur + 1; f < MAX_FLOORS; ++f) {
-            if (has_request_on_floor(e, f)) {
-                e->target_floor = f;
-                return PICK_TARGET_SET;
-            }
-        }
-        // 沒目標了 => 找反向（向下）
-        for (int f = cur - 1; f >= 0; --f) {
-            if (has_request_on_floor(e, f)) {
-                e->direction = DIR_DOWN;
-                e->target_floor = f;
-                return PICK_TARGET_SET;
-            }
-        }
+static inline int lowest_bit(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int)i;
+#elif defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while (!(x & 1u)) { x >>= 1; ++i; }
+    return i;
+#endif
+}
+
+static inline int highest_bit(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return (int)i;
+#elif defined(__GNUC__)
+    return 63 - __builtin_clzll(x);
+#else
+    int i = 63;
+    while (!(x >> i)) --i;
+    return i;
+#endif
+}
+
+static inline int any_at(const StopSet* s, int f) {
+    return StopSet_get(s->up, f) | StopSet_get(s->down, f) | StopSet_get(s->inside, f);
+}
+
+/* f 以上（不含 f）最近有請求的樓層，沒有回傳 -1 */
+static int stops_above(const StopSet* s, int f) {
+    int start = f + 1;
+    if (start >= MAX_FLOORS) return -1;
+    uint64_t mask = ~(uint64_t)0 << (start & 63);
+    for (int w = start >> 6; w < STOPSET_WORDS; ++w, mask = ~(uint64_t)0) {
+        uint64_t x = (s->up[w] | s->down[w] | s->inside[w]) & mask;
+        if (x) return w * 64 + lowest_bit(x);
     }
-    // 如果電梯向下
-    else if (e->direction == DIR_DOWN) {
-        // 先找同向（向下）
-        for (int f = cur - 1; f >= 0; --f) {
-            if (has_request_on_floor(e, f)) {
-                e->target_floor = f;
-                return PICK_TARGET_SET;
-            }
+    return -1;
+}
+
+/* f 以下（不含 f）最近有請求的樓層，沒有回傳 -1 */
+static int stops_below(const StopSet* s, int f) {
+    int end = f - 1;
+    if (end < 0) return -1;
+    uint64_t mask = ((end & 63) == 63) ? ~(uint64_t)0 : (((uint64_t)1 << ((end & 63) + 1)) - 1);
+    for (int w = end >> 6; w >= 0; --w, mask = ~(uint64_t)0) {
+        uint64_t x = (s->up[w] | s->down[w] | s->inside[w]) & mask;
+        if (x) return w * 64 + highest_bit(x);
+    }
+    return -1;
+}
+
+/* 選層規則（集體控制）：同方向最近的 => 本層外呼原地開門 => 反向最近的
+ * 閒置時：本層有請求就開門，否則找最近的（距離相同往上優先）
+ * 回傳下一個停靠樓層（-1 = 沒有），*dir 改成出發方向（原地開門 = DIR_NONE） */
+int Route_pick(const StopSet* s, int cur, Direction* dir) {
+    int f;
+    if (*dir == DIR_UP || *dir == DIR_DOWN) {
+        int ahead = (*dir == DIR_UP) ? stops_above(s, cur) : stops_below(s, cur);
+        if (ahead >= 0) return ahead;
+        // 前方沒目標，本層還有外呼 => 原地開門讓本層乘客先上（否則上下兩層的反向外呼會來回空跑）
+        if (StopSet_get(s->up, cur) || StopSet_get(s->down, cur)) {
+            *dir = DIR_NONE;
+            return cur;
         }
-        // 沒目標了 => 找反向（向上）
-        for (int f = cur + 1; f < MAX_FLOORS; ++f) {
-            if (has_request_on_floor(e, f)) {
-                e->direction = DIR_UP;
-                e->target_floor = f;
-                return PICK_TARGET_SET;
-            }
+        // 沒目標了 => 找反向
+        f = (*dir == DIR_UP) ? stops_below(s, cur) : stops_above(s, cur);
+        if (f >= 0) {
+            *dir = (*dir == DIR_UP) ? DIR_DOWN : DIR_UP;
+            return f;
         }
+        *dir = DIR_NONE;
+        return -1;
     }
-    // 如果電梯閒置
-    else {
-        // 同時往上下找最近的
-        for (int offset = 1; offset < MAX_FLOORS; ++offset) {
-            int up = cur + offset;
-            int down = cur - offset;
-            if (up < MAX_FLOORS && has_request_on_floor(e, up)) {
-                e->direction = DIR_UP;
-                e->target_floor = up;
-                return PICK_TARGET_SET;
-            }
-            if (down >= 0 && has_request_on_floor(e, down)) {
-                e->direction = DIR_DOWN;
-                e->target_floor = down;
-                return PICK_TARGET_SET;
-            }
+
+    *dir = DIR_NONE;
+    if (any_at(s, cur)) return cur;
+    int up = stops_above(s, cur);
+    int down = stops_below(s, cur);
+    if (up >= 0 && (down < 0 || up - cur <= cur - down)) {
+        *dir = DIR_UP;
+        return up;
+    }
+    if (down >= 0) {
+        *dir = DIR_DOWN;
+        return down;
+    }
+    return -1;
+}
+
+/* 從 (from, dir) 依序模擬每一次選層，同時清掉電梯會清的旗標 */
+void Route_build(RoutePlan* r, StopSet* s, int from, Direction dir) {
+    r->start_floor = (short)from;
+    r->start_dir = (signed char)dir;
+    r->head = 0;
+    r->count = 0;
+
+    int p = from;
+    Direction d = dir;
+    while (r->count < r->cap) {
+        Direction nd = d;
+        int next = Route_pick(s, p, &nd);
+        RouteLeg* leg = &r->legs[r->count++];
+        leg->target = (short)next;
+        leg->dir = (signed char)nd;
+        if (next < 0) return;
+
+        if (next == p) {
+            // 原地開門：本層兩個方向的外呼都算服務
+            StopSet_clear(s->up, p);
+            StopSet_clear(s->down, p);
+        } else {
+            // 往 nd 出發：本層 nd 方向的外呼已上車
+            StopSet_clear((nd == DIR_UP) ? s->up : s->down, p);
         }
+        StopSet_clear(s->inside, next);  // 開門 => 內呼已下車
+        p = next;
+        d = nd;
+    }
+}
+
+const RoutePlan* Elevator_route_from(const Elevator* e, int floor, Direction dir) {
+    if (!e) return NULL;
+    const RoutePlan* r = &e->route;
+    if (r->version != e->stops_version || r->head >= r->count) return NULL;
+    int from = r->head ? r->legs[r->head - 1].target : r->start_floor;
+    int d = r->head ? r->legs[r->head - 1].dir : r->start_dir;
+    return (from == floor && d == (int)dir) ? r : NULL;
+}
+
+/* 選取下一個目標樓層 */
+/* 照快取的路線走下一段；旗標被外部改過（或位置對不上）才從頭重建路線 */
+PickResult pick_next_target_flag(Elevator* e) {
+    if (!e) return PICK_ERROR;
+    int cur = e->current_floor;
+    if (cur < 0 || cur >= e->floors) return PICK_NONE;
+
+    RoutePlan* r = &e->route;
+    if (!Elevator_route_from(e, cur, e->direction)) {
+        StopSet s = e->stops;
+        Route_build(r, &s, cur, e->direction);
+        r->version = e->stops_version;
     }
 
-    return PICK_NONE;
+    const RouteLeg* leg = &r->legs[r->head];
+    if (leg->target < 0) {
+        // 路線跑完 => 電梯會閒置在本層；記成從 (cur, NONE) 開始的空路線，閒置時不用每個 tick 重建
+        r->start_floor = (short)cur;
+        r->start_dir = DIR_NONE;
+        r->legs[0] = *leg;
+        r->head = 0;
+        r->count = 1;
+        return PICK_NONE;
+    }
+    r->head++;
+    e->target_floor = leg->target;
+    e->direction = (Direction)leg->dir;
+    return PICK_TARGET_SET;
 }
 
 /* ---------------------------
    Elevator implementation
    --------------------------- */
 
+/* 每台電梯的旗標與路線：三個旗標陣列（湊成 8 的倍數）後接路線 */
+static size_t flags_size(int floors) {
+    return ((size_t)3 * (size_t)floors + 7) & ~(size_t)7;
+}
+
+size_t Elevator_storage_size(int floors) {
+    if (floors < 1) floors = 1;
+    if (floors > MAX_FLOORS) floors = MAX_FLOORS;
+    return flags_size(floors) + sizeof(RouteLeg) * (size_t)ROUTE_LEGS(floors);
+}
+
+void Elevator_attach(Elevator* e, void* mem, int floors) {
+    if (!e || !mem) return;
+    if (floors < 1) floors = 1;
+    if (floors > MAX_FLOORS) floors = MAX_FLOORS;
+    bool* flags = (bool*)mem;
+    e->call_up = flags;
+    e->call_down = flags + floors;
+    e->inside = flags + 2 * floors;
+    e->floor_cap = floors;
+    e->route.legs = (RouteLeg*)((unsigned char*)mem + flags_size(floors));
+    e->route.cap = (short)ROUTE_LEGS(floors);
+    e->route.count = 0;
+    e->route.head = 0;
+}
+
+/* 複製到 dst 自己的儲存空間（struct 直接複製會共用旗標陣列） */
+int Elevator_copy(Elevator* dst, const Elevator* src) {
+    if (!dst || !src || dst->floor_cap < src->floors) return -1;
+    bool* up = dst->call_up;
+    bool* down = dst->call_down;
+    bool* inside = dst->inside;
+    RouteLeg* legs = dst->route.legs;
+    int floor_cap = dst->floor_cap;
+    short cap = dst->route.cap;
+    *dst = *src;
+    dst->call_up = up;
+    dst->call_down = down;
+    dst->inside = inside;
+    dst->floor_cap = floor_cap;
+    dst->route.legs = legs;
+    dst->route.cap = cap;
+    memcpy(up, src->call_up, (size_t)src->floors);
+    memcpy(down, src->call_down, (size_t)src->floors);
+    memcpy(inside, src->inside, (size_t)src->floors);
+    if (src->route.count <= cap) {
+        memcpy(legs, src->route.legs, sizeof(RouteLeg) * (size_t)src->route.count);
+    } else {
+        // 放不下 => 路線作廢，下次選層重建
+        dst->route.count = 0;
+        dst->route.head = 0;
+        dst->route.version = dst->stops_version - 1u;
+    }
+    return 0;
+}
+
 /* 初始化 */
 void Elevator_init(Elevator* e, int id, int start_floor) {
     if (!e) return;
@@ -164,14 +409,47 @@ void Elevator_init(Elevator* e, int id, int start_floor) {
     e->task_state = TASK_IDLE;
     e->door_timer_s = 0.0;
     e->speed_fps = DEFAULT_SPEED_FPS;
+    e->door_open_s = DEFAULT_DOOR_OPEN_S;
+    e->floors = e->floor_cap;
+    e->in_service = true;
+    e->parking = false;
+    e->capacity = 0;
+    e->load = 0;
     e->direction = DIR_NONE;
     /* clear flags */
-    for (int f = 0; f < MAX_FLOORS; ++f) {
+    for (int f = 0; f < e->floor_cap; ++f) {
         e->call_up[f] = false;
         e->call_down[f] = false;
         e->inside[f] = false;
     }
-    if (id >= 0 && id < MAX_ELEVATORS) g_accum_time[id] = 0.0;
+    for (int w = 0; w < STOPSET_WORDS; ++w) e->served[w] = 0;
+    for (int f = 0; f < e->floor_cap; ++f) bit_set(e->served, f);
+    e->route.count = 0;
+    e->route.head = 0;
+    Elevator_mark_stops_changed(e);
+    e->accum_time = 0.0;
+}
+
+/* 套用大樓描述中的單台電梯參數 */
+void Elevator_configure(Elevator* e, int floors, double speed_fps, double door_open_s, const uint64_t* served) {
+    if (!e) return;
+    if (floors < 1) floors = 1;
+    if (floors > e->floor_cap) floors = e->floor_cap;
+    e->floors = floors;
+    if (speed_fps > 0.0) e->speed_fps = speed_fps;
+    if (door_open_s > 0.0) e->door_open_s = door_open_s;
+    for (int w = 0; w < STOPSET_WORDS; ++w) e->served[w] = 0;
+    for (int f = 0; f < floors; ++f) {
+        if (!served || StopSet_get(served, f)) bit_set(e->served, f);
+    }
+    // 不再停靠（或超出大樓）的樓層上的旗標直接丟掉
+    for (int f = 0; f < e->floor_cap; ++f) {
+        if (Elevator_serves(e, f)) continue;
+        e->call_up[f] = false;
+        e->call_down[f] = false;
+        e->inside[f] = false;
+    }
+    Elevator_mark_stops_changed(e);
 }
 
 /* 電梯狀態機 */
@@ -204,12 +482,12 @@ void Elevator_step(Elevator* e, double dt_seconds) {
 
     switch (e->task_state) {
     case TASK_DOOR_OPENING:  // 當前狀態：正在開門
-        printf("[ELEV_STATUS] E%d STATE: DOOR_OPENING (TASK_DOOR_OPENING) - floor=%d target=%d\n",
-               e->id, e->current_floor, e->target_floor);
+        CORE_LOG("[ELEV_STATUS] E%d STATE: DOOR_OPENING (TASK_DOOR_OPENING) - floor=%d target=%d\n",
+                 e->id, e->current_floor, e->target_floor);
         // 可插入延遲或動畫
         // 目前直接打開
         e->task_state = TASK_DOOR_OPEN;
-        e->door_timer_s = DEFAULT_DOOR_OPEN_S;
+        e->door_timer_s = e->door_open_s;
         return;
 
     case TASK_DOOR_OPEN:  // 當前狀態：門正開著，計時，計時到了改為關閉
@@ -220,7 +498,7 @@ void Elevator_step(Elevator* e, double dt_seconds) {
         // 若時間到 => 取得下個停靠
         if (e->door_timer_s <= 0.0) {
             e->door_timer_s = 0.0;
-            printf("[ELEV_STATUS] E%d ACTION: door closed, selecting next target (door_timer expired)\n", e->id);
+            CORE_LOG("[ELEV_STATUS] E%d ACTION: door closed, selecting next target (door_timer expired)\n", e->id);
             remove_served_flags_on_arrival(e, e->current_floor, e->direction);
 
             /* pick next target according to flags */
@@ -229,6 +507,7 @@ void Elevator_step(Elevator* e, double dt_seconds) {
                 if (e->target_floor > e->current_floor) e->direction = DIR_UP;
                 else if (e->target_floor < e->current_floor) e->direction = DIR_DOWN;
                 else e->direction = DIR_NONE;
+                clear_departing_call(e);
                 e->task_state = TASK_PREPARE;
             } else {
                 e->task_state = TASK_IDLE;
@@ -238,8 +517,8 @@ void Elevator_step(Elevator* e, double dt_seconds) {
         return;
 
     case TASK_DOOR_CLOSING:  // 當前狀態：正在關門
-        printf("[ELEV_STATUS] E%d STATE: DOOR_CLOSING (TASK_DOOR_CLOSING) - floor=%d\n",
-               e->id, e->current_floor);
+        CORE_LOG("[ELEV_STATUS] E%d STATE: DOOR_CLOSING (TASK_DOOR_CLOSING) - floor=%d\n",
+                 e->id, e->current_floor);
         // 可插入延遲或動畫
         // 目前直接關閉
         remove_served_flags_on_arrival(e, e->current_floor, e->direction);
@@ -247,6 +526,7 @@ void Elevator_step(Elevator* e, double dt_seconds) {
             if (e->target_floor > e->current_floor) e->direction = DIR_UP;
             else if (e->target_floor < e->current_floor) e->direction = DIR_DOWN;
             else e->direction = DIR_NONE;
+            clear_departing_call(e);
             e->task_state = TASK_PREPARE;
         } else {
             e->task_state = TASK_IDLE;
@@ -260,7 +540,13 @@ void Elevator_step(Elevator* e, double dt_seconds) {
         // 若直接收到相同樓層請求 => 立即開門
         if (e->target_floor == e->current_floor) {
             // 直接當作已抵達 => 開門 & 移除請求
+            // 沒有行進方向，外呼不會在離開時被清除，所以兩個方向都在這裡清掉
             e->task_state = TASK_DOOR_OPENING;
+            if (e->direction == DIR_NONE) {
+                int cleared = clear_stop_flag(e, e->call_up, e->current_floor);
+                cleared |= clear_stop_flag(e, e->call_down, e->current_floor);
+                if (cleared) bump_stops_version(e, 1);
+            }
             remove_served_flags_on_arrival(e, e->current_floor, e->direction);
             return;
         }
@@ -277,57 +563,50 @@ void Elevator_step(Elevator* e, double dt_seconds) {
         // 直接進入移動所以不 break
 
     case TASK_MOVING:  // 當前狀態：正在移動
+        // 前往待命樓層途中有了請求 => 放棄待命，從目前位置重新選目標
+        if (e->parking && elevator_has_stops(e)) {
+            e->parking = false;
+            if (pick_next_target_flag(e)) {
+                if (e->target_floor > e->current_floor) e->direction = DIR_UP;
+                else if (e->target_floor < e->current_floor) e->direction = DIR_DOWN;
+                else e->direction = DIR_NONE;
+                e->task_state = TASK_PREPARE;
+                return;
+            }
+        }
         double speed = (e->speed_fps > 0.0) ? e->speed_fps : DEFAULT_SPEED_FPS;
         double time_per_floor = 1.0 / speed;
         /*printf("[ELEV_STATUS] E%d STATE: MOVING (TASK_MOVING) - speed=%.3f floors/sec time_per_floor=%.3f cur=%d target=%d\n",
                e->id, speed, time_per_floor, e->current_floor, e->target_floor);*/
 
-        if (e->id >= 0 && e->id < MAX_ELEVATORS) {
-            g_accum_time[e->id] += dt_seconds;
-            while (g_accum_time[e->id] >= time_per_floor) {
-                g_accum_time[e->id] -= time_per_floor;
-
-                int from_floor = e->current_floor;
+        {
+            /* 0.1s => 0.5s => 直到 1.0s => 減 1 秒 & 移動一層樓 */
+            e->accum_time += dt_seconds;
+            while (e->accum_time >= time_per_floor) {
+                e->accum_time -= time_per_floor;
 
                 if (e->current_floor < e->target_floor) {
                     e->current_floor++;
-                    printf("[ELEV_STEP] E%d moved up: %d -> %d\n", e->id, e->current_floor - 1, e->current_floor);
-
-                    // 往上離開 from_floor，視為已服務該層的「往上」乘客
-                    if (from_floor >= 0 && from_floor < MAX_FLOORS) {
-                        if (e->call_up[from_floor]) {
-                            e->call_up[from_floor] = false;
-                            printf("[ELEV_DEBUG] E%d cleared call_up at floor %d when moving up\n", e->id, from_floor);
-                        }
-                    }
+                    CORE_LOG("[ELEV_STEP] E%d moved up: %d -> %d\n", e->id, e->current_floor - 1, e->current_floor);
                 } else if (e->current_floor > e->target_floor) {
                     e->current_floor--;
-                    printf("[ELEV_STEP] E%d moved down: %d -> %d\n", e->id, e->current_floor + 1, e->current_floor);
-
-                    // 往下離開 from_floor，視為已服務該層的「往下」乘客
-                    if (from_floor >= 0 && from_floor < MAX_FLOORS) {
-                        if (e->call_down[from_floor]) {
-                            e->call_down[from_floor] = false;
-                            printf("[ELEV_DEBUG] E%d cleared call_down at floor %d when moving down\n", e->id, from_floor);
-                        }
-                    }
+                    CORE_LOG("[ELEV_STEP] E%d moved down: %d -> %d\n", e->id, e->current_floor + 1, e->current_floor);
+                }
+
+                // 經過的樓層有同向請求（行進中才指派的內呼 / 同向外呼）=> 就地停靠，不直接駛過
+                int at = e->current_floor;
+                if (at != e->target_floor && at >= 0 && at < e->floors &&
+                    (e->inside[at] || (e->direction == DIR_UP ? e->call_up[at] : e->call_down[at]))) {
+                    CORE_LOG("[ELEV_STEP] E%d stopping at %d on the way to %d\n", e->id, at, e->target_floor);
+                    e->target_floor = at;
                 }
 
                 // 到達目標 => break 掉 while & 準備開門
                 if (e->current_floor == e->target_floor) {
-                    printf("[ELEV_STEP] E%d ARRIVED at %d -> opening door\n", e->id, e->current_floor);
+                    CORE_LOG("[ELEV_STEP] E%d ARRIVED at %d -> opening door\n", e->id, e->current_floor);
                     break;
                 }
             }
-        } else {
-            /* fallback：每 step 最多移一層（保守行為） */
-            if (e->current_floor < e->target_floor) {
-                e->current_floor++;
-                printf("[ELEV_STEP] E%d (fallback) moved up to %d\n", e->id, e->current_floor);
-            } else if (e->current_floor > e->target_floor) {
-                e->current_floor--;
-                printf("[ELEV_STEP] E%d (fallback) moved down to %d\n", e->id, e->current_floor);
-            }
         }
 
         // 到達目標 => 狀態設為到達
@@ -337,10 +616,19 @@ void Elevator_step(Elevator* e, double dt_seconds) {
         return;
 
     case TASK_ARRIVED:  // 當前狀態：抵達目標樓層 => 開門 & 移除請求
-        printf("[ELEV_STATUS] E%d STATE: ARRIVED (TASK_ARRIVED) - floor=%d, opening door and removing stops\n",
-               e->id, e->current_floor);
+        // 抵達待命樓層且沒有請求 => 不開門，直接閒置
+        if (e->parking) {
+            e->parking = false;
+            if (!elevator_has_stops(e)) {
+                e->task_state = TASK_IDLE;
+                e->direction = DIR_NONE;
+                return;
+            }
+        }
+        CORE_LOG("[ELEV_STATUS] E%d STATE: ARRIVED (TASK_ARRIVED) - floor=%d, opening door and removing stops\n",
+                 e->id, e->current_floor);
         e->task_state = TASK_DOOR_OPENING;
-        e->door_timer_s = DEFAULT_DOOR_OPEN_S;
+        e->door_timer_s = e->door_open_s;
         // 移除請求
         remove_served_flags_on_arrival(e, e->current_floor, e->direction);
         return;
@@ -359,7 +647,7 @@ void Elevator_step(Elevator* e, double dt_seconds) {
             else
                 e->direction = DIR_NONE;
             e->task_state = TASK_PREPARE;
-            printf("[ELEV_STATUS] E%d IDLE -> chose target=%d dir=%d\n", e->id, e->target_floor, e->direction);
+            CORE_LOG("[ELEV_STATUS] E%d IDLE -> chose target=%d dir=%d\n", e->id, e->target_floor, e->direction);
         } else {
             /* remain idle */
             e->task_state = TASK_IDLE;
@@ -368,22 +656,56 @@ void Elevator_step(Elevator* e, double dt_seconds) {
     } /* end switch */
 }
 
+/* 空車移往待命樓層 */
+int Elevator_park(Elevator* e, int floor) {
+    if (!e) return ELEV_ERR_INVALID;
+    if (!Elevator_serves(e, floor)) return ELEV_ERR_INVALID;
+    if (e->task_state != TASK_IDLE || elevator_has_stops(e) || e->current_floor == floor) return ELEV_IGNORED;
+    e->target_floor = floor;
+    e->direction = (floor > e->current_floor) ? DIR_UP : DIR_DOWN;
+    e->parking = true;
+    e->task_state = TASK_PREPARE;
+    return ELEV_OK;
+}
+
+/* 乘客還在進出 => 延長開門時間（只延長、不縮短） */
+int Elevator_hold_door(Elevator* e, double seconds) {
+    if (!e) return ELEV_ERR_INVALID;
+    if (e->task_state != TASK_DOOR_OPEN) return ELEV_IGNORED;
+    if (e->door_timer_s < seconds) {
+        e->door_timer_s = seconds;
+        bump_stops_version(e, 1);  // 停靠不變，但 ETA 快取要重算（關門時間延後了）
+    }
+    return ELEV_OK;
+}
+
+/* 取得 / 設定移動累積時間（存檔與還原用） */
+double Elevator_get_accum_time(const Elevator* e) {
+    return e ? e->accum_time : 0.0;
+}
+
+void Elevator_set_accum_time(Elevator* e, double seconds) {
+    if (e) e->accum_time = seconds;
+}
+
 /* 回傳電梯狀態文字(顯示用) */
 const char* Elevator_status_line(Elevator* e, char* out, int out_size) {
     if (!e || !out || out_size <= 0) return NULL;
     const char* dstr = (e->direction == DIR_UP) ? "UP" : (e->direction == DIR_DOWN) ? "DOWN" : "NONE";
     int off = 0;
     off += snprintf(out+off, (off < out_size)? out_size-off : 0, "[E%d] cur=%d tgt=%d dir=%s | up:", e->id, e->current_floor, e->target_floor, dstr);
-    for (int f = 0; f < MAX_FLOORS && off < out_size-8; ++f) {
+    for (int f = 0; f < e->floors && off < out_size-8; ++f) {
         if (e->call_up[f]) off += snprintf(out+off, out_size-off, "%d,", f);
     }
     off += snprintf(out+off, (off < out_size)? out_size-off : 0, " down:");
-    for (int f = 0; f < MAX_FLOORS && off < out_size-8; ++f) {
+    for (int f = 0; f < e->floors && off < out_size-8; ++f) {
         if (e->call_down[f]) off += snprintf(out+off, out_size-off, "%d,", f);
     }
     off += snprintf(out+off, (off < out_size)? out_size-off : 0, " inside:");
-    for (int f = 0; f < MAX_FLOORS && off < out_size-8; ++f) {
+    for (int f = 0; f < e->floors && off < out_size-8; ++f) {
         if (e->inside[f]) off += snprintf(out+off, out_size-off, "%d,", f);
     }
+    if (!e->in_service && off < out_size) off += snprintf(out+off, out_size-off, " [OUT]");
+    if (e->parking && off < out_size) snprintf(out+off, out_size-off, " [PARK]");
     return out;
 }
@@ -3,14 +3,16 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #ifndef ELEVATOR_H
 #define ELEVATOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,11 +22,14 @@ extern "C" {
     Configurations
     --------------------------- */
 
-#define MAX_ELEVATORS 8
+/* 編譯期上限：實際樓層數 / 電梯數由大樓描述決定（building.h），只要不超過上限不必重新編譯 */
+#ifndef MAX_ELEVATORS
+#define MAX_ELEVATORS 32  // 排程器以 32 位元遮罩記錄哪些電梯掛著同一筆外呼
+#endif
 #define MAX_REQUESTS 256
 
 #ifndef MAX_FLOORS
-#define MAX_FLOORS 100
+#define MAX_FLOORS 256
 #endif
 
 /* ---------------------------
@@ -35,7 +40,7 @@ extern "C" {
 typedef enum {
     TASK_IDLE = 0,        // 閒置
     TASK_PREPARE,         // 已有下一個目標，還沒開始移動（設定 target，但尚未變 direction/moving）
-    TASK_MOVING,          // 正在行駛（使用 g_accum_time 移動 current_floor）
+    TASK_MOVING,          // 正在行駛（使用 accum_time 移動 current_floor）
     TASK_ARRIVED,         // 已抵達目標（剛到、剛開門前的過渡）
     TASK_DOOR_OPENING,    // 正在開門（若要做開門動畫，可用）
     TASK_DOOR_OPEN,       // 門開著（目前等候倒數關門）
@@ -70,8 +75,36 @@ typedef struct {
     RequestType type;   // REQ_CALL_UP / REQ_CALL_DOWN / REQ_INSIDE
     int source_id;      // 外呼來源（client/panel id），INSIDE 可設 -1
     int to_floor;       // INSIDE 用；外呼可設 -1
+    double enqueue_s;   // 進入佇列的虛擬時間（秒，核心 tick × tick 長度）
+    unsigned request_id;  // 非 0 => 發出者有訂閱，要回報指派／靠站／服務
 } PendingRequest;
 
+/* 停靠旗標的位元集合（bit f = 第 f 層） */
+#define STOPSET_WORDS ((MAX_FLOORS + 63) / 64)
+typedef struct {
+    uint64_t up[STOPSET_WORDS];
+    uint64_t down[STOPSET_WORDS];
+    uint64_t inside[STOPSET_WORDS];
+} StopSet;
+
+/* 停靠路線：之後每一次關門選層的結果（SCAN 順序） */
+#define ROUTE_LEGS(floors) (4 * (floors) + 8)  // 每層最多停兩次，另加折返
+#define ROUTE_MAX_LEGS ROUTE_LEGS(MAX_FLOORS)
+typedef struct {
+    short target;       // 下一個停靠樓層（-1 = 路線結束，電梯閒置）
+    signed char dir;    // 出發方向（DIR_NONE = 原地重新開門）
+} RouteLeg;
+
+typedef struct {
+    unsigned int version;  // 對應的 stops_version（電梯自己照路線清旗標時跟著更新）
+    short start_floor;     // 第一次選層時所在樓層 / 方向
+    signed char start_dir;
+    short head;            // 下一次選層用的 leg
+    short count;
+    short cap;             // legs 的格數
+    RouteLeg* legs;
+} RoutePlan;
+
 /* 電梯資料結構 */
 typedef struct {
     int id;                   // 電梯 ID
@@ -80,31 +113,158 @@ typedef struct {
     TaskState task_state;     // 當前運行狀態
     double door_timer_s;      // 開門剩餘時間（秒）
     double speed_fps;         // 電梯運行速率
+    double door_open_s;       // 每次停靠開門時長（秒）
+    int floors;               // 大樓樓層數（有效樓層 0 .. floors - 1，<= MAX_FLOORS）
+    bool in_service;          // false = 停用（維修）：排程器不再派外呼，車內乘客照常送達
+    bool parking;             // 空車移往待命樓層中（抵達不開門，途中有請求就放棄）
     Direction direction;      // 電梯運行方向
-    bool call_up[MAX_FLOORS];
-    bool call_down[MAX_FLOORS];
-    bool inside[MAX_FLOORS];
+    double accum_time;        // 往下一層累積的移動時間（秒，滿 1 / speed_fps 就移動一層）
+    bool* call_up;            // 旗標陣列各 floor_cap 格（Elevator_attach 指定的儲存空間）
+    bool* call_down;
+    bool* inside;
+    int floor_cap;            // 儲存空間容納的樓層數（floors <= floor_cap）
+    unsigned int stops_version; // 停靠旗標變動或延長開門時就加一（ETA 快取失效用，重新初始化也不歸零）
+    StopSet stops;              // 與 call_up / call_down / inside 同步的位元集合
+    int request_count;          // 旗標總數（內呼 + 上 + 下）
+    int stop_floors;            // 有任何請求的樓層數
+    RoutePlan route;            // 快取的停靠路線（旗標被外部改變時才重建）
+    uint64_t served[STOPSET_WORDS];  // 可停靠的樓層（bit f = 第 f 層）
+    int capacity;               // 額定載客人數（0 = 不限）
+    int load;                   // 車內人數（乘客模擬填入；沒有秤重時維持 0）
 } Elevator;
 
+/* Motion defaults (elevator.c) */
+extern const double DEFAULT_SPEED_FPS;
+extern const double DEFAULT_DOOR_OPEN_S;
+
 /* Elevator APIs */
+/* Per-floor storage of a car (call_up / call_down / inside and the route
+ * legs) lives outside the struct, sized for the building: reserve
+ * Elevator_storage_size(floors) bytes (8-byte aligned, e.g. from a building
+ * arena) and Elevator_attach them before Elevator_init. The memory must
+ * outlive the car. A plain struct copy shares the storage; use
+ * Elevator_copy for an independent copy.
+ */
+size_t Elevator_storage_size(int floors);
+void Elevator_attach(Elevator* e, void* mem, int floors);
+
+/* Copy the whole state of src into dst, flags and route into dst's own
+ * storage. Returns 0, or -1 if dst's storage holds fewer floors than src.
+ */
+int Elevator_copy(Elevator* dst, const Elevator* src);
+
+/* Reset a car: no calls, idle at start_floor, in service, default speed and
+ * door time, as many floors as its storage holds, every floor served. Use
+ * Elevator_configure (or building_configure_car) afterwards for a described
+ * building.
+ */
 void Elevator_init(Elevator* e, int id, int start_floor);
+
+/* Per-car parameters from a building description. `floors` is clamped to
+ * 1..floor_cap; served may be NULL (every floor). Speeds / door times <= 0
+ * keep the defaults. Calls on floors the car no longer serves are dropped.
+ */
+void Elevator_configure(Elevator* e, int floors, double speed_fps, double door_open_s, const uint64_t* served);
 void Elevator_step(Elevator* e, double dt_seconds);
-const char* Elevator_status_line(Elevator* e, char* out, int out_size);
+const char* Elevator_status_line(Elevator* e, char* out, int out_size);  // "[OUT]" when out of service
+
+/* Send an idle car without stops to `floor` to wait there (predictive
+ * parking). The car arrives without opening its doors; any request it gets
+ * on the way cancels the move and it serves that request instead.
+ * Returns ELEV_OK, ELEV_IGNORED if the car is busy or already there, or
+ * ELEV_ERR_INVALID for a floor it does not serve.
+ */
+int Elevator_park(Elevator* e, int floor);
+
+/* Keep the doors open for at least `seconds` more (passengers still getting
+ * on or off). Only extends the current dwell, never shortens it; an
+ * extension bumps stops_version (the cached route stays) so cached ETAs of
+ * the car are recomputed. Returns ELEV_OK, or ELEV_IGNORED if the doors are not open.
+ */
+int Elevator_hold_door(Elevator* e, double seconds);
 
 /* Local stop management (single-writer expected) */
 /* Add request into elevator stops lists using "elevator algorithm" insertion.
- * Returns 0 on success, -1 on failure (e.g. lists full).
+ * Returns 0 on success, 1 (ELEV_DUPLICATE) if already set, -1 on failure
+ * (invalid type, or a floor the car does not serve).
  */
 int elevator_add_request_flag(Elevator* e, int floor, RequestType type);
 
+/* Withdraw a request that has not been served yet (e.g. a hall call handed
+ * to another car). Returns ELEV_OK, ELEV_IGNORED if it was not set, or
+ * ELEV_ERR_INVALID.
+ */
+int elevator_remove_request_flag(Elevator* e, int floor, RequestType type);
+
 /* Helper to push an inside (car) request into appropriate list.
  * Equivalent to building ElevatorRequest and calling elevator_add_request.
  */
 int Elevator_push_inside_request(Elevator* e, int dest_floor, int client_id);
 
+/* Mark the stop flags as changed: new stops_version, rebuild stops /
+ * request_count / stop_floors and drop the cached route. Elevator APIs keep all of these up
+ * to date themselves; call it after writing call_up / call_down / inside
+ * directly.
+ */
+void Elevator_mark_stops_changed(Elevator* e);
+
 /* Query helpers (optional) */
 int elevator_has_stops(const Elevator* e);
 
+/* Choose the next stop from the car's flags (collective control: keep going
+ * in the current direction, then serve the current floor, then reverse).
+ * Updates target_floor and direction (DIR_NONE when reopening in place).
+ * Reads the next leg of the cached route in O(1); the route is rebuilt only
+ * when the flags changed other than by the car serving its own route.
+ * Exposed so simulations can predict where a car leaves to by running it on
+ * a copy.
+ */
+PickResult pick_next_target_flag(Elevator* e);
+
+/* The car's cached route if it is current and its next leg
+ * (route.legs[route.head]) is the pick the car makes from (floor, dir);
+ * NULL otherwise.
+ */
+const RoutePlan* Elevator_route_from(const Elevator* e, int floor, Direction dir);
+
+/* Route building (shared with the ETA engine).
+ * Route_build simulates every pick from (`from`, `dir`) on `s`, clearing the
+ * flags the car clears as it goes (inside on arrival, the departing
+ * direction's hall call, both hall calls when reopening in place), and ends
+ * with a target -1 leg unless r->cap legs were filled.
+ */
+void Route_build(RoutePlan* r, StopSet* s, int from, Direction dir);
+
+/* One pick of the same rule (shared with rollouts): the next stop from
+ * (`cur`, *dir) on `s`, or -1 if there is none. *dir becomes the departure
+ * direction (DIR_NONE = reopen in place / idle). Does not clear flags.
+ */
+int Route_pick(const StopSet* s, int cur, Direction* dir);
+
+static inline int StopSet_get(const uint64_t* bits, int floor) {
+    return (int)((bits[floor >> 6] >> (floor & 63)) & 1u);
+}
+
+static inline void StopSet_clear(uint64_t* bits, int floor) {
+    bits[floor >> 6] &= ~((uint64_t)1 << (floor & 63));
+}
+
+/* Whether the car can stop at `floor` (inside the building and in its served set). */
+static inline int Elevator_serves(const Elevator* e, int floor) {
+    return floor >= 0 && floor < e->floors && StopSet_get(e->served, floor);
+}
+
+/* Whether the car is at its rated load (never for capacity 0). */
+static inline int Elevator_full(const Elevator* e) {
+    return e->capacity > 0 && e->load >= e->capacity;
+}
+
+/* Travel time accumulated towards the next floor (seconds). Exposed so the
+ * full motion state can be saved and restored (checkpoint / hot upgrade).
+ */
+double Elevator_get_accum_time(const Elevator* e);
+void Elevator_set_accum_time(Elevator* e, double seconds);
+
 #ifdef __cplusplus
 }
 #endif
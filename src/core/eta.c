@@ -0,0 +1,412 @@
+/* ----- ----- ----- ----- */
+// eta.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eta.h"
+#include "building.h"
+
+#define ETA_DEFAULT_TICK_S 0.1             // 與 SERVER_CORE_DEFAULT_TICK_SECONDS 相同
+#define ETA_OPEN_TICKS 2                   // 抵達後 ARRIVED → DOOR_OPENING → DOOR_OPEN 各一個 tick
+
+/* 每台電梯的 ETA 快取 */
+typedef struct {
+    int valid;
+    unsigned int stops_version;  // 以下任一項不同就重算
+    int floor;
+    int target;
+    int state;
+    int dir;
+    double at;                   // 計算當下的 ETA 時鐘
+    unsigned long serial;        // 第幾次重算（複製端判斷是否要更新）
+    double* up;                  // floors 筆
+    double* down;
+} EtaEntry;
+
+/* 一棟大樓的 ETA 快取（以電梯 id 為索引，表的大小依大樓描述） */
+struct EtaCache {
+    EtaEntry* entries;
+    int cars;
+    int floors;
+    double clock;
+    double tick_s;              // 最近一次 eta_advance 的 tick 長度
+    unsigned long hits;
+    unsigned long recomputes;
+    unsigned long serial;       // 重算序號（eta_reset 不歸零）
+};
+
+/* 舊介面（單一大樓）使用的預設快取：核心綁上大樓 0 的快取（依大樓描述配置），
+ * 沒有綁定時才配置一份上限大小的 */
+static EtaCache* g_default = NULL;
+static EtaCache* g_fallback = NULL;
+
+/* 記錄 (floor, dir) 的 ETA（tick 數），只保留最早的一次；DIR_NONE 兩個方向都記 */
+static inline void record(double up[], double down[], int f, Direction dir, long t) {
+    if (dir != DIR_DOWN && up[f] < 0.0) up[f] = (double)t;
+    if (dir != DIR_UP && down[f] < 0.0) down[f] = (double)t;
+}
+
+/* 門開著倒數到關門需要幾個 tick（與 Elevator_step 相同的浮點遞減） */
+static long door_ticks(double remaining_s, double tick_s) {
+    long n = 0;
+    while (remaining_s > 0.0 && n < 1000000L) {
+        remaining_s -= tick_s;
+        ++n;
+    }
+    return n;
+}
+
+/* 模擬中的電梯狀態（時間單位：tick） */
+typedef struct {
+    StopSet s;
+    double accum;           // 往下一層累積的移動時間（跨路段保留，同 Elevator.accum_time）
+    double tick_s;
+    double time_per_floor;
+} SimCar;
+
+/* 從 from 開到 to，t0 之後的每個 tick 累積移動時間（與 TASK_MOVING 相同）
+ * 途經樓層記錄「若有同向外呼會在此停下」的開門時間，回傳抵達 to 的 tick */
+static long run_leg(SimCar* c, int from, int to, Direction dir, long t0, double up[], double down[]) {
+    long t = t0;
+    for (int f = from + (int)dir;; f += (int)dir) {
+        while (c->accum < c->time_per_floor) {
+            c->accum += c->tick_s;
+            ++t;
+        }
+        c->accum -= c->time_per_floor;
+        if (f == to) break;
+        record(up, down, f, dir, t + ETA_OPEN_TICKS);
+    }
+    return t;
+}
+
+/* ---------------------------
+   ETA computation
+   --------------------------- */
+
+/* 依電梯目前狀態模擬整條停靠路線，填入每層兩個方向的 ETA */
+void eta_compute(const Elevator* e, double tick_s, double up[], double down[]) {
+    if (!up || !down || !e) return;
+    const int floors = e->floors;
+    for (int f = 0; f < floors; ++f) up[f] = down[f] = -1.0;
+    if (e->task_state == TASK_ERROR || tick_s <= 0.0) return;
+    if (e->current_floor < 0 || e->current_floor >= floors) return;
+
+    SimCar c;
+    c.s = e->stops;
+    c.tick_s = tick_s;
+    c.time_per_floor = 1.0 / ((e->speed_fps > 0.0) ? e->speed_fps : DEFAULT_SPEED_FPS);
+    c.accum = Elevator_get_accum_time(e);
+    const long door = door_ticks((e->door_open_s > 0.0) ? e->door_open_s : DEFAULT_DOOR_OPEN_S, tick_s);
+
+    // 以下時間都是「從現在起第幾個 tick」
+    int p = e->current_floor;
+    Direction d = e->direction;
+    long t = 0;              // 下一次關門選目標的 tick
+    long last_open = -1;     // 本層這次停靠開門的 tick（-1 = 還沒開門）
+    long idle_after = 1;     // 路線跑完後，新請求要等下一個 tick 的 IDLE 才會被選到
+
+    // 前往待命樓層的空車一有請求就從目前位置重新出發 => 當作閒置
+    switch (e->parking ? TASK_IDLE : e->task_state) {
+        case TASK_IDLE:
+            t = 1;
+            idle_after = 0;
+            break;
+        case TASK_ARRIVED:
+            StopSet_clear(c.s.inside, p);
+            last_open = ETA_OPEN_TICKS;
+            t = last_open + door;
+            break;
+        case TASK_DOOR_OPENING:
+            last_open = 1;
+            t = last_open + door;
+            break;
+        case TASK_DOOR_OPEN:
+            last_open = 0;
+            t = door_ticks(e->door_timer_s, tick_s);
+            break;
+        case TASK_DOOR_CLOSING:
+            last_open = 0;
+            t = 1;
+            break;
+        case TASK_PREPARE:
+        case TASK_MOVING: {
+            int target = e->target_floor;
+            if (target < 0 || target >= floors) break;
+            if (target == p) {
+                // PREPARE 原地開門：沒有方向時本層兩個方向的外呼都算服務
+                if (d == DIR_NONE) {
+                    StopSet_clear(c.s.up, p);
+                    StopSet_clear(c.s.down, p);
+                }
+                last_open = ETA_OPEN_TICKS;
+                t = last_open + door;
+                break;
+            }
+            d = (target > p) ? DIR_UP : DIR_DOWN;
+            // 途中若有同向請求會先停（elevator.c 行進中停靠）
+            const uint64_t* same = (d == DIR_UP) ? c.s.up : c.s.down;
+            for (int f = p + (int)d; f != target; f += (int)d) {
+                if (StopSet_get(c.s.inside, f) || StopSet_get(same, f)) {
+                    target = f;
+                    break;
+                }
+            }
+            long arrive = run_leg(&c, p, target, d, 0, up, down);
+            p = target;
+            last_open = arrive + ETA_OPEN_TICKS;
+            t = last_open + door;
+            break;
+        }
+        default:
+            break;
+    }
+
+    // 依序走過每一次關門選目標的結果，直到路線跑完
+    // 電梯快取的路線正好從 (p, d) 接續 => 直接用，否則在複本上從頭排一次
+    const RoutePlan* plan = Elevator_route_from(e, p, d);
+    RouteLeg legs[ROUTE_MAX_LEGS];  // 暫存，只在這次估算用
+    RoutePlan local = { .cap = (short)ROUTE_LEGS(floors), .legs = legs };
+    if (!plan) {
+        if (last_open >= 0) StopSet_clear(c.s.inside, p);  // 開過門 => 本層內呼已下車
+        Route_build(&local, &c.s, p, d);
+        plan = &local;
+    }
+    for (int i = plan->head; i < plan->count; ++i) {
+        int next = plan->legs[i].target;
+        Direction nd = (Direction)plan->legs[i].dir;
+        if (next < 0) {
+            if (last_open >= 0) record(up, down, p, DIR_NONE, last_open);
+            break;
+        }
+        if (next == p) {
+            // 原地再開一次門（乘客在第一次開門時就能上車）
+            long open = t + ETA_OPEN_TICKS;
+            record(up, down, p, DIR_NONE, (last_open >= 0) ? last_open : open);
+            last_open = open;
+            t = open + door;
+            continue;
+        }
+        // 關門往 nd 方向出發：這次開門即服務該方向的乘客
+        if (last_open >= 0) record(up, down, p, nd, last_open);
+        long arrive = run_leg(&c, p, next, nd, t, up, down);
+        p = next;
+        last_open = arrive + ETA_OPEN_TICKS;
+        t = last_open + door;
+    }
+
+    // 路線跑完後閒置在 p：其餘樓層直接開過去（不再逐 tick 模擬，取整即可）
+    long base = t + idle_after;
+    for (int f = 0; f < floors; ++f) {
+        double travel = abs(f - p) * c.time_per_floor - c.accum;
+        long v = base + ((travel > 0.0) ? (long)ceil(travel / tick_s - 1e-9) : 0) + ETA_OPEN_TICKS;
+        record(up, down, f, DIR_NONE, v);
+    }
+
+    // tick 數換成秒；不停靠的樓層（途經的也一樣）沒有 ETA
+    for (int f = 0; f < floors; ++f) {
+        if (!StopSet_get(e->served, f)) {
+            up[f] = down[f] = -1.0;
+            continue;
+        }
+        up[f] *= tick_s;
+        down[f] *= tick_s;
+    }
+}
+
+/* ---------------------------
+   Cache
+   --------------------------- */
+
+/* 快取的鍵值是否與電梯目前狀態一致 */
+static int entry_matches(const EtaEntry* c, const Elevator* e) {
+    return c->valid &&
+           c->stops_version == e->stops_version &&
+           c->floor == e->current_floor &&
+           c->target == e->target_floor &&
+           c->state == (int)e->task_state &&
+           c->dir == (int)e->direction;
+}
+
+/* 取得電梯的 ETA 表（必要時重算），回傳 NULL 表示無法快取 */
+static const EtaEntry* cached_table(EtaCache* k, const Elevator* e) {
+    if (!k || !e || e->id < 0 || e->id >= k->cars || e->floors > k->floors) return NULL;
+    EtaEntry* c = &k->entries[e->id];
+    if (entry_matches(c, e)) {
+        // 閒置電梯不會照路線前進，表上的時間不隨時鐘倒數
+        if (e->task_state == TASK_IDLE) c->at = k->clock;
+        k->hits++;
+        return c;
+    }
+    eta_compute(e, k->tick_s, c->up, c->down);
+    c->valid = 1;
+    c->stops_version = e->stops_version;
+    c->floor = e->current_floor;
+    c->target = e->target_floor;
+    c->state = (int)e->task_state;
+    c->dir = (int)e->direction;
+    c->at = k->clock;
+    c->serial = ++k->serial;
+    k->recomputes++;
+    return c;
+}
+
+double eta_cache_car(EtaCache* k, const Elevator* e, int floor, Direction dir) {
+    if (!k || !e || floor < 0 || floor >= e->floors) return -1.0;
+
+    const EtaEntry* c = cached_table(k, e);
+    double up, down, elapsed = 0.0;
+    if (c) {
+        up = c->up[floor];
+        down = c->down[floor];
+        elapsed = k->clock - c->at;
+    } else {
+        // 電梯 id / 樓層數超出快取範圍 => 直接算，不快取
+        double tu[MAX_FLOORS], td[MAX_FLOORS];
+        eta_compute(e, k->tick_s, tu, td);
+        up = tu[floor];
+        down = td[floor];
+    }
+
+    double v;
+    if (dir == DIR_UP) v = up;
+    else if (dir == DIR_DOWN) v = down;
+    else v = (up >= 0.0 && (down < 0.0 || up < down)) ? up : down;
+    if (v < 0.0) return -1.0;
+
+    // 快取之後電梯照預測前進，剩餘時間跟著時鐘倒數
+    v -= elapsed;
+    return (v > 0.0) ? v : 0.0;
+}
+
+int eta_cache_table(EtaCache* k, const Elevator* e, const double** up, const double** down,
+                    double* computed_at, unsigned long* serial) {
+    const EtaEntry* c = cached_table(k, e);
+    if (!c) return -1;
+    if (up) *up = c->up;
+    if (down) *down = c->down;
+    if (computed_at) *computed_at = c->at;
+    if (serial) *serial = c->serial;
+    return 0;
+}
+
+void eta_cache_advance(EtaCache* k, double dt) {
+    if (!k || dt <= 0.0) return;
+    k->clock += dt;
+    k->tick_s = dt;
+}
+
+double eta_cache_now(const EtaCache* k) {
+    return k ? k->clock : 0.0;
+}
+
+void eta_cache_reset(EtaCache* k) {
+    if (!k) return;
+    for (int i = 0; i < k->cars; ++i) k->entries[i].valid = 0;
+    k->clock = 0.0;
+    k->hits = 0;
+    k->recomputes = 0;
+}
+
+void eta_cache_invalidate(EtaCache* k, int car) {
+    if (!k || car < 0 || car >= k->cars) return;
+    k->entries[car].valid = 0;
+}
+
+void eta_cache_get_stats(const EtaCache* k, unsigned long* hits, unsigned long* recomputes) {
+    if (hits) *hits = k ? k->hits : 0;
+    if (recomputes) *recomputes = k ? k->recomputes : 0;
+}
+
+/* 依 cars x floors 在同一塊記憶體中排出快取（base = NULL 只計算大小） */
+static size_t cache_layout(BuildingArena* a, EtaCache** out, int cars, int floors) {
+    EtaCache* k = (EtaCache*)building_arena_take(a, sizeof(EtaCache));
+    EtaEntry* entries = (EtaEntry*)building_arena_take(a, sizeof(EtaEntry) * (size_t)cars);
+    double* tables = (double*)building_arena_take(a, sizeof(double) * 2 * (size_t)cars * (size_t)floors);
+    if (k) {
+        memset(k, 0, sizeof(*k));
+        k->entries = entries;
+        k->cars = cars;
+        k->floors = floors;
+        k->tick_s = ETA_DEFAULT_TICK_S;
+        for (int i = 0; i < cars; ++i) {
+            memset(&entries[i], 0, sizeof(EtaEntry));
+            entries[i].up = tables + (size_t)(2 * i) * floors;
+            entries[i].down = tables + (size_t)(2 * i + 1) * floors;
+        }
+    }
+    if (out) *out = k;
+    return a->used;
+}
+
+size_t eta_cache_size(int cars, int floors) {
+    BuildingArena a = { NULL, 0 };
+    return cache_layout(&a, NULL, cars, floors);
+}
+
+EtaCache* eta_cache_init_at(void* mem, int cars, int floors) {
+    if (!mem || cars < 1 || cars > MAX_ELEVATORS || floors < 1 || floors > MAX_FLOORS) return NULL;
+    BuildingArena a = { (unsigned char*)mem, 0 };
+    EtaCache* k = NULL;
+    cache_layout(&a, &k, cars, floors);
+    return k;
+}
+
+/* 建立 / 釋放一棟大樓的快取 */
+EtaCache* eta_cache_create(int cars, int floors) {
+    if (cars < 1 || cars > MAX_ELEVATORS || floors < 1 || floors > MAX_FLOORS) return NULL;
+    void* mem = malloc(eta_cache_size(cars, floors));
+    return mem ? eta_cache_init_at(mem, cars, floors) : NULL;
+}
+
+void eta_cache_destroy(EtaCache* k) {
+    if (k == g_fallback) return;
+    free(k);
+}
+
+EtaCache* eta_default_cache(void) {
+    if (g_default) return g_default;
+    if (!g_fallback) g_fallback = eta_cache_create(MAX_ELEVATORS, MAX_FLOORS);
+    return g_fallback;
+}
+
+void eta_set_default_cache(EtaCache* k) {
+    g_default = k;
+}
+
+/* ---------------------------
+   Default cache (single building)
+   --------------------------- */
+
+double eta_car(const Elevator* e, int floor, Direction dir) {
+    return eta_cache_car(eta_default_cache(), e, floor, dir);
+}
+
+int eta_table(const Elevator* e, const double** up, const double** down,
+              double* computed_at, unsigned long* serial) {
+    return eta_cache_table(eta_default_cache(), e, up, down, computed_at, serial);
+}
+
+void eta_advance(double dt) {
+    eta_cache_advance(eta_default_cache(), dt);
+}
+
+double eta_now(void) {
+    return eta_cache_now(eta_default_cache());
+}
+
+void eta_reset(void) {
+    eta_cache_reset(eta_default_cache());
+}
+
+void eta_get_stats(unsigned long* hits, unsigned long* recomputes) {
+    eta_cache_get_stats(eta_default_cache(), hits, recomputes);
+}
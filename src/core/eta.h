@@ -0,0 +1,107 @@
+/* ----- ----- ----- ----- */
+// eta.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef ETA_H
+#define ETA_H
+
+#include <stddef.h>
+
+#include "elevator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Time-to-serve estimates for hall calls.
+ *
+ * The ETA of (floor, dir) for a car is the time until that car opens its
+ * doors at `floor` ready to leave in `dir`. It is computed from the car's
+ * stop flags by replaying the same collective-control sweep the car runs
+ * (pick_next_target_flag) in closed form: travel is floors / speed_fps,
+ * every stop costs two ticks to open the doors plus the car's door_open_s,
+ * and the sweep includes the remaining door time, the motion already made
+ * towards the next floor, intermediate stops and reversals.
+ * Floors the car does not stop at get the time it passes them in that
+ * direction (it would stop if the call were added), or, after its last
+ * stop, the time to drive there from where it goes idle. Floors outside the
+ * car's served set have no ETA (< 0).
+ *
+ * Results are cached per car and only recomputed when that car's stops or
+ * position / state change; in between, cached values count down with the
+ * clock advanced by eta_advance. All functions except eta_compute use the
+ * cache and must be called from the core thread only.
+ *
+ * Each building owns one EtaCache (cars are indexed by id) sized for its
+ * car and floor count. The eta_cache_* functions take the cache explicitly;
+ * the plain eta_* functions use a process-wide default cache for
+ * single-building callers and benchmarks. The server core binds building
+ * 0's cache as the default; without a binding, one sized for
+ * MAX_ELEVATORS x MAX_FLOORS is allocated on first use.
+ */
+
+typedef struct EtaCache EtaCache;
+
+/* Fill up[f] / down[f] (e->floors entries each) with the ETA in seconds
+ * for car `e`, assuming ticks of `tick_s`. Entries are < 0 if the car
+ * cannot serve (error state). Does not touch the cache.
+ */
+void eta_compute(const Elevator* e, double tick_s, double up[], double down[]);
+
+/* Cached ETA of car `e` for (floor, dir); DIR_NONE takes the earlier of the
+ * two directions. Returns seconds, or < 0 on invalid input / error state.
+ */
+double eta_car(const Elevator* e, int floor, Direction dir);
+
+/* Cached table of car `e`, recomputed if stale: up[f] / down[f] hold the
+ * ETA in seconds as of ETA clock *computed_at; subtract the time elapsed
+ * since then (eta_now() - *computed_at) for the current value. *serial
+ * changes on every recompute, so copies can be refreshed only when needed.
+ * The pointers stay valid until the next cache call for that car.
+ * Returns 0 or -1.
+ */
+int eta_table(const Elevator* e, const double** up, const double** down,
+              double* computed_at, unsigned long* serial);
+
+/* Advance the ETA clock by one core tick of `dt` seconds. */
+void eta_advance(double dt);
+double eta_now(void);
+
+/* Drop every cached table (e.g. after cars were re-initialised). */
+void eta_reset(void);
+
+/* Cache counters since the last eta_reset. */
+void eta_get_stats(unsigned long* hits, unsigned long* recomputes);
+
+/* Explicit-cache variants of the functions above. */
+EtaCache* eta_cache_create(int cars, int floors);  // NULL on allocation failure / bad size
+void eta_cache_destroy(EtaCache* k);               // only for eta_cache_create
+/* Lay a cache out in caller-owned memory of eta_cache_size() bytes (16-byte
+ * aligned), e.g. inside a building's arena. Cars with a larger id or floor
+ * count than the cache get uncached estimates.
+ */
+size_t eta_cache_size(int cars, int floors);
+EtaCache* eta_cache_init_at(void* mem, int cars, int floors);
+EtaCache* eta_default_cache(void);  // the cache behind the plain eta_* functions
+void eta_set_default_cache(EtaCache* k);  // NULL = back to the built-in one
+double eta_cache_car(EtaCache* k, const Elevator* e, int floor, Direction dir);
+int eta_cache_table(EtaCache* k, const Elevator* e, const double** up, const double** down,
+                    double* computed_at, unsigned long* serial);
+void eta_cache_advance(EtaCache* k, double dt);
+double eta_cache_now(const EtaCache* k);
+void eta_cache_reset(EtaCache* k);
+/* Drop one car's cached table (the car was re-initialised, e.g. added to
+ * the fleet in a slot used before). */
+void eta_cache_invalidate(EtaCache* k, int car);
+void eta_cache_get_stats(const EtaCache* k, unsigned long* hits, unsigned long* recomputes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ETA_H */
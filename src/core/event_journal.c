@@ -0,0 +1,437 @@
+/* ----- ----- ----- ----- */
+// event_journal.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include "event_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "platform.h"
+
+/* 每批寫入後等待的時間，讓後續事件累積成同一批（group commit） */
+#define JOURNAL_COMMIT_WINDOW_MS 20
+#define JOURNAL_INITIAL_CAP (EVENT_JOURNAL_RECORD_SIZE * 256)
+
+struct EventJournal {
+    FILE* fp;
+    PlatformMutex* mutex;
+    PlatformCond* cond;
+    PlatformThread* writer;
+
+    // 雙緩衝：append 寫 active，writer 把 active 換出來寫檔
+    unsigned char* active;
+    int active_len;
+    int active_cap;
+    unsigned char* flushing;
+    int flushing_cap;
+
+    int writing;   // writer 正在寫 flushing（event_journal_flush 等它寫完）
+    int closing;
+    int discard;   // 關閉時丟棄尚未寫出的紀錄
+};
+
+struct EventJournalReader {
+    FILE* fp;
+    uint32_t base_tick;
+    unsigned char* snap;   // 起始狀態（NULL = 全新的核心）
+    int snap_len;
+};
+
+/* ---------------------------
+   Little-endian helpers
+   --------------------------- */
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_i64(unsigned char* p, long long v) {
+    put_u32(p, (uint32_t)((unsigned long long)v & 0xFFFFFFFFu));
+    put_u32(p + 4, (uint32_t)((unsigned long long)v >> 32));
+}
+
+static long long get_i64(const unsigned char* p) {
+    return (long long)((unsigned long long)get_u32(p) | ((unsigned long long)get_u32(p + 4) << 32));
+}
+
+/* 事件 <=> 四個整數欄位 */
+static void event_to_fields(const ServerEvent* ev, int32_t f[4]) {
+    f[0] = f[1] = f[2] = f[3] = 0;
+    switch (ev->type) {
+        case EVT_OUTSIDE_CALL:
+            f[0] = ev->v.outside_call.floor;
+            f[1] = ev->v.outside_call.direction;
+            f[2] = ev->v.outside_call.client_id;
+            f[3] = ev->v.outside_call.to_floor + 1;  // 0 = 沒有目的樓層（舊日誌也是 0）
+            break;
+        case EVT_INSIDE_CALL:
+            f[0] = ev->v.inside_call.elevator_id;
+            f[1] = ev->v.inside_call.dest_floor;
+            f[2] = ev->v.inside_call.client_id;
+            break;
+        case EVT_GUARD_COMMAND:
+            f[0] = ev->v.guard_cmd.elevator_id;
+            f[1] = ev->v.guard_cmd.floor;
+            f[2] = ev->v.guard_cmd.force;
+            f[3] = ev->v.guard_cmd.client_id;
+            break;
+        case EVT_FLEET_COMMAND:
+            f[0] = ev->v.fleet_cmd.op;
+            f[1] = ev->v.fleet_cmd.elevator_id;
+            f[2] = ev->v.fleet_cmd.client_id;
+            break;
+        default:
+            break;
+    }
+}
+
+static void fields_to_event(ServerEventType type, const int32_t f[4], ServerEvent* ev) {
+    memset(ev, 0, sizeof(*ev));
+    ev->type = type;
+    switch (type) {
+        case EVT_OUTSIDE_CALL:
+            ev->v.outside_call.floor = f[0];
+            ev->v.outside_call.direction = f[1];
+            ev->v.outside_call.client_id = f[2];
+            ev->v.outside_call.to_floor = f[3] - 1;
+            break;
+        case EVT_INSIDE_CALL:
+            ev->v.inside_call.elevator_id = f[0];
+            ev->v.inside_call.dest_floor = f[1];
+            ev->v.inside_call.client_id = f[2];
+            break;
+        case EVT_GUARD_COMMAND:
+            ev->v.guard_cmd.elevator_id = f[0];
+            ev->v.guard_cmd.floor = f[1];
+            ev->v.guard_cmd.force = f[2];
+            ev->v.guard_cmd.client_id = f[3];
+            break;
+        case EVT_FLEET_COMMAND:
+            ev->v.fleet_cmd.op = f[0];
+            ev->v.fleet_cmd.elevator_id = f[1];
+            ev->v.fleet_cmd.client_id = f[2];
+            break;
+        default:
+            break;
+    }
+}
+
+/* ---------------------------
+   Writer
+   --------------------------- */
+
+/* 背景寫檔執行緒：把累積的紀錄整批寫入並 sync */
+static void* journal_writer_fn(void* arg)
+{
+    EventJournal* j = (EventJournal*)arg;
+
+    platform_mutex_lock(j->mutex);
+    while (1) {
+        while (j->active_len == 0 && !j->closing) {
+            platform_cond_wait(j->cond, j->mutex);
+        }
+        if (j->closing && (j->active_len == 0 || j->discard)) break;
+
+        // 交換緩衝區，寫檔期間 append 可以繼續寫入新的 active
+        unsigned char* buf = j->active;
+        int len = j->active_len;
+        int cap = j->active_cap;
+        j->active = j->flushing;
+        j->active_cap = j->flushing_cap;
+        j->active_len = 0;
+        j->flushing = buf;
+        j->flushing_cap = cap;
+        int closing = j->closing;
+        j->writing = 1;
+        platform_mutex_unlock(j->mutex);
+
+        fwrite(buf, 1, (size_t)len, j->fp);
+        platform_file_sync(j->fp);
+
+        platform_mutex_lock(j->mutex);
+        j->writing = 0;
+        platform_cond_broadcast(j->cond);
+        platform_mutex_unlock(j->mutex);
+
+        if (!closing) platform_sleep_ms(JOURNAL_COMMIT_WINDOW_MS);
+        platform_mutex_lock(j->mutex);
+    }
+    platform_mutex_unlock(j->mutex);
+    return NULL;
+}
+
+/* 配置緩衝區並啟動寫檔執行緒（紀錄接著寫在 fp 的檔尾） */
+static EventJournal* journal_start(FILE* fp)
+{
+    EventJournal* j = (EventJournal*)calloc(1, sizeof(EventJournal));
+    if (!j) {
+        fclose(fp);
+        return NULL;
+    }
+    j->fp = fp;
+    j->active = (unsigned char*)malloc(JOURNAL_INITIAL_CAP);
+    j->flushing = (unsigned char*)malloc(JOURNAL_INITIAL_CAP);
+    if (!j->active || !j->flushing) {
+        fclose(j->fp);
+        free(j->active);
+        free(j->flushing);
+        free(j);
+        return NULL;
+    }
+    j->active_cap = j->flushing_cap = JOURNAL_INITIAL_CAP;
+
+    j->mutex = platform_mutex_create();
+    j->cond = platform_cond_create();
+    j->writer = platform_thread_create(journal_writer_fn, j);
+    return j;
+}
+
+/* 建立日誌檔並啟動寫檔執行緒 */
+EventJournal* event_journal_open(const char* path, int tick_ms, uint32_t base_tick,
+                                 const unsigned char* snap, int snap_len)
+{
+    if (!path || snap_len < 0 || (snap_len > 0 && !snap) || snap_len > CHECKPOINT_MAX_PAYLOAD) return NULL;
+
+    // 只建立新檔：既有的日誌可能是事故紀錄，不能被截斷
+    FILE* fp = fopen(path, "wbx");
+    if (!fp) return NULL;
+
+    unsigned char hdr[EVENT_JOURNAL_HEADER_SIZE];
+    memcpy(hdr, EVENT_JOURNAL_MAGIC, 4);
+    put_u32(hdr + 4, EVENT_JOURNAL_VERSION);
+    put_u32(hdr + 8, (uint32_t)tick_ms);
+    put_u32(hdr + 12, base_tick);
+    put_u32(hdr + 16, (uint32_t)snap_len);
+    int ok = fwrite(hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+    if (ok && snap_len > 0) ok = fwrite(snap, 1, (size_t)snap_len, fp) == (size_t)snap_len;
+    if (!ok || platform_file_sync(fp) != 0) {
+        fclose(fp);
+        remove(path);
+        return NULL;
+    }
+    return journal_start(fp);
+}
+
+/* 接著既有的日誌往下寫（熱升級：舊行程已寫完，新行程從交接的狀態繼續） */
+EventJournal* event_journal_resume(const char* path, int tick_ms, uint32_t from_tick)
+{
+    if (!path) return NULL;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    unsigned char hdr[EVENT_JOURNAL_HEADER_SIZE];
+    unsigned char rec[EVENT_JOURNAL_RECORD_SIZE];
+    int ok = fread(hdr, 1, sizeof(hdr), fp) == sizeof(hdr) && memcmp(hdr, EVENT_JOURNAL_MAGIC, 4) == 0 &&
+             get_u32(hdr + 4) == EVENT_JOURNAL_VERSION && get_u32(hdr + 8) == (uint32_t)tick_ms;
+    long start = ok ? (long)EVENT_JOURNAL_HEADER_SIZE + (long)get_u32(hdr + 16) : 0;
+    long end = (ok && fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
+    // 紀錄要完整（最後一筆寫到一半 => 另開新段落），且不能晚於接手的 tick
+    if (end < start || (end - start) % EVENT_JOURNAL_RECORD_SIZE != 0) ok = 0;
+    if (ok && end > start) {
+        ok = fseek(fp, end - EVENT_JOURNAL_RECORD_SIZE, SEEK_SET) == 0 &&
+             fread(rec, 1, sizeof(rec), fp) == sizeof(rec) && get_u32(rec) <= from_tick;
+    }
+    fclose(fp);
+    if (!ok) return NULL;
+
+    fp = fopen(path, "ab");
+    return fp ? journal_start(fp) : NULL;
+}
+
+/* 加入一筆紀錄（只寫入記憶體緩衝，不等待磁碟） */
+int event_journal_append(EventJournal* j, uint32_t tick, const ServerEvent* ev)
+{
+    if (!j || !ev) return -1;
+
+    unsigned char rec[EVENT_JOURNAL_RECORD_SIZE];
+    int32_t f[4];
+    event_to_fields(ev, f);
+    put_u32(rec, tick);
+    put_u32(rec + 4, (uint32_t)ev->type);
+    put_i64(rec + 8, platform_time_ms());
+    for (int i = 0; i < 4; ++i) put_u32(rec + 16 + i * 4, (uint32_t)f[i]);
+
+    platform_mutex_lock(j->mutex);
+    if (j->closing) {
+        platform_mutex_unlock(j->mutex);
+        return -1;
+    }
+    // 寫檔跟不上時擴充緩衝區，而不是讓呼叫端等待
+    if (j->active_len + EVENT_JOURNAL_RECORD_SIZE > j->active_cap) {
+        int ncap = j->active_cap * 2;
+        unsigned char* nbuf = (unsigned char*)realloc(j->active, (size_t)ncap);
+        if (!nbuf) {
+            platform_mutex_unlock(j->mutex);
+            return -1;
+        }
+        j->active = nbuf;
+        j->active_cap = ncap;
+    }
+    memcpy(j->active + j->active_len, rec, EVENT_JOURNAL_RECORD_SIZE);
+    j->active_len += EVENT_JOURNAL_RECORD_SIZE;
+    platform_cond_broadcast(j->cond);  // 與 event_journal_flush 共用條件變數，要叫醒 writer
+    platform_mutex_unlock(j->mutex);
+    return 0;
+}
+
+/* 等到目前為止的紀錄都寫進磁碟 */
+void event_journal_flush(EventJournal* j)
+{
+    if (!j) return;
+    platform_mutex_lock(j->mutex);
+    while ((j->active_len > 0 || j->writing) && !j->closing) {
+        platform_cond_wait(j->cond, j->mutex);
+    }
+    platform_mutex_unlock(j->mutex);
+}
+
+/* 通知 writer 結束並釋放日誌 */
+static void journal_shutdown(EventJournal* j, int discard)
+{
+    platform_mutex_lock(j->mutex);
+    j->closing = 1;
+    j->discard = discard;
+    platform_cond_broadcast(j->cond);
+    platform_mutex_unlock(j->mutex);
+
+    platform_thread_join(j->writer);
+    fclose(j->fp);
+    platform_cond_destroy(j->cond);
+    platform_mutex_destroy(j->mutex);
+    free(j->active);
+    free(j->flushing);
+    free(j);
+}
+
+/* 寫出剩餘紀錄並關閉日誌 */
+void event_journal_close(EventJournal* j)
+{
+    if (!j) return;
+    journal_shutdown(j, 0);
+}
+
+/* 不寫出剩餘紀錄，直接關閉（檔案已交給新行程） */
+void event_journal_discard(EventJournal* j)
+{
+    if (!j) return;
+    journal_shutdown(j, 1);
+}
+
+/* 既有日誌改名成下一個編號的舊段落 */
+int event_journal_rotate(const char* path, char* kept, int kept_size)
+{
+    if (!path || !kept || kept_size <= 0) return -1;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+    fclose(fp);
+    for (int n = 1; n < 10000; ++n) {
+        if (snprintf(kept, (size_t)kept_size, "%s.%d", path, n) >= kept_size) return -1;
+        FILE* old = fopen(kept, "rb");
+        if (old) {
+            fclose(old);
+            continue;
+        }
+        return (rename(path, kept) == 0) ? 1 : -1;
+    }
+    return -1;
+}
+
+/* ---------------------------
+   Reader
+   --------------------------- */
+
+/* 開啟日誌並檢查檔頭 */
+EventJournalReader* event_journal_reader_open(const char* path, int* tick_ms)
+{
+    if (!path) return NULL;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    unsigned char hdr[EVENT_JOURNAL_HEADER_SIZE];
+    if (fread(hdr, 1, EVENT_JOURNAL_V1_HEADER_SIZE, fp) != EVENT_JOURNAL_V1_HEADER_SIZE ||
+        memcmp(hdr, EVENT_JOURNAL_MAGIC, 4) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+    uint32_t version = get_u32(hdr + 4);
+    if (version < 1 || version > EVENT_JOURNAL_VERSION) {
+        fclose(fp);
+        return NULL;
+    }
+    if (tick_ms) *tick_ms = (int)get_u32(hdr + 8);
+
+    EventJournalReader* r = (EventJournalReader*)calloc(1, sizeof(EventJournalReader));
+    if (!r) {
+        fclose(fp);
+        return NULL;
+    }
+    r->fp = fp;
+    // v2 起檔頭帶起始 tick 與狀態快照
+    if (version >= 2) {
+        int ok = fread(hdr + EVENT_JOURNAL_V1_HEADER_SIZE, 1, EVENT_JOURNAL_HEADER_SIZE - EVENT_JOURNAL_V1_HEADER_SIZE,
+                       fp) == EVENT_JOURNAL_HEADER_SIZE - EVENT_JOURNAL_V1_HEADER_SIZE;
+        uint32_t snap_len = ok ? get_u32(hdr + 16) : 0;
+        if (ok && (snap_len > CHECKPOINT_MAX_PAYLOAD)) ok = 0;
+        if (ok && snap_len > 0) {
+            r->snap = (unsigned char*)malloc(snap_len);
+            ok = r->snap && fread(r->snap, 1, snap_len, fp) == snap_len;
+        }
+        if (!ok) {
+            event_journal_reader_close(r);
+            return NULL;
+        }
+        r->base_tick = get_u32(hdr + 12);
+        r->snap_len = (int)snap_len;
+    }
+    return r;
+}
+
+void event_journal_reader_base(const EventJournalReader* r, uint32_t* base_tick,
+                               const unsigned char** snap, int* snap_len)
+{
+    if (base_tick) *base_tick = r ? r->base_tick : 0;
+    if (snap) *snap = r ? r->snap : NULL;
+    if (snap_len) *snap_len = r ? r->snap_len : 0;
+}
+
+/* 讀取下一筆紀錄 */
+int event_journal_read(EventJournalReader* r, JournalRecord* out)
+{
+    if (!r || !out) return -1;
+    unsigned char rec[EVENT_JOURNAL_RECORD_SIZE];
+    size_t n = fread(rec, 1, sizeof(rec), r->fp);
+    if (n == 0) return 0;
+    if (n != sizeof(rec)) return -1;  // 最後一筆寫到一半（例如程式被強制結束）
+
+    uint32_t type = get_u32(rec + 4);
+    if (type != EVT_OUTSIDE_CALL && type != EVT_INSIDE_CALL && type != EVT_GUARD_COMMAND &&
+        type != EVT_FLEET_COMMAND) return -1;
+
+    int32_t f[4];
+    for (int i = 0; i < 4; ++i) f[i] = (int32_t)get_u32(rec + 16 + i * 4);
+    out->tick = get_u32(rec);
+    out->wall_ms = get_i64(rec + 8);
+    fields_to_event((ServerEventType)type, f, &out->event);
+    return 1;
+}
+
+void event_journal_reader_close(EventJournalReader* r)
+{
+    if (!r) return;
+    fclose(r->fp);
+    free(r->snap);
+    free(r);
+}
@@ -0,0 +1,112 @@
+/* ----- ----- ----- ----- */
+// event_journal.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <stdint.h>
+
+#include "server_events.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Append-only binary journal of every ServerEvent accepted by the core.
+ *
+ * File layout (all integers little-endian):
+ *   header : "EVJ1" | u32 version | u32 tick_ms | u32 base_tick | u32 snap_len | snapshot
+ *   record : u32 tick | u32 type | i64 wall_ms | i32 a | i32 b | i32 c | i32 d
+ *
+ * The snapshot (checkpoint encoding, checkpoint.h) is the core state at
+ * base_tick that the first record applies to, e.g. a state restored from a
+ * checkpoint; snap_len 0 = a freshly initialised core at tick 0. Version 1
+ * journals have neither field and always start from a fresh core.
+ *
+ * a..d carry the event payload in declaration order of the matching union
+ * member (outside_call / inside_call / guard_cmd / fleet_cmd). For hall calls
+ * d is to_floor + 1 (0 = direction only, as in journals written before
+ * destination calls).
+ */
+
+#define EVENT_JOURNAL_MAGIC "EVJ1"
+#define EVENT_JOURNAL_VERSION 2
+#define EVENT_JOURNAL_RECORD_SIZE 32
+#define EVENT_JOURNAL_V1_HEADER_SIZE 12
+#define EVENT_JOURNAL_HEADER_SIZE 20  // 不含快照
+
+/* 單筆日誌紀錄（解碼後） */
+typedef struct {
+    uint32_t tick;         // 核心 tick（事件在該 tick 開頭被處理）
+    long long wall_ms;     // 寫入當下的 platform_time_ms()
+    ServerEvent event;     // 事件內容（next 恆為 NULL）
+} JournalRecord;
+
+typedef struct EventJournal EventJournal;
+typedef struct EventJournalReader EventJournalReader;
+
+/* Create a new journal starting from the core state `snap` (snap_len bytes,
+ * NULL / 0 = fresh core) at base_tick. Never overwrites: fails if `path`
+ * exists (see event_journal_rotate). Records are buffered in memory and
+ * group-committed to disk by a background writer thread, so
+ * event_journal_append never touches the disk.
+ * Returns NULL on error.
+ */
+EventJournal* event_journal_open(const char* path, int tick_ms, uint32_t base_tick,
+                                 const unsigned char* snap, int snap_len);
+
+/* Continue an existing journal (hot upgrade: the old process flushed it
+ * and the new one goes on from the state it handed over). Only a journal of
+ * this version with the same tick_ms, whole records and no record after
+ * from_tick is continued; new records are appended after the last one.
+ * Returns NULL otherwise (start a new segment instead).
+ */
+EventJournal* event_journal_resume(const char* path, int tick_ms, uint32_t from_tick);
+
+/* Keep an existing journal at `path` as an older segment: rename it to the
+ * first free "<path>.<n>" (n = 1, 2, ...), written to kept. Returns 1 if a
+ * file was moved, 0 if there was none, -1 on error.
+ */
+int event_journal_rotate(const char* path, char* kept, int kept_size);
+
+/* Append one event. Returns 0 on success, -1 on error. */
+int event_journal_append(EventJournal* j, uint32_t tick, const ServerEvent* ev);
+
+/* Block until every record appended so far is on disk. */
+void event_journal_flush(EventJournal* j);
+
+/* Flush everything still buffered, stop the writer thread and close the file. */
+void event_journal_close(EventJournal* j);
+
+/* Stop the writer thread and close the file without writing what is still
+ * buffered. Used after a hot upgrade, when the file belongs to the new process.
+ */
+void event_journal_discard(EventJournal* j);
+
+/* Reader side (used by replay). tick_ms may be NULL. */
+EventJournalReader* event_journal_reader_open(const char* path, int* tick_ms);
+
+/* The state the journal starts from: *base_tick and the snapshot (*snap_len
+ * 0 = fresh core). The snapshot stays valid until the reader is closed.
+ */
+void event_journal_reader_base(const EventJournalReader* r, uint32_t* base_tick,
+                               const unsigned char** snap, int* snap_len);
+
+/* Read next record. Returns 1 if a record was read, 0 at end of file, -1 on a
+ * truncated or corrupt record.
+ */
+int event_journal_read(EventJournalReader* r, JournalRecord* out);
+
+void event_journal_reader_close(EventJournalReader* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_JOURNAL_H */
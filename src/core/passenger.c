@@ -0,0 +1,425 @@
+/* ----- ----- ----- ----- */
+// passenger.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "passenger.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PAX_HIST_BINS ((int)(PAX_HIST_MAX_S / PAX_HIST_BIN_S) + 1)
+#define BUDGET_EPS 1e-9
+
+struct PaxSim {
+    PaxSimConfig cfg;
+    int floors;
+    Elevator* cars;
+    int car_count;
+    ServerEventQueue* q;
+
+    // slab pool：索引 i => slab[i >> PAX_SLAB_SHIFT][i & (PAX_SLAB_SIZE - 1)]，slab 配置後不搬動
+    Passenger** slab;
+    uint32_t slab_count;
+    uint32_t slab_cap;
+    uint32_t top;           // 用過的索引數（之後是還沒碰過的）
+    uint32_t free_head;     // 回收的乘客
+
+    uint32_t* wait_head;    // [floor] 樓層等待串列（依到達順序）
+    uint32_t* wait_tail;
+    uint32_t* ride_head;    // [car] 車內乘客串列
+
+    int* prev_state;        // [car] 上一個 tick 的 TaskState
+    int* last_stop;         // [car] 最後一次開門的樓層
+    double* budget;         // [car] 這次開門可用的進出時間（< 0 = 還有人在進出）
+
+    PaxStats st;
+    uint32_t* wait_hist;    // [PAX_HIST_BINS]
+    uint32_t* journey_hist;
+
+    Elevator probe;         // 預測關門後方向用的電梯複本（旗標與路線放在 probe_mem）
+    void* probe_mem;
+};
+
+/* ---------------------------
+   Pool
+   --------------------------- */
+
+static inline Passenger* pax_at(const PaxSim* s, uint32_t i)
+{
+    return &s->slab[i >> PAX_SLAB_SHIFT][i & (PAX_SLAB_SIZE - 1)];
+}
+
+static uint32_t pool_alloc(PaxSim* s)
+{
+    if (s->free_head != PAX_NONE) {
+        uint32_t i = s->free_head;
+        s->free_head = pax_at(s, i)->next;
+        return i;
+    }
+    if (s->top == (s->slab_count << PAX_SLAB_SHIFT)) {
+        if (s->slab_count == PAX_NONE >> PAX_SLAB_SHIFT) return PAX_NONE;
+        if (s->slab_count == s->slab_cap) {
+            uint32_t cap = s->slab_cap ? s->slab_cap * 2 : 16;
+            Passenger** grown = (Passenger**)realloc(s->slab, sizeof(Passenger*) * cap);
+            if (!grown) return PAX_NONE;
+            s->slab = grown;
+            s->slab_cap = cap;
+        }
+        Passenger* block = (Passenger*)malloc(sizeof(Passenger) * PAX_SLAB_SIZE);
+        if (!block) return PAX_NONE;
+        s->slab[s->slab_count++] = block;
+    }
+    return s->top++;
+}
+
+static void pool_free(PaxSim* s, uint32_t i)
+{
+    Passenger* p = pax_at(s, i);
+    p->state = PAX_FREE;
+    p->next = s->free_head;
+    s->free_head = i;
+}
+
+/* ---------------------------
+   Create / destroy
+   --------------------------- */
+
+PaxSim* pax_sim_create(const PaxSimConfig* cfg, int floors, Elevator* cars, int car_count, ServerEventQueue* q)
+{
+    if (floors < 2 || floors > MAX_FLOORS || !cars || car_count < 1) return NULL;
+    PaxSim* s = (PaxSim*)calloc(1, sizeof(PaxSim));
+    if (!s) return NULL;
+    if (cfg) s->cfg = *cfg;
+    if (s->cfg.board_s < 0.0) s->cfg.board_s = 0.0;
+    if (s->cfg.alight_s < 0.0) s->cfg.alight_s = 0.0;
+    s->floors = floors;
+    s->cars = cars;
+    s->car_count = car_count;
+    s->q = q ? q : server_events_default_queue();
+    s->free_head = PAX_NONE;
+
+    s->wait_head = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)floors);
+    s->wait_tail = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)floors);
+    s->ride_head = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)car_count);
+    s->prev_state = (int*)malloc(sizeof(int) * (size_t)car_count);
+    s->last_stop = (int*)malloc(sizeof(int) * (size_t)car_count);
+    s->budget = (double*)calloc((size_t)car_count, sizeof(double));
+    s->wait_hist = (uint32_t*)calloc(PAX_HIST_BINS, sizeof(uint32_t));
+    s->journey_hist = (uint32_t*)calloc(PAX_HIST_BINS, sizeof(uint32_t));
+    int probe_floors = floors;
+    for (int c = 0; c < car_count; ++c) {
+        if (cars[c].floors > probe_floors) probe_floors = cars[c].floors;
+    }
+    s->probe_mem = malloc(Elevator_storage_size(probe_floors));
+    if (!s->wait_head || !s->wait_tail || !s->ride_head || !s->prev_state || !s->last_stop || !s->budget ||
+        !s->wait_hist || !s->journey_hist || !s->probe_mem) {
+        pax_sim_destroy(s);
+        return NULL;
+    }
+    Elevator_attach(&s->probe, s->probe_mem, probe_floors);
+    for (int f = 0; f < floors; ++f) s->wait_head[f] = s->wait_tail[f] = PAX_NONE;
+    for (int c = 0; c < car_count; ++c) {
+        s->ride_head[c] = PAX_NONE;
+        s->prev_state[c] = (int)cars[c].task_state;
+        s->last_stop[c] = -1;
+        cars[c].load = 0;
+    }
+    return s;
+}
+
+void pax_sim_destroy(PaxSim* s)
+{
+    if (!s) return;
+    for (uint32_t i = 0; i < s->slab_count; ++i) free(s->slab[i]);
+    free(s->slab);
+    free(s->wait_head);
+    free(s->wait_tail);
+    free(s->ride_head);
+    free(s->prev_state);
+    free(s->last_stop);
+    free(s->budget);
+    free(s->wait_hist);
+    free(s->journey_hist);
+    free(s->probe_mem);
+    free(s);
+}
+
+/* ---------------------------
+   Calls
+   --------------------------- */
+
+/* 按外呼；目的樓層模式的請求 ID = 乘客索引 + 1，用來對回 BOARD */
+static void press_hall(PaxSim* s, uint32_t i)
+{
+    Passenger* p = pax_at(s, i);
+    if (s->cfg.destination) event_queue_push_destination(s->q, p->from, p->to, -1, i + 1);
+    else event_queue_push_outside(s->q, p->from, p->dir, -1, 0);
+}
+
+/* 有沒有電梯亮著這層這個方向的外呼 */
+static int hall_lit(const PaxSim* s, int floor, int dir)
+{
+    for (int c = 0; c < s->car_count; ++c) {
+        const Elevator* e = &s->cars[c];
+        if ((dir == DIR_UP) ? e->call_up[floor] : e->call_down[floor]) return 1;
+    }
+    return 0;
+}
+
+/* 電梯關門後會往哪個方向：在複本上跑一次核心的選層邏輯（與關門時相同的步驟） */
+static int car_next_dir(PaxSim* s, const Elevator* e)
+{
+    Elevator* probe = &s->probe;
+    if (Elevator_copy(probe, e) != 0) return DIR_NONE;
+    probe->inside[probe->current_floor] = false;
+    Elevator_mark_stops_changed(probe);
+    if (pick_next_target_flag(probe) != PICK_TARGET_SET) return DIR_NONE;
+    if (probe->target_floor > probe->current_floor) return DIR_UP;
+    if (probe->target_floor < probe->current_floor) return DIR_DOWN;
+    return DIR_NONE;   // 原地重新開門，兩個方向的外呼都會被清掉
+}
+
+int pax_sim_arrive(PaxSim* s, int from, int to, double now_s)
+{
+    if (!s || from < 0 || from >= s->floors || to < 0 || to >= s->floors || from == to) return -1;
+    uint32_t i = pool_alloc(s);
+    if (i == PAX_NONE) return -1;
+    Passenger* p = pax_at(s, i);
+    memset(p, 0, sizeof(*p));
+    p->arrive_s = now_s;
+    p->last_press_s = now_s;
+    p->from = from;
+    p->to = to;
+    p->dir = (signed char)((to > from) ? DIR_UP : DIR_DOWN);
+    p->car = -1;
+    p->state = PAX_WAITING;
+    p->next = PAX_NONE;
+    if (s->wait_tail[from] == PAX_NONE) s->wait_head[from] = i;
+    else pax_at(s, s->wait_tail[from])->next = i;
+    s->wait_tail[from] = i;
+
+    s->st.arrived++;
+    if (++s->st.live > s->st.peak_live) s->st.peak_live = s->st.live;
+    press_hall(s, i);
+    return 0;
+}
+
+void pax_sim_on_notice(PaxSim* s, const CoreNotice* n)
+{
+    if (!s || !n || n->type != NOTICE_BOARD || n->request_id == 0 || n->request_id > s->top) return;
+    Passenger* p = pax_at(s, n->request_id - 1);
+    if (p->state == PAX_WAITING) p->car = n->car;
+}
+
+/* ---------------------------
+   Boarding
+   --------------------------- */
+
+static void hist_add(uint32_t* h, double v)
+{
+    int b = (int)(v / PAX_HIST_BIN_S + 0.5);
+    if (b < 0) b = 0;
+    if (b >= PAX_HIST_BINS) b = PAX_HIST_BINS - 1;
+    h[b]++;
+}
+
+/* 走出電梯 => 記錄統計並回收 */
+static void finish_trip(PaxSim* s, uint32_t i, double now_s)
+{
+    Passenger* p = pax_at(s, i);
+    double wait = p->board_s - p->arrive_s;
+    double journey = now_s - p->arrive_s;
+    s->st.served++;
+    s->st.sum_wait_s += wait;
+    s->st.sum_journey_s += journey;
+    s->st.sum_stops += p->stops;
+    if (wait > s->st.max_wait_s) s->st.max_wait_s = wait;
+    hist_add(s->wait_hist, wait);
+    hist_add(s->journey_hist, journey);
+    s->st.live--;
+    pool_free(s, i);
+}
+
+/* 車內到這層的乘客 => 取出一位（沒有回傳 PAX_NONE） */
+static uint32_t take_alighting(PaxSim* s, int c, int floor)
+{
+    uint32_t* link = &s->ride_head[c];
+    while (*link != PAX_NONE) {
+        Passenger* p = pax_at(s, *link);
+        if (p->to == floor) {
+            uint32_t i = *link;
+            *link = p->next;
+            return i;
+        }
+        link = &p->next;
+    }
+    return PAX_NONE;
+}
+
+/* 這層等待、可以搭這台的第一位乘客 => 取出（沒有回傳 PAX_NONE） */
+static uint32_t take_boarding(PaxSim* s, int c, int floor, int next_dir)
+{
+    uint32_t prev = PAX_NONE;
+    for (uint32_t i = s->wait_head[floor]; i != PAX_NONE; prev = i, i = pax_at(s, i)->next) {
+        Passenger* p = pax_at(s, i);
+        if (p->car >= 0 && p->car != c) continue;  // 已指定別台
+        if (next_dir != DIR_NONE && next_dir != p->dir) continue;
+        if (prev == PAX_NONE) s->wait_head[floor] = p->next;
+        else pax_at(s, prev)->next = p->next;
+        if (s->wait_tail[floor] == i) s->wait_tail[floor] = prev;
+        return i;
+    }
+    return PAX_NONE;
+}
+
+/* 開門中：先下後上，一次一位，每位花 alight_s / board_s；還有人在進出就讓門開著 */
+static void transfer(PaxSim* s, int c, double now_s, double dt_s)
+{
+    Elevator* e = &s->cars[c];
+    const int floor = e->current_floor;
+    int next_dir = -1;  // 有人要上車才算（要複製整台電梯）
+
+    while (s->budget[c] >= -BUDGET_EPS) {
+        uint32_t i = take_alighting(s, c, floor);
+        if (i != PAX_NONE) {
+            e->load--;
+            s->budget[c] -= s->cfg.alight_s;
+            finish_trip(s, i, now_s);
+            continue;
+        }
+        if (Elevator_full(e) || s->wait_head[floor] == PAX_NONE) break;
+        if (next_dir < 0) next_dir = car_next_dir(s, e);
+        i = take_boarding(s, c, floor, next_dir);
+        if (i == PAX_NONE) break;
+
+        Passenger* p = pax_at(s, i);
+        // 有 BOARD 的乘客目的樓層已由核心登記
+        if (p->car < 0) event_queue_push_inside(s->q, c, p->to, -1);
+        p->state = PAX_RIDING;
+        p->car = c;
+        p->board_s = now_s;
+        p->next = s->ride_head[c];
+        s->ride_head[c] = i;
+        e->load++;
+        s->budget[c] -= s->cfg.board_s;
+    }
+    // 沒人進出的時間不能留給之後到的乘客
+    if (s->budget[c] > 0.0) s->budget[c] = 0.0;
+    // 最後一位進出完之後再多等一個 tick，讓正好趕到的人也能開始進出
+    if (s->budget[c] < -BUDGET_EPS) Elevator_hold_door(e, -s->budget[c] + dt_s);
+}
+
+static void note_left_behind(PaxSim* s, Passenger* p)
+{
+    if (p->left) return;
+    p->left = 1;
+    s->st.left_behind++;
+}
+
+/* 電梯關門離開：沒搭上的人外呼已被清掉 => 馬上重按 */
+static void car_departed(PaxSim* s, int c, int floor, double now_s)
+{
+    const Elevator* e = &s->cars[c];
+    if (floor < 0 || s->wait_head[floor] == PAX_NONE) return;
+    if (e->task_state == TASK_PREPARE && e->target_floor == floor) return;  // 原地重新開門
+
+    int full = Elevator_full(e);
+    int pressed_up = 0, pressed_down = 0;
+    for (uint32_t i = s->wait_head[floor]; i != PAX_NONE; i = pax_at(s, i)->next) {
+        Passenger* p = pax_at(s, i);
+        if (s->cfg.destination) {
+            // 還沒分到電梯的請求仍在核心佇列裡，不重按
+            if (p->car != c) continue;
+            if (full) note_left_behind(s, p);
+            p->car = -1;
+            p->last_press_s = now_s;
+            press_hall(s, i);
+            continue;
+        }
+        if (full && (e->direction == DIR_NONE || e->direction == p->dir)) note_left_behind(s, p);
+        int* pressed = (p->dir == DIR_UP) ? &pressed_up : &pressed_down;
+        if (!*pressed && !hall_lit(s, floor, p->dir)) {
+            press_hall(s, i);
+            *pressed = 1;
+        }
+        if (*pressed) p->last_press_s = now_s;
+    }
+}
+
+void pax_sim_observe(PaxSim* s, double now_s, double dt_s)
+{
+    if (!s) return;
+    for (int c = 0; c < s->car_count; ++c) {
+        Elevator* e = &s->cars[c];
+        int door_open = (e->task_state == TASK_DOOR_OPEN);
+        int was_open = (s->prev_state[c] == TASK_DOOR_OPEN);
+        // 同一層原地重新開門不算新的停靠
+        int new_stop = door_open && !was_open && s->last_stop[c] != e->current_floor;
+        s->prev_state[c] = (int)e->task_state;
+        if (!door_open) {
+            if (was_open) car_departed(s, c, s->last_stop[c], now_s);
+            continue;
+        }
+        s->last_stop[c] = e->current_floor;
+        if (was_open) s->budget[c] += dt_s;
+        else s->budget[c] = 0.0;
+
+        if (new_stop) {
+            for (uint32_t i = s->ride_head[c]; i != PAX_NONE; i = pax_at(s, i)->next) {
+                Passenger* p = pax_at(s, i);
+                if (p->to != e->current_floor) p->stops++;
+            }
+        }
+        transfer(s, c, now_s, dt_s);
+    }
+
+    // 外呼消失卻一直沒被載走 => 重按
+    for (int f = 0; f < s->floors; ++f) {
+        for (uint32_t i = s->wait_head[f]; i != PAX_NONE; i = pax_at(s, i)->next) {
+            Passenger* p = pax_at(s, i);
+            if (now_s - p->last_press_s < PAX_REPRESS_AFTER_S) continue;
+            if (!hall_lit(s, f, p->dir)) {
+                p->car = -1;
+                press_hall(s, i);
+            }
+            p->last_press_s = now_s;
+        }
+    }
+}
+
+/* ---------------------------
+   Statistics
+   --------------------------- */
+
+void pax_sim_get_stats(const PaxSim* s, PaxStats* out)
+{
+    if (!s || !out) return;
+    *out = s->st;
+    out->slabs = s->slab_count;
+}
+
+static double hist_percentile(const uint32_t* h, unsigned long n, double q)
+{
+    if (n == 0) return 0.0;
+    unsigned long rank = (unsigned long)(q * (double)(n - 1) + 0.5);
+    unsigned long seen = 0;
+    for (int b = 0; b < PAX_HIST_BINS; ++b) {
+        seen += h[b];
+        if (seen > rank) return b * PAX_HIST_BIN_S;
+    }
+    return PAX_HIST_MAX_S;
+}
+
+double pax_sim_wait_percentile(const PaxSim* s, double q)
+{
+    return s ? hist_percentile(s->wait_hist, s->st.served, q) : 0.0;
+}
+
+double pax_sim_journey_percentile(const PaxSim* s, double q)
+{
+    return s ? hist_percentile(s->journey_hist, s->st.served, q) : 0.0;
+}
@@ -0,0 +1,124 @@
+/* ----- ----- ----- ----- */
+// passenger.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef PASSENGER_H
+#define PASSENGER_H
+
+#include <stdint.h>
+
+#include "core_notify.h"
+#include "elevator.h"
+#include "server_events.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Passenger-level simulation of one building, driven next to a core in
+ * virtual time (benchmarks, sizing studies).
+ *
+ * Every trip is a passenger with origin, destination and timestamps. Waiting
+ * passengers queue per floor, riders per car. While a car's doors are open
+ * its riders for that floor get off and waiting passengers going its way get
+ * on, one at a time: each takes board_s / alight_s seconds and the doors are
+ * held open until the last one is through (Elevator_hold_door). Nobody
+ * boards a car at its capacity (Elevator.capacity, 0 = unlimited); people
+ * left behind press the hall button again as the car leaves, and anyone
+ * whose call went dark presses again after PAX_REPRESS_AFTER_S.
+ *
+ * Passengers live in a slab pool: slabs of PAX_SLAB_SIZE records are
+ * allocated as the number of people in the building grows and finished
+ * trips are recycled, so memory follows the peak population, not the total
+ * number of trips. Wait / journey percentiles come from fixed histograms.
+ */
+
+#define PAX_SLAB_SHIFT 12                  // 每塊 4096 位乘客
+#define PAX_SLAB_SIZE (1u << PAX_SLAB_SHIFT)
+#define PAX_NONE 0xffffffffu               // 空串列 / 空閒串列結尾
+#define PAX_REPRESS_AFTER_S 30.0           // 外呼消失卻沒被載走 => 重按
+#define PAX_HIST_BIN_S 0.1                 // 等待 / 旅程時間直方圖的格寬（秒）
+#define PAX_HIST_MAX_S 3600.0              // 超過的算在最後一格
+
+/* 乘客狀態 */
+typedef enum { PAX_FREE = 0, PAX_WAITING, PAX_RIDING } PaxState;
+
+/* 一位乘客（一趟行程） */
+typedef struct {
+    double arrive_s;        // 到達樓層的時間
+    double board_s;         // 開始進入電梯的時間
+    double last_press_s;    // 最後一次按外呼的時間
+    int from;
+    int to;
+    int car;                // 乘坐的電梯；等待中 = BOARD 指定的電梯（-1 = 尚未指定）
+    int stops;              // 乘坐期間途經的停靠次數（不含目的樓層）
+    signed char dir;        // DIR_UP / DIR_DOWN
+    unsigned char state;    // PaxState
+    unsigned char left;     // 曾因客滿沒搭上
+    uint32_t next;          // 所在串列（樓層等待 / 車內 / 空閒）的下一位
+} Passenger;
+
+/* 模擬參數 */
+typedef struct {
+    double board_s;         // 每人進電梯的時間（秒，0 = 瞬間）
+    double alight_s;        // 每人出電梯的時間
+    int destination;        // 1 = 乘客在大廳輸入目的樓層（CALL <from> <to>），只搭 BOARD 指定的電梯
+} PaxSimConfig;
+
+/* 累計統計（完成的行程） */
+typedef struct {
+    unsigned long arrived;      // 產生的乘客數
+    unsigned long served;       // 已抵達目的樓層
+    unsigned long left_behind;  // 至少一次因客滿沒搭上的乘客數
+    double sum_wait_s;          // 到達 => 開始進電梯
+    double sum_journey_s;       // 到達 => 走出電梯
+    double sum_stops;
+    double max_wait_s;
+    uint32_t live;              // 目前在大樓裡（等待 + 乘坐）的人數
+    uint32_t peak_live;
+    uint32_t slabs;             // 已配置的 slab 數
+} PaxStats;
+
+typedef struct PaxSim PaxSim;
+
+/* Simulate passengers for the cars `cars[0 .. car_count)` of one building
+ * with `floors` floors. Hall and car calls go into `q` (NULL = the default
+ * queue). cfg may be NULL (instant boarding, direction calls).
+ */
+PaxSim* pax_sim_create(const PaxSimConfig* cfg, int floors, Elevator* cars, int car_count, ServerEventQueue* q);
+void pax_sim_destroy(PaxSim* s);
+
+/* A passenger appears at `from` at core time now_s and presses the hall
+ * button (or enters the destination). Returns 0, or -1 for an invalid trip.
+ */
+int pax_sim_arrive(PaxSim* s, int from, int to, double now_s);
+
+/* Call after every core tick (now_s = core time after the tick, dt_s = tick
+ * length): people get on and off open cars, left-behind passengers press
+ * again.
+ */
+void pax_sim_observe(PaxSim* s, double now_s, double dt_s);
+
+/* Feed a core notice; NOTICE_BOARD tells a destination passenger which car
+ * to take. Other notices are ignored.
+ */
+void pax_sim_on_notice(PaxSim* s, const CoreNotice* n);
+
+void pax_sim_get_stats(const PaxSim* s, PaxStats* out);
+
+/* Wait (arrival => boarding) / journey (arrival => alighting) time of served
+ * passengers at quantile q (0..1), PAX_HIST_BIN_S resolution. 0 if none.
+ */
+double pax_sim_wait_percentile(const PaxSim* s, double q);
+double pax_sim_journey_percentile(const PaxSim* s, double q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PASSENGER_H */
@@ -0,0 +1,344 @@
+/* ----- ----- ----- ----- */
+// plan_opt.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "plan_opt.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+#define PLAN_BATCH 16            // 背景執行緒每搜尋幾步就回頭看有沒有新快照、換下一棟
+#define PLAN_START_TEMP_S 4.0    // 起始溫度（秒總等待：差這麼多的變差約有 1/e 機率接受）
+#define PLAN_COOLING 0.997       // 每步降溫（2000 步後約剩 0.25%，即 0.01 秒）
+
+/* 一棟大樓：核心送來的快照、搜尋中的快照與指派、送出的計畫 */
+typedef struct {
+    /* 核心送來的快照（lock 保護） */
+    RolloutSnapshot in;
+    uint64_t in_served[MAX_ELEVATORS][STOPSET_WORDS];
+    unsigned long in_seq;
+    int fresh;                              // 還沒被搜尋拿走
+
+    /* 搜尋狀態（只有搜尋的執行緒碰） */
+    RolloutSnapshot work;
+    uint64_t served[MAX_ELEVATORS][STOPSET_WORDS];
+    unsigned long work_seq;
+    int left;                               // 這份快照還能搜尋幾步
+    int movable_count;
+    short movable[ROLLOUT_MAX_CALLS];       // 可改派的外呼（calls[] 索引）
+    signed char cur[ROLLOUT_MAX_CALLS];     // 目前的指派
+    signed char best[ROLLOUT_MAX_CALLS];    // 找到最好的指派
+    double base_cost;                       // 快照原本指派的總等待（< 0 = 還沒算）
+    double cur_cost;
+    double best_cost;
+    double posted_cost;                     // 已送出的計畫的總等待
+    double temp;
+    uint32_t rng;
+
+    /* 送出的計畫（lock 保護） */
+    PlanMove plan[PLAN_MAX_MOVES];
+    int plan_count;
+    unsigned long plan_seq;                 // 計畫所屬的快照（0 = 沒有計畫）
+    double plan_gain_s;
+} PlanSlot;
+
+struct PlanOptimizer {
+    PlanSlot* slots;
+    int slot_count;
+    int inline_iterations;    // > 0 = 沒有背景執行緒，plan_opt_run 時搜尋
+    PlatformMutex* lock;      // 保護快照 / 計畫的交接與以下欄位
+    PlatformCond* cond;
+    PlatformThread* thread;
+    int stop;
+    int next;                 // 輪詢游標
+    unsigned long seq;        // 最後發出的快照編號
+    PlanOptStats stats;
+};
+
+/* ---------------------------
+   Snapshot hand-over
+   --------------------------- */
+
+/* 複製快照用到的部分；停靠樓層也複製一份，搜尋時不再讀電梯本身 */
+static void snapshot_copy(RolloutSnapshot* dst, uint64_t served[][STOPSET_WORDS], const RolloutSnapshot* src)
+{
+    dst->floors = src->floors;
+    dst->car_count = src->car_count;
+    dst->call_count = src->call_count;
+    dst->down_to = src->down_to;
+    dst->horizon_s = src->horizon_s;
+    memcpy(dst->cars, src->cars, sizeof(RollCar) * (size_t)src->car_count);
+    memcpy(dst->calls, src->calls, sizeof(RollCall) * (size_t)src->call_count);
+    for (int k = 0; k < src->car_count; ++k) {
+        if (src->cars[k].served) memcpy(served[k], src->cars[k].served, sizeof(served[k]));
+        else memset(served[k], 0xff, sizeof(served[k]));
+        dst->cars[k].served = served[k];
+    }
+}
+
+/* 拿走新快照，從它原本的指派重新開始搜尋（lock 內） */
+static void slot_load(PlanSlot* s)
+{
+    snapshot_copy(&s->work, s->served, &s->in);
+    s->work_seq = s->in_seq;
+    s->fresh = 0;
+    s->left = PLAN_MAX_ITERATIONS;
+    s->base_cost = -1.0;
+    s->movable_count = 0;
+    for (int i = 0; i < s->work.call_count; ++i) {
+        const RollCall* q = &s->work.calls[i];
+        s->cur[i] = q->car;
+        // 只動已掛在電梯上、允許改派的外呼；佇列中與預測的外呼交給模擬派
+        if (q->car >= 0 && !q->fixed && q->arrive_s <= 0.0f) s->movable[s->movable_count++] = (short)i;
+    }
+    if (s->movable_count == 0) s->left = 0;
+    s->rng = (uint32_t)(s->work_seq * 2654435761u) | 1u;
+}
+
+/* ---------------------------
+   Search
+   --------------------------- */
+
+static inline uint32_t next_rand(PlanSlot* s)
+{
+    uint32_t x = s->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return s->rng = x;
+}
+
+/* car 能不能接外呼 i */
+static int can_take(const PlanSlot* s, int car, int i)
+{
+    const RollCar* c = &s->work.cars[car];
+    return c->phase != ROLL_OFF && c->accept && StopSet_get(c->served, s->work.calls[i].floor);
+}
+
+/* 外呼 i 隨機換一台能接的電梯（-1 = 沒有別台） */
+static int random_car(PlanSlot* s, int i)
+{
+    int cand[MAX_ELEVATORS];
+    int n = 0;
+    for (int k = 0; k < s->work.car_count; ++k) {
+        if (k != s->cur[i] && can_take(s, k, i)) cand[n++] = k;
+    }
+    return (n > 0) ? cand[next_rand(s) % (uint32_t)n] : -1;
+}
+
+/* 模擬退火：改派一筆或對調兩筆，整體總等待變少就接受，變多依溫度機率接受 */
+static unsigned long slot_search(PlanSlot* s, int steps)
+{
+    unsigned long done = 0;
+    if (s->left <= 0) return 0;
+    if (s->base_cost < 0.0) {
+        s->base_cost = rollout_total(&s->work, NULL);
+        s->cur_cost = s->best_cost = s->posted_cost = s->base_cost;
+        memcpy(s->best, s->cur, (size_t)s->work.call_count);
+        s->temp = PLAN_START_TEMP_S;
+        ++done;
+    }
+    for (; steps > 0 && s->left > 0; --steps, --s->left) {
+        int a = s->movable[next_rand(s) % (uint32_t)s->movable_count];
+        int b = -1;
+        signed char ca = s->cur[a];
+        if (s->movable_count >= 2 && (next_rand(s) & 3) == 0) {
+            b = s->movable[next_rand(s) % (uint32_t)s->movable_count];
+            if (s->cur[b] == ca || !can_take(s, s->cur[b], a) || !can_take(s, ca, b)) b = -1;
+        }
+        signed char cb = (b >= 0) ? s->cur[b] : -1;
+        if (b >= 0) {
+            s->cur[a] = cb;
+            s->cur[b] = ca;
+        } else {
+            int to = random_car(s, a);
+            if (to < 0) continue;
+            s->cur[a] = (signed char)to;
+        }
+
+        double cost = rollout_total(&s->work, s->cur);
+        ++done;
+        double delta = cost - s->cur_cost;
+        if (delta <= 0.0 || (next_rand(s) >> 8) * (1.0 / 16777216.0) < exp(-delta / s->temp)) {
+            s->cur_cost = cost;
+            if (cost < s->best_cost) {
+                s->best_cost = cost;
+                memcpy(s->best, s->cur, (size_t)s->work.call_count);
+            }
+        } else {
+            s->cur[a] = ca;
+            if (b >= 0) s->cur[b] = cb;
+        }
+        s->temp *= PLAN_COOLING;
+    }
+    return done;
+}
+
+/* 找到的最好指派明顯比原本好、且比上次送出的更好 => 送出計畫（lock 內） */
+static void slot_publish(PlanOptimizer* o, PlanSlot* s)
+{
+    if (s->fresh || s->base_cost < 0.0) return;  // 已有更新的快照，這份的結果作廢
+    if (s->best_cost > s->base_cost - PLAN_MIN_GAIN_S || s->best_cost >= s->posted_cost) return;
+    int n = 0;
+    for (int k = 0; k < s->movable_count; ++k) {
+        int i = s->movable[k];
+        const RollCall* q = &s->work.calls[i];
+        if (s->best[i] == q->car) continue;
+        if (n == PLAN_MAX_MOVES) return;  // 改動太多：只送一部分就不是評估過的那組指派
+        s->plan[n].floor = q->floor;
+        s->plan[n].dir = q->dir;
+        s->plan[n].from = q->car;
+        s->plan[n].to = s->best[i];
+        ++n;
+    }
+    if (n == 0) return;
+    s->plan_count = n;
+    s->plan_seq = s->work_seq;
+    s->plan_gain_s = s->base_cost - s->best_cost;
+    s->posted_cost = s->best_cost;
+    o->stats.plans++;
+}
+
+/* 背景執行緒：輪流搜尋有新快照或還沒搜完的大樓，沒事就等下一份快照 */
+static void* opt_thread_fn(void* arg)
+{
+    PlanOptimizer* o = (PlanOptimizer*)arg;
+    platform_mutex_lock(o->lock);
+    while (!o->stop) {
+        PlanSlot* s = NULL;
+        for (int k = 0; k < o->slot_count && !s; ++k) {
+            PlanSlot* c = &o->slots[(o->next + k) % o->slot_count];
+            if (c->fresh || c->left > 0) s = c;
+        }
+        if (!s) {
+            platform_cond_wait(o->cond, o->lock);
+            continue;
+        }
+        o->next = (int)(s - o->slots + 1) % o->slot_count;
+        if (s->fresh) slot_load(s);
+        platform_mutex_unlock(o->lock);
+
+        unsigned long done = slot_search(s, PLAN_BATCH);
+
+        platform_mutex_lock(o->lock);
+        o->stats.iterations += done;
+        slot_publish(o, s);
+    }
+    platform_mutex_unlock(o->lock);
+    return NULL;
+}
+
+/* ---------------------------
+   Public API
+   --------------------------- */
+
+PlanOptimizer* plan_opt_create(int slots, int inline_iterations)
+{
+    if (slots < 1) return NULL;
+    PlanOptimizer* o = (PlanOptimizer*)calloc(1, sizeof(PlanOptimizer));
+    if (!o) return NULL;
+    o->slots = (PlanSlot*)calloc((size_t)slots, sizeof(PlanSlot));
+    o->slot_count = slots;
+    o->inline_iterations = (inline_iterations > 0) ? inline_iterations : 0;
+    o->lock = platform_mutex_create();
+    o->cond = platform_cond_create();
+    if (!o->slots || !o->lock || !o->cond) {
+        plan_opt_destroy(o);
+        return NULL;
+    }
+    if (o->inline_iterations == 0) {
+        o->thread = platform_thread_create(opt_thread_fn, o);
+        if (!o->thread) {
+            plan_opt_destroy(o);
+            return NULL;
+        }
+    }
+    return o;
+}
+
+void plan_opt_destroy(PlanOptimizer* o)
+{
+    if (!o) return;
+    if (o->thread) {
+        platform_mutex_lock(o->lock);
+        o->stop = 1;
+        platform_cond_broadcast(o->cond);
+        platform_mutex_unlock(o->lock);
+        platform_thread_join(o->thread);
+    }
+    if (o->cond) platform_cond_destroy(o->cond);
+    if (o->lock) platform_mutex_destroy(o->lock);
+    free(o->slots);
+    free(o);
+}
+
+unsigned long plan_opt_post(PlanOptimizer* o, int slot, const RolloutSnapshot* snap)
+{
+    if (!o || !snap || slot < 0 || slot >= o->slot_count) return 0;
+    if (snap->car_count > MAX_ELEVATORS || snap->call_count > ROLLOUT_MAX_CALLS) return 0;
+    PlanSlot* s = &o->slots[slot];
+    platform_mutex_lock(o->lock);
+    snapshot_copy(&s->in, s->in_served, snap);
+    s->in_seq = ++o->seq;
+    s->fresh = 1;
+    s->plan_count = 0;
+    s->plan_seq = 0;
+    o->stats.snapshots++;
+    unsigned long seq = s->in_seq;
+    platform_cond_signal(o->cond);
+    platform_mutex_unlock(o->lock);
+    return seq;
+}
+
+int plan_opt_take(PlanOptimizer* o, int slot, unsigned long seq, PlanMove moves[], int max, double* gain_s)
+{
+    if (!o || !moves || slot < 0 || slot >= o->slot_count) return 0;
+    PlanSlot* s = &o->slots[slot];
+    int n = 0;
+    platform_mutex_lock(o->lock);
+    if (s->plan_seq != 0 && s->plan_seq == seq && s->plan_count <= max) {
+        n = s->plan_count;
+        memcpy(moves, s->plan, sizeof(PlanMove) * (size_t)n);
+        if (gain_s) *gain_s = s->plan_gain_s;
+    }
+    if (s->plan_seq != 0 && (n > 0 || s->plan_seq != seq)) {
+        // 拿走了，或是舊快照的計畫 => 清掉
+        s->plan_count = 0;
+        s->plan_seq = 0;
+    }
+    platform_mutex_unlock(o->lock);
+    return n;
+}
+
+void plan_opt_run(PlanOptimizer* o, int slot)
+{
+    if (!o || o->thread || slot < 0 || slot >= o->slot_count) return;
+    PlanSlot* s = &o->slots[slot];
+    platform_mutex_lock(o->lock);
+    if (s->fresh) slot_load(s);
+    platform_mutex_unlock(o->lock);
+
+    unsigned long done = slot_search(s, o->inline_iterations);
+
+    platform_mutex_lock(o->lock);
+    o->stats.iterations += done;
+    slot_publish(o, s);
+    platform_mutex_unlock(o->lock);
+}
+
+void plan_opt_get_stats(PlanOptimizer* o, PlanOptStats* out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!o) return;
+    platform_mutex_lock(o->lock);
+    *out = o->stats;
+    platform_mutex_unlock(o->lock);
+}
@@ -0,0 +1,97 @@
+/* ----- ----- ----- ----- */
+// plan_opt.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef PLAN_OPT_H
+#define PLAN_OPT_H
+
+#include "rollout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Anytime optimiser for the hall-call-to-car assignment of whole buildings.
+ *
+ * The dispatch policy places one call at a time; the optimiser looks at all
+ * held calls together. Every building owns a slot. The core posts a
+ * rollout snapshot of the building into its slot (plan_opt_post), and the
+ * optimiser searches that snapshot with simulated annealing: move one held
+ * call to another car, or swap the cars of two calls, score the whole
+ * assignment with rollout_total and keep the change if it is better (or,
+ * while the temperature is high, not much worse). Whenever the best
+ * assignment found beats the snapshot's own by PLAN_MIN_GAIN_S it is
+ * published as a plan, a list of moves (call, from car, to car).
+ *
+ * The core picks plans up between ticks (plan_opt_take) and decides on its
+ * own whether they still fit the building; the optimiser never touches core
+ * state. The slot lock is only held to copy a snapshot in or a plan out, so
+ * the tick never waits for the search.
+ *
+ * With a background thread (inline_iterations = 0) the search runs while
+ * the core sleeps between ticks, round robin over the slots with work, and
+ * gets as many iterations as the CPU allows up to PLAN_MAX_ITERATIONS per
+ * snapshot. Inline (inline_iterations > 0) there is no thread: plan_opt_run
+ * does that many iterations on the caller, which makes virtual-time runs
+ * reproducible.
+ */
+
+#define PLAN_MAX_MOVES 32            // 一份計畫最多改派幾筆
+#define PLAN_MAX_ITERATIONS 2000     // 每份快照最多搜尋幾步（之後等下一份）
+#define PLAN_MIN_GAIN_S 2.0          // 比快照原本的指派少等這麼多秒（總等待）才送出計畫
+
+/* 計畫中的一筆改派 */
+typedef struct {
+    short floor;
+    signed char dir;      // DIR_UP / DIR_DOWN
+    signed char from;     // 快照當下負責的電梯（elevators[] 索引）
+    signed char to;
+} PlanMove;
+
+typedef struct {
+    unsigned long snapshots;   // snapshots posted
+    unsigned long iterations;  // assignments scored
+    unsigned long plans;       // plans published
+} PlanOptStats;
+
+typedef struct PlanOptimizer PlanOptimizer;
+
+/* One slot per building. inline_iterations = 0 starts the background
+ * thread; > 0 runs that many iterations per plan_opt_run instead.
+ * Returns NULL on error.
+ */
+PlanOptimizer* plan_opt_create(int slots, int inline_iterations);
+
+/* Stops the thread; plans not taken yet are dropped. */
+void plan_opt_destroy(PlanOptimizer* o);
+
+/* Hand a new snapshot of building `slot` to the optimiser (copied; the car
+ * stop masks too). The search on the previous snapshot of this slot stops
+ * and its plan, if not taken, is dropped. Returns the snapshot number
+ * (> 0), or 0 on error.
+ */
+unsigned long plan_opt_post(PlanOptimizer* o, int slot, const RolloutSnapshot* snap);
+
+/* Take the plan of snapshot `seq` of building `slot`: copies up to max moves
+ * and the predicted saving in seconds of total wait. Returns the number of
+ * moves, 0 if there is no plan for that snapshot (yet).
+ */
+int plan_opt_take(PlanOptimizer* o, int slot, unsigned long seq, PlanMove moves[], int max, double* gain_s);
+
+/* Inline mode: search slot `slot` for the configured iterations on the
+ * calling thread. No-op with a background thread.
+ */
+void plan_opt_run(PlanOptimizer* o, int slot);
+
+void plan_opt_get_stats(PlanOptimizer* o, PlanOptStats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLAN_OPT_H */
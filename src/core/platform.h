@@ -3,13 +3,15 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,10 +23,15 @@ extern "C" {
 #ifdef _WIN32
     #include <winsock2.h>
     typedef SOCKET platform_socket_t;
+    typedef WSAPOLLFD platform_pollfd_t;
 #else
+    #include <poll.h>
     #include <sys/types.h>
     #include <sys/socket.h>
     typedef int platform_socket_t;
+    typedef struct pollfd platform_pollfd_t;
+    #define INVALID_SOCKET (-1)
+    #define SOCKET_ERROR (-1)
 #endif
 
 // =====================
@@ -63,12 +70,16 @@ typedef void* (*PlatformThreadFn)(void* arg);
 PlatformThread* platform_thread_create(PlatformThreadFn func, void* arg);
 void platform_thread_join(PlatformThread* t);
 
+// 線上的邏輯 CPU 數（至少 1）
+int platform_cpu_count(void);
+
 // =====================
 // Time / Sleep
 // =====================
 
 void platform_sleep_ms(int ms);
 long long platform_time_ms(void);  // monotonic if possible
+long long platform_time_ns(void);  // monotonic, for benchmarks
 
 // =====================
 // String
@@ -76,6 +87,44 @@ long long platform_time_ms(void);  // monotonic if possible
 
 int platform_stricmp(const char* s1, const char* s2);
 
+// =====================
+// File
+// =====================
+
+// 將 FILE 緩衝寫入磁碟（fflush + fsync），成功回傳 0
+int platform_file_sync(FILE* f);
+
+// =====================
+// Memory-mapped file
+// =====================
+
+typedef struct PlatformMap PlatformMap;
+
+// 以讀寫模式映射檔案（不存在則建立，不足 size 則擴充），失敗回傳 NULL
+PlatformMap* platform_map_file(const char* path, size_t size);
+
+// 映射區起始位址
+void* platform_map_data(PlatformMap* m);
+
+// 將 [offset, offset+len) 寫回磁碟，成功回傳 0
+int platform_map_flush(PlatformMap* m, size_t offset, size_t len);
+
+// 解除映射並關閉檔案
+void platform_map_close(PlatformMap* m);
+
+// 具名共享記憶體（同主機跨行程）：create=1 建立並可寫，create=0 以唯讀開啟既有區段
+PlatformMap* platform_shm_open(const char* name, size_t size, int create);
+
+// 移除具名共享記憶體（Windows 為 no-op，最後一個使用者關閉即釋放）
+void platform_shm_unlink(const char* name);
+
+// =====================
+// Memory ordering
+// =====================
+
+// 完整記憶體屏障（seqlock 等跨行程 / 跨執行緒同步用）
+void platform_memory_fence(void);
+
 // =====================
 // Socket
 // =====================
@@ -92,6 +141,9 @@ void platform_socket_close(platform_socket_t s);
 // 取得錯誤碼 (回傳平台相關錯誤)
 int platform_socket_last_error(void);
 
+// 等待多個 socket (poll / WSAPoll)，沒有 FD_SETSIZE 上限；回傳就緒數量、逾時 0、錯誤 SOCKET_ERROR
+int platform_poll(platform_pollfd_t* fds, int count, int timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,16 +3,20 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifndef _WIN32
 
 #include "platform.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -93,6 +97,11 @@ void platform_thread_join(PlatformThread* t){
     free(t);
 }
 
+int platform_cpu_count(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
+
 // =====================
 // Time / Sleep
 // =====================
@@ -108,6 +117,12 @@ long long platform_time_ms(void){
            (long long)ts.tv_nsec / 1000000LL;
 }
 
+long long platform_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + (long long)ts.tv_nsec;
+}
+
 // =====================
 // String
 // =====================
@@ -116,6 +131,107 @@ int platform_stricmp(const char* s1, const char* s2) {
     return strcasecmp(s1, s2);
 }
 
+// =====================
+// File
+// =====================
+
+int platform_file_sync(FILE* f) {
+    if (!f) return -1;
+    if (fflush(f) != 0) return -1;
+    return fsync(fileno(f));
+}
+
+// =====================
+// Memory-mapped file
+// =====================
+
+struct PlatformMap {
+    int fd;
+    void* data;
+    size_t size;
+};
+
+PlatformMap* platform_map_file(const char* path, size_t size) {
+    if (!path || size == 0) return NULL;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    PlatformMap* m = malloc(sizeof(PlatformMap));
+    m->fd = fd;
+    m->data = p;
+    m->size = size;
+    return m;
+}
+
+void* platform_map_data(PlatformMap* m) {
+    return m ? m->data : NULL;
+}
+
+int platform_map_flush(PlatformMap* m, size_t offset, size_t len) {
+    if (!m || offset + len > m->size) return -1;
+    // msync 需要以頁為單位對齊
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset - (offset % page);
+    return msync((char*)m->data + start, len + (offset - start), MS_SYNC);
+}
+
+void platform_map_close(PlatformMap* m) {
+    if (!m) return;
+    munmap(m->data, m->size);
+    close(m->fd);
+    free(m);
+}
+
+PlatformMap* platform_shm_open(const char* name, size_t size, int create) {
+    if (!name || size == 0) return NULL;
+    int fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (create && (size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0) ||
+        (!create && (size_t)st.st_size < size)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* p = mmap(NULL, size, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    PlatformMap* m = malloc(sizeof(PlatformMap));
+    m->fd = fd;
+    m->data = p;
+    m->size = size;
+    return m;
+}
+
+void platform_shm_unlink(const char* name) {
+    if (name) shm_unlink(name);
+}
+
+// =====================
+// Memory ordering
+// =====================
+
+void platform_memory_fence(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
 // =====================
 // Socket
 // =====================
@@ -139,4 +255,11 @@ int platform_socket_last_error(void) {
     return errno;
 }
 
+int platform_poll(platform_pollfd_t* fds, int count, int timeout_ms) {
+    int rc = poll(fds, (nfds_t)count, timeout_ms);
+    // 被訊號打斷視為逾時，呼叫端下一輪再等
+    if (rc < 0 && errno == EINTR) return 0;
+    return rc;
+}
+
 #endif
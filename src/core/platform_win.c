@@ -3,13 +3,14 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifdef _WIN32
 
 #include "platform.h"
+#include <io.h>
 #include <stdlib.h>
 #include <string.h>
 #include <windows.h>
@@ -124,6 +125,13 @@ void platform_thread_join(PlatformThread* t){
     free(t);
 }
 
+// 線上的邏輯 CPU 數
+int platform_cpu_count(void){
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (si.dwNumberOfProcessors > 0) ? (int)si.dwNumberOfProcessors : 1;
+}
+
 // =====================
 // Time / Sleep
 // =====================
@@ -150,6 +158,21 @@ long long platform_time_ms(void){
     return (long long)(counter.QuadPart * 1000 / freq.QuadPart);
 }
 
+// 回傳單調時間（奈秒），分成整數秒與餘數換算避免溢位
+long long platform_time_ns(void){
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER counter;
+
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+
+    QueryPerformanceCounter(&counter);
+    long long sec = counter.QuadPart / freq.QuadPart;
+    long long rem = counter.QuadPart % freq.QuadPart;
+    return sec * 1000000000LL + rem * 1000000000LL / freq.QuadPart;
+}
+
 // =====================
 // String
 // =====================
@@ -159,6 +182,120 @@ int platform_stricmp(const char* s1, const char* s2) {
     return _stricmp(s1, s2);
 }
 
+// =====================
+// File
+// =====================
+
+// 將檔案緩衝寫入磁碟
+int platform_file_sync(FILE* f) {
+    if (!f) return -1;
+    if (fflush(f) != 0) return -1;
+    return _commit(_fileno(f));
+}
+
+// =====================
+// Memory-mapped file
+// =====================
+
+struct PlatformMap {
+    HANDLE file;
+    HANDLE mapping;
+    void* data;
+    size_t size;
+};
+
+// 映射檔案（不存在則建立）
+PlatformMap* platform_map_file(const char* path, size_t size) {
+    if (!path || size == 0) return NULL;
+    HANDLE f = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                           OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return NULL;
+
+    // 映射大小大於檔案時 CreateFileMapping 會自動擴充檔案
+    HANDLE mp = CreateFileMappingA(f, NULL, PAGE_READWRITE,
+                                   (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFFu), NULL);
+    if (!mp) {
+        CloseHandle(f);
+        return NULL;
+    }
+    void* p = MapViewOfFile(mp, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!p) {
+        CloseHandle(mp);
+        CloseHandle(f);
+        return NULL;
+    }
+
+    PlatformMap* m = malloc(sizeof(PlatformMap));
+    m->file = f;
+    m->mapping = mp;
+    m->data = p;
+    m->size = size;
+    return m;
+}
+
+void* platform_map_data(PlatformMap* m) {
+    return m ? m->data : NULL;
+}
+
+// 寫回磁碟
+int platform_map_flush(PlatformMap* m, size_t offset, size_t len) {
+    if (!m || offset + len > m->size) return -1;
+    if (!FlushViewOfFile((char*)m->data + offset, len)) return -1;
+    return FlushFileBuffers(m->file) ? 0 : -1;
+}
+
+// 解除映射並關閉
+void platform_map_close(PlatformMap* m) {
+    if (!m) return;
+    UnmapViewOfFile(m->data);
+    CloseHandle(m->mapping);
+    if (m->file != INVALID_HANDLE_VALUE) CloseHandle(m->file);
+    free(m);
+}
+
+// 具名共享記憶體（以 page file 為後備）
+PlatformMap* platform_shm_open(const char* name, size_t size, int create) {
+    if (!name || size == 0) return NULL;
+    // POSIX 名稱以 '/' 開頭，Windows 物件名稱不允許
+    if (name[0] == '/') name++;
+
+    HANDLE mp;
+    if (create) {
+        mp = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFFu), name);
+    } else {
+        mp = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    }
+    if (!mp) return NULL;
+
+    void* p = MapViewOfFile(mp, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+    if (!p) {
+        CloseHandle(mp);
+        return NULL;
+    }
+
+    PlatformMap* m = malloc(sizeof(PlatformMap));
+    m->file = INVALID_HANDLE_VALUE;
+    m->mapping = mp;
+    m->data = p;
+    m->size = size;
+    return m;
+}
+
+// Windows 的具名映射在最後一個 handle 關閉時自動釋放
+void platform_shm_unlink(const char* name) {
+    (void)name;
+}
+
+// =====================
+// Memory ordering
+// =====================
+
+// 完整記憶體屏障
+void platform_memory_fence(void) {
+    MemoryBarrier();
+}
+
 // ---------------------
 // Socket API
 // ---------------------
@@ -186,4 +323,8 @@ int platform_socket_last_error(void) {
     return WSAGetLastError();
 }
 
+int platform_poll(platform_pollfd_t* fds, int count, int timeout_ms) {
+    return WSAPoll(fds, (ULONG)count, timeout_ms);
+}
+
 #endif // _WIN32
@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #include "request_queue.h"
@@ -32,6 +32,15 @@ int rq_push(RequestQueue* q, PendingRequest r) {
     return 0;
 }
 
+int rq_push_front(RequestQueue* q, PendingRequest r) {
+    if (!q) return -1;
+    if (q->count >= MAX_REQUESTS) return -1;
+    q->head = (q->head + MAX_REQUESTS - 1) % MAX_REQUESTS;
+    q->items[q->head] = r;
+    q->count++;
+    return 0;
+}
+
 int rq_pop(RequestQueue* q, PendingRequest* out) {
     if (!q) return -1;
     if (q->count == 0) return -1;
@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifndef REQUEST_QUEUE_H
@@ -30,6 +30,11 @@ void rq_init(RequestQueue* q);
 /* Push item to tail. Returns 0 on success, -1 on full or error. */
 int rq_push(RequestQueue* q, PendingRequest r);
 
+/* Push item back to the head (it becomes the next pop), e.g. a request that
+ * could not be handled yet and must keep its place. Returns 0 or -1.
+ */
+int rq_push_front(RequestQueue* q, PendingRequest r);
+
 /* Pop item from head. Returns 0 on success and writes to out (if non-NULL), -1 if empty. */
 int rq_pop(RequestQueue* q, PendingRequest* out);
 
@@ -0,0 +1,559 @@
+/* ----- ----- ----- ----- */
+// rollout.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "rollout.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core_pool.h"
+#include "platform.h"
+
+#define ROLL_OPEN_S 0.2        // 抵達到開門（ETA_OPEN_TICKS × 預設 tick）
+#define ROLL_MAX_EVENTS 20000  // 單次 rollout 的事件上限（防呆）
+
+/* 共用的工作執行緒（同一時間只給一個呼叫端用） */
+static CorePool* g_pool = NULL;
+static PlatformMutex* g_pool_lock = NULL;
+static int g_pool_busy = 0;
+static int g_workers = 1;
+
+/* 一次 rollout 的工作區：快照的複本（只複製用到的部分） */
+typedef struct {
+    int floors;
+    int car_count;
+    int call_count;
+    int down_to;
+    double horizon_s;
+    RollCar cars[MAX_ELEVATORS];
+    RollCall calls[ROLLOUT_MAX_CALLS];
+} RollWork;
+
+/* ---------------------------
+   Snapshot
+   --------------------------- */
+
+void rollout_snapshot_init(RolloutSnapshot* r, int floors, double horizon_s)
+{
+    if (!r) return;
+    r->floors = (floors < 1) ? 1 : ((floors > MAX_FLOORS) ? MAX_FLOORS : floors);
+    r->car_count = 0;
+    r->call_count = 0;
+    r->down_to = -1;
+    r->horizon_s = (horizon_s > 0.0) ? horizon_s : ROLLOUT_DEFAULT_HORIZON_S;
+}
+
+/* 電梯目前的狀態換成「下一個事件」（時間算法同 eta_compute，以秒計） */
+int rollout_add_car(RolloutSnapshot* r, const Elevator* e, int accept)
+{
+    if (!r || !e || r->car_count >= MAX_ELEVATORS) return -1;
+    RollCar* c = &r->cars[r->car_count];
+    memset(c, 0, sizeof(*c));
+    c->s = e->stops;
+    c->served = e->served;
+    c->time_per_floor = (float)(1.0 / ((e->speed_fps > 0.0) ? e->speed_fps : DEFAULT_SPEED_FPS));
+    c->door_s = (float)((e->door_open_s > 0.0) ? e->door_open_s : DEFAULT_DOOR_OPEN_S);
+    c->floor = (short)e->current_floor;
+    c->target = (short)e->current_floor;
+    c->dir = (signed char)e->direction;
+    c->open_t = -1.0;
+    c->accept = (unsigned char)(accept != 0);
+
+    const int p = e->current_floor;
+    if (e->task_state == TASK_ERROR || p < 0 || p >= e->floors) {
+        c->phase = ROLL_OFF;
+        c->accept = 0;
+        return r->car_count++;
+    }
+
+    // 前往待命樓層的空車一有請求就從目前位置出發 => 當作閒置
+    switch (e->parking ? TASK_IDLE : e->task_state) {
+        case TASK_ARRIVED:
+            StopSet_clear(c->s.inside, p);
+            c->open_t = ROLL_OPEN_S;
+            c->t = c->open_t + c->door_s;
+            c->phase = ROLL_DWELL;
+            break;
+        case TASK_DOOR_OPENING:
+            c->open_t = ROLL_OPEN_S / 2;
+            c->t = c->open_t + c->door_s;
+            c->phase = ROLL_DWELL;
+            break;
+        case TASK_DOOR_OPEN:
+            c->open_t = 0.0;
+            c->t = (e->door_timer_s > 0.0) ? e->door_timer_s : 0.0;
+            c->phase = ROLL_DWELL;
+            break;
+        case TASK_DOOR_CLOSING:
+            c->open_t = 0.0;
+            c->t = ROLL_OPEN_S / 2;
+            c->phase = ROLL_DWELL;
+            break;
+        case TASK_PREPARE:
+        case TASK_MOVING: {
+            int target = e->target_floor;
+            if (target < 0 || target >= e->floors || target == p) {
+                // 原地開門
+                c->open_t = ROLL_OPEN_S;
+                c->t = c->open_t + c->door_s;
+                c->phase = ROLL_DWELL;
+                break;
+            }
+            Direction d = (target > p) ? DIR_UP : DIR_DOWN;
+            // 途中若有同向請求會先停（elevator.c 行進中停靠）
+            const uint64_t* same = (d == DIR_UP) ? c->s.up : c->s.down;
+            for (int f = p + (int)d; f != target; f += (int)d) {
+                if (StopSet_get(c->s.inside, f) || StopSet_get(same, f)) {
+                    target = f;
+                    break;
+                }
+            }
+            c->dir = (signed char)d;
+            c->target = (short)target;
+            c->t0 = -Elevator_get_accum_time(e);
+            c->t = c->t0 + abs(target - p) * c->time_per_floor;
+            c->phase = ROLL_MOVING;
+            break;
+        }
+        default:
+            c->dir = DIR_NONE;
+            c->phase = ROLL_IDLE;
+            break;
+    }
+    return r->car_count++;
+}
+
+int rollout_add_call(RolloutSnapshot* r, int floor, Direction dir, int to_floor, double arrive_s, int car)
+{
+    if (!r || r->call_count >= ROLLOUT_MAX_CALLS || floor < 0 || floor >= r->floors) return -1;
+    if ((dir != DIR_UP && dir != DIR_DOWN) || car >= r->car_count) return -1;
+    RollCall* k = &r->calls[r->call_count];
+    k->arrive_s = (float)arrive_s;
+    k->served_s = -1.0f;
+    k->floor = (short)floor;
+    k->to_floor = (short)((to_floor >= 0 && to_floor < r->floors && to_floor != floor) ? to_floor : -1);
+    k->dir = (signed char)dir;
+    k->car = (signed char)((car >= 0) ? car : -1);
+    k->fixed = 0;
+    return r->call_count++;
+}
+
+/* 每個 (樓層, 方向) 依到達率等間隔排在視野內，只留最早的 ROLLOUT_MAX_ARRIVALS 筆 */
+void rollout_add_demand(RolloutSnapshot* r, const double rate[][2])
+{
+    if (!r || !rate) return;
+    RollCall next[ROLLOUT_MAX_ARRIVALS];
+    int n = 0;
+    for (int f = 0; f < r->floors; ++f) {
+        for (int di = 0; di < 2; ++di) {
+            if (!(rate[f][di] >= ROLLOUT_MIN_RATE)) continue;
+            if ((di == 0 && f == r->floors - 1) || (di == 1 && f == 0)) continue;
+            // 各層錯開第一筆的時間（黃金比例），否則到達率相同的樓層會在同一刻一起按
+            double gap = 1.0 / rate[f][di];
+            double phase = fmod((2 * f + di + 1) * 0.6180339887, 1.0);
+            for (double t = phase * gap; t < r->horizon_s; t += gap) {
+                // 插入排序：滿了只取代最晚的一筆
+                int k;
+                if (n < ROLLOUT_MAX_ARRIVALS) k = n++;
+                else if (t < next[n - 1].arrive_s) k = n - 1;
+                else break;
+                while (k > 0 && next[k - 1].arrive_s > t) {
+                    next[k] = next[k - 1];
+                    --k;
+                }
+                next[k].arrive_s = (float)t;
+                next[k].floor = (short)f;
+                next[k].dir = (signed char)((di == 0) ? DIR_UP : DIR_DOWN);
+            }
+        }
+    }
+    for (int k = 0; k < n; ++k) {
+        if (rollout_add_call(r, next[k].floor, (Direction)next[k].dir, -1, next[k].arrive_s, -1) < 0) break;
+    }
+}
+
+/* ---------------------------
+   Stepping
+   --------------------------- */
+
+static inline int popcount64(uint64_t x)
+{
+    int n = 0;
+    for (; x; x &= x - 1) ++n;
+    return n;
+}
+
+static inline uint64_t any_word(const StopSet* s, int w)
+{
+    return s->up[w] | s->down[w] | s->inside[w];
+}
+
+/* [lo, hi] 之間有請求的樓層數 */
+static int count_range(const StopSet* s, int lo, int hi)
+{
+    if (lo < 0) lo = 0;
+    if (hi >= MAX_FLOORS) hi = MAX_FLOORS - 1;
+    int n = 0;
+    for (int w = lo >> 6; w <= (hi >> 6); ++w) {
+        uint64_t m = ~(uint64_t)0;
+        if (w == (lo >> 6)) m &= ~(uint64_t)0 << (lo & 63);
+        if (w == (hi >> 6) && (hi & 63) != 63) m &= ((uint64_t)1 << ((hi & 63) + 1)) - 1;
+        n += popcount64(any_word(s, w) & m);
+    }
+    return n;
+}
+
+/* 最高 / 最低有請求的樓層（沒有回傳 -1） */
+static int highest_stop(const StopSet* s)
+{
+    for (int w = STOPSET_WORDS - 1; w >= 0; --w) {
+        uint64_t x = any_word(s, w);
+        if (!x) continue;
+        int i = 63;
+        while (!(x >> i)) --i;
+        return w * 64 + i;
+    }
+    return -1;
+}
+
+static int lowest_stop(const StopSet* s)
+{
+    for (int w = 0; w < STOPSET_WORDS; ++w) {
+        uint64_t x = any_word(s, w);
+        if (x) return w * 64 + popcount64((x & (~x + 1)) - 1);
+    }
+    return -1;
+}
+
+static inline void set_bit(uint64_t* bits, int floor)
+{
+    bits[floor >> 6] |= (uint64_t)1 << (floor & 63);
+}
+
+/* MOVING 的電梯在時間 x 的位置（樓層，含小數） */
+static double car_pos(const RollCar* c, double x)
+{
+    if (c->phase != ROLL_MOVING) return c->floor;
+    double moved = (x - c->t0) / c->time_per_floor;
+    double span = abs(c->target - c->floor);
+    if (moved < 0.0) moved = 0.0;
+    if (moved > span) moved = span;
+    return c->floor + c->dir * moved;
+}
+
+/* 粗估：電梯在時間 x 之後多久能在 floor 開門接 dir 方向的乘客
+ * 同方向且在前方 => 直接開過去，途中每個停靠加一次開關門；否則先跑完這一趟再回頭 */
+static double quick_eta(const RollCar* c, int f, int dir, double x)
+{
+    double pos = car_pos(c, x);
+    double ready = (c->phase == ROLL_DWELL && c->t > x) ? c->t - x : 0.0;
+    double stop_s = ROLL_OPEN_S + c->door_s;
+    if (c->phase == ROLL_IDLE || c->dir == DIR_NONE) return ready + fabs(f - pos) * c->time_per_floor + ROLL_OPEN_S;
+
+    double ahead = (f - pos) * c->dir;
+    if (ahead >= 0.0 && dir == c->dir) {
+        int lo = (c->dir == DIR_UP) ? (int)ceil(pos) : f + 1;
+        int hi = (c->dir == DIR_UP) ? f - 1 : (int)floor(pos);
+        return ready + ahead * c->time_per_floor + count_range(&c->s, lo, hi) * stop_s + ROLL_OPEN_S;
+    }
+    int ext = (c->dir == DIR_UP) ? highest_stop(&c->s) : lowest_stop(&c->s);
+    double turn = (ext < 0 || (ext - pos) * c->dir < 0.0) ? pos : ext;
+    double travel = fabs(turn - pos) + fabs(turn - f);
+    int stops = count_range(&c->s, 0, MAX_FLOORS - 1);
+    return ready + travel * c->time_per_floor + stops * stop_s + ROLL_OPEN_S;
+}
+
+/* 沒有目的樓層的乘客：往上猜起點以上的中點，往下猜 down_to（或起點以下的中點） */
+static int guess_destination(const RollWork* w, int floor, int dir)
+{
+    if (dir == DIR_UP) return floor + (w->floors - floor) / 2;
+    if (w->down_to >= 0 && w->down_to < floor) return w->down_to;
+    return floor / 2;
+}
+
+/* car 在本層（時間 at 開門）接走 dir 方向的外呼：乘客按目的樓層，其他電梯的同一筆外呼取消 */
+static void board(RollWork* w, int k, int dir, double at)
+{
+    RollCar* c = &w->cars[k];
+    const int p = c->floor;
+    uint64_t* bits = (dir == DIR_UP) ? c->s.up : c->s.down;
+    if (!StopSet_get(bits, p)) return;
+    StopSet_clear(bits, p);
+    for (int i = 0; i < w->call_count; ++i) {
+        RollCall* q = &w->calls[i];
+        if (q->floor != p || q->dir != dir || q->car < 0 || q->served_s >= 0.0f) continue;
+        q->served_s = (float)((at > q->arrive_s) ? at : q->arrive_s);
+        int to = (q->to_floor >= 0) ? q->to_floor : guess_destination(w, p, dir);
+        if (to != p && to >= 0 && to < w->floors && StopSet_get(c->served, to)) set_bit(c->s.inside, to);
+    }
+    for (int j = 0; j < w->car_count; ++j) {
+        if (j != k) StopSet_clear((dir == DIR_UP) ? w->cars[j].s.up : w->cars[j].s.down, p);
+    }
+}
+
+/* 關門（或閒置中收到請求）時在時間 x 選下一站，規則同 Route_build */
+static void depart(RollWork* w, int k, double x)
+{
+    RollCar* c = &w->cars[k];
+    const int p = c->floor;
+    Direction nd = (Direction)c->dir;
+    int next = Route_pick(&c->s, p, &nd);
+    if (next < 0) {
+        c->phase = ROLL_IDLE;
+        c->dir = DIR_NONE;
+        c->open_t = -1.0;
+        return;
+    }
+    if (next == p) {
+        // 原地開門：兩個方向的乘客都上車（開過門的話第一次開門就上了）
+        double at = (c->open_t >= 0.0) ? c->open_t : x + ROLL_OPEN_S;
+        board(w, k, DIR_UP, at);
+        board(w, k, DIR_DOWN, at);
+        StopSet_clear(c->s.inside, p);
+        c->dir = DIR_NONE;
+        c->open_t = x + ROLL_OPEN_S;
+        c->t = c->open_t + c->door_s;
+        c->phase = ROLL_DWELL;
+        return;
+    }
+    if (c->open_t >= 0.0) {
+        // 往 nd 出發：本層 nd 方向的乘客上車，他們的目的樓層可能更近
+        board(w, k, nd, c->open_t);
+        Direction d2 = nd;
+        int n2 = Route_pick(&c->s, p, &d2);
+        if (n2 >= 0 && n2 != p && d2 == nd) next = n2;
+    }
+    c->dir = (signed char)nd;
+    c->target = (short)next;
+    c->t0 = x;
+    c->t = x + abs(next - p) * c->time_per_floor;
+    c->open_t = -1.0;
+    c->phase = ROLL_MOVING;
+}
+
+/* 抵達：車內到這層的乘客下車，開門 */
+static void arrive(RollWork* w, int k)
+{
+    RollCar* c = &w->cars[k];
+    c->floor = c->target;
+    StopSet_clear(c->s.inside, c->floor);
+    c->open_t = c->t + ROLL_OPEN_S;
+    c->t = c->open_t + c->door_s;
+    c->phase = ROLL_DWELL;
+}
+
+/* 時間 x 把 (floor, dir) 加給 car：閒置就出發，行進中且在前方就先停這層 */
+static void add_hall_flag(RollWork* w, int k, int floor, int dir, double x)
+{
+    RollCar* c = &w->cars[k];
+    set_bit((dir == DIR_UP) ? c->s.up : c->s.down, floor);
+    if (c->phase == ROLL_IDLE) {
+        depart(w, k, x);
+    } else if (c->phase == ROLL_MOVING && dir == c->dir) {
+        double ahead = (floor - car_pos(c, x)) * c->dir;
+        if (ahead > 0.0 && (c->target - floor) * c->dir > 0) {
+            c->target = (short)floor;
+            c->t = c->t0 + abs(floor - c->floor) * c->time_per_floor;
+        }
+    }
+}
+
+/* 時間 x 派出一筆外呼：已有電梯掛著同一筆就併入，否則給粗估 ETA 最短的電梯 */
+static void dispatch_call(RollWork* w, int i, double x)
+{
+    RollCall* q = &w->calls[i];
+    const uint64_t bit = (uint64_t)1 << (q->floor & 63);
+    const int word = q->floor >> 6;
+    int best = -1;
+    double best_eta = 1e18;
+    for (int k = 0; k < w->car_count; ++k) {
+        const RollCar* c = &w->cars[k];
+        if (c->phase == ROLL_OFF) continue;
+        if (((q->dir == DIR_UP) ? c->s.up[word] : c->s.down[word]) & bit) {
+            q->car = (signed char)k;
+            return;
+        }
+        if (!c->accept || !StopSet_get(c->served, q->floor)) continue;
+        double eta = quick_eta(c, q->floor, q->dir, x);
+        if (eta < best_eta) {
+            best_eta = eta;
+            best = k;
+        }
+    }
+    if (best < 0) return;  // 沒有電梯能接：留到結算
+    q->car = (signed char)best;
+    add_hall_flag(w, best, q->floor, q->dir, x);
+}
+
+/* 複製快照到工作區（只複製用到的部分） */
+static void work_load(RollWork* w, const RolloutSnapshot* r)
+{
+    w->floors = r->floors;
+    w->car_count = r->car_count;
+    w->call_count = r->call_count;
+    w->down_to = r->down_to;
+    w->horizon_s = r->horizon_s;
+    memcpy(w->cars, r->cars, sizeof(RollCar) * (size_t)r->car_count);
+    memcpy(w->calls, r->calls, sizeof(RollCall) * (size_t)r->call_count);
+}
+
+/* 事件推進到視野結束並結算總等待 */
+static double simulate(RollWork* w)
+{
+    const double H = w->horizon_s;
+
+    // 本 tick 剛派到請求、還沒起步的閒置電梯先出發
+    for (int k = 0; k < w->car_count; ++k) {
+        const RollCar* c = &w->cars[k];
+        if (c->phase != ROLL_IDLE) continue;
+        for (int j = 0; j < STOPSET_WORDS; ++j) {
+            if (any_word(&c->s, j)) {
+                depart(w, k, 0.0);
+                break;
+            }
+        }
+    }
+
+    // 事件推進：下一個電梯事件與下一筆待派外呼，誰早先處理
+    int cursor = 0;
+    for (int n = 0; n < ROLL_MAX_EVENTS; ++n) {
+        int k = -1;
+        double tk = H;
+        for (int j = 0; j < w->car_count; ++j) {
+            const RollCar* c = &w->cars[j];
+            if ((c->phase == ROLL_MOVING || c->phase == ROLL_DWELL) && c->t < tk) {
+                tk = c->t;
+                k = j;
+            }
+        }
+        while (cursor < w->call_count && w->calls[cursor].car >= 0) ++cursor;
+        if (cursor < w->call_count) {
+            double ta = (w->calls[cursor].arrive_s > 0.0f) ? w->calls[cursor].arrive_s : 0.0;
+            if (ta <= tk && ta < H) {
+                dispatch_call(w, cursor++, ta);
+                continue;
+            }
+        }
+        if (k < 0) break;
+        if (w->cars[k].phase == ROLL_MOVING) arrive(w, k);
+        else depart(w, k, tk);
+    }
+
+    // 結算：服務了的算到開門，還在等的算到視野結束再加粗估 ETA
+    double cost = 0.0;
+    for (int i = 0; i < w->call_count; ++i) {
+        const RollCall* q = &w->calls[i];
+        if (q->arrive_s >= H) continue;
+        if (q->served_s >= 0.0f) {
+            cost += q->served_s - q->arrive_s;
+        } else {
+            double tail = (q->car >= 0) ? quick_eta(&w->cars[q->car], q->floor, q->dir, H) : H;
+            cost += H - q->arrive_s + tail;
+        }
+    }
+    return cost;
+}
+
+double rollout_run(const RolloutSnapshot* r, int call, int car)
+{
+    if (!r || call < 0 || call >= r->call_count || car < 0 || car >= r->car_count) return 1e18;
+    RollWork w;
+    work_load(&w, r);
+    w.calls[call].car = (signed char)car;
+    add_hall_flag(&w, car, w.calls[call].floor, w.calls[call].dir, 0.0);
+    return simulate(&w);
+}
+
+double rollout_total(const RolloutSnapshot* r, const signed char assign[])
+{
+    if (!r) return 1e18;
+    RollWork w;
+    work_load(&w, r);
+    for (int i = 0; assign && i < w.call_count; ++i) {
+        RollCall* q = &w.calls[i];
+        int to = assign[i];
+        if (q->car < 0 || q->fixed || to == q->car || to < 0 || to >= w.car_count) continue;
+        const RollCar* c = &w.cars[to];
+        if (c->phase == ROLL_OFF || !c->accept || !StopSet_get(c->served, q->floor)) continue;
+        // 從原電梯撤掉旗標（原本要停這層的話，抵達時只是開一次空門）
+        StopSet_clear((q->dir == DIR_UP) ? w.cars[q->car].s.up : w.cars[q->car].s.down, q->floor);
+        q->car = (signed char)to;
+        add_hall_flag(&w, to, q->floor, q->dir, 0.0);
+    }
+    return simulate(&w);
+}
+
+/* ---------------------------
+   Parallel evaluation
+   --------------------------- */
+
+typedef struct {
+    const RolloutSnapshot* r;
+    int call;
+    const int* cars;
+    double* cost;
+} EvalCtx;
+
+static void eval_task(int task, void* arg)
+{
+    EvalCtx* ctx = (EvalCtx*)arg;
+    ctx->cost[task] = rollout_run(ctx->r, ctx->call, ctx->cars[task]);
+}
+
+/* 取得共用的工作執行緒（別人在用就回傳 0，自己跑） */
+static int pool_acquire(void)
+{
+    if (!g_pool || !g_pool_lock) return 0;
+    platform_mutex_lock(g_pool_lock);
+    int ok = !g_pool_busy;
+    if (ok) g_pool_busy = 1;
+    platform_mutex_unlock(g_pool_lock);
+    return ok;
+}
+
+static void pool_release(void)
+{
+    platform_mutex_lock(g_pool_lock);
+    g_pool_busy = 0;
+    platform_mutex_unlock(g_pool_lock);
+}
+
+void rollout_evaluate(const RolloutSnapshot* r, int call, const int cars[], int n, double cost[])
+{
+    if (!r || !cars || !cost || n <= 0) return;
+    EvalCtx ctx = { r, call, cars, cost };
+    if (n >= ROLLOUT_PARALLEL_MIN && pool_acquire()) {
+        int rc = core_pool_run(g_pool, n, eval_task, &ctx);
+        pool_release();
+        if (rc == 0) return;
+    }
+    for (int k = 0; k < n; ++k) eval_task(k, &ctx);
+}
+
+int rollout_set_workers(int workers)
+{
+    if (workers < 1) workers = 1;
+    if (g_pool) {
+        core_pool_destroy(g_pool);
+        g_pool = NULL;
+    }
+    g_workers = 1;
+    if (workers == 1) return 0;
+    if (!g_pool_lock) g_pool_lock = platform_mutex_create();
+    if (!g_pool_lock) return -1;
+    g_pool = core_pool_create(workers, MAX_ELEVATORS);
+    if (!g_pool) return -1;
+    g_workers = core_pool_workers(g_pool);
+    return 0;
+}
+
+int rollout_workers(void)
+{
+    return g_workers;
+}
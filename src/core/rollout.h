@@ -0,0 +1,149 @@
+/* ----- ----- ----- ----- */
+// rollout.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+#include <stdint.h>
+
+#include "elevator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lookahead for dispatch: what happens over the next horizon_s seconds if a
+ * new hall call goes to car k?
+ *
+ * A RolloutSnapshot is a compact, copyable image of one building: every car
+ * reduced to its stop flags, position and the time of its next event, plus
+ * the hall calls in play (held, queued, the new one, and future arrivals
+ * predicted from recent call rates). A rollout copies the snapshot, hands
+ * the new call to one car and runs all cars forward event by event (arrive,
+ * close doors and pick the next stop with Route_pick), so cost grows with
+ * the number of stops, not with the number of ticks. Boarding passengers
+ * press their destination (the known one, otherwise a guess); predicted
+ * arrivals go to the car with the shortest rough ETA, which is how one
+ * choice delays or speeds up the calls after it.
+ *
+ * The cost of a rollout is the total wait of every call in the snapshot:
+ * served calls count until the doors open for them, calls still waiting at
+ * the horizon count until then plus a rough ETA from there.
+ *
+ * rollout_total runs the same simulation without a new call, optionally
+ * with held calls moved to other cars: the cost of a whole assignment, as
+ * used by the background plan optimiser (plan_opt.h).
+ *
+ * rollout_evaluate runs one rollout per candidate; with workers configured
+ * (rollout_set_workers) and at least ROLLOUT_PARALLEL_MIN candidates they
+ * run on a shared thread pool. Only one caller uses the pool at a time; a
+ * caller that finds it busy (another building) runs its rollouts itself.
+ */
+
+#define ROLLOUT_DEFAULT_HORIZON_S 60.0
+#define ROLLOUT_MAX_CALLS 256         // 快照中的外呼（含預測到達）上限
+#define ROLLOUT_MAX_ARRIVALS 64       // 預測到達上限（取最早的）
+#define ROLLOUT_PARALLEL_MIN 4        // 候選電梯至少幾台才分給工作執行緒
+#define ROLLOUT_MIN_RATE 0.08         // 預測到達只看夠忙的 (樓層, 方向)（次 / 秒，約每分鐘 5 次）
+
+/* 模擬中的電梯階段 */
+typedef enum {
+    ROLL_OFF = 0,     // 故障：不動、不服務
+    ROLL_IDLE,        // 停在 floor，沒有請求
+    ROLL_MOVING,      // 從 floor 開往 target，t 抵達
+    ROLL_DWELL        // 門開在 floor，t 關門選下一站
+} RollPhase;
+
+/* 一台電梯的精簡狀態（複製一台約 150 bytes） */
+typedef struct {
+    StopSet s;
+    const uint64_t* served;   // 可停靠樓層（指向原電梯，rollout 期間不變）
+    double t;                 // 下一個事件的時間（IDLE 不用）
+    double t0;                // MOVING：離開 floor 的時間
+    double open_t;            // 本層這次開門的時間（< 0 = 還沒開門）
+    float time_per_floor;
+    float door_s;
+    short floor;              // 所在樓層（MOVING = 出發樓層）
+    short target;             // MOVING 的停靠樓層
+    signed char dir;          // Direction
+    unsigned char phase;      // RollPhase
+    unsigned char accept;     // 可接新外呼（服務中、沒客滿）
+} RollCar;
+
+/* 一筆外呼（時間都相對於快照當下） */
+typedef struct {
+    float arrive_s;           // 按下的時間（已在等的 <= 0）
+    float served_s;           // 開門服務的時間（< 0 = 還沒）
+    short floor;
+    short to_floor;           // 目的樓層（-1 = 不知道，用猜的）
+    signed char dir;          // DIR_UP / DIR_DOWN
+    signed char car;          // 負責的電梯（-1 = 還沒派）
+    unsigned char fixed;      // 不可改派（rollout_total 不動它）
+} RollCall;
+
+typedef struct {
+    int floors;
+    int car_count;
+    int call_count;
+    int down_to;              // 往下的乘客猜測的目的樓層（-1 = 猜起點以下的中點）
+    double horizon_s;
+    RollCar cars[MAX_ELEVATORS];
+    RollCall calls[ROLLOUT_MAX_CALLS];
+} RolloutSnapshot;
+
+/* Start an empty snapshot of a building with `floors` floors looking
+ * horizon_s seconds ahead (<= 0 = ROLLOUT_DEFAULT_HORIZON_S).
+ */
+void rollout_snapshot_init(RolloutSnapshot* r, int floors, double horizon_s);
+
+/* Append car `e` (cars keep the order they are added in, so use the
+ * building's car index). accept = 0: the car keeps serving its flags but
+ * gets no new calls in the rollout. Returns the car index or -1 (full).
+ */
+int rollout_add_car(RolloutSnapshot* r, const Elevator* e, int accept);
+
+/* Append a hall call pressed at arrive_s (relative to now; <= 0 for calls
+ * already waiting) held by `car`, or car = -1 for a call not assigned yet:
+ * those are handed out by the rollout at max(arrive_s, 0) in the order they
+ * were added. Returns the call index or -1 (full / invalid).
+ */
+int rollout_add_call(RolloutSnapshot* r, int floor, Direction dir, int to_floor, double arrive_s, int car);
+
+/* Append predicted arrivals from per-floor call rates (calls per second,
+ * rate[f][0] = up, rate[f][1] = down): evenly spaced over the horizon with
+ * staggered first arrivals, the earliest ROLLOUT_MAX_ARRIVALS in time order.
+ * Rates below ROLLOUT_MIN_RATE are ignored: a call that may or may not come
+ * only adds noise to the comparison.
+ */
+void rollout_add_demand(RolloutSnapshot* r, const double rate[][2]);
+
+/* Predicted total wait (seconds) if unassigned call `call` goes to `car`. */
+double rollout_run(const RolloutSnapshot* r, int call, int car);
+
+/* Predicted total wait (seconds) with held calls reassigned: call i goes to
+ * assign[i] instead of its snapshot car. Entries equal to the snapshot car
+ * or naming a car that cannot take the call are ignored, as are unassigned
+ * and fixed calls. assign may be NULL (the snapshot as it is).
+ */
+double rollout_total(const RolloutSnapshot* r, const signed char assign[]);
+
+/* cost[k] = rollout_run(r, call, cars[k]) for k < n. */
+void rollout_evaluate(const RolloutSnapshot* r, int call, const int cars[], int n, double cost[]);
+
+/* Threads used by rollout_evaluate, including the caller (<= 1 = run on the
+ * caller only, the default). Call before the core starts. Returns 0 or -1.
+ */
+int rollout_set_workers(int workers);
+int rollout_workers(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROLLOUT_H */
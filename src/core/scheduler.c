@@ -3,43 +3,171 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #include "scheduler.h"
+#include <limits.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "building.h"
+#include "core_log.h"
+#include "core_notify.h"
+#include "demand.h"
 #include "elevator.h"
+#include "eta.h"
+#include "rollout.h"
 #include "status.h"
 
+/* 設定（所有大樓共用，啟動前設定） */
+static SchedulerPolicy g_policy = SCHED_POLICY_GREEDY;
+static int g_redispatch_budget = SCHED_REDISPATCH_DEFAULT_BUDGET;       // 每個 tick 最多重新評估幾筆（0 = 關閉）
+static double g_redispatch_hysteresis_s = SCHED_REDISPATCH_DEFAULT_HYSTERESIS_S;
+static double g_wait_slo_s = SCHED_DEFAULT_WAIT_SLO_S;
+static int g_parking = 0;  // 預測停靠（預設關閉：開啟後軌跡取決於學到的需求）
+static int g_traffic_modes = 1;  // 自動判斷交通型態
+static double g_rollout_horizon_s = ROLLOUT_DEFAULT_HORIZON_S;
+
+#define QLOAD_NORM_FLOORS 100.0  // 成本中的負載項正規化（固定值，不隨大樓樓層數變動）
+#define PARK_INTERVAL_S 5.0      // 多久重新檢查一次待命位置（避免閒置電梯來回跑）
+#define ROLL_TIE_WAIT_S 0.5      // rollout 總等待相差不到這麼多算平手
+#define ASSIGN_PER_TICK 8        // 每個 tick 最多派出幾筆
+#define ASSIGN_SCAN_PER_TICK 32  // 每個 tick 最多看幾筆（派不出去的跳過）
+
+/* 交通型態判斷：SCHED_TRAFFIC_WINDOW_S 切成幾格滑動，每格結束時重新判斷 */
+#define TRAFFIC_SLOTS 6
+#define TRAFFIC_SLOT_S (SCHED_TRAFFIC_WINDOW_S / TRAFFIC_SLOTS)
+#define TRAFFIC_MIN_CALLS 12       // 視窗內外呼太少 => 不算尖峰
+#define TRAFFIC_ENTER_SKEW 0.75    // 進入尖峰：同方向外呼的比例
+#define TRAFFIC_LEAVE_SKEW 0.60    // 離開尖峰：低於這個比例
+#define TRAFFIC_ENTER_ORIGIN 0.50  // 上班尖峰：最多外呼的樓層佔的比例
+#define TRAFFIC_LEAVE_ORIGIN 0.35
+#define TRAFFIC_MIN_HOLD_S 60.0    // 切換後至少維持多久
+
+/* 待命位置 */
+typedef enum {
+    HOME_NONE = 0,   // 不主動移動（或交給預測停靠）
+    HOME_ORIGIN,     // 全部回尖峰起點層（大廳）
+    HOME_SPREAD      // 平均分散在各樓層區段
+} HomePolicy;
+
+/* 各交通型態的參數 */
+typedef struct {
+    double idle_bonus;     // 成本：閒置電梯扣分
+    double ahead_bonus;    // 成本：同方向且請求在前方扣分
+    double door_penalty;   // 成本：正在開門加分
+    double load_weight;    // 成本：負載項權重
+    HomePolicy home;
+} TrafficParams;
+
+static const TrafficParams g_traffic_params[TRAFFIC_MODE_COUNT] = {
+    [TRAFFIC_MODE_BALANCED]  = { 2.0, 1.5, 2.0, 3.0, HOME_NONE },
+    [TRAFFIC_MODE_UP_PEAK]   = { 2.0, 1.5, 2.0, 3.0, HOME_ORIGIN },
+    [TRAFFIC_MODE_DOWN_PEAK] = { 2.0, 3.0, 2.0, 3.0, HOME_SPREAD },
+};
+
+/* 目的樓層派車 */
+#define DEST_TICKETS_PER_FLOOR SCHED_DEST_TICKETS_PER_FLOOR  // 每層可同時掛幾筆目的樓層（滿了就退回只按方向）
+#define DEST_STOP_PENALTY_S 8.0    // 多停一層的代價（秒）：目的樓層已在停靠清單上的電梯優先 => 同目的地併車
+
+/* 一位乘客的目的樓層：car 在 floor 開門服務後才變成內呼（先接人再送） */
+typedef struct {
+    short floor;          // 上車樓層
+    short to_floor;       // 目的樓層
+    unsigned char di;     // 0 = UP, 1 = DOWN
+    unsigned char car;    // 負責的電梯（elevators[] 索引）
+    int client_id;
+    unsigned request_id;  // 非 0 => 回報要搭哪台
+} DestTicket;
+
+/* 訂閱生命週期通知的請求（網路層發的 ID） */
+#define CALL_SUBSCRIBERS_MAX SCHED_CALL_SUBSCRIBERS_MAX  // 每筆外呼最多記幾個，超過的只收到 ASSIGNED
+typedef struct {
+    int client_id;
+    unsigned request_id;
+} CallSubscriber;
+
+/* 外呼等待時間（按下到電梯清掉旗標），超過 SLO 就升級處理 */
+typedef struct {
+    int active;          // 追蹤中
+    double since_s;      // 最早一次按下的虛擬時間
+    int escalated;       // 已升級（不重複告警）
+    unsigned holders;    // 掛著這筆外呼的電梯（bit i = elevators[i]）
+    int arriving_car;    // 已送出 ARRIVING 的電梯 id（-1 = 還沒）
+    int planned;         // 最佳化計畫改派過（一般改派不再搬動）
+    int sub_count;
+    CallSubscriber subs[CALL_SUBSCRIBERS_MAX];
+} CallAge;
+
+/* 一棟大樓的排程狀態 */
+struct SchedulerState {
+    EtaCache* eta;                        // 這棟大樓的 ETA 快取
+    int building;                         // 大樓 ID（通知用）
+    int rd_car;                           // 改派輪詢游標：下一筆從哪台電梯的哪個位置開始找
+    int rd_slot;                          // slot = floor * 2 + (0 = 上, 1 = 下)
+    SchedulerRedispatchStats rd_stats;
+    int floors;                           // 大樓樓層數（下面兩張表的大小）
+    CallAge (*call_age)[2];               // [floor][0 = UP, 1 = DOWN]
+    short* tracked;                       // 追蹤中的外呼（slot = floor * 2 + dir_idx）
+    int tracked_count;
+    double now_s;                         // 本次 Scheduler_Process 的虛擬時間
+    SchedulerSloStats slo_stats;
+    DemandModel* demand;                  // 外呼到達率（預測停靠用，NULL = 不停靠）
+    double park_next_s;                   // 下一次檢查待命位置的時間
+    TrafficMode mode;                     // 目前的交通型態
+    double mode_since_s;                  // 進入目前型態的時間
+    int peak_floor;                       // 最多外呼的樓層（上班尖峰的起點）
+    long traffic_slot;                    // 目前計數中的格子序號（-1 = 尚未開始）
+    unsigned short (*traffic_count)[2];   // [slot * floors + floor][0 = UP, 1 = DOWN]
+    DestTicket* tickets;                  // 已派車、還沒上車的目的樓層
+    int ticket_count;
+    int ticket_cap;
+    PlanOptimizer* opt;                   // 背景最佳化（NULL = 不用）
+    int opt_slot;                         // 這棟大樓在最佳化器中的編號
+    unsigned long opt_seq;                // 最後送出的快照編號
+    double opt_next_s;                    // 下一次送快照的時間
+};
+
+/* 舊介面（單一大樓）使用的預設狀態：核心綁上大樓 0 的狀態（依大樓描述配置），
+ * 沒有綁定時才配置一份上限大小的 */
+static SchedulerState* g_default = NULL;
+static SchedulerState* g_fallback = NULL;
+
+static SchedulerState* default_state(void)
+{
+    if (g_default) return g_default;
+    if (!g_fallback) g_fallback = Scheduler_create(eta_default_cache(), 0, MAX_FLOORS);
+    return g_fallback;
+}
+
 /* sign helper */
 static int sign_int(int x) {
     return (x > 0) ? 1 : ((x < 0) ? -1 : 0);
 }
 
-/* 計算電梯目前所有待處理請求數（內部 + 上 + 下）*/
+/* 計算電梯目前所有待處理請求數（內部 + 上 + 下），電梯自己維護計數 */
 static int count_requests(const Elevator* e) {
-    if (!e) return 0;
-    int count = 0;
-    for (int f = 0; f < MAX_FLOORS; ++f) {
-        if (e->inside[f]) ++count;
-        if (e->call_up[f]) ++count;
-        if (e->call_down[f]) ++count;
-    }
-    return count;
+    return e ? e->request_count : 0;
+}
+
+/* 電梯能否接這層的新外呼：服務中、停靠該層且沒有客滿 */
+static inline int car_available(const Elevator* e, int floor) {
+    return e->in_service && Elevator_serves(e, floor) && !Elevator_full(e);
 }
 
-/* 估算電梯載客的成本 */
-static double estimate_cost(const Elevator* e, int pickup_floor)
+/* 估算電梯載客的成本（權重依交通型態） */
+static double estimate_cost(const TrafficParams* P, const Elevator* e, int pickup_floor)
 {
     if (!e) return 1e12;
     double d = fabs((double)e->current_floor - (double)pickup_floor);
     double cost = d;
 
-    if (e->task_state == TASK_IDLE) cost -= 2.0;
+    if (e->task_state == TASK_IDLE) cost -= P->idle_bonus;
 
     /* direction match bonus */
     if (e->direction != DIR_NONE) {
@@ -48,102 +176,663 @@ static double estimate_cost(const Elevator* e, int pickup_floor)
             /* ensure pickup is ahead (not behind) */
             if ((e->direction == DIR_UP && pickup_floor >= e->current_floor) ||
                 (e->direction == DIR_DOWN && pickup_floor <= e->current_floor)) {
-                cost -= 1.5;
+                cost -= P->ahead_bonus;
             }
         }
-        if (e->task_state == TASK_DOOR_OPEN || e->task_state == TASK_DOOR_OPENING) cost += 2.0;
+        if (e->task_state == TASK_DOOR_OPEN || e->task_state == TASK_DOOR_OPENING) cost += P->door_penalty;
     }
 
-    /* qload: normalize by MAX_FLOORS to keep scale moderate */
+    /* qload: normalize to keep scale moderate */
     double qcount = (double)count_requests(e);
-    double qload = qcount / (double)MAX_FLOORS;
-    cost += qload * 3.0;
+    double qload = qcount / QLOAD_NORM_FLOORS;
+    cost += qload * P->load_weight;
 
     if (cost < 0.0) cost = 0.0;
     return cost;
 }
 
 /*
- * 從 pending queue 取一個請求，選擇最適合的電梯分配
+ * 預設策略：選擇最適合的電梯
  * A) 先選擇最靠近的閒置電梯
  * B) 否則依成本評估選最佳電梯
- * 分配失敗則將請求放回佇列
+ * 回傳電梯索引（-1 = 沒有可用電梯），*out_cost 為成本
  */
-static int try_assign_one(RequestQueue* pending, Elevator elevators[], int elevator_count)
+static int select_greedy(SchedulerState* S, const PendingRequest* preq, Elevator elevators[], int elevator_count,
+                         double* out_cost)
 {
-    PendingRequest preq;
-    if (rq_pop(pending, &preq) != 0) return 0;
-
-    int pickup_floor = preq.floor;
+    int pickup_floor = preq->floor;
+    int best_idx = -1;
+    double best_cost = 1e18;
 
     // 如果有閒置，先選最近的閒置電梯
     int idle_idx = -1;
     int idle_best_dist = INT_MAX;
     for (int i = 0; i < elevator_count; ++i) {
         Elevator* e = &elevators[i];
-        if (!e) continue;
-        if (e->task_state == TASK_IDLE) {
+        if (!car_available(e, pickup_floor)) continue;  // 停用中 / 不停靠該層的電梯（分區 / 高低層）
+        if (e->task_state == TASK_IDLE || e->parking) {  // 前往待命樓層的空車一樣可以直接接
             int dist = abs(e->current_floor - pickup_floor);
             // 計算閒置電梯的距離，挑近的
             if (dist < idle_best_dist) {
                 idle_best_dist = dist;
                 idle_idx = i;
             } else if (dist == idle_best_dist) {
-                // 距離相同選擇請求較少的電梯
-                int cur_load = 0;
-                for (int f = 0; f < MAX_FLOORS; ++f) {
-                    cur_load += (e->inside[f] || e->call_up[f] || e->call_down[f]);
-                }
-                Elevator* prev = &elevators[idle_idx];
-                int prev_load = 0;
-                for (int f = 0; f < MAX_FLOORS; ++f) {
-                    prev_load += (prev->inside[f] || prev->call_up[f] || prev->call_down[f]);
-                }
-                if (cur_load < prev_load) idle_idx = i;
+                // 距離相同選擇停靠樓層較少的電梯
+                if (e->stop_floors < elevators[idle_idx].stop_floors) idle_idx = i;
             }
         }
     }
 
-    int best_idx = -1;
-    double best_cost = 1e18;
-
     // 如果挑到閒置 => 指派過去
     if (idle_idx >= 0) {
         /* Assign to the chosen idle elevator */
         best_idx = idle_idx;
         best_cost = 0.0;
-        printf("[SCHED] try_assign_one: picked idle elevator %d for request floor=%d type=%d\n",
-               best_idx, pickup_floor, (int)preq.type);
+        CORE_LOG("[SCHED] try_assign_one: picked idle elevator %d for request floor=%d type=%d\n",
+                 best_idx, pickup_floor, (int)preq->type);
     }
     // 沒閒置的 => 去算載客成本
     else {
         for (int i = 0; i < elevator_count; ++i) {
             Elevator* e = &elevators[i];
             int cur_load = count_requests(e);
-            if (cur_load >= MAX_REQUESTS) continue;
+            if (cur_load >= MAX_REQUESTS || !car_available(e, pickup_floor)) continue;
 
-            double c = estimate_cost(e, preq.floor);
+            double c = estimate_cost(&g_traffic_params[S->mode], e, preq->floor);
             if (c < best_cost) {
                 best_cost = c;
                 best_idx = i;
             }
         }
         if (best_idx >= 0) {
-            printf("[SCHED] try_assign_one: picked elevator %d for request floor=%d type=%d (cost=%.2f)\n",
-                   best_idx, pickup_floor, (int)preq.type, best_cost);
+            CORE_LOG("[SCHED] try_assign_one: picked elevator %d for request floor=%d type=%d (cost=%.2f)\n",
+                     best_idx, pickup_floor, (int)preq->type, best_cost);
+        }
+    }
+
+    *out_cost = best_cost;
+    return best_idx;
+}
+
+/* ETA 策略：挑預估開門時間最早的電梯（成本 = 秒數，見 eta.h） */
+static int select_by_eta(SchedulerState* S, const PendingRequest* preq, Elevator elevators[], int elevator_count, double* out_cost)
+{
+    Direction want = (preq->type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+    int best_idx = -1;
+    double best_cost = 1e18;
+
+    for (int i = 0; i < elevator_count; ++i) {
+        if (count_requests(&elevators[i]) >= MAX_REQUESTS || !car_available(&elevators[i], preq->floor)) continue;
+        double eta = eta_cache_car(S->eta, &elevators[i], preq->floor, want);
+        if (eta >= 0.0 && eta < best_cost) {
+            best_cost = eta;
+            best_idx = i;
+        }
+    }
+    *out_cost = best_cost;
+    return best_idx;
+}
+
+/* rollout 快照：所有電梯（依 elevators[] 索引） */
+static void snapshot_cars(const SchedulerState* S, const Elevator elevators[], int elevator_count, RolloutSnapshot* snap)
+{
+    rollout_snapshot_init(snap, elevators[0].floors, g_rollout_horizon_s);
+    if (S->mode != TRAFFIC_MODE_BALANCED && S->peak_floor >= 0) snap->down_to = S->peak_floor;
+    for (int i = 0; i < elevator_count && i < MAX_ELEVATORS; ++i) {
+        const Elevator* e = &elevators[i];
+        rollout_add_car(snap, e, e->in_service && !Elevator_full(e) && count_requests(e) < MAX_REQUESTS);
+    }
+}
+
+/* rollout 快照：已掛著的外呼（各記在第一台持有的電梯）、佇列中的外呼、依近期外呼率預測的到達 */
+static void snapshot_calls(const SchedulerState* S, const RequestQueue* pending, RolloutSnapshot* snap)
+{
+    for (int k = 0; k < S->tracked_count; ++k) {
+        int floor = S->tracked[k] >> 1;
+        int di = S->tracked[k] & 1;
+        const CallAge* a = &S->call_age[floor][di];
+        if (!a->holders) continue;
+        int car = 0;
+        while (!(a->holders & (1u << car))) ++car;
+        rollout_add_call(snap, floor, di ? DIR_DOWN : DIR_UP, -1, a->since_s - S->now_s, car);
+    }
+    for (int k = 0; k < pending->count; ++k) {
+        const PendingRequest* q = &pending->items[(pending->head + k) % MAX_REQUESTS];
+        if (q->type == REQ_INSIDE) continue;
+        rollout_add_call(snap, q->floor, (q->type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN, q->to_floor,
+                         q->enqueue_s - S->now_s, -1);
+    }
+    if (g_traffic_modes && S->traffic_slot >= 0) {
+        double rate[MAX_FLOORS][2];
+        for (int f = 0; f < snap->floors; ++f) {
+            unsigned up = 0, down = 0;
+            for (int k = 0; k < TRAFFIC_SLOTS && f < S->floors; ++k) {
+                up += S->traffic_count[k * S->floors + f][0];
+                down += S->traffic_count[k * S->floors + f][1];
+            }
+            rate[f][0] = up / SCHED_TRAFFIC_WINDOW_S;
+            rate[f][1] = down / SCHED_TRAFFIC_WINDOW_S;
         }
+        rollout_add_demand(snap, (const double(*)[2])rate);
     }
+}
 
-    // 沒可用電梯 => 將請求丟回佇列等待下次分配
+/* Rollout 策略：每台能接的電梯各往前模擬一次（rollout.h），挑預估總等待最短的 */
+static int select_by_rollout(SchedulerState* S, const PendingRequest* preq, Elevator elevators[], int elevator_count,
+                             const RequestQueue* pending, double* out_cost)
+{
+    int cand[MAX_ELEVATORS];
+    int n = 0;
+    for (int i = 0; i < elevator_count && i < MAX_ELEVATORS; ++i) {
+        if (count_requests(&elevators[i]) >= MAX_REQUESTS || !car_available(&elevators[i], preq->floor)) continue;
+        cand[n++] = i;
+    }
+    *out_cost = 0.0;
+    if (n <= 1) return (n == 1) ? cand[0] : -1;
+
+    // 快照：電梯、新外呼、其他已知的外呼與預測的到達
+    RolloutSnapshot snap;
+    snapshot_cars(S, elevators, elevator_count, &snap);
+    Direction want = (preq->type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+    int call = rollout_add_call(&snap, preq->floor, want, preq->to_floor, preq->enqueue_s - S->now_s, -1);
+    if (call < 0) return select_by_eta(S, preq, elevators, elevator_count, out_cost);
+    snapshot_calls(S, pending, &snap);
+
+    double cost[MAX_ELEVATORS];
+    rollout_evaluate(&snap, call, cand, n, cost);
+    int best = 0;
+    for (int k = 1; k < n; ++k) {
+        if (cost[k] < cost[best]) best = k;
+    }
+    // 差不多的（例如同一筆外呼已有別台電梯掛著）=> 挑 ETA 最短的
+    int pick = best;
+    double pick_eta = 1e18;
+    for (int k = 0; k < n; ++k) {
+        if (cost[k] > cost[best] + ROLL_TIE_WAIT_S) continue;
+        double eta = eta_cache_car(S->eta, &elevators[cand[k]], preq->floor, want);
+        if (eta >= 0.0 && eta < pick_eta) {
+            pick_eta = eta;
+            pick = k;
+        }
+    }
+    *out_cost = cost[pick];
+    return cand[pick];
+}
+
+/* 是否有電梯停靠該層（不論是否停用：停用的電梯之後可能恢復） */
+static int any_serves(const Elevator elevators[], int elevator_count, int floor)
+{
+    for (int i = 0; i < elevator_count; ++i) {
+        if (Elevator_serves(&elevators[i], floor)) return 1;
+    }
+    return 0;
+}
+
+static inline int dir_index(RequestType type)
+{
+    return (type == REQ_CALL_UP) ? 0 : 1;
+}
+
+/* 目前掛著這筆外呼的電梯 */
+static unsigned call_holders(const Elevator elevators[], int elevator_count, int floor, int di)
+{
+    unsigned mask = 0;
+    for (int i = 0; i < elevator_count; ++i) {
+        if (di == 0 ? elevators[i].call_up[floor] : elevators[i].call_down[floor]) mask |= 1u << i;
+    }
+    return mask;
+}
+
+/* 外呼指派給 car => 開始追蹤等待時間（重複按同一筆沿用最早的時間） */
+static void track_call(SchedulerState* S, int floor, RequestType type, double since_s, int car)
+{
+    if (floor < 0 || floor >= S->floors || type == REQ_INSIDE) return;
+    CallAge* a = &S->call_age[floor][dir_index(type)];
+    if (a->active) {
+        if (since_s < a->since_s) a->since_s = since_s;
+        a->holders |= 1u << car;
+        return;
+    }
+    a->active = 1;
+    a->since_s = since_s;
+    a->escalated = 0;
+    a->holders = 1u << car;
+    a->arriving_car = -1;
+    a->planned = 0;
+    a->sub_count = 0;
+    S->tracked[S->tracked_count++] = (short)(floor * 2 + dir_index(type));
+}
+
+/* ---------------------------
+   Destination tickets
+   --------------------------- */
+
+/* 告訴乘客要搭哪台（派車與改派時） */
+static void notify_board(SchedulerState* S, const DestTicket* t, int car_id)
+{
+    if (t->request_id == 0) return;
+    CoreNotice n;
+    memset(&n, 0, sizeof(n));
+    n.type = NOTICE_BOARD;
+    n.building = S->building;
+    n.at_s = S->now_s;
+    n.floor = t->floor;
+    n.dir = t->di ? DIR_DOWN : DIR_UP;
+    n.car = car_id;
+    n.eta_s = -1.0;
+    n.client_id = t->client_id;
+    n.request_id = t->request_id;
+    n.to_floor = t->to_floor;
+    core_notify_push(&n);
+}
+
+static int add_ticket(SchedulerState* S, const PendingRequest* preq, int car)
+{
+    if (S->ticket_count >= S->ticket_cap) return -1;
+    DestTicket* t = &S->tickets[S->ticket_count++];
+    t->floor = (short)preq->floor;
+    t->to_floor = (short)preq->to_floor;
+    t->di = (unsigned char)dir_index(preq->type);
+    t->car = (unsigned char)car;
+    t->client_id = preq->source_id;
+    t->request_id = preq->request_id;
+    return 0;
+}
+
+/* car 在 floor / 方向 di 等著上車的乘客數 */
+static int count_tickets(const SchedulerState* S, int car, int floor, int di)
+{
+    int n = 0;
+    for (int k = 0; k < S->ticket_count; ++k) {
+        const DestTicket* t = &S->tickets[k];
+        if (t->car == car && t->floor == floor && t->di == di) ++n;
+    }
+    return n;
+}
+
+/* car 會不會停 floor：已有任何請求或已有乘客要去那層 */
+static int stops_at(const SchedulerState* S, const Elevator* e, int car, int floor)
+{
+    if (e->inside[floor] || e->call_up[floor] || e->call_down[floor]) return 1;
+    for (int k = 0; k < S->ticket_count; ++k) {
+        if (S->tickets[k].car == car && S->tickets[k].to_floor == floor) return 1;
+    }
+    return 0;
+}
+
+/* car 已在 floor 開門服務 => 這些乘客上車了，目的樓層變成內呼 */
+static void board_tickets(SchedulerState* S, Elevator elevators[], int floor, int di, int car)
+{
+    for (int k = 0; k < S->ticket_count;) {
+        DestTicket* t = &S->tickets[k];
+        if (t->car != car || t->floor != floor || t->di != di) {
+            ++k;
+            continue;
+        }
+        int rc = Elevator_push_inside_request(&elevators[car], t->to_floor, t->client_id);
+        if (rc != ELEV_OK && rc != ELEV_DUPLICATE) {
+            CORE_LOG("[SCHED] B%d E%d does not stop at %d, destination dropped\n", S->building, elevators[car].id,
+                     t->to_floor);
+        }
+        *t = S->tickets[--S->ticket_count];
+    }
+}
+
+/* 取走某個請求的目的樓層（放回 pending 時用），回傳目的樓層或 -1 */
+static int take_ticket(SchedulerState* S, int car, int floor, int di, unsigned request_id)
+{
+    if (request_id == 0) return -1;
+    for (int k = 0; k < S->ticket_count; ++k) {
+        DestTicket* t = &S->tickets[k];
+        if (t->car != car || t->floor != floor || t->di != di || t->request_id != request_id) continue;
+        int to = t->to_floor;
+        *t = S->tickets[--S->ticket_count];
+        return to;
+    }
+    return -1;
+}
+
+/* 外呼改由 to 負責 => 等這筆的乘客也跟著換車 */
+static void move_tickets(SchedulerState* S, const Elevator elevators[], int floor, int di, int from, int to)
+{
+    for (int k = 0; k < S->ticket_count; ++k) {
+        DestTicket* t = &S->tickets[k];
+        if (t->car != from || t->floor != floor || t->di != di) continue;
+        t->car = (unsigned char)to;
+        notify_board(S, t, elevators[to].id);
+    }
+}
+
+/* 排程器自己把外呼從 from 移到 to（改派 / 升級） */
+static void move_holder(SchedulerState* S, const Elevator elevators[], int floor, RequestType type, int from, int to)
+{
+    CallAge* a = &S->call_age[floor][dir_index(type)];
+    a->holders = (a->holders & ~(1u << from)) | (1u << to);
+    move_tickets(S, elevators, floor, dir_index(type), from, to);
+}
+
+/* 目的樓層派車：預估到達時間 + 目的樓層不在停靠清單上時多停一層的代價
+ * 同樣往那層去的電梯較便宜 => 同目的地的乘客併到同一台（不論策略都用這個成本） */
+static int select_by_destination(SchedulerState* S, const PendingRequest* preq, Elevator elevators[], int elevator_count,
+                                 double* out_cost)
+{
+    Direction want = (preq->type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+    int best_idx = -1;
+    double best_cost = 1e18;
+
+    for (int i = 0; i < elevator_count; ++i) {
+        const Elevator* e = &elevators[i];
+        if (count_requests(e) >= MAX_REQUESTS || !car_available(e, preq->floor) ||
+            !Elevator_serves(e, preq->to_floor)) continue;
+        // 有載客量 => 這層已分到的乘客加上車內的人不能超過（車內的人到時可能已下車，保守估計）
+        if (e->capacity > 0 &&
+            count_tickets(S, i, preq->floor, dir_index(preq->type)) + e->load >= e->capacity) continue;
+        double eta = eta_cache_car(S->eta, e, preq->floor, want);
+        if (eta < 0.0) continue;
+        double cost = eta + (stops_at(S, e, i, preq->to_floor) ? 0.0 : DEST_STOP_PENALTY_S);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_idx = i;
+        }
+    }
+    *out_cost = best_cost;
+    return best_idx;
+}
+
+/* 是否有電梯同時停靠上車與目的樓層（不論是否停用） */
+static int any_serves_trip(const Elevator elevators[], int elevator_count, int from, int to)
+{
+    for (int i = 0; i < elevator_count; ++i) {
+        if (Elevator_serves(&elevators[i], from) && Elevator_serves(&elevators[i], to)) return 1;
+    }
+    return 0;
+}
+
+/* 電梯是否已經在處理這筆外呼（停在該層開門中 / 正要往該層停靠） => 不改派 */
+static int call_committed(const Elevator* e, int floor)
+{
+    if (e->target_floor == floor &&
+        (e->task_state == TASK_PREPARE || e->task_state == TASK_MOVING)) return 1;
+    if (e->current_floor != floor) return 0;
+    switch (e->task_state) {
+        case TASK_ARRIVED:
+        case TASK_DOOR_OPENING:
+        case TASK_DOOR_OPEN:
+        case TASK_DOOR_CLOSING:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* 送一筆生命週期通知 */
+static void push_lifecycle(SchedulerState* S, CoreNoticeType type, int floor, int di, int car, double eta_s,
+                           int client_id, unsigned request_id)
+{
+    CoreNotice n;
+    memset(&n, 0, sizeof(n));
+    n.type = type;
+    n.building = S->building;
+    n.at_s = S->now_s;
+    n.floor = floor;
+    n.dir = di ? DIR_DOWN : DIR_UP;
+    n.car = car;
+    n.wait_s = 0.0;
+    n.eta_s = eta_s;
+    n.client_id = client_id;
+    n.request_id = request_id;
+    core_notify_push(&n);
+}
+
+/* 通知這筆外呼的所有訂閱者（沒人訂閱就什麼都不做） */
+static void notify_subscribers(SchedulerState* S, const CallAge* a, CoreNoticeType type, int floor, int di, int car, double eta_s)
+{
+    for (int s = 0; s < a->sub_count; ++s) {
+        push_lifecycle(S, type, floor, di, car, eta_s, a->subs[s].client_id, a->subs[s].request_id);
+    }
+}
+
+/* 訂閱者還沒收到 ARRIVING => 看有沒有掛著的電梯已鎖定這層 */
+static void check_arriving(SchedulerState* S, CallAge* a, const Elevator elevators[], int elevator_count, int floor, int di)
+{
+    if (a->sub_count == 0 || a->arriving_car >= 0) return;
+    for (int i = 0; i < elevator_count; ++i) {
+        if ((a->holders & (1u << i)) && call_committed(&elevators[i], floor)) {
+            a->arriving_car = elevators[i].id;
+            notify_subscribers(S, a, NOTICE_ARRIVING, floor, di, a->arriving_car, -1.0);
+            return;
+        }
+    }
+}
+
+/* 有電梯自己清掉了外呼 => 已開門服務，記錄等待時間
+ * 其他電梯若還掛著同一筆（重複指派），那是之後才要等的，從現在重新計時 */
+static void refresh_call_ages(SchedulerState* S, Elevator elevators[], int elevator_count)
+{
+    for (int k = 0; k < S->tracked_count;) {
+        int floor = S->tracked[k] >> 1;
+        int di = S->tracked[k] & 1;
+        CallAge* a = &S->call_age[floor][di];
+        unsigned now_held = call_holders(elevators, elevator_count, floor, di);
+        unsigned served = a->holders & ~now_held;
+        if (served) {
+            double wait = S->now_s - a->since_s;
+            if (wait > S->slo_stats.max_wait_s) S->slo_stats.max_wait_s = wait;
+            a->since_s = S->now_s;
+            a->escalated = 0;
+            int car = 0;
+            while (!(served & (1u << car))) ++car;
+            notify_subscribers(S, a, NOTICE_SERVED, floor, di, elevators[car].id, -1.0);
+            for (int i = car; S->ticket_count > 0 && i < elevator_count; ++i) {
+                if (served & (1u << i)) board_tickets(S, elevators, floor, di, i);
+            }
+            a->sub_count = 0;
+            a->arriving_car = -1;
+        }
+        a->holders = now_held;  // 沒有電梯服務時可能是警衛直接加的
+        if (now_held) {
+            check_arriving(S, a, elevators, elevator_count, floor, di);
+            ++k;
+            continue;
+        }
+        a->sub_count = 0;
+        a->active = 0;
+        S->tracked[k] = S->tracked[--S->tracked_count];
+    }
+}
+
+/* SLO 逾時：不管負載上限與改派門檻，挑 ETA 最短的電梯（仍須停靠該層） */
+static int select_forced(SchedulerState* S, int floor, Direction dir, Elevator elevators[], int elevator_count, double* out_eta)
+{
+    int best_idx = -1;
+    double best = 1e18;
+    for (int i = 0; i < elevator_count; ++i) {
+        if (!elevators[i].in_service || !Elevator_serves(&elevators[i], floor)) continue;
+        double eta = eta_cache_car(S->eta, &elevators[i], floor, dir);
+        if (eta >= 0.0 && eta < best) {
+            best = eta;
+            best_idx = i;
+        }
+    }
+    *out_eta = best;
+    return best_idx;
+}
+
+/* 升級告警給警衛端 */
+static void notify_slo(SchedulerState* S, int floor, Direction dir, int car, double wait_s)
+{
+    CoreNotice n;
+    memset(&n, 0, sizeof(n));
+    n.type = NOTICE_WAIT_SLO;
+    n.building = S->building;
+    n.at_s = S->now_s;
+    n.floor = floor;
+    n.dir = (int)dir;
+    n.car = car;
+    n.wait_s = wait_s;
+    n.eta_s = -1.0;
+    n.client_id = -1;
+    n.request_id = 0;
+    core_notify_push(&n);
+    S->slo_stats.escalated++;
+    CORE_LOG("[SCHED] SLO: floor=%d %s waited %.1fs -> E%d\n",
+             floor, (dir == DIR_UP) ? "UP" : "DOWN", wait_s, car);
+}
+
+/* 有訂閱的外呼指派成功：回 ASSIGNED，並記下來等之後的 ARRIVING / SERVED */
+static void subscribe_call(SchedulerState* S, const PendingRequest* preq, const Elevator* chosen,
+                           const Elevator elevators[], int elevator_count)
+{
+    int di = dir_index(preq->type);
+    CallAge* a = &S->call_age[preq->floor][di];
+    double eta = eta_cache_car(S->eta, chosen, preq->floor, di ? DIR_DOWN : DIR_UP);
+    push_lifecycle(S, NOTICE_ASSIGNED, preq->floor, di, chosen->id, eta, preq->source_id, preq->request_id);
+    if (a->sub_count >= CALL_SUBSCRIBERS_MAX) {
+        CORE_LOG("[SCHED] too many subscribers on floor=%d, request %u not tracked\n", preq->floor, preq->request_id);
+        return;
+    }
+    a->subs[a->sub_count].client_id = preq->source_id;
+    a->subs[a->sub_count].request_id = preq->request_id;
+    a->sub_count++;
+    // 已經有電梯在靠站 => 直接補送 ARRIVING
+    if (a->arriving_car >= 0) {
+        push_lifecycle(S, NOTICE_ARRIVING, preq->floor, di, a->arriving_car, -1.0, preq->source_id, preq->request_id);
+    } else {
+        check_arriving(S, a, elevators, elevator_count, preq->floor, di);
+    }
+}
+
+/* ---------------------------
+   Traffic mode
+   --------------------------- */
+
+/* 把已派出的外呼計入目前的格子 */
+static void note_traffic(SchedulerState* S, int floor, RequestType type)
+{
+    if (!g_traffic_modes || S->traffic_slot < 0) return;
+    int slot = (int)(S->traffic_slot % TRAFFIC_SLOTS);
+    unsigned short* c = S->traffic_count[slot * S->floors + floor];
+    int di = dir_index(type);
+    if (c[di] < USHRT_MAX) c[di]++;
+}
+
+/* 依視窗內的外呼統計決定下一個型態（進入 / 離開用不同門檻） */
+static TrafficMode classify_traffic(SchedulerState* S)
+{
+    unsigned up = 0, down = 0, top = 0;
+    int top_floor = -1;
+    for (int f = 0; f < S->floors; ++f) {
+        unsigned fu = 0, fd = 0;
+        for (int k = 0; k < TRAFFIC_SLOTS; ++k) {
+            fu += S->traffic_count[k * S->floors + f][0];
+            fd += S->traffic_count[k * S->floors + f][1];
+        }
+        up += fu;
+        down += fd;
+        if (fu + fd > top) {
+            top = fu + fd;
+            top_floor = f;
+        }
+    }
+    unsigned n = up + down;
+    if (n < TRAFFIC_MIN_CALLS) return TRAFFIC_MODE_BALANCED;
+    double up_share = (double)up / n;
+    double down_share = (double)down / n;
+    double origin_share = (double)top / n;
+
+    switch (S->mode) {
+        case TRAFFIC_MODE_UP_PEAK:
+            if (up_share >= TRAFFIC_LEAVE_SKEW && origin_share >= TRAFFIC_LEAVE_ORIGIN) {
+                S->peak_floor = top_floor;
+                return TRAFFIC_MODE_UP_PEAK;
+            }
+            return TRAFFIC_MODE_BALANCED;
+        case TRAFFIC_MODE_DOWN_PEAK:
+            return (down_share >= TRAFFIC_LEAVE_SKEW) ? TRAFFIC_MODE_DOWN_PEAK : TRAFFIC_MODE_BALANCED;
+        default:
+            if (up_share >= TRAFFIC_ENTER_SKEW && origin_share >= TRAFFIC_ENTER_ORIGIN) {
+                S->peak_floor = top_floor;
+                return TRAFFIC_MODE_UP_PEAK;
+            }
+            if (down_share >= TRAFFIC_ENTER_SKEW) return TRAFFIC_MODE_DOWN_PEAK;
+            return TRAFFIC_MODE_BALANCED;
+    }
+}
+
+/* 時間進到新的格子：清掉滑出視窗的計數，重新判斷型態（至少維持 TRAFFIC_MIN_HOLD_S 才切換） */
+static void update_traffic_mode(SchedulerState* S)
+{
+    if (!g_traffic_modes) return;
+    long slot = (long)floor(S->now_s / TRAFFIC_SLOT_S);
+    if (slot == S->traffic_slot) return;
+    if (S->traffic_slot < 0) {
+        S->traffic_slot = slot;
+        return;
+    }
+    for (long k = S->traffic_slot + 1; k <= slot && k <= S->traffic_slot + TRAFFIC_SLOTS; ++k) {
+        memset(S->traffic_count[(k % TRAFFIC_SLOTS) * S->floors], 0, sizeof(unsigned short) * 2 * (size_t)S->floors);
+    }
+    S->traffic_slot = slot;
+
+    TrafficMode next = classify_traffic(S);
+    if (next == S->mode || S->now_s - S->mode_since_s < TRAFFIC_MIN_HOLD_S) return;
+    CORE_LOG("[SCHED] B%d traffic mode %s -> %s\n", S->building, Scheduler_traffic_mode_name(S->mode),
+             Scheduler_traffic_mode_name(next));
+    S->mode = next;
+    S->mode_since_s = S->now_s;
+}
+
+/*
+ * 依目前策略替一筆已取出的請求選擇電梯分配
+ * 回傳 1 = 已派出（或永遠派不出去而丟掉），0 = 目前沒有電梯能接，由呼叫端放回佇列
+ */
+static int assign_request(SchedulerState* S, PendingRequest preq, RequestQueue* pending, Elevator elevators[],
+                          int elevator_count, PendingRequest* unplaced)
+{
+    // 有目的樓層、但沒有電梯能直達 => 當成只按方向（乘客進電梯再按）
+    if (preq.type != REQ_INSIDE && preq.to_floor >= 0 &&
+        !any_serves_trip(elevators, elevator_count, preq.floor, preq.to_floor)) {
+        preq.to_floor = -1;
+    }
+    int dest = (preq.type != REQ_INSIDE && preq.to_floor >= 0);
+
+    double best_cost = 0.0;
+    int best_idx;
+    if (dest) {
+        best_idx = select_by_destination(S, &preq, elevators, elevator_count, &best_cost);
+    } else if (g_policy == SCHED_POLICY_ETA && preq.type != REQ_INSIDE) {
+        best_idx = select_by_eta(S, &preq, elevators, elevator_count, &best_cost);
+    } else if (g_policy == SCHED_POLICY_ROLLOUT && preq.type != REQ_INSIDE) {
+        best_idx = select_by_rollout(S, &preq, elevators, elevator_count, pending, &best_cost);
+    } else {
+        best_idx = select_greedy(S, &preq, elevators, elevator_count, &best_cost);
+    }
+
+    // 外呼在佇列裡等超過 SLO => 不管負載上限，強制交給 ETA 最短的電梯
+    int forced = 0;
+    if (best_idx < 0 && preq.type != REQ_INSIDE && g_wait_slo_s > 0.0 &&
+        S->now_s - preq.enqueue_s > g_wait_slo_s) {
+        Direction want = (preq.type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+        best_idx = select_forced(S, preq.floor, want, elevators, elevator_count, &best_cost);
+        forced = (best_idx >= 0);
+    }
+
+    // 沒有任何電梯停靠該層 => 永遠派不出去，丟掉以免卡住後面的請求
+    if (best_idx < 0 && preq.type != REQ_INSIDE && !any_serves(elevators, elevator_count, preq.floor)) {
+        CORE_LOG("[SCHED] B%d no car serves floor=%d, call dropped\n", S->building, preq.floor);
+        return 1;
+    }
+
+    // 沒可用電梯 => 交回呼叫端，等待下次分配
     if (best_idx < 0) {
-        rq_push(pending, preq);
+        *unplaced = preq;
         return 0;
     }
 
     Elevator* chosen = &elevators[best_idx];
 
-    printf("[SCHED] try_assign_one: picked elevator %d for request floor=%d type=%d (cost=%.2f)\n",
-           best_idx, preq.floor, (int)preq.type, best_cost);
+    CORE_LOG("[SCHED] try_assign_one: picked elevator %d for request floor=%d type=%d (cost=%.2f)\n",
+             best_idx, preq.floor, (int)preq.type, best_cost);
 
     int rc = ELEV_ERR_INTERNAL;
     if (preq.type == REQ_INSIDE) {
@@ -157,26 +846,807 @@ static int try_assign_one(RequestQueue* pending, Elevator elevators[], int eleva
 
     if (rc == ELEV_OK || rc == ELEV_DUPLICATE) {
         // 成功指派請求
-        printf("[SCHED] try_assign_one: elevator_add_request_flag SUCCEEDED for E%d floor=%d (rc=%d)\n",
-               chosen->id, preq.floor, rc);
+        CORE_LOG("[SCHED] try_assign_one: elevator_add_request_flag SUCCEEDED for E%d floor=%d (rc=%d)\n",
+                 chosen->id, preq.floor, rc);
+        track_call(S, preq.floor, preq.type, preq.enqueue_s, best_idx);
+        if (preq.type != REQ_INSIDE) note_traffic(S, preq.floor, preq.type);
+        if (dest && Elevator_serves(chosen, preq.to_floor)) {
+            if (add_ticket(S, &preq, best_idx) == 0) {
+                notify_board(S, &S->tickets[S->ticket_count - 1], chosen->id);
+            } else {
+                CORE_LOG("[SCHED] B%d destination table full, floor=%d -> %d left to the car panel\n", S->building,
+                         preq.floor, preq.to_floor);
+            }
+        }
+        if (preq.request_id != 0 && preq.type != REQ_INSIDE) subscribe_call(S, &preq, chosen, elevators, elevator_count);
+        if (forced) {
+            S->call_age[preq.floor][dir_index(preq.type)].escalated = 1;
+            notify_slo(S, preq.floor, (preq.type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN, chosen->id,
+                       S->now_s - preq.enqueue_s);
+        }
         return 1;
     } else {
         // 錯誤
-        printf("[SCHED] try_assign_one: elevator_add_request_flag FAILED for E%d floor=%d (rc=%d) -> pushed back\n",
-               chosen->id, preq.floor, rc);
-        rq_push(pending, preq);
+        CORE_LOG("[SCHED] try_assign_one: elevator_add_request_flag FAILED for E%d floor=%d (rc=%d) -> pushed back\n",
+                 chosen->id, preq.floor, rc);
+        *unplaced = preq;
         return 0;
     }
 }
 
+/*
+ * 從 pending queue 取一個請求分配
+ * 分配失敗則將請求放回佇列最前面（保持先來先派，不會越排越後面）
+ */
+static int try_assign_one(SchedulerState* S, RequestQueue* pending, Elevator elevators[], int elevator_count)
+{
+    PendingRequest preq, unplaced;
+    if (rq_pop(pending, &preq) != 0) return 0;
+    if (assign_request(S, preq, pending, elevators, elevator_count, &unplaced)) return 1;
+    rq_push_front(pending, unplaced);
+    return 0;
+}
+
+/*
+ * 一個 tick 的分配：由最舊的請求往後看，派不出去的先放一邊、繼續看後面的
+ * （例如只有客滿電梯停靠的樓層，不擋住其他樓層），最多看 ASSIGN_SCAN_PER_TICK 筆
+ * 派不出去的依原順序放回佇列最前面，下個 tick 仍然最先處理
+ */
+static void assign_pending(SchedulerState* S, RequestQueue* pending, Elevator elevators[], int elevator_count)
+{
+    PendingRequest skipped[ASSIGN_SCAN_PER_TICK];
+    int skipped_count = 0;
+    int assigned = 0;
+    PendingRequest preq;
+    for (int scanned = 0; scanned < ASSIGN_SCAN_PER_TICK && assigned < ASSIGN_PER_TICK; ++scanned) {
+        if (rq_pop(pending, &preq) != 0) break;
+        if (assign_request(S, preq, pending, elevators, elevator_count, &skipped[skipped_count])) ++assigned;
+        else ++skipped_count;
+    }
+    while (skipped_count > 0) rq_push_front(pending, skipped[--skipped_count]);
+}
+
+/* 重新評估一筆已指派的外呼：別台電梯的 ETA 比原本的早超過門檻就改派 */
+static void redispatch_call(SchedulerState* S, Elevator elevators[], int elevator_count, int car, int floor, RequestType type)
+{
+    Elevator* from = &elevators[car];
+    if (!from->in_service) return;  // 停用時已交出外呼，剩下的是警衛強制加的
+    S->rd_stats.evaluated++;
+    if (call_committed(from, floor)) return;
+
+    Direction dir = (type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+    // 最佳化計畫排好的 => 不為了單筆的 ETA 搬走
+    if (S->call_age[floor][dir_index(type)].planned) return;
+    // 已告訴乘客搭這台 => 不改派（只有 SLO 升級與停用時才換車）
+    if (count_tickets(S, car, floor, dir_index(type)) > 0) return;
+    double current = eta_cache_car(S->eta, from, floor, dir);
+    if (current < 0.0) return;
+
+    int best_idx = -1;
+    double best = current - g_redispatch_hysteresis_s;
+    for (int i = 0; i < elevator_count; ++i) {
+        if (i == car || elevators[i].request_count >= MAX_REQUESTS || !car_available(&elevators[i], floor)) continue;
+        double eta = eta_cache_car(S->eta, &elevators[i], floor, dir);
+        if (eta >= 0.0 && eta < best) {
+            best = eta;
+            best_idx = i;
+        }
+    }
+    if (best_idx < 0) return;
+
+    // 先加到新電梯，成功才從原電梯撤回（新電梯已有同一筆外呼也算成功）
+    int rc = elevator_add_request_flag(&elevators[best_idx], floor, type);
+    if (rc != ELEV_OK && rc != ELEV_DUPLICATE) return;
+    elevator_remove_request_flag(from, floor, type);
+    move_holder(S, elevators, floor, type, car, best_idx);
+    notify_subscribers(S, &S->call_age[floor][dir_index(type)], NOTICE_ASSIGNED, floor, dir_index(type),
+                       elevators[best_idx].id, best);
+
+    S->rd_stats.moved++;
+    S->rd_stats.saved_s += current - best;
+    CORE_LOG("[SCHED] redispatch: floor=%d %s E%d -> E%d (eta %.1f -> %.1f)\n",
+             floor, (dir == DIR_UP) ? "UP" : "DOWN", from->id, elevators[best_idx].id, current, best);
+}
+
+/* 從輪詢游標往後找下一筆已指派的外呼，最多評估 budget 筆 */
+static void redispatch_assigned(SchedulerState* S, Elevator elevators[], int elevator_count)
+{
+    if (g_redispatch_budget <= 0 || elevator_count < 2) return;
+    if (S->rd_car >= elevator_count) {
+        S->rd_car = 0;
+        S->rd_slot = 0;
+    }
+
+    int budget = g_redispatch_budget;
+    // 最多繞所有電梯一圈（回到起點那台時再把前半段看完）
+    for (int visited = 0; visited <= elevator_count && budget > 0; ++visited) {
+        const Elevator* e = &elevators[S->rd_car];
+        for (; S->rd_slot < 2 * e->floors && budget > 0; ++S->rd_slot) {
+            int floor = S->rd_slot >> 1;
+            RequestType type = (S->rd_slot & 1) ? REQ_CALL_DOWN : REQ_CALL_UP;
+            if (!((type == REQ_CALL_UP) ? e->call_up[floor] : e->call_down[floor])) continue;
+            redispatch_call(S, elevators, elevator_count, S->rd_car, floor, type);
+            --budget;
+        }
+        if (budget == 0) break;  // 預算用完，下次從這裡接著找（這台看完了也等下次才換下一台）
+        S->rd_slot = 0;
+        S->rd_car = (S->rd_car + 1) % elevator_count;
+    }
+}
+
+/* ---------------------------
+   Plan optimiser
+   --------------------------- */
+
+/* 外呼 (floor, di) 可以交給最佳化改派：只有 car 一台掛著、服務中、還沒靠站、沒告訴乘客搭這台 */
+static int plan_movable(const SchedulerState* S, const Elevator elevators[], int floor, int di, int car)
+{
+    const CallAge* a = &S->call_age[floor][di];
+    const Elevator* e = &elevators[car];
+    if (!a->active || a->holders != (1u << car) || !e->in_service) return 0;
+    if (!(di ? e->call_down[floor] : e->call_up[floor])) return 0;
+    return !call_committed(e, floor) && count_tickets(S, car, floor, di) == 0;
+}
+
+/* 套用最佳化器對上一份快照的計畫：每一筆都還成立才整份套用，否則整份丟掉 */
+static void apply_plan(SchedulerState* S, Elevator elevators[], int elevator_count)
+{
+    PlanMove moves[PLAN_MAX_MOVES];
+    double gain = 0.0;
+    int n = plan_opt_take(S->opt, S->opt_slot, S->opt_seq, moves, PLAN_MAX_MOVES, &gain);
+    if (n <= 0) return;
+    for (int k = 0; k < n; ++k) {
+        const PlanMove* m = &moves[k];
+        if (m->floor < 0 || m->floor >= S->floors || m->from < 0 || m->from >= elevator_count || m->to < 0 ||
+            m->to >= elevator_count || m->to == m->from ||
+            !plan_movable(S, elevators, m->floor, (m->dir == DIR_UP) ? 0 : 1, m->from) ||
+            count_requests(&elevators[m->to]) >= MAX_REQUESTS || !car_available(&elevators[m->to], m->floor)) {
+            S->rd_stats.plans_dropped++;
+            return;
+        }
+    }
+
+    // 先全部加到新電梯，有一筆加不上就撤回已加的
+    for (int k = 0; k < n; ++k) {
+        RequestType type = (moves[k].dir == DIR_UP) ? REQ_CALL_UP : REQ_CALL_DOWN;
+        if (elevator_add_request_flag(&elevators[moves[k].to], moves[k].floor, type) == ELEV_OK) continue;
+        while (--k >= 0) {
+            type = (moves[k].dir == DIR_UP) ? REQ_CALL_UP : REQ_CALL_DOWN;
+            elevator_remove_request_flag(&elevators[moves[k].to], moves[k].floor, type);
+        }
+        S->rd_stats.plans_dropped++;
+        return;
+    }
+    for (int k = 0; k < n; ++k) {
+        const PlanMove* m = &moves[k];
+        RequestType type = (m->dir == DIR_UP) ? REQ_CALL_UP : REQ_CALL_DOWN;
+        int di = dir_index(type);
+        elevator_remove_request_flag(&elevators[m->from], m->floor, type);
+        move_holder(S, elevators, m->floor, type, m->from, m->to);
+        S->call_age[m->floor][di].planned = 1;
+        notify_subscribers(S, &S->call_age[m->floor][di], NOTICE_ASSIGNED, m->floor, di, elevators[m->to].id,
+                           eta_cache_car(S->eta, &elevators[m->to], m->floor, (Direction)m->dir));
+    }
+    S->rd_stats.planned += (unsigned long)n;
+    S->opt_next_s = S->now_s;  // 指派變了 => 這個 tick 就送新快照，舊快照的計畫作廢
+    CORE_LOG("[SCHED] B%d plan applied: %d calls moved (predicted -%.1f s total wait)\n", S->building, n, gain);
+}
+
+/* 每 SCHED_PLAN_POST_S 秒把目前的電梯與外呼送給最佳化器（不能改派的外呼標成 fixed） */
+static void post_plan_snapshot(SchedulerState* S, const Elevator elevators[], int elevator_count,
+                               const RequestQueue* pending)
+{
+    if (S->now_s < S->opt_next_s) return;
+    S->opt_next_s = S->now_s + SCHED_PLAN_POST_S;
+    if (elevator_count < 2 || S->tracked_count == 0) return;  // 沒有可改派的外呼
+
+    RolloutSnapshot snap;
+    snapshot_cars(S, elevators, elevator_count, &snap);
+    snapshot_calls(S, pending, &snap);
+    for (int i = 0; i < snap.call_count; ++i) {
+        RollCall* q = &snap.calls[i];
+        if (q->car >= 0 && !plan_movable(S, elevators, q->floor, (q->dir == DIR_UP) ? 0 : 1, q->car)) q->fixed = 1;
+    }
+    unsigned long seq = plan_opt_post(S->opt, S->opt_slot, &snap);
+    if (seq) S->opt_seq = seq;
+}
+
+/* 已指派的外呼等超過 SLO => 告警；ETA 最短的電梯明顯較快（超過遲滯門檻）且原車未鎖定時才改派 */
+static void escalate_overdue(SchedulerState* S, Elevator elevators[], int elevator_count)
+{
+    if (g_wait_slo_s <= 0.0) return;
+    for (int k = 0; k < S->tracked_count; ++k) {
+        int floor = S->tracked[k] >> 1;
+        int di = S->tracked[k] & 1;
+        CallAge* a = &S->call_age[floor][di];
+        double wait = S->now_s - a->since_s;
+        if (a->escalated || wait <= g_wait_slo_s) continue;
+        a->escalated = 1;
+
+        RequestType type = di ? REQ_CALL_DOWN : REQ_CALL_UP;
+        Direction dir = di ? DIR_DOWN : DIR_UP;
+        int holder = -1;
+        for (int i = 0; i < elevator_count && holder < 0; ++i) {
+            if (di ? elevators[i].call_down[floor] : elevators[i].call_up[floor]) holder = i;
+        }
+        if (holder < 0) continue;
+        // 已超過 SLO：只要有電梯比目前的更早到就改派（不套用改派門檻）
+        double eta = 0.0;
+        int best_idx = select_forced(S, floor, dir, elevators, elevator_count, &eta);
+        double holder_eta = eta_cache_car(S->eta, &elevators[holder], floor, dir);
+        if (best_idx >= 0 && best_idx != holder &&
+            !call_committed(&elevators[holder], floor) &&
+            (holder_eta < 0.0 || eta < holder_eta) &&
+            elevator_add_request_flag(&elevators[best_idx], floor, type) >= 0) {
+            elevator_remove_request_flag(&elevators[holder], floor, type);
+            move_holder(S, elevators, floor, type, holder, best_idx);
+            notify_subscribers(S, a, NOTICE_ASSIGNED, floor, di, elevators[best_idx].id, eta);
+            holder = best_idx;
+        }
+        notify_slo(S, floor, dir, elevators[holder].id, wait);
+    }
+}
+
+/* 依目前策略替外呼挑電梯，都不行就不管負載上限挑 ETA 最短的 */
+static int select_for_handoff(SchedulerState* S, int floor, RequestType type, Elevator elevators[], int elevator_count,
+                              double* out_eta)
+{
+    PendingRequest preq;
+    memset(&preq, 0, sizeof(preq));
+    preq.floor = floor;
+    preq.type = type;
+    preq.to_floor = -1;
+    double cost = 0.0;
+    int best_idx = (g_policy == SCHED_POLICY_ETA) ? select_by_eta(S, &preq, elevators, elevator_count, &cost)
+                                                  : select_greedy(S, &preq, elevators, elevator_count, &cost);
+    Direction dir = (type == REQ_CALL_UP) ? DIR_UP : DIR_DOWN;
+    if (best_idx < 0) best_idx = select_forced(S, floor, dir, elevators, elevator_count, &cost);
+    *out_eta = (best_idx >= 0) ? eta_cache_car(S->eta, &elevators[best_idx], floor, dir) : -1.0;
+    return best_idx;
+}
+
+/* 停用電梯：外呼立刻交給其他電梯（同一個 tick 內），沒有電梯能接的放回 pending 最前面 */
+int Scheduler_release_car(SchedulerState* S, Elevator elevators[], int elevator_count, int car,
+                          RequestQueue* pending, double now_s)
+{
+    if (!S || !elevators || car < 0 || car >= elevator_count) return 0;
+    Elevator* from = &elevators[car];
+    S->now_s = now_s;
+    int moved = 0;
+    for (int floor = 0; floor < from->floors; ++floor) {
+        for (int di = 0; di < 2; ++di) {
+            if (!(di ? from->call_down[floor] : from->call_up[floor])) continue;
+            RequestType type = di ? REQ_CALL_DOWN : REQ_CALL_UP;
+            CallAge* a = (floor < S->floors) ? &S->call_age[floor][di] : NULL;
+            int tracked = a && a->active;
+
+            double eta = -1.0;
+            int to = select_for_handoff(S, floor, type, elevators, elevator_count, &eta);
+            int rc = (to >= 0) ? elevator_add_request_flag(&elevators[to], floor, type) : ELEV_ERR_INVALID;
+            elevator_remove_request_flag(from, floor, type);
+            ++moved;
+
+            if (rc == ELEV_OK || rc == ELEV_DUPLICATE) {
+                if (tracked) {
+                    move_holder(S, elevators, floor, type, car, to);
+                    if (a->arriving_car == from->id) a->arriving_car = -1;
+                    notify_subscribers(S, a, NOTICE_ASSIGNED, floor, di, elevators[to].id, eta);
+                } else {
+                    track_call(S, floor, type, now_s, to);
+                    move_tickets(S, elevators, floor, di, car, to);
+                }
+                CORE_LOG("[SCHED] B%d E%d out of service: floor=%d %s -> E%d\n",
+                         S->building, from->id, floor, di ? "DOWN" : "UP", elevators[to].id);
+                continue;
+            }
+
+            // 沒有電梯能接 => 回 pending 最前面，等待時間從原本按下時算起，訂閱者之後重新收到 ASSIGNED
+            PendingRequest p;
+            p.floor = floor;
+            p.type = type;
+            p.to_floor = -1;
+            p.source_id = -1;
+            p.request_id = 0;
+            p.enqueue_s = tracked ? a->since_s : now_s;
+            if (tracked) {
+                a->holders &= ~(1u << car);
+                a->arriving_car = -1;
+            }
+            int subs = tracked ? a->sub_count : 0;
+            int n = 0;
+            do {
+                if (subs > 0) {
+                    p.source_id = a->subs[n].client_id;
+                    p.request_id = a->subs[n].request_id;
+                    p.to_floor = take_ticket(S, car, floor, di, p.request_id);
+                }
+                if (rq_push_front(pending, p) != 0) {
+                    CORE_LOG("[SCHED] B%d pending queue full, hall call %d dropped\n", S->building, floor);
+                    break;
+                }
+            } while (++n < subs);
+            if (tracked) a->sub_count = 0;
+            // 沒訂閱的乘客也帶著目的樓層放回去
+            for (int k = 0; k < S->ticket_count;) {
+                DestTicket* t = &S->tickets[k];
+                if (t->car != car || t->floor != floor || t->di != di) {
+                    ++k;
+                    continue;
+                }
+                p.source_id = t->client_id;
+                p.request_id = t->request_id;
+                p.to_floor = t->to_floor;
+                *t = S->tickets[--S->ticket_count];
+                if (rq_push_front(pending, p) != 0) {
+                    CORE_LOG("[SCHED] B%d pending queue full, destination %d -> %d dropped\n", S->building, floor,
+                             p.to_floor);
+                }
+            }
+            CORE_LOG("[SCHED] B%d E%d out of service: floor=%d %s requeued\n",
+                     S->building, from->id, floor, di ? "DOWN" : "UP");
+        }
+    }
+    return moved;
+}
+
+/* 空車、服務中、沒有任何請求 => 可以移去待命 */
+static int car_parkable(const Elevator* e) {
+    return e->in_service && e->task_state == TASK_IDLE && !elevator_has_stops(e);
+}
+
+/* 各台空車的待命樓層：尖峰時依交通型態，否則（開啟預測停靠時）取需求最高的前 N 層
+ * N = 服務中電梯數，回傳寫入 want 的樓層數 */
+static int home_floors(SchedulerState* S, const Elevator elevators[], int active, int* want)
+{
+    switch (g_traffic_params[S->mode].home) {
+        case HOME_ORIGIN:
+            for (int k = 0; k < active; ++k) want[k] = S->peak_floor;
+            return (S->peak_floor >= 0) ? active : 0;
+        case HOME_SPREAD:
+            // 每台負責一段，停在該段中間（樓層數取電梯的設定：預設狀態是以上限配置）
+            for (int k = 0; k < active; ++k) want[k] = (int)(((2 * k + 1) * (long)elevators[0].floors) / (2 * active));
+            return active;
+        default:
+            break;
+    }
+    if (!g_parking || !S->demand) return 0;
+    return demand_top_floors(S->demand, S->now_s, want, active);
+}
+
+/* 空車移往待命樓層：已有電梯停著 / 正前往的樓層跳過，其餘派最近的空車 */
+static void park_idle_cars(SchedulerState* S, Elevator elevators[], int elevator_count, RequestQueue* pending)
+{
+    if (S->now_s < S->park_next_s || !rq_empty(pending)) return;
+    if (g_traffic_params[S->mode].home == HOME_NONE && (!g_parking || !S->demand)) return;
+    S->park_next_s = S->now_s + PARK_INTERVAL_S;
+
+    int active = 0;
+    for (int i = 0; i < elevator_count; ++i) {
+        if (elevators[i].in_service) ++active;
+    }
+    int want[MAX_ELEVATORS];
+    int n = home_floors(S, elevators, active, want);
+    if (n == 0) return;
+
+    unsigned used = 0;  // 已負責某個待命樓層的電梯
+    int covered[MAX_ELEVATORS] = { 0 };
+    for (int k = 0; k < n; ++k) {
+        for (int i = 0; i < elevator_count; ++i) {
+            const Elevator* e = &elevators[i];
+            if ((used & (1u << i)) || !e->in_service || elevator_has_stops(e)) continue;
+            int at = e->parking ? e->target_floor : (e->task_state == TASK_IDLE ? e->current_floor : -1);
+            if (at == want[k]) {
+                used |= 1u << i;
+                covered[k] = 1;
+                break;
+            }
+        }
+    }
+    for (int k = 0; k < n; ++k) {
+        if (covered[k]) continue;
+        int best = -1;
+        int best_dist = INT_MAX;
+        for (int i = 0; i < elevator_count; ++i) {
+            const Elevator* e = &elevators[i];
+            if ((used & (1u << i)) || !car_parkable(e) || !Elevator_serves(e, want[k])) continue;
+            int dist = abs(e->current_floor - want[k]);
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = i;
+            }
+        }
+        if (best < 0) continue;
+        used |= 1u << best;
+        if (Elevator_park(&elevators[best], want[k]) == ELEV_OK) {
+            CORE_LOG("[SCHED] B%d park E%d: %d -> %d (%s)\n", S->building, elevators[best].id,
+                     elevators[best].current_floor, want[k], Scheduler_traffic_mode_name(S->mode));
+        }
+    }
+}
+
+/* 切換派車策略 */
+void Scheduler_set_policy(SchedulerPolicy policy)
+{
+    if (policy >= 0 && policy < SCHED_POLICY_COUNT) g_policy = policy;
+}
+
+SchedulerPolicy Scheduler_get_policy(void)
+{
+    return g_policy;
+}
+
+const char* Scheduler_policy_name(SchedulerPolicy policy)
+{
+    switch (policy) {
+        case SCHED_POLICY_GREEDY: return "greedy";
+        case SCHED_POLICY_ETA:    return "eta";
+        case SCHED_POLICY_ROLLOUT: return "rollout";
+        default:                  return "unknown";
+    }
+}
+
+void Scheduler_set_rollout(double horizon_s, int workers)
+{
+    if (horizon_s > 0.0) g_rollout_horizon_s = horizon_s;
+    if (workers > 0 && rollout_set_workers(workers) != 0) {
+        CORE_LOG("[SCHED] rollout workers unavailable, rollouts run on the core thread\n");
+    }
+}
+
+/* 預測停靠開關 */
+void Scheduler_set_parking(int enabled)
+{
+    g_parking = enabled ? 1 : 0;
+}
+
+void Scheduler_set_demand(SchedulerState* S, DemandModel* demand)
+{
+    if (S) S->demand = demand;
+}
+
+/* 背景最佳化 */
+void Scheduler_set_optimizer(SchedulerState* S, PlanOptimizer* opt, int slot)
+{
+    if (!S) return;
+    S->opt = opt;
+    S->opt_slot = slot;
+    S->opt_seq = 0;
+    S->opt_next_s = 0.0;
+}
+
+/* 交通型態判斷開關與查詢 */
+void Scheduler_set_traffic_modes(int enabled)
+{
+    g_traffic_modes = enabled ? 1 : 0;
+}
+
+TrafficMode Scheduler_traffic_mode(const SchedulerState* S)
+{
+    return S ? S->mode : TRAFFIC_MODE_BALANCED;
+}
+
+const char* Scheduler_traffic_mode_name(TrafficMode mode)
+{
+    switch (mode) {
+        case TRAFFIC_MODE_BALANCED:  return "balanced";
+        case TRAFFIC_MODE_UP_PEAK:   return "up-peak";
+        case TRAFFIC_MODE_DOWN_PEAK: return "down-peak";
+        default:                return "unknown";
+    }
+}
+
+/* 重新派車設定與統計 */
+void Scheduler_set_redispatch(int budget_per_tick, double hysteresis_s)
+{
+    g_redispatch_budget = (budget_per_tick > 0) ? budget_per_tick : 0;
+    if (hysteresis_s >= 0.0) g_redispatch_hysteresis_s = hysteresis_s;
+}
+
+void Scheduler_get_redispatch_stats(SchedulerRedispatchStats* out)
+{
+    Scheduler_get_state_stats(default_state(), out, NULL);
+}
+
+void Scheduler_reset(void)
+{
+    Scheduler_reset_state(default_state());
+}
+
+/* 外呼等待 SLO 設定與統計 */
+void Scheduler_set_wait_slo(double seconds)
+{
+    g_wait_slo_s = (seconds > 0.0) ? seconds : 0.0;
+}
+
+void Scheduler_get_slo_stats(SchedulerSloStats* out)
+{
+    Scheduler_get_state_stats(default_state(), NULL, out);
+}
+
+/* 依樓層數在同一塊記憶體中排出排程狀態（base = NULL 只計算大小） */
+static size_t state_layout(BuildingArena* a, SchedulerState** out, int floors)
+{
+    SchedulerState* S = (SchedulerState*)building_arena_take(a, sizeof(SchedulerState));
+    CallAge (*ages)[2] = (CallAge (*)[2])building_arena_take(a, sizeof(CallAge) * 2 * (size_t)floors);
+    short* tracked = (short*)building_arena_take(a, sizeof(short) * 2 * (size_t)floors);
+    unsigned short (*traffic)[2] =
+        (unsigned short (*)[2])building_arena_take(a, sizeof(unsigned short) * 2 * TRAFFIC_SLOTS * (size_t)floors);
+    DestTicket* tickets = (DestTicket*)building_arena_take(a, sizeof(DestTicket) * DEST_TICKETS_PER_FLOOR * (size_t)floors);
+    if (S) {
+        memset(S, 0, sizeof(*S));
+        memset(ages, 0, sizeof(CallAge) * 2 * (size_t)floors);
+        S->floors = floors;
+        S->call_age = ages;
+        S->tracked = tracked;
+        S->traffic_count = traffic;
+        S->traffic_slot = -1;
+        memset(traffic, 0, sizeof(unsigned short) * 2 * TRAFFIC_SLOTS * (size_t)floors);
+        S->tickets = tickets;
+        S->ticket_cap = DEST_TICKETS_PER_FLOOR * floors;
+    }
+    if (out) *out = S;
+    return a->used;
+}
+
+size_t Scheduler_state_size(int floors)
+{
+    BuildingArena a = { NULL, 0 };
+    return state_layout(&a, NULL, floors);
+}
+
+/* 每棟大樓各自的排程狀態 */
+SchedulerState* Scheduler_init_at(void* mem, EtaCache* eta, int building, int floors)
+{
+    if (!mem || floors < 1 || floors > MAX_FLOORS) return NULL;
+    BuildingArena a = { (unsigned char*)mem, 0 };
+    SchedulerState* S = NULL;
+    state_layout(&a, &S, floors);
+    S->eta = eta;
+    S->building = building;
+    return S;
+}
+
+SchedulerState* Scheduler_create(EtaCache* eta, int building, int floors)
+{
+    if (floors < 1 || floors > MAX_FLOORS) return NULL;
+    void* mem = malloc(Scheduler_state_size(floors));
+    return mem ? Scheduler_init_at(mem, eta, building, floors) : NULL;
+}
+
+SchedulerState* Scheduler_default_state(void)
+{
+    return default_state();
+}
+
+void Scheduler_set_default_state(SchedulerState* S)
+{
+    g_default = S;
+}
+
+void Scheduler_destroy(SchedulerState* S)
+{
+    if (S != g_fallback && S != g_default) free(S);
+}
+
+void Scheduler_reset_state(SchedulerState* S)
+{
+    if (!S) return;
+    S->rd_car = 0;
+    S->rd_slot = 0;
+    S->rd_stats.evaluated = 0;
+    S->rd_stats.moved = 0;
+    S->rd_stats.saved_s = 0.0;
+    S->rd_stats.planned = 0;
+    S->rd_stats.plans_dropped = 0;
+    S->opt_seq = 0;
+    S->opt_next_s = 0.0;
+    for (int f = 0; f < S->floors; ++f) {
+        S->call_age[f][0].active = 0;
+        S->call_age[f][1].active = 0;
+    }
+    S->tracked_count = 0;
+    S->now_s = 0.0;
+    S->slo_stats.escalated = 0;
+    S->slo_stats.max_wait_s = 0.0;
+    S->park_next_s = 0.0;
+    S->mode = TRAFFIC_MODE_BALANCED;
+    S->mode_since_s = 0.0;
+    S->peak_floor = -1;
+    S->traffic_slot = -1;
+    memset(S->traffic_count, 0, sizeof(unsigned short) * 2 * TRAFFIC_SLOTS * (size_t)S->floors);
+    S->ticket_count = 0;
+}
+
+void Scheduler_get_state_stats(const SchedulerState* S, SchedulerRedispatchStats* rd, SchedulerSloStats* slo)
+{
+    if (!S) return;
+    if (rd) *rd = S->rd_stats;
+    if (!slo) return;
+    *slo = S->slo_stats;
+    // 還沒服務的外呼也算進最長等待
+    for (int k = 0; k < S->tracked_count; ++k) {
+        double wait = S->now_s - S->call_age[S->tracked[k] >> 1][S->tracked[k] & 1].since_s;
+        if (wait > slo->max_wait_s) slo->max_wait_s = wait;
+    }
+}
+
+/* ---------------------------
+   Checkpoint section
+   --------------------------- */
+
+#define SCHED_STATE_VERSION 2  // v2: 目的樓層票（上車樓層 => 電梯的分組）
+#define SCHED_CALL_FIXED 24  // slot | f64 since_s | flags | arriving_car | sub_count（之後每位訂閱者 8 bytes）
+#define SCHED_TICKET_SIZE 20 // floor | to_floor | di | car | client_id | request_id（前四項各 u16 / u8）
+#define SCHED_CALL_ESCALATED 0x1u
+#define SCHED_CALL_PLANNED 0x2u
+
+static void put_le32(unsigned char* p, uint32_t v)
+{
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_le32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le_f64(unsigned char* p, double d)
+{
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static double get_le_f64(const unsigned char* p)
+{
+    uint64_t v = (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+/* 追蹤中的外呼（最早按下時間、升級、訂閱者）與目的樓層票寫進存檔；外呼掛在哪台電梯由電梯旗標決定，不另外存 */
+int Scheduler_encode_state(const SchedulerState* S, unsigned char* out, int cap)
+{
+    if (!S || !out || cap < 8) return -1;
+    unsigned char* p = out;
+    put_le32(p, SCHED_STATE_VERSION);
+    put_le32(p + 4, (uint32_t)S->tracked_count);
+    p += 8;
+    for (int k = 0; k < S->tracked_count; ++k) {
+        const CallAge* a = &S->call_age[S->tracked[k] >> 1][S->tracked[k] & 1];
+        if ((p - out) + SCHED_CALL_FIXED + 8 * a->sub_count > cap) return -1;
+        put_le32(p, (uint32_t)S->tracked[k]);
+        put_le_f64(p + 4, a->since_s);
+        put_le32(p + 12, (a->escalated ? SCHED_CALL_ESCALATED : 0u) | (a->planned ? SCHED_CALL_PLANNED : 0u));
+        put_le32(p + 16, (uint32_t)a->arriving_car);
+        put_le32(p + 20, (uint32_t)a->sub_count);
+        p += SCHED_CALL_FIXED;
+        for (int s = 0; s < a->sub_count; ++s, p += 8) {
+            put_le32(p, (uint32_t)a->subs[s].client_id);
+            put_le32(p + 4, a->subs[s].request_id);
+        }
+    }
+
+    if ((p - out) + 4 + SCHED_TICKET_SIZE * S->ticket_count > cap) return -1;
+    put_le32(p, (uint32_t)S->ticket_count);
+    p += 4;
+    for (int k = 0; k < S->ticket_count; ++k, p += SCHED_TICKET_SIZE) {
+        const DestTicket* t = &S->tickets[k];
+        put_le32(p, (uint32_t)(unsigned short)t->floor | ((uint32_t)(unsigned short)t->to_floor << 16));
+        put_le32(p + 4, (uint32_t)t->di);
+        put_le32(p + 8, (uint32_t)t->car);
+        put_le32(p + 12, (uint32_t)t->client_id);
+        put_le32(p + 16, t->request_id);
+    }
+    return (int)(p - out);
+}
+
+/* 還原追蹤中的外呼；電梯已先還原，沒有電梯掛著的外呼（存檔後已服務）略過 */
+int Scheduler_decode_state(SchedulerState* S, const unsigned char* in, int len,
+                           const Elevator elevators[], int elevator_count)
+{
+    if (!S || !in || len < 8) return -1;
+    uint32_t version = get_le32(in);
+    if (version < 1 || version > SCHED_STATE_VERSION) return -1;
+    int n = (int)get_le32(in + 4);
+    if (n < 0 || n > 2 * S->floors) return -1;
+    const unsigned char* p = in + 8;
+    for (int k = 0; k < n; ++k) {
+        if ((p - in) + SCHED_CALL_FIXED > len) return -1;
+        int slot = (int)get_le32(p);
+        int subs = (int)get_le32(p + 20);
+        if (slot < 0 || slot >= 2 * S->floors || subs < 0 || subs > CALL_SUBSCRIBERS_MAX ||
+            (p - in) + SCHED_CALL_FIXED + 8 * subs > len) return -1;
+        int floor = slot >> 1;
+        int di = slot & 1;
+        unsigned holders = call_holders(elevators, elevator_count, floor, di);
+        CallAge* a = &S->call_age[floor][di];
+        if (holders && !a->active) {
+            a->active = 1;
+            a->since_s = get_le_f64(p + 4);
+            a->escalated = (get_le32(p + 12) & SCHED_CALL_ESCALATED) != 0;
+            a->planned = (get_le32(p + 12) & SCHED_CALL_PLANNED) != 0;
+            a->holders = holders;
+            a->arriving_car = (int)get_le32(p + 16);
+            a->sub_count = subs;
+            for (int s = 0; s < subs; ++s) {
+                a->subs[s].client_id = (int)get_le32(p + SCHED_CALL_FIXED + 8 * s);
+                a->subs[s].request_id = get_le32(p + SCHED_CALL_FIXED + 8 * s + 4);
+            }
+            S->tracked[S->tracked_count++] = (short)slot;
+        }
+        p += SCHED_CALL_FIXED + 8 * subs;
+    }
+    if (version < 2) return 0;  // v1 沒有目的樓層票
+
+    // 票只在負責的電梯還掛著那筆外呼時還原（已開門服務的乘客早已轉成內呼）
+    if ((p - in) + 4 > len) return -1;
+    int tn = (int)get_le32(p);
+    p += 4;
+    if (tn < 0 || tn > S->ticket_cap || (p - in) + (long)tn * SCHED_TICKET_SIZE > len) return -1;
+    for (int k = 0; k < tn; ++k, p += SCHED_TICKET_SIZE) {
+        int floor = (int)(get_le32(p) & 0xFFFFu);
+        int to_floor = (int)(get_le32(p) >> 16);
+        int di = (int)get_le32(p + 4);
+        int car = (int)get_le32(p + 8);
+        if (floor >= S->floors || to_floor >= S->floors || di < 0 || di > 1) return -1;
+        if (car < 0 || car >= elevator_count || !(call_holders(elevators, elevator_count, floor, di) & (1u << car))) {
+            continue;
+        }
+        DestTicket* t = &S->tickets[S->ticket_count++];
+        t->floor = (short)floor;
+        t->to_floor = (short)to_floor;
+        t->di = (unsigned char)di;
+        t->car = (unsigned char)car;
+        t->client_id = (int)get_le32(p + 12);
+        t->request_id = get_le32(p + 16);
+    }
+    return 0;
+}
+
+/* 對外（基準測試）用的包裝 */
+double Scheduler_estimate_cost(const Elevator* e, int pickup_floor)
+{
+    return estimate_cost(&g_traffic_params[TRAFFIC_MODE_BALANCED], e, pickup_floor);
+}
+
+int Scheduler_assign_one(RequestQueue* pending, Elevator elevators[], int elevator_count)
+{
+    return try_assign_one(default_state(), pending, elevators, elevator_count);
+}
+
 /* 電梯排程器 */
-void Scheduler_Process(Elevator elevators[], int elevator_count, RequestQueue* pending)
+void Scheduler_Process(Elevator elevators[], int elevator_count, RequestQueue* pending, double now_s)
 {
-    if (!pending || !elevators) return;
+    Scheduler_Process_state(default_state(), elevators, elevator_count, pending, now_s);
+}
+
+void Scheduler_Process_state(SchedulerState* S, Elevator elevators[], int elevator_count,
+                             RequestQueue* pending, double now_s)
+{
+    if (!S || !pending || !elevators) return;
+    S->now_s = now_s;
+    refresh_call_ages(S, elevators, elevator_count);
+    update_traffic_mode(S);
 
-    const int MAX_ASSIGN_PER_TICK = 8;
-    for (int i = 0; i < MAX_ASSIGN_PER_TICK; ++i) {
-        int ok = try_assign_one(pending, elevators, elevator_count);
-        if (!ok) break;
+    assign_pending(S, pending, elevators, elevator_count);
+
+    // 等太久的外呼先強制處理，其餘有更快的電梯就改派
+    escalate_overdue(S, elevators, elevator_count);
+    redispatch_assigned(S, elevators, elevator_count);
+
+    // 背景最佳化：套用它對上一份快照的計畫，定期送新快照
+    if (S->opt) {
+        apply_plan(S, elevators, elevator_count);
+        post_plan_snapshot(S, elevators, elevator_count, pending);
+        plan_opt_run(S->opt, S->opt_slot);  // 沒有背景執行緒時在這裡搜尋
     }
+
+    // 沒事做的電梯先移到待命樓層（尖峰時依交通型態，否則依預估需求）
+    park_idle_cars(S, elevators, elevator_count, pending);
 }
@@ -3,21 +3,212 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "demand.h"
 #include "elevator.h"
+#include "eta.h"
+#include "plan_opt.h"
 #include "request_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void Scheduler_Process(Elevator elevators[], int elevator_count, RequestQueue* pending);
+/* 派車策略 */
+typedef enum {
+    SCHED_POLICY_GREEDY = 0,   // 最近閒置電梯，否則距離 + 方向 + 負載成本
+    SCHED_POLICY_ETA,          // 預估到達時間最短的電梯（eta.h）
+    SCHED_POLICY_ROLLOUT,      // 每台候選電梯往前模擬一段時間，預估總等待最短的（rollout.h）
+    SCHED_POLICY_COUNT
+} SchedulerPolicy;
+
+/* 交通型態（依近期外呼統計自動判斷） */
+typedef enum {
+    TRAFFIC_MODE_BALANCED = 0,      // 一般 / 混合
+    TRAFFIC_MODE_UP_PEAK,           // 上班：外呼集中在同一層且幾乎都往上
+    TRAFFIC_MODE_DOWN_PEAK,         // 下班：外呼分散在各層且幾乎都往下
+    TRAFFIC_MODE_COUNT
+} TrafficMode;
+
+/* Re-dispatch defaults: hall calls re-evaluated per tick, and how much
+ * earlier (seconds of ETA) another car must be to take a call over. */
+#define SCHED_REDISPATCH_DEFAULT_BUDGET 2
+#define SCHED_REDISPATCH_DEFAULT_HYSTERESIS_S 5.0
+
+/* Default wait SLO: a hall call unserved this long (seconds since it was
+ * first pressed) is escalated. */
+#define SCHED_DEFAULT_WAIT_SLO_S 60.0
+
+typedef struct {
+    unsigned long evaluated;  // assigned hall calls looked at
+    unsigned long moved;      // calls handed to another car
+    double saved_s;           // sum of projected wait removed by the moves
+    unsigned long planned;    // calls moved by optimiser plans
+    unsigned long plans_dropped;  // plans that no longer fit when taken
+} SchedulerRedispatchStats;
+
+typedef struct {
+    unsigned long escalated;  // hall calls that exceeded the wait SLO
+    double max_wait_s;        // longest hall-call wait seen (served or not)
+} SchedulerSloStats;
+
+/* Per-building scheduler state (re-dispatch cursor, hall-call ages and
+ * subscribers, statistics). Policy, re-dispatch budget / hysteresis and the
+ * wait SLO are process-wide settings shared by every building. The plain
+ * Scheduler_* functions below operate on the default state (see
+ * Scheduler_set_default_state); a campus creates one state per building.
+ */
+typedef struct SchedulerState SchedulerState;
+
+/* One scheduling pass at virtual time now_s (seconds, same clock as
+ * PendingRequest.enqueue_s):
+ * 1. Assign pending requests oldest first, up to 8 per pass. A request that
+ *    cannot be placed is set aside and the scan moves on to younger ones
+ *    (at most 32 looked at per pass), so one call no car can take now does
+ *    not hold up the rest; the skipped requests go back to the head of the
+ *    queue in their order and keep their place.
+ * 2. Escalate hall calls that have waited longer than the wait SLO since
+ *    they were first pressed: a NOTICE_WAIT_SLO is queued for the guards
+ *    (core_notify.h), and the call moves to the earliest-ETA car whenever
+ *    that car is strictly earlier than the holder (no hysteresis) and the
+ *    holder is not already stopping for it. A new call no car accepts is
+ *    forced onto the earliest-ETA car (ignoring the load limit) once overdue.
+ * 3. Re-evaluate up to the re-dispatch budget of already assigned, not yet
+ *    served hall calls (round robin over all cars). A call moves to the car
+ *    with the earliest ETA if that beats the current car's ETA by more than
+ *    the hysteresis; calls the car is already stopping for are left alone.
+ * 4. With an optimiser attached (Scheduler_set_optimizer), apply its plan
+ *    for the last posted snapshot if every move still holds, and post a
+ *    fresh snapshot every SCHED_PLAN_POST_S seconds.
+ * 5. With nothing pending, every few seconds send idle cars without stops
+ *    to their waiting floors: the traffic mode's home floors during a peak,
+ *    otherwise (parking enabled) the floors the state's demand model
+ *    predicts to call next (busiest floors, one car each, nearest idle car).
+ */
+void Scheduler_Process(Elevator elevators[], int elevator_count, RequestQueue* pending, double now_s);
+
+/* Per-building variants. Scheduler_create returns NULL on allocation
+ * failure; `eta` is the building's cache and must outlive the state.
+ * Different states may be processed concurrently on different threads.
+ * Scheduler_init_at lays a state for `floors` floors out in caller-owned
+ * memory of Scheduler_state_size() bytes (16-byte aligned, e.g. a building
+ * arena); such a state is released with its memory, not Scheduler_destroy.
+ * Cars only get hall calls on floors they serve and while in service; a
+ * call no car serves (in service or not) is dropped.
+ */
+SchedulerState* Scheduler_create(EtaCache* eta, int building, int floors);
+size_t Scheduler_state_size(int floors);
+SchedulerState* Scheduler_init_at(void* mem, EtaCache* eta, int building, int floors);
+void Scheduler_destroy(SchedulerState* s);         // default state is ignored
+SchedulerState* Scheduler_default_state(void);     // the state behind Scheduler_Process
+/* Bind `s` as the default state (the server core binds building 0's); NULL
+ * goes back to a built-in state for MAX_FLOORS floors, allocated on first use.
+ */
+void Scheduler_set_default_state(SchedulerState* s);
+void Scheduler_reset_state(SchedulerState* s);
+void Scheduler_Process_state(SchedulerState* s, Elevator elevators[], int elevator_count,
+                             RequestQueue* pending, double now_s);
+void Scheduler_get_state_stats(const SchedulerState* s, SchedulerRedispatchStats* rd, SchedulerSloStats* slo);
+
+/* Hand every hall call of car `car` (already marked out of service) to the
+ * car the current policy picks, ignoring the per-car load limit if needed;
+ * subscribers get a fresh ASSIGNED. Calls no car can take go back to the
+ * front of `pending` with their original press time. Car calls stay on the
+ * car. Returns the number of hall calls taken off the car.
+ */
+int Scheduler_release_car(SchedulerState* s, Elevator elevators[], int elevator_count, int car,
+                          RequestQueue* pending, double now_s);
+
+/* The part of a state that checkpoints and hot upgrades must carry besides
+ * the cars and the pending queue: the hall calls being tracked, with their
+ * first press time, escalation and lifecycle subscribers (request ids), and
+ * the destination tickets (which car each rider waiting on a floor was told
+ * to take, and where the rider goes). Tickets whose car no longer holds the
+ * call are skipped on decode.
+ * Scheduler_encode_state returns the length or -1 if cap is too small;
+ * SCHED_STATE_MAX_BYTES is always enough. Scheduler_decode_state expects a
+ * freshly reset state whose cars are restored already; calls no car holds
+ * any more are skipped. Returns 0 or -1 on a malformed section.
+ */
+#define SCHED_CALL_SUBSCRIBERS_MAX 8
+#define SCHED_DEST_TICKETS_PER_FLOOR 8
+#define SCHED_STATE_MAX_BYTES \
+    (8 + 2 * MAX_FLOORS * (24 + 8 * SCHED_CALL_SUBSCRIBERS_MAX) + 4 + SCHED_DEST_TICKETS_PER_FLOOR * MAX_FLOORS * 20)
+int Scheduler_encode_state(const SchedulerState* s, unsigned char* out, int cap);
+int Scheduler_decode_state(SchedulerState* s, const unsigned char* in, int len,
+                           const Elevator elevators[], int elevator_count);
+
+/* Predictive parking of idle cars (off by default). The demand model is the
+ * building's arrival-rate estimator; a state without one never parks. */
+void Scheduler_set_parking(int enabled);
+void Scheduler_set_demand(SchedulerState* s, DemandModel* demand);
+
+/* Traffic-mode detection (on by default). Every building classifies its
+ * recent hall calls (sliding window of SCHED_TRAFFIC_WINDOW_S) by direction
+ * skew and origin concentration into balanced / up-peak / down-peak, with
+ * separate enter and leave thresholds and a minimum time in a mode. The
+ * mode selects the cost weights of the greedy policy and where idle cars
+ * wait: at the peak origin floor in up-peak, spread over the building in
+ * down-peak (this homing replaces predictive parking while a peak lasts).
+ * Disabled, every building stays balanced.
+ */
+#define SCHED_TRAFFIC_WINDOW_S 180.0
+void Scheduler_set_traffic_modes(int enabled);
+TrafficMode Scheduler_traffic_mode(const SchedulerState* s);
+const char* Scheduler_traffic_mode_name(TrafficMode mode);
+
+/* Select the dispatch policy used by Scheduler_Process (before the core starts). */
+void Scheduler_set_policy(SchedulerPolicy policy);
+SchedulerPolicy Scheduler_get_policy(void);
+const char* Scheduler_policy_name(SchedulerPolicy policy);
+
+/* Rollout policy settings: lookahead horizon in seconds (<= 0 keeps the
+ * current value, default ROLLOUT_DEFAULT_HORIZON_S) and threads for the
+ * rollouts of one decision, including the caller (<= 0 keeps the current
+ * value, 1 = core thread only). Predicted arrivals come from the traffic-mode
+ * window, so they are only used while traffic modes are enabled. Set before
+ * the core starts.
+ */
+void Scheduler_set_rollout(double horizon_s, int workers);
+
+/* Background plan optimiser (plan_opt.h) for one building; opt = NULL
+ * detaches it. The state posts a snapshot of its cars and calls into slot
+ * `slot` every SCHED_PLAN_POST_S seconds (and right after a plan was
+ * applied) and takes plans for the last snapshot between ticks. A plan is
+ * applied whole or not at all: every moved call must still be held by its
+ * old car alone, not yet committed to (the car is not stopping there and no
+ * destination passenger was told to take it) and the new car must be able
+ * to take it. Calls moved by a plan are left out of ETA re-dispatch.
+ */
+#define SCHED_PLAN_POST_S 1.0
+void Scheduler_set_optimizer(SchedulerState* s, PlanOptimizer* opt, int slot);
+
+/* Re-dispatch budget (calls per tick, 0 disables) and hysteresis in seconds
+ * (< 0 keeps the current value). Set before the core starts.
+ */
+void Scheduler_set_redispatch(int budget_per_tick, double hysteresis_s);
+void Scheduler_get_redispatch_stats(SchedulerRedispatchStats* out);
+
+/* Wait SLO in seconds (<= 0 disables escalation). Set before the core starts. */
+void Scheduler_set_wait_slo(double seconds);
+void Scheduler_get_slo_stats(SchedulerSloStats* out);
+
+/* Clear the re-dispatch cursor, hall-call ages and statistics (on core init). */
+void Scheduler_reset(void);
+
+/* Building blocks of Scheduler_Process, exposed for benchmarks.
+ * Scheduler_estimate_cost: cost of sending car `e` to `pickup_floor`.
+ * Scheduler_assign_one: pop one pending request and hand it to a car;
+ *   returns 1 if assigned, 0 if the queue was empty or the request was put back.
+ */
+double Scheduler_estimate_cost(const Elevator* e, int pickup_floor);
+int Scheduler_assign_one(RequestQueue* pending, Elevator elevators[], int elevator_count);
 
 #ifdef __cplusplus
 }
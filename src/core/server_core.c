@@ -3,31 +3,98 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #include "server_core.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "building.h"
+#include "checkpoint.h"
+#include "core_log.h"
+#include "core_notify.h"
+#include "core_pool.h"
+#include "demand.h"
+#include "eta.h"
+#include "event_journal.h"
 #include "scheduler.h"
-#include "server_events.h"
+#include "status.h"
+#include "status_shm.h"
 
 /* Config */
 #define DEFAULT_ELEVATOR_COUNT 2
 #define TICK_DT_SECONDS 0.1
 #define BUF_SZ 4096
+#define CHECKPOINT_DEFAULT_EVERY_TICKS 10  /* 預設每 1 秒存檔一次 */
+#define REPLAY_DRAIN_MAX_TICKS 36000  /* 重播結束後最多再跑 1 小時虛擬時間讓電梯跑完 */
+#define LANE_BUDGET_CAR  256  /* 每 tick 最多處理的內呼事件數 */
+#define LANE_BUDGET_HALL 256  /* 每 tick 最多處理的外呼事件數 */
+
+/* 一棟大樓的完整核心狀態 */
+// 各表依大樓描述的電梯井數（max_cars）/ 樓層數排在同一塊 arena（見 core_layout）
+// 執行中加入電梯只是啟用下一個預留的位置，網路執行緒拿到的指標不會失效
+struct ServerCore {
+    int building;  // 大樓 ID（0 = 預設大樓）
+    BuildingDesc desc;
+    void* arena;
+    Elevator* elevators;  // desc.max_cars 個位置
+    int elevator_count;   // 目前使用中的電梯數（前 elevator_count 個）
+    RequestQueue pending;
+    uint32_t tick;  /* 核心 tick 計數（虛擬時間 = tick * TICK_DT_SECONDS） */
+
+    ServerEventQueue* events;  // 網路執行緒推入的事件
+    EtaCache* eta;
+    SchedulerState* sched;
+    DemandModel* demand;       // 各樓層外呼到達率（預測停靠用）
+    char* demand_path;         // 到達率存檔（可選，只有單一大樓時可用）
+
+    /* 事件日誌與軌跡輸出（皆可選，只有單一大樓時可用） */
+    EventJournal* journal;
+    FILE* traj_fp;
+    int (*traj_last)[3];
+
+    /* 同主機顯示器用的共享記憶體狀態（可選） */
+    StatusShm* status_shm;
+
+    /* 週期性狀態存檔（可選） */
+    CheckpointFile* checkpoint;
+    int checkpoint_every;
+
+    /* 各電梯 ETA 表的副本（快取重算時才複製，網路執行緒查詢用） */
+    PlatformMutex* eta_lock;
+    float* eta_pub;                              // [(car * 2 + 0 = UP / 1 = DOWN) * floors + floor]
+    double* eta_pub_at;                          // 該表計算當下的 ETA 時鐘（< 0 = 尚無資料）
+    unsigned long* eta_pub_serial;               // 已複製的快取重算序號
+    double eta_pub_now;                          // 最近一次發布時的 ETA 時鐘
+    int eta_pub_count;
+};
+
+/* 大樓 0 使用預設的事件佇列、ETA 快取與排程狀態，舊的單一大樓介面都作用在它上面 */
+static ServerCore g_core = { .elevator_count = DEFAULT_ELEVATOR_COUNT,
+                             .checkpoint_every = CHECKPOINT_DEFAULT_EVERY_TICKS };
+
+/* 園區：所有大樓（[0] 永遠是 &g_core） */
+static ServerCore* g_buildings[MAX_BUILDINGS] = { &g_core };
+static int g_building_count = 1;
+
+/* 多棟大樓時每個 tick 由工作池平行執行 */
+static CorePool* g_pool = NULL;
+static int g_workers = 0;  // 0 = 依 CPU 數
+
+/* 背景最佳化（每棟大樓一個位置） */
+static PlanOptimizer* g_opt = NULL;
+static int g_opt_iterations = -1;  // < 0 = 不用，0 = 背景執行緒，> 0 = 每 tick 在核心執行緒搜尋幾步
 
-/* Globals internal to server_core */
-static Elevator g_elevators[MAX_ELEVATORS];
-static int g_elevator_count = DEFAULT_ELEVATOR_COUNT;
-static RequestQueue g_pending_requests;
 static int g_running = 0;
 
 /* Core thread handle */
 static PlatformThread* g_core_thread = NULL;
+static int g_state_imported = 0;  // 狀態由熱升級接手（比存檔新）
+static int g_handed_off = 0;      // 狀態已交給新行程，停止時不再寫任何檔案
 
 static server_core_status_cb_t g_status_cb = NULL;
 /* 電梯狀態輸出的輸出介面 */
@@ -36,101 +103,389 @@ void server_core_set_status_callback(server_core_status_cb_t cb) {
     g_status_cb = cb;
 }
 
+/* 依大樓描述排出各表（base = NULL 只計算大小）
+ * 電梯的旗標與路線、ETA 快取、排程狀態都依樓層數放在同一塊 arena；
+ * 大樓 0 的快取與排程狀態同時綁成舊介面的預設值 */
+static size_t core_layout(ServerCore* c, unsigned char* base)
+{
+    const int cars = c->desc.max_cars;
+    const int floors = c->desc.floors;
+    BuildingArena a = { base, 0 };
+    c->elevators = (Elevator*)building_arena_take(&a, sizeof(Elevator) * (size_t)cars);
+    const size_t car_bytes = Elevator_storage_size(floors);
+    unsigned char* car_mem = (unsigned char*)building_arena_take(&a, car_bytes * (size_t)cars);
+    if (base) {
+        for (int i = 0; i < cars; ++i) Elevator_attach(&c->elevators[i], car_mem + car_bytes * (size_t)i, floors);
+    }
+    c->traj_last = (int (*)[3])building_arena_take(&a, sizeof(int[3]) * (size_t)cars);
+    c->eta_pub = (float*)building_arena_take(&a, sizeof(float) * 2 * (size_t)cars * (size_t)floors);
+    c->eta_pub_at = (double*)building_arena_take(&a, sizeof(double) * (size_t)cars);
+    c->eta_pub_serial = (unsigned long*)building_arena_take(&a, sizeof(unsigned long) * (size_t)cars);
+    void* demand_mem = building_arena_take(&a, demand_size(floors));
+    if (base) c->demand = demand_init_at(demand_mem, floors);
+    void* eta_mem = building_arena_take(&a, eta_cache_size(cars, floors));
+    void* sched_mem = building_arena_take(&a, Scheduler_state_size(floors));
+    if (base) {
+        c->eta = eta_cache_init_at(eta_mem, cars, floors);
+        c->sched = Scheduler_init_at(sched_mem, c->eta, c->building, floors);
+        Scheduler_set_demand(c->sched, c->demand);
+        if (c == &g_core) {
+            eta_set_default_cache(c->eta);
+            Scheduler_set_default_state(c->sched);
+        }
+    }
+    return a.used;
+}
+
+/* 配置（或重新配置）一棟大樓的 arena */
+static int core_alloc(ServerCore* c, const BuildingDesc* desc)
+{
+    if (c == &g_core) {
+        // 舊的 arena 要釋放了，先解除預設值的綁定
+        eta_set_default_cache(NULL);
+        Scheduler_set_default_state(NULL);
+    }
+    free(c->arena);
+    c->arena = NULL;
+    c->desc = *desc;
+    size_t bytes = core_layout(c, NULL);
+    c->arena = calloc(1, bytes);
+    if (!c->arena) return -1;
+    core_layout(c, (unsigned char*)c->arena);
+    return 0;
+}
+
+/* 重設一棟大樓的狀態 */
+static void core_reset(ServerCore* c)
+{
+    c->elevator_count = c->desc.cars;
+
+    // init pending queue
+    rq_init(&c->pending);
+    c->tick = 0;
+
+    // ETA 快取與查詢表
+    eta_cache_reset(c->eta);
+    Scheduler_reset_state(c->sched);
+    demand_reset(c->demand);
+    if (!c->eta_lock) c->eta_lock = platform_mutex_create();
+    for (int i = 0; i < c->elevator_count; ++i) c->eta_pub_at[i] = -1.0;
+    c->eta_pub_count = 0;
+
+    // init elevators
+    for (int i = 0; i < c->elevator_count; ++i) {
+        building_configure_car(&c->desc, i, &c->elevators[i]);
+    }
+}
+
+/* 建立另一棟大樓（大樓 0 以外） */
+static ServerCore* core_create(int building, const BuildingDesc* desc)
+{
+    ServerCore* c = (ServerCore*)calloc(1, sizeof(ServerCore));
+    if (!c) return NULL;
+    c->building = building;
+    c->checkpoint_every = CHECKPOINT_DEFAULT_EVERY_TICKS;
+    c->events = event_queue_create();
+    if (!c->events || core_alloc(c, desc) != 0) {
+        event_queue_destroy(c->events);
+        free(c->arena);
+        free(c);
+        return NULL;
+    }
+    core_reset(c);
+    return c;
+}
+
+static void core_destroy(ServerCore* c)
+{
+    if (!c || c == &g_core) return;
+    event_queue_destroy(c->events);
+    if (c->eta_lock) platform_mutex_destroy(c->eta_lock);
+    free(c->arena);  // 電梯、ETA 快取、排程狀態都在這裡
+    free(c);
+}
+
 /* 初始化電梯系統與事件系統 */
 int server_core_init(int elevator_count)
+{
+    return server_core_init_campus(1, elevator_count);
+}
+
+/* 停掉最佳化器（各大樓的排程先放開它） */
+static void release_optimizer(void)
+{
+    if (!g_opt) return;
+    for (int b = 0; b < g_building_count; ++b) Scheduler_set_optimizer(g_buildings[b]->sched, NULL, 0);
+    plan_opt_destroy(g_opt);
+    g_opt = NULL;
+}
+
+/* 初始化園區：buildings 棟，每棟 elevator_count 台（預設大樓描述） */
+int server_core_init_campus(int buildings, int elevator_count)
 {
     if (elevator_count <= 0 || elevator_count > MAX_ELEVATORS) elevator_count = DEFAULT_ELEVATOR_COUNT;
-    g_elevator_count = elevator_count;
+    BuildingDesc desc;
+    building_desc_default(&desc, BUILDING_DEFAULT_FLOORS, elevator_count);
+    return server_core_init_desc(buildings, &desc);
+}
 
-    // init pending queue
-    rq_init(&g_pending_requests);
+/* 初始化園區：buildings 棟，每棟照 desc 配置 */
+int server_core_init_desc(int buildings, const BuildingDesc* desc)
+{
+    if (g_core_thread || !desc) return -1;
+    if (buildings < 1 || buildings > MAX_BUILDINGS) return -1;
+    if (desc->floors < 1 || desc->floors > MAX_FLOORS || desc->cars < 1 || desc->cars > desc->max_cars ||
+        desc->max_cars > MAX_ELEVATORS) return -1;
 
-    // init elevators
-    for (int i = 0; i < g_elevator_count; ++i) {
-        Elevator_init(&g_elevators[i], i, 1);
+    // 上一次 init 留下的最佳化器與其他大樓
+    release_optimizer();
+    for (int b = 1; b < g_building_count; ++b) {
+        core_destroy(g_buildings[b]);
+        g_buildings[b] = NULL;
     }
+    g_building_count = 1;
+    g_state_imported = 0;  // 新的狀態：還沒有接手，也還沒交出去
+    g_handed_off = 0;
+
+    g_core.building = 0;
+    g_core.events = server_events_default_queue();
+    if (core_alloc(&g_core, desc) != 0) {
+        printf("[CORE] cannot allocate building 0\n");
+        return -1;
+    }
+    core_reset(&g_core);
+    core_notify_init();
 
     // init server_events system (network will push into this)
     server_events_init();
 
+    for (int b = 1; b < buildings; ++b) {
+        g_buildings[b] = core_create(b, desc);
+        if (!g_buildings[b]) {
+            printf("[CORE] cannot allocate building %d\n", b);
+            return -1;
+        }
+        g_building_count = b + 1;
+    }
+
     return 0; /* success */
 }
 
+/* 設定背景最佳化（start 之前） */
+void server_core_set_optimizer(int iterations_per_tick)
+{
+    g_opt_iterations = (iterations_per_tick >= 0) ? iterations_per_tick : -1;
+}
+
+void server_core_get_optimizer_stats(PlanOptStats* out)
+{
+    plan_opt_get_stats(g_opt, out);
+}
+
+/* 設定工作執行緒數（start 之前） */
+void server_core_set_workers(int workers)
+{
+    g_workers = (workers > 0) ? workers : 0;
+}
+
 /* 關閉事件 */
 void server_core_shutdown(void)
 {
-    server_events_shutdown();
+    for (int b = 0; b < g_building_count; ++b) {
+        event_queue_shutdown(g_buildings[b]->events);
+    }
 }
 
 /* 取得 Pending Request 佇列指標 */
 RequestQueue* server_core_get_pending_queue(void) {
-    return &g_pending_requests;
+    return &g_core.pending;
 }
 
-/* 處理一次事件佇列 */
+/* 各通道每 tick 的處理上限（0 = 不限）：關閉與警衛指令一律當 tick 處理完 */
+static const int g_lane_budget[EVT_LANE_COUNT] = {
+    [EVT_LANE_SHUTDOWN] = 0,
+    [EVT_LANE_GUARD]    = 0,
+    [EVT_LANE_CAR]      = LANE_BUDGET_CAR,
+    [EVT_LANE_HALL]     = LANE_BUDGET_HALL,
+};
+
+/* 車隊調整結果通知警衛端 */
+static void notify_fleet(ServerCore* c, int op, int car, int result)
+{
+    CoreNotice n;
+    memset(&n, 0, sizeof(n));
+    n.type = NOTICE_FLEET;
+    n.building = c->building;
+    n.at_s = c->tick * TICK_DT_SECONDS;
+    n.floor = -1;
+    n.car = car;
+    n.eta_s = -1.0;
+    n.client_id = -1;
+    n.op = op;
+    n.result = result;
+    core_notify_push(&n);
+}
+
+/* 車隊調整（在 tick 中處理，排程器與電梯不會同時被改） */
+// 加入：啟用下一個預留位置；移除：只能移除最後一台，且須已停用、沒有乘客 / 停靠點
+// 停用：外呼立刻改派給其他電梯，車內乘客照常送達
+static void handle_fleet(ServerCore* c, const FleetCommand* cmd)
+{
+    int car = cmd->elevator_id;
+    int rc = ELEV_OK;
+    switch (cmd->op) {
+        case FLEET_ADD_CAR: {
+            car = c->elevator_count;
+            if (car >= c->desc.max_cars) {
+                rc = ELEV_ERR_FULL;
+                break;
+            }
+            building_configure_car(&c->desc, car, &c->elevators[car]);
+            c->traj_last[car][0] = c->traj_last[car][1] = c->traj_last[car][2] = -999;
+            eta_cache_invalidate(c->eta, car);
+            if (c->eta_lock) platform_mutex_lock(c->eta_lock);
+            c->eta_pub_at[car] = -1.0;
+            if (c->eta_lock) platform_mutex_unlock(c->eta_lock);
+            c->elevator_count++;
+        } break;
+
+        case FLEET_REMOVE_CAR: {
+            if (car < 0) car = c->elevator_count - 1;
+            if (c->elevator_count <= 1 || car != c->elevator_count - 1) {
+                rc = ELEV_ERR_INVALID;
+                break;
+            }
+            const Elevator* e = &c->elevators[car];
+            if (e->in_service || e->task_state != TASK_IDLE || elevator_has_stops(e)) {
+                rc = ELEV_ERR_BUSY;
+                break;
+            }
+            c->elevator_count--;
+        } break;
+
+        case FLEET_OUT_OF_SERVICE: {
+            if (car < 0 || car >= c->elevator_count) {
+                rc = ELEV_ERR_INVALID;
+                break;
+            }
+            if (!c->elevators[car].in_service) {
+                rc = ELEV_IGNORED;
+                break;
+            }
+            c->elevators[car].in_service = false;
+            Scheduler_release_car(c->sched, c->elevators, c->elevator_count, car, &c->pending, c->tick * TICK_DT_SECONDS);
+        } break;
+
+        case FLEET_IN_SERVICE: {
+            if (car < 0 || car >= c->elevator_count) {
+                rc = ELEV_ERR_INVALID;
+                break;
+            }
+            if (c->elevators[car].in_service) rc = ELEV_IGNORED;
+            c->elevators[car].in_service = true;
+        } break;
+
+        default:
+            rc = ELEV_ERR_INVALID;
+            break;
+    }
+    CORE_LOG("[CORE] B%d fleet op=%d E%d rc=%d (%d cars)\n", c->building, cmd->op, car, rc, c->elevator_count);
+    notify_fleet(c, cmd->op, car, rc);
+}
+
+/* 處理單一事件 */
 // server_events 轉換成 elevator/scheduler 事件
-static void process_incoming_events_once(void)
+static void handle_event(ServerCore* c, ServerEvent* ev)
 {
-    ServerEvent* ev = NULL;
-    while (server_events_try_pop(&ev) == 0) {
-        if (!ev) continue;
+    // 記錄所有被核心接受的事件（關閉事件不記錄）
+    if (c->journal && ev->type != EVT_SHUTDOWN) {
+        event_journal_append(c->journal, c->tick, ev);
+    }
+
+    switch (ev->type) {
+        case EVT_OUTSIDE_CALL: {
+            PendingRequest p;
+            p.floor     = ev->v.outside_call.floor;
+            p.source_id = ev->v.outside_call.client_id;
+            p.to_floor  = ev->v.outside_call.to_floor;  /* 目的樓層外呼才有（-1 = 只按方向） */
+            if (p.to_floor < 0 || p.to_floor >= c->desc.floors || p.to_floor == p.floor) p.to_floor = -1;
+            p.enqueue_s = c->tick * TICK_DT_SECONDS;  /* 等待時間從進佇列開始算 */
+            p.request_id = ev->v.outside_call.request_id;
+
+            if (ev->v.outside_call.direction == DIR_UP)
+                p.type = REQ_CALL_UP;
+            else
+                p.type = REQ_CALL_DOWN;
+            demand_record(c->demand, p.floor, (p.type == REQ_CALL_UP) ? 0 : 1, p.enqueue_s);
+            // 外呼只在 pending 有空位時才從通道取出（process_incoming_events_once），這裡不應失敗
+            if (rq_push(&c->pending, p) != 0) {
+                CORE_LOG("[CORE] B%d pending queue full, hall call %d dropped\n", c->building, p.floor);
+            }
+        } break;
+
+        case EVT_INSIDE_CALL: {
+            int eid = ev->v.inside_call.elevator_id;
+            if (eid >= 0 && eid < c->elevator_count) {
+                /* push into elevator local queue via helper (or direct push) */
+                Elevator_push_inside_request(&c->elevators[eid], ev->v.inside_call.dest_floor, ev->v.inside_call.client_id);
+            } else {
+                // invalid elevator id: ignore or log
+                // fprintf(stderr, "[CORE] invalid inside call elevator id %d\n", eid);
+            }
+        } break;
+
+        case EVT_GUARD_COMMAND: {
+            // Implement guard handling as needed: e.g., force assign, maintenance flag
+            // For now we optionally support a simple "force assign" where guard requests direct push to specific elevator
+            int eid = ev->v.guard_cmd.elevator_id;
+            if (eid >= 0 && eid < c->elevator_count && ev->v.guard_cmd.force && c->elevators[eid].in_service) {
 
-        switch (ev->type) {
-            case EVT_OUTSIDE_CALL: {
                 PendingRequest p;
-                p.floor     = ev->v.outside_call.floor;
-                p.source_id = ev->v.outside_call.client_id;
-                p.to_floor  = -1;  /* 外呼沒有目的樓層 */
-
-                if (ev->v.outside_call.direction == DIR_UP)
-                    p.type = REQ_CALL_UP;
-                else
-                    p.type = REQ_CALL_DOWN;
-                rq_push(&g_pending_requests, p);
-            } break;
-
-            case EVT_INSIDE_CALL: {
-                int eid = ev->v.inside_call.elevator_id;
-                if (eid >= 0 && eid < g_elevator_count) {
-                    /* push into elevator local queue via helper (or direct push) */
-                    Elevator_push_inside_request(&g_elevators[eid], ev->v.inside_call.dest_floor, ev->v.inside_call.client_id);
-                } else {
-                    // invalid elevator id: ignore or log
-                    // fprintf(stderr, "[CORE] invalid inside call elevator id %d\n", eid);
-                }
-            } break;
-
-            case EVT_GUARD_COMMAND: {
-                // Implement guard handling as needed: e.g., force assign, maintenance flag
-                // For now we optionally support a simple "force assign" where guard requests direct push to specific elevator
-                int eid = ev->v.guard_cmd.elevator_id;
-                if (eid >= 0 && eid < g_elevator_count && ev->v.guard_cmd.force) {
-
-                    PendingRequest p;
-                    p.floor     = ev->v.guard_cmd.floor;
-                    p.source_id = ev->v.guard_cmd.client_id;
-                    p.to_floor  = -1;
-                    p.type      = REQ_CALL_UP;  /* 你可依需求改成 guard_cmd.direction */
-
-                    /* 強制加入該電梯 */
-                    int rc = elevator_add_request_flag(&g_elevators[eid], p.floor, p.type);
-                    if (rc < 0) {
-                        printf("[CORE] guard forced call rejected: E%d floor=%d\n", eid, p.floor);
-                    }
+                p.floor     = ev->v.guard_cmd.floor;
+                p.source_id = ev->v.guard_cmd.client_id;
+                p.to_floor  = -1;
+                p.enqueue_s = c->tick * TICK_DT_SECONDS;
+                p.request_id = 0;
+                p.type      = REQ_CALL_UP;  /* 你可依需求改成 guard_cmd.direction */
+
+                /* 強制加入該電梯 */
+                int rc = elevator_add_request_flag(&c->elevators[eid], p.floor, p.type);
+                if (rc < 0) {
+                    CORE_LOG("[CORE] B%d guard forced call rejected: E%d floor=%d\n", c->building, eid, p.floor);
                 }
-            } break;
+            }
+        } break;
 
-            case EVT_SHUTDOWN: {
-                // set running to 0 to exit loop gracefully
-                g_running = 0;
-            } break;
+        case EVT_FLEET_COMMAND: {
+            handle_fleet(c, &ev->v.fleet_cmd);
+        } break;
 
-            default:
-                break;
-        }
+        case EVT_SHUTDOWN: {
+            // set running to 0 to exit loop gracefully
+            g_running = 0;
+        } break;
 
-        server_events_free(ev);
-        ev = NULL;
+        default:
+            break;
+    }
+}
+
+/* 處理一次事件佇列 */
+// 依優先順序逐通道處理；budgeted = 1 時套用每通道預算，沒處理完的留到下一個 tick
+// 外呼另受 pending 佇列剩餘空間限制（不論是否套用預算），塞不下的留在通道裡而不是被丟掉
+static void process_incoming_events_once(ServerCore* c, int budgeted)
+{
+    ServerEvent* ev = NULL;
+    for (int lane = 0; lane < EVT_LANE_COUNT; ++lane) {
+        int budget = budgeted ? g_lane_budget[lane] : 0;
+        for (int n = 0; budget == 0 || n < budget; ++n) {
+            if (lane == EVT_LANE_HALL && rq_count(&c->pending) >= MAX_REQUESTS) break;
+            if (event_queue_try_pop_lane(c->events, (ServerEventLane)lane, &ev) != 0) break;
+            if (!ev) continue;
+            handle_event(c, ev);
+            server_events_free(ev);
+            ev = NULL;
+        }
     }
 }
 
@@ -142,9 +497,9 @@ static void publish_state_once(void)
     char buf[BUF_SZ];
     int off = 0;
     off += snprintf(buf + off, BUF_SZ - off, "=== ELEVATORS STATUS ===\n");
-    for (int i = 0; i < g_elevator_count && off < BUF_SZ; ++i) {
+    for (int i = 0; i < g_core.elevator_count && off < BUF_SZ; ++i) {
         char line[256];
-        Elevator_status_line(&g_elevators[i], line, sizeof(line));
+        Elevator_status_line(&g_core.elevators[i], line, sizeof(line));
         off += snprintf(buf + off, BUF_SZ - off, "%s\n", line);
     }
     // 如果有連接外部 => 丟給外部
@@ -157,47 +512,416 @@ static void publish_state_once(void)
     }
 }
 
+/* 電梯位置 / 狀態有變化時寫一行軌跡：tick car floor state dir */
+static void write_trajectory_once(ServerCore* c)
+{
+    if (!c->traj_fp) return;
+    for (int i = 0; i < c->elevator_count; ++i) {
+        const Elevator* e = &c->elevators[i];
+        if (c->traj_last[i][0] == e->current_floor &&
+            c->traj_last[i][1] == (int)e->task_state &&
+            c->traj_last[i][2] == (int)e->direction) continue;
+        c->traj_last[i][0] = e->current_floor;
+        c->traj_last[i][1] = (int)e->task_state;
+        c->traj_last[i][2] = (int)e->direction;
+        fprintf(c->traj_fp, "%u %d %d %d %d\n", (unsigned)c->tick, e->id,
+                e->current_floor, (int)e->task_state, (int)e->direction);
+    }
+}
+
+/* 發布 ETA 查詢表：只有快取重算過的電梯才複製整張表 */
+static void publish_eta_once(ServerCore* c)
+{
+    if (!c->eta_lock) return;
+    platform_mutex_lock(c->eta_lock);
+    for (int i = 0; i < c->elevator_count; ++i) {
+        const double* up = NULL;
+        const double* down = NULL;
+        double at = 0.0;
+        unsigned long serial = 0;
+        if (!c->elevators[i].in_service) {
+            c->eta_pub_at[i] = -1.0;  // 停用的電梯不對外報 ETA
+            continue;
+        }
+        if (eta_cache_table(c->eta, &c->elevators[i], &up, &down, &at, &serial) != 0) continue;
+        if (c->eta_pub_at[i] >= 0.0 && serial == c->eta_pub_serial[i]) {
+            c->eta_pub_at[i] = at;  // 同一張表（閒置電梯的計算時間會跟著時鐘走）
+            continue;
+        }
+        const int floors = c->desc.floors;
+        float* pub = c->eta_pub + (size_t)(2 * i) * floors;
+        for (int f = 0; f < floors; ++f) {
+            pub[f] = (float)up[f];
+            pub[floors + f] = (float)down[f];
+        }
+        c->eta_pub_at[i] = at;
+        c->eta_pub_serial[i] = serial;
+    }
+    c->eta_pub_count = c->elevator_count;
+    c->eta_pub_now = eta_cache_now(c->eta);
+    platform_mutex_unlock(c->eta_lock);
+}
+
 /*
- * 核心迴圈（執行緒）：
+ * 執行一個 tick（不睡眠）：
  * 1. 處理事件
  * 2. 執行排程器（指派請求）
  * 3. 更新電梯狀態
- * 4. 輸出電梯狀態
- * 5. 睡眠
+ */
+static void core_tick_once(ServerCore* c, double dt)
+{
+    // 到達率：跨時段時把上一段折進 EWMA，有設定存檔就順便寫出
+    if (demand_advance(c->demand, c->tick * dt) > 0 && c->demand_path) {
+        if (demand_save(c->demand, c->demand_path) != 0) {
+            CORE_LOG("[CORE] cannot save demand model to %s\n", c->demand_path);
+        }
+    }
+
+    // 1 process events
+    process_incoming_events_once(c, 1);
+
+    // 2 scheduler
+    Scheduler_Process_state(c->sched, c->elevators, c->elevator_count, &c->pending, c->tick * dt);
+
+    // 3 step elevators
+    for (int i = 0; i < c->elevator_count; ++i) {
+        Elevator_step(&c->elevators[i], dt);
+    }
+
+    c->tick++;
+    eta_cache_advance(c->eta, dt);
+    publish_eta_once(c);
+    write_trajectory_once(c);
+
+    if (c->status_shm) {
+        status_shm_publish(c->status_shm, c->elevators, c->elevator_count, c->tick);
+    }
+
+    if (c->checkpoint && c->tick % (uint32_t)c->checkpoint_every == 0) {
+        checkpoint_write(c->checkpoint, c->elevators, c->elevator_count, &c->pending, c->sched, c->tick);
+    }
+}
+
+/* 工作池的一個工作：一棟大樓跑一個 tick（各大樓狀態互不共用） */
+static void campus_tick_task(int building, void* arg)
+{
+    (void)arg;
+    core_tick_once(g_buildings[building], TICK_DT_SECONDS);
+}
+
+/* 所有大樓各跑一個 tick；有工作池就平行執行 */
+static void campus_tick_once(void)
+{
+    if (g_building_count == 1) {
+        core_tick_once(&g_core, TICK_DT_SECONDS);
+    } else if (g_pool) {
+        core_pool_run(g_pool, g_building_count, campus_tick_task, NULL);
+    } else {
+        for (int b = 0; b < g_building_count; ++b) campus_tick_task(b, NULL);
+    }
+}
+
+/*
+ * 核心迴圈（執行緒）：
+ * 1. 執行一個 tick
+ * 2. 輸出電梯狀態
+ * 3. 睡眠
  * 直到 g_running = 0 結束
  */
 static void* core_thread_fn(void* arg)
 {
     (void)arg;
     const double dt = TICK_DT_SECONDS;
-    g_running = 1;
 
     while (g_running) {
-        // 1 process events
-        process_incoming_events_once();
-
-        // 2 scheduler
-        Scheduler_Process(g_elevators, g_elevator_count, &g_pending_requests);
-
-        // 3 step elevators
-        for (int i = 0; i < g_elevator_count; ++i) {
-            Elevator_step(&g_elevators[i], dt);
-        }
+        // 1 events + scheduler + elevators（每棟大樓）
+        campus_tick_once();
 
-        // 4 publish state (could be every N ticks; here every tick)
+        // 2 publish state (could be every N ticks; here every tick)
         //publish_state_once();
 
-        // 5 sleep dt
+        // 3 sleep dt
         platform_sleep_ms((int)(dt * 1000.0));
     }
 
     return NULL;
 }
 
+/* 建立工作池（多棟大樓才需要） */
+static int ensure_pool(void)
+{
+    if (g_pool || g_building_count == 1) return 0;
+    int workers = g_workers ? g_workers : platform_cpu_count();
+    if (workers > g_building_count) workers = g_building_count;
+    g_pool = core_pool_create(workers, g_building_count);
+    return g_pool ? 0 : -1;
+}
+
+/* 建立最佳化器並交給每棟大樓的排程 */
+static int ensure_optimizer(void)
+{
+    if (g_opt || g_opt_iterations < 0) return 0;
+    g_opt = plan_opt_create(g_building_count, g_opt_iterations);
+    if (!g_opt) return -1;
+    for (int b = 0; b < g_building_count; ++b) Scheduler_set_optimizer(g_buildings[b]->sched, g_opt, b);
+    return 0;
+}
+
+/* 在呼叫端執行緒跑一個 tick（虛擬時間，不睡眠） */
+void server_core_step(void)
+{
+    ensure_pool();
+    ensure_optimizer();
+    campus_tick_once();
+}
+
+/* 取得目前 tick */
+uint32_t server_core_get_tick(void)
+{
+    return g_core.tick;
+}
+
+/* 查詢某樓層 / 方向 ETA 最短的電梯（任何執行緒皆可呼叫） */
+int server_core_query_eta_of(ServerCore* c, int floor, Direction dir, int* car, double* seconds)
+{
+    if (!c || !c->eta_lock || floor < 0 || floor >= c->desc.floors) return -1;
+    if (dir != DIR_UP && dir != DIR_DOWN) return -1;
+    int k = (dir == DIR_UP) ? 0 : 1;
+    int best = -1;
+    double best_s = 0.0;
+
+    platform_mutex_lock(c->eta_lock);
+    for (int i = 0; i < c->eta_pub_count; ++i) {
+        float v = c->eta_pub[(size_t)(2 * i + k) * c->desc.floors + floor];
+        if (c->eta_pub_at[i] < 0.0 || v < 0.0f) continue;
+        double s = v - (c->eta_pub_now - c->eta_pub_at[i]);
+        if (s < 0.0) s = 0.0;
+        if (best < 0 || s < best_s) {
+            best = i;
+            best_s = s;
+        }
+    }
+    platform_mutex_unlock(c->eta_lock);
+
+    if (best < 0) return -1;
+    if (car) *car = best;
+    if (seconds) *seconds = best_s;
+    return 0;
+}
+
+int server_core_query_eta(int floor, Direction dir, int* car, double* seconds)
+{
+    return server_core_query_eta_of(&g_core, floor, dir, car, seconds);
+}
+
+/* 還原快照後重新套用大樓描述（速率、開門時間、停靠樓層不在快照裡） */
+static void apply_desc(ServerCore* c)
+{
+    for (int i = 0; i < c->elevator_count; ++i) {
+        building_apply_car(&c->desc, i, &c->elevators[i]);
+    }
+    eta_cache_reset(c->eta);
+}
+
+/* 載入一份 checkpoint 編碼的狀態（接手、重播日誌的起始狀態） */
+static int load_snapshot(ServerCore* c, const unsigned char* in, int len)
+{
+    int count = c->desc.max_cars;
+    uint32_t tick = 0;
+    if (checkpoint_decode(in, len, c->elevators, &count, &c->pending, c->sched, &tick) != 0) return -1;
+    c->elevator_count = count;
+    c->tick = tick;
+    apply_desc(c);
+    return 0;
+}
+
+/* 開啟事件日誌：從目前的狀態開始記（存檔還原、接手後都不是 tick 0），狀態寫進檔頭 */
+int server_core_enable_journal(const char* path)
+{
+    if (!path || g_core.journal || g_core_thread || g_building_count > 1) return -1;
+    const int tick_ms = (int)(TICK_DT_SECONDS * 1000.0);
+    // 熱升級接手：舊行程交接前已把日誌寫完，從接手的 tick 接著寫，整份日誌仍可重播
+    if (g_state_imported) {
+        g_core.journal = event_journal_resume(path, tick_ms, g_core.tick);
+        if (g_core.journal) {
+            printf("[CORE] journal: continuing %s from tick %u\n", path, (unsigned)g_core.tick);
+            return 0;
+        }
+    }
+    unsigned char* snap = (unsigned char*)malloc(CHECKPOINT_MAX_PAYLOAD);
+    if (!snap) return -1;
+    int slen = checkpoint_encode(g_core.elevators, g_core.elevator_count, &g_core.pending, g_core.sched,
+                                 g_core.tick, snap, CHECKPOINT_MAX_PAYLOAD);
+    // 既有的日誌（例如當機前的紀錄）改名保留，不覆蓋
+    char kept[1024];
+    int moved = (slen > 0) ? event_journal_rotate(path, kept, (int)sizeof(kept)) : -1;
+    if (moved > 0) printf("[CORE] journal: previous %s kept as %s\n", path, kept);
+    if (moved >= 0) {
+        g_core.journal = event_journal_open(path, tick_ms, g_core.tick, snap, slen);
+    }
+    free(snap);
+    return g_core.journal ? 0 : -1;
+}
+
+/* 開啟狀態存檔；若檔案內有有效存檔則先還原 */
+int server_core_enable_checkpoint(const char* path, int every_ticks)
+{
+    if (g_core.checkpoint || g_core_thread || g_building_count > 1) return -1;
+    g_core.checkpoint = checkpoint_open(path);
+    if (!g_core.checkpoint) return -1;
+    g_core.checkpoint_every = (every_ticks > 0) ? every_ticks : CHECKPOINT_DEFAULT_EVERY_TICKS;
+
+    // 接手的狀態比存檔新，不能被存檔蓋掉；之後照常定期寫入
+    if (g_state_imported) {
+        printf("[CORE] checkpoint %s: keeping the state taken over, not restoring\n", path);
+        return 0;
+    }
+
+    int count = g_core.desc.max_cars;
+    uint32_t tick = 0;
+    long long t0 = platform_time_ms();
+    int rc = checkpoint_load(g_core.checkpoint, g_core.elevators, &count, &g_core.pending, g_core.sched, &tick);
+    if (rc == 1) {
+        g_core.elevator_count = count;
+        g_core.tick = tick;
+        apply_desc(&g_core);
+        printf("[CORE] checkpoint restored: %d elevators, %d pending, tick=%u (%lld ms)\n",
+               count, rq_count(&g_core.pending), (unsigned)tick, platform_time_ms() - t0);
+        return 1;
+    }
+    if (rc < 0) {
+        printf("[CORE] checkpoint %s is not compatible, starting fresh\n", path);
+    }
+    return 0;
+}
+
+/* 開啟到達率存檔：有舊檔先載入，之後每個時段結束與停止時寫回
+ * 時段依本機時間切分（存檔還原過的 tick 也算進去） */
+int server_core_enable_demand(const char* path)
+{
+    if (!path || g_core.demand_path || g_core_thread || g_building_count > 1) return -1;
+    int rc = demand_load(g_core.demand, path);
+    if (rc < 0) {
+        printf("[CORE] demand model %s is not compatible, learning from scratch\n", path);
+        rc = 0;
+    }
+    size_t len = strlen(path) + 1;
+    g_core.demand_path = (char*)malloc(len);
+    if (!g_core.demand_path) return -1;
+    memcpy(g_core.demand_path, path, len);
+
+    time_t now = time(NULL);
+    struct tm* lt = localtime(&now);
+    double tod = lt ? lt->tm_hour * 3600.0 + lt->tm_min * 60.0 + lt->tm_sec : 0.0;
+    demand_set_day_offset(g_core.demand, tod - g_core.tick * TICK_DT_SECONDS);
+    return rc;
+}
+
+/* 開啟共享記憶體狀態發布 */
+int server_core_enable_status_shm(const char* name)
+{
+    if (g_core.status_shm || g_core_thread || g_building_count > 1) return -1;
+    g_core.status_shm = status_shm_create(name);
+    if (!g_core.status_shm) return -1;
+    status_shm_publish(g_core.status_shm, g_core.elevators, g_core.elevator_count, g_core.tick);
+    return 0;
+}
+
+/* 設定軌跡輸出（NULL 關閉） */
+void server_core_set_trajectory_log(FILE* fp)
+{
+    g_core.traj_fp = fp;
+    for (int i = 0; i < g_core.desc.max_cars; ++i) {
+        g_core.traj_last[i][0] = g_core.traj_last[i][1] = g_core.traj_last[i][2] = -999;
+    }
+    write_trajectory_once(&g_core);
+}
+
+/* 是否已無任何待處理工作（重播收尾用） */
+static int core_is_quiescent(ServerCore* c)
+{
+    if (!rq_empty(&c->pending) || event_queue_count(c->events) > 0) return 0;
+    for (int i = 0; i < c->elevator_count; ++i) {
+        if (c->elevators[i].task_state != TASK_IDLE || elevator_has_stops(&c->elevators[i])) return 0;
+    }
+    return 1;
+}
+
+/* 重播時把日誌事件重新推回事件佇列 */
+static void replay_push_event(const ServerEvent* ev)
+{
+    switch (ev->type) {
+        case EVT_OUTSIDE_CALL:
+            if (ev->v.outside_call.to_floor >= 0) {
+                server_events_push_destination(ev->v.outside_call.floor, ev->v.outside_call.to_floor,
+                                               ev->v.outside_call.client_id, 0);
+            } else {
+                server_events_push_outside(ev->v.outside_call.floor, ev->v.outside_call.direction,
+                                           ev->v.outside_call.client_id);
+            }
+            break;
+        case EVT_INSIDE_CALL:
+            server_events_push_inside(ev->v.inside_call.elevator_id, ev->v.inside_call.dest_floor,
+                                      ev->v.inside_call.client_id);
+            break;
+        case EVT_GUARD_COMMAND:
+            server_events_push_guard(ev->v.guard_cmd.elevator_id, ev->v.guard_cmd.floor,
+                                     ev->v.guard_cmd.force, ev->v.guard_cmd.client_id, NULL);
+            break;
+        case EVT_FLEET_COMMAND:
+            server_events_push_fleet(ev->v.fleet_cmd.op, ev->v.fleet_cmd.elevator_id, ev->v.fleet_cmd.client_id);
+            break;
+        default:
+            break;
+    }
+}
+
+/* 以虛擬時間全速重播事件日誌 */
+int server_core_replay(const char* journal_path)
+{
+    if (g_core_thread || g_building_count > 1) return -1;
+
+    int tick_ms = 0;
+    EventJournalReader* r = event_journal_reader_open(journal_path, &tick_ms);
+    if (!r) return -1;
+    if (tick_ms != (int)(TICK_DT_SECONDS * 1000.0)) {
+        printf("[CORE] replay: journal tick %d ms differs from core tick, trajectories may diverge\n", tick_ms);
+    }
+    // 日誌開始時的狀態（存檔還原、接手後開的日誌）先載入，再從該 tick 重播
+    uint32_t base_tick = 0;
+    const unsigned char* snap = NULL;
+    int slen = 0;
+    event_journal_reader_base(r, &base_tick, &snap, &slen);
+    if (slen > 0 && (load_snapshot(&g_core, snap, slen) != 0 || g_core.tick != base_tick)) {
+        printf("[CORE] replay: cannot load the journal's starting state\n");
+        event_journal_reader_close(r);
+        return -1;
+    }
+
+    JournalRecord rec;
+    int count = 0;
+    int rc;
+    while ((rc = event_journal_read(r, &rec)) == 1) {
+        // 先跑到事件當初被處理的 tick，再推入事件，讓它在同一個 tick 被處理
+        while (g_core.tick < rec.tick) core_tick_once(&g_core, TICK_DT_SECONDS);
+        replay_push_event(&rec.event);
+        count++;
+    }
+    event_journal_reader_close(r);
+
+    for (int i = 0; i < REPLAY_DRAIN_MAX_TICKS && !core_is_quiescent(&g_core); ++i) {
+        core_tick_once(&g_core, TICK_DT_SECONDS);
+    }
+    return (rc < 0) ? -1 : count;
+}
+
 /* 啟動核心迴圈執行緒 */
 int server_core_start(void)
 {
     if (g_core_thread != NULL) return -1; // already running
+    if (ensure_pool() != 0) return -1;
+    if (ensure_optimizer() != 0) return -1;
+    g_running = 1;
     g_core_thread = platform_thread_create(core_thread_fn, NULL);
     if (!g_core_thread) return -1;
     return 0;
@@ -208,13 +932,147 @@ void server_core_stop(void)
 {
     // set running flag to 0 and also trigger server_events shutdown to wake potential blocking calls
     g_running = 0;
-    server_events_shutdown();
+    server_core_shutdown();
+    if (g_core_thread) {
+        platform_thread_join(g_core_thread);
+        g_core_thread = NULL;
+    }
+    if (g_pool) {
+        core_pool_destroy(g_pool);
+        g_pool = NULL;
+    }
+    release_optimizer();
+    // 交接之後日誌、存檔、到達率檔與共享記憶體都屬於新行程，只放掉本行程的資源
+    if (g_core.journal) {
+        if (g_handed_off) event_journal_discard(g_core.journal);
+        else event_journal_close(g_core.journal);
+        g_core.journal = NULL;
+    }
+    if (g_core.status_shm) {
+        if (g_handed_off) status_shm_detach(g_core.status_shm);
+        else status_shm_destroy(g_core.status_shm);
+        g_core.status_shm = NULL;
+    }
+    if (g_core.demand_path) {
+        if (!g_handed_off) demand_save(g_core.demand, g_core.demand_path);
+        free(g_core.demand_path);
+        g_core.demand_path = NULL;
+    }
+    if (g_core.checkpoint) {
+        // 正常關閉時寫最後一次，重啟後從停止當下繼續
+        if (!g_handed_off) {
+            checkpoint_write(g_core.checkpoint, g_core.elevators, g_core.elevator_count, &g_core.pending,
+                             g_core.sched, g_core.tick);
+        }
+        checkpoint_close(g_core.checkpoint);
+        g_core.checkpoint = NULL;
+    }
+}
+
+/* 暫停核心迴圈（事件佇列保持開啟，可再用 server_core_start 繼續） */
+void server_core_pause(void)
+{
+    g_running = 0;
     if (g_core_thread) {
         platform_thread_join(g_core_thread);
         g_core_thread = NULL;
     }
 }
 
+static void put_le32(unsigned char* p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_le32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 把一筆外呼放回外呼通道（目的樓層外呼與一般外呼分開推） */
+static int push_hall_event(ServerEventQueue* q, int floor, int dir, int to_floor, int client_id, unsigned request_id)
+{
+    if (to_floor >= 0) return event_queue_push_destination(q, floor, to_floor, client_id, request_id);
+    return event_queue_push_outside(q, floor, dir, client_id, request_id);
+}
+
+/* 交接資料中一筆還在外呼通道裡的事件：floor | dir | to_floor | client | request_id */
+#define HANDOFF_HALL_SIZE 20
+
+/* 匯出完整核心狀態（需先暫停核心）
+ * 格式：u32 快照長度 | 快照（checkpoint 編碼）| u32 外呼數 | 還在外呼通道裡的外呼 */
+int server_core_export_state(unsigned char* out, int cap)
+{
+    if (g_core_thread || g_building_count > 1 || !out || cap < 8) return -1;
+    // 已被接受但還在事件佇列中的事件先併入狀態；pending 滿了的外呼留在通道裡，下面原樣帶走
+    process_incoming_events_once(&g_core, 0);
+    int slen = checkpoint_encode(g_core.elevators, g_core.elevator_count, &g_core.pending, g_core.sched,
+                                 g_core.tick, out + 4, cap - 8);
+    if (slen < 0) return -1;
+    put_le32(out, (uint32_t)slen);
+    // 新行程會接著這份日誌往下寫、載入到達率檔：先把本行程的份寫完
+    event_journal_flush(g_core.journal);
+    if (g_core.demand_path) demand_save(g_core.demand, g_core.demand_path);
+    unsigned char* p = out + 4 + slen;
+    int n = event_queue_lane_count(g_core.events, EVT_LANE_HALL);
+    if ((p - out) + 4 + n * HANDOFF_HALL_SIZE > cap) return -1;
+
+    // 取出後依原順序放回：交接失敗時本行程照常繼續，通道內容不變
+    ServerEvent* held[SERVER_EVENTS_LANE_CAPACITY];
+    int count = 0;
+    ServerEvent* ev = NULL;
+    while (count < n && event_queue_try_pop_lane(g_core.events, EVT_LANE_HALL, &ev) == 0) {
+        if (ev) held[count++] = ev;
+        ev = NULL;
+    }
+    put_le32(p, (uint32_t)count);
+    p += 4;
+    for (int k = 0; k < count; ++k) {
+        const ServerEvent* e = held[k];
+        put_le32(p, (uint32_t)e->v.outside_call.floor);
+        put_le32(p + 4, (uint32_t)e->v.outside_call.direction);
+        put_le32(p + 8, (uint32_t)e->v.outside_call.to_floor);
+        put_le32(p + 12, (uint32_t)e->v.outside_call.client_id);
+        put_le32(p + 16, e->v.outside_call.request_id);
+        p += HANDOFF_HALL_SIZE;
+        push_hall_event(g_core.events, e->v.outside_call.floor, e->v.outside_call.direction,
+                        e->v.outside_call.to_floor, e->v.outside_call.client_id, e->v.outside_call.request_id);
+        server_events_free(held[k]);
+    }
+    return (int)(p - out);
+}
+
+/* 匯入核心狀態（server_core_init 之後、start 之前）；還沒處理的外呼放回外呼通道 */
+int server_core_import_state(const unsigned char* in, int len)
+{
+    if (g_core_thread || g_building_count > 1 || !in || len < 8) return -1;
+    int slen = (int)get_le32(in);
+    if (slen <= 0 || 4 + slen + 4 > len) return -1;
+    int n = (int)get_le32(in + 4 + slen);
+    if (n < 0 || n > SERVER_EVENTS_LANE_CAPACITY || 8 + slen + n * HANDOFF_HALL_SIZE > len) return -1;
+
+    if (load_snapshot(&g_core, in + 4, slen) != 0) return -1;
+    g_state_imported = 1;
+
+    const unsigned char* p = in + 8 + slen;
+    for (int k = 0; k < n; ++k, p += HANDOFF_HALL_SIZE) {
+        if (push_hall_event(g_core.events, (int)get_le32(p), (int)get_le32(p + 4), (int)get_le32(p + 8),
+                            (int)get_le32(p + 12), get_le32(p + 16)) != 0) {
+            CORE_LOG("[CORE] handoff: hall call floor=%d could not be queued\n", (int)get_le32(p));
+        }
+    }
+    return 0;
+}
+
+/* 交接完成：之後的 server_core_stop 不再碰任何檔案 */
+void server_core_mark_handed_off(void)
+{
+    g_handed_off = 1;
+}
+
 /* 阻塞等待核心執行緒結束 */
 void server_core_join(void)
 {
@@ -226,10 +1084,64 @@ void server_core_join(void)
 
 /* 回傳電梯陣列指標 */
 Elevator* server_core_get_elevators(void) {
-    return g_elevators;
+    return g_core.elevators;
 }
 
 /* 回傳目前電梯數量 */
 int server_core_get_elevator_count(void) {
-    return g_elevator_count;
+    return g_core.elevator_count;
+}
+
+/* ---------------------------
+   Campus (per-building access)
+   --------------------------- */
+
+int server_core_building_count(void) {
+    return g_building_count;
+}
+
+ServerCore* server_core_get(int building) {
+    if (building < 0 || building >= g_building_count) return NULL;
+    return g_buildings[building];
+}
+
+int server_core_building_id(const ServerCore* c) {
+    return c ? c->building : -1;
+}
+
+ServerEventQueue* server_core_events_of(ServerCore* c) {
+    return c ? c->events : NULL;
+}
+
+Elevator* server_core_elevators_of(ServerCore* c) {
+    return c ? c->elevators : NULL;
+}
+
+int server_core_elevator_count_of(const ServerCore* c) {
+    return c ? c->elevator_count : 0;
+}
+
+uint32_t server_core_tick_of(const ServerCore* c) {
+    return c ? c->tick : 0;
+}
+
+int server_core_floor_count_of(const ServerCore* c) {
+    return c ? c->desc.floors : 0;
+}
+
+int server_core_floor_served_of(const ServerCore* c, int floor) {
+    return c ? building_floor_served(&c->desc, floor) : 0;
+}
+
+const char* server_core_traffic_mode_of(const ServerCore* c) {
+    return Scheduler_traffic_mode_name(c ? Scheduler_traffic_mode(c->sched) : TRAFFIC_MODE_BALANCED);
+}
+
+/* 工作池統計（單一大樓或尚未建立時皆為 0） */
+void server_core_get_pool_stats(int* workers, unsigned long* rounds, unsigned long* steals)
+{
+    if (workers) *workers = g_pool ? core_pool_workers(g_pool) : 1;
+    if (rounds) *rounds = 0;
+    if (steals) *steals = 0;
+    if (g_pool) core_pool_get_stats(g_pool, rounds, steals);
 }
@@ -3,20 +3,32 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifndef SERVER_CORE_H
 #define SERVER_CORE_H
 
+#include <stdint.h>
+#include <stdio.h>
+
+#include "building.h"
+#include "checkpoint.h"
 #include "elevator.h"
+#include "plan_opt.h"
 #include "platform.h"
 #include "request_queue.h"
+#include "server_events.h"
 
 /* Tick default used by internal core (same as in server_core.c). */
 #define SERVER_CORE_DEFAULT_TICK_SECONDS 0.1
 
+/* Largest campus (independent buildings in one process). */
+#ifndef MAX_BUILDINGS
+#define MAX_BUILDINGS 64
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -28,11 +40,48 @@ extern "C" {
 typedef void (*server_core_status_cb_t)(const char* snapshot);
 
 /* Initialize server core. Must be called before start.
- * - elevator_count: number of elevators to initialize (clamped 1..MAX_ELEVATORS).
+ * - elevator_count: number of elevators to initialize (clamped 1..MAX_ELEVATORS),
+ *   in a default building of BUILDING_DEFAULT_FLOORS floors.
  * Returns 0 on success, non-zero on error.
  */
 int server_core_init(int elevator_count);
 
+/* Initialize a campus of `buildings` independent buildings (1..MAX_BUILDINGS),
+ * each with `elevator_count` cars, its own event queue, pending queue, ETA
+ * cache and scheduler state. Building 0 is the one every single-building
+ * function in this header refers to; server_core_init(n) is
+ * server_core_init_campus(1, n). Journal, checkpoint, status shm, replay,
+ * export / import and the trajectory log cover building 0 only and the
+ * enable / replay / export / import calls return -1 when buildings > 1.
+ * Returns 0 on success, -1 on error (including while the core is running).
+ */
+int server_core_init_campus(int buildings, int elevator_count);
+
+/* Same as server_core_init_campus, but every building is laid out from
+ * `desc` (building.h): floors, cars, per-car speed / door time / served
+ * floors. Each building's cars and per-car tables live in one allocation
+ * sized from the description. A restored checkpoint / imported state keeps
+ * positions and calls but takes its car parameters from `desc`.
+ */
+int server_core_init_desc(int buildings, const BuildingDesc* desc);
+
+/* Worker threads that tick the buildings of a campus (0 = one per CPU,
+ * never more than the building count). Call before server_core_start.
+ * Each tick, every building runs its tick as one task on a work-stealing
+ * pool (core_pool.h); a single building is ticked on the core thread alone.
+ */
+void server_core_set_workers(int workers);
+
+/* Background plan optimiser (plan_opt.h), one slot per building: < 0 off
+ * (the default), 0 = a search thread that uses whatever CPU the ticks
+ * leave, > 0 = that many search iterations per building per tick on the
+ * tick thread (reproducible virtual-time runs). Call before
+ * server_core_start / server_core_step; the optimiser is created on the
+ * first of those and dropped by server_core_stop and server_core_init.
+ */
+void server_core_set_optimizer(int iterations_per_tick);
+void server_core_get_optimizer_stats(PlanOptStats* out);
+
 /* Set optional status callback (may be NULL to clear). If set while the core
  * thread is running, the callback pointer is updated atomically (but the callback
  * itself must be thread-safe).
@@ -47,6 +96,39 @@ int server_core_start(void);
 /* Stop core loop and join the thread. Safe to call multiple times. */
 void server_core_stop(void);
 
+/* Stop the core thread after its current tick but keep the event queue
+ * open; server_core_start resumes from the same state.
+ */
+void server_core_pause(void);
+
+/* Serialise the full core state (checkpoint encoding) into `out`. The core
+ * must be paused or not started; events already accepted into the event
+ * queue are folded into the state first. Hall calls that do not fit into
+ * the pending queue stay in their lane and travel with the state, so an
+ * accepted call is never dropped by a handoff; the local queue is left as
+ * it was (a failed handoff resumes unchanged). The journal is flushed and
+ * the demand model saved before returning, because the new process continues
+ * the journal and reloads the demand file. Returns the length or -1; SERVER_CORE_HANDOFF_MAX bytes are always
+ * enough.
+ */
+#define SERVER_CORE_HANDOFF_MAX (8 + CHECKPOINT_MAX_PAYLOAD + SERVER_EVENTS_LANE_CAPACITY * 20)
+int server_core_export_state(unsigned char* out, int cap);
+
+/* Replace the core state with one produced by server_core_export_state;
+ * hall calls that were still queued go back into the hall-call lane. A
+ * later server_core_enable_checkpoint keeps this state instead of restoring
+ * the (older) file. Call after server_core_init and before
+ * server_core_start. Returns 0 or -1.
+ */
+int server_core_import_state(const unsigned char* in, int len);
+
+/* The new process has taken the state over: server_core_stop then writes no
+ * final checkpoint or demand file, drops unwritten journal records and
+ * leaves the status segment in place, since all of them now belong to the
+ * new process.
+ */
+void server_core_mark_handed_off(void);
+
 /* Blocking join (if a caller wants to wait on thread termination). */
 void server_core_join(void);
 
@@ -64,6 +146,103 @@ RequestQueue* server_core_get_pending_queue(void);
 Elevator* server_core_get_elevators(void);      /* pointer to array of elevators */
 int server_core_get_elevator_count(void);
 
+/* Number of ticks executed since server_core_init. */
+uint32_t server_core_get_tick(void);
+
+/* Car with the shortest ETA (see eta.h) for a hall call at (floor, dir),
+ * as of the last core tick. dir must be DIR_UP or DIR_DOWN. Safe to call
+ * from any thread. Returns 0 and fills car / seconds, or -1 if the input is
+ * invalid or no car can serve.
+ */
+int server_core_query_eta(int floor, Direction dir, int* car, double* seconds);
+
+/* Run exactly one core tick (events, scheduler, elevators) of every building
+ * on the calling thread (plus the pool workers for a campus) without sleeping. Used for headless virtual-time runs; must not be
+ * mixed with a running core thread.
+ */
+void server_core_step(void);
+
+/* Record every event accepted by the core into a binary journal (see
+ * event_journal.h). Call after server_core_init, after any checkpoint
+ * restore or takeover, and before server_core_start: the journal starts from
+ * the core's current state, which is stored in its header. After a takeover
+ * the old process's journal at `path` is continued instead, so the whole
+ * file still replays. Otherwise an existing file at `path` is never
+ * overwritten; it is kept as "<path>.<n>". The journal is
+ * flushed and closed by server_core_stop.
+ * Returns 0 on success, -1 on error.
+ */
+int server_core_enable_journal(const char* path);
+
+/* Keep a memory-mapped checkpoint of the full core state (see checkpoint.h),
+ * rewritten every `every_ticks` ticks (<= 0 selects the default of 1 s) and
+ * once more on server_core_stop. If the file already holds a valid snapshot,
+ * cars, pending hall calls, the scheduler's tracked calls and destination
+ * tickets and the tick counter are restored from it, unless the state was
+ * taken over with server_core_import_state.
+ * Call after server_core_init and before server_core_start.
+ * Returns 1 if state was restored, 0 if starting fresh, -1 on error.
+ */
+int server_core_enable_checkpoint(const char* path, int every_ticks);
+
+/* Persist the hall-call arrival-rate model (demand.h) in `path`: loaded now
+ * if the file exists, rewritten whenever a time-of-day bucket closes and on
+ * server_core_stop. Buckets follow local time. Call after
+ * server_core_enable_checkpoint / takeover and before server_core_start.
+ * Returns 1 if a model was loaded, 0 if learning from scratch, -1 on error.
+ */
+int server_core_enable_demand(const char* path);
+
+/* Publish the car status into a shared-memory segment every tick (see
+ * status_shm.h). name may be NULL for STATUS_SHM_DEFAULT_NAME. Call before
+ * server_core_start; the segment is removed by server_core_stop.
+ * Returns 0 on success, -1 on error.
+ */
+int server_core_enable_status_shm(const char* name);
+
+/* Write one line "tick car floor state dir" whenever a car changes floor,
+ * state or direction. Pass NULL to disable. The FILE stays owned by the caller.
+ */
+void server_core_set_trajectory_log(FILE* fp);
+
+/* Replay a journal into a freshly initialised (not started) core as fast as
+ * possible in virtual time, starting from the state stored in its header
+ * (a fresh core at tick 0 for journals without one). Each event is injected
+ * so that it is processed on the same tick as when it was recorded, so the
+ * same journal always produces the same car trajectories. After the last event the core keeps running
+ * until every car is idle.
+ * Returns the number of replayed events, or -1 on error.
+ */
+int server_core_replay(const char* journal_path);
+
+/* ---------------------------
+   Campus (per-building access)
+   ---------------------------
+ * A ServerCore is one building. Handles are valid until the next
+ * server_core_init / server_core_init_campus. The network thread pushes
+ * into a building through its event queue and may query its ETA table at
+ * any time; the elevator array follows the same read-only rules as
+ * server_core_get_elevators.
+ */
+typedef struct ServerCore ServerCore;
+
+int server_core_building_count(void);
+ServerCore* server_core_get(int building);   /* NULL if out of range */
+int server_core_building_id(const ServerCore* c);
+ServerEventQueue* server_core_events_of(ServerCore* c);
+Elevator* server_core_elevators_of(ServerCore* c);
+int server_core_elevator_count_of(const ServerCore* c);
+uint32_t server_core_tick_of(const ServerCore* c);
+int server_core_floor_count_of(const ServerCore* c);              // floors 0 .. n-1
+int server_core_floor_served_of(const ServerCore* c, int floor);  // any car stops there
+const char* server_core_traffic_mode_of(const ServerCore* c);      // detected traffic mode (scheduler.h)
+
+/* server_core_query_eta for one building. */
+int server_core_query_eta_of(ServerCore* c, int floor, Direction dir, int* car, double* seconds);
+
+/* Worker count of the tick pool and its rounds / steals (1, 0, 0 without a pool). */
+void server_core_get_pool_stats(int* workers, unsigned long* rounds, unsigned long* steals);
+
 #ifdef __cplusplus
 }
 #endif
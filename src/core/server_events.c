@@ -3,84 +3,196 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #include "server_events.h"
 #include <stdlib.h>
 #include <string.h>
 
+#include "elevator.h"
 #include "platform.h"
+#include "status.h"
 
-// 單向鏈結串列
-static ServerEvent* g_head = NULL;
-static ServerEvent* g_tail = NULL;
-static int g_count = 0;
-static int g_shutdown = 0;
 
-static PlatformMutex* g_mutex = NULL;
-static PlatformCond*  g_cond  = NULL;
+// 每個優先通道各一條單向鏈結串列
+typedef struct {
+    ServerEvent* head;
+    ServerEvent* tail;
+    int count;
+} EventLane;
+
+/* 一棟大樓的事件佇列 */
+struct ServerEventQueue {
+    EventLane lanes[EVT_LANE_COUNT];
+    unsigned long popped[EVT_LANE_COUNT];  // 各通道累計取出數
+    int count;     // 所有通道合計
+    int shutdown;  // 是否進入關閉狀態
+    PlatformMutex* mutex;
+    PlatformCond*  cond;
+};
+
+/* 舊介面（單一大樓）使用的預設佇列 */
+static ServerEventQueue g_default;
+
+/* 釋放所有殘留事件並清除計數（呼叫端持有 mutex 或佇列尚未共用） */
+static void clear_lanes(ServerEventQueue* q)
+{
+    for (int l = 0; l < EVT_LANE_COUNT; ++l) {
+        while (q->lanes[l].head) {
+            ServerEvent* next = q->lanes[l].head->next;
+            free(q->lanes[l].head);
+            q->lanes[l].head = next;
+        }
+        q->lanes[l].tail = NULL;
+        q->lanes[l].count = 0;
+        q->popped[l] = 0;
+    }
+    q->count = 0;
+    q->shutdown = 0;
+}
 
 /* 初始化事件佇列：建立 mutex/condvar，清除狀態 */
+// 可重複呼叫（例如同一行程內跑多個模擬），殘留事件會被釋放
 int server_events_init(void)
 {
-    g_mutex = platform_mutex_create();
-    g_cond  = platform_cond_create();
-    g_head = g_tail = NULL;
-    g_count = 0;
-    g_shutdown = 0;  // 是否進入關閉狀態
+    if (!g_default.mutex) g_default.mutex = platform_mutex_create();
+    if (!g_default.cond)  g_default.cond  = platform_cond_create();
+    clear_lanes(&g_default);
     return 0;
 }
 
+/* 建立一棟大樓的事件佇列 */
+ServerEventQueue* event_queue_create(void)
+{
+    ServerEventQueue* q = (ServerEventQueue*)calloc(1, sizeof(ServerEventQueue));
+    if (!q) return NULL;
+    q->mutex = platform_mutex_create();
+    q->cond = platform_cond_create();
+    if (!q->mutex || !q->cond) {
+        event_queue_destroy(q);
+        return NULL;
+    }
+    return q;
+}
+
+/* 釋放佇列（不可再有執行緒使用） */
+void event_queue_destroy(ServerEventQueue* q)
+{
+    if (!q || q == &g_default) return;
+    clear_lanes(q);
+    if (q->mutex) platform_mutex_destroy(q->mutex);
+    if (q->cond) platform_cond_destroy(q->cond);
+    free(q);
+}
+
+ServerEventQueue* server_events_default_queue(void)
+{
+    return &g_default;
+}
+
+/* 事件種類 => 優先通道 */
+ServerEventLane server_events_lane_of(ServerEventType type)
+{
+    switch (type) {
+        case EVT_SHUTDOWN:      return EVT_LANE_SHUTDOWN;
+        case EVT_GUARD_COMMAND: return EVT_LANE_GUARD;
+        case EVT_FLEET_COMMAND: return EVT_LANE_GUARD;
+        case EVT_INSIDE_CALL:   return EVT_LANE_CAR;
+        default:                return EVT_LANE_HALL;
+    }
+}
+
+/* 接到所屬通道尾端（呼叫端持有 mutex） */
+static void append_locked(ServerEventQueue* q, ServerEvent* ev)
+{
+    EventLane* lane = &q->lanes[server_events_lane_of(ev->type)];
+    // tail 非空 => 接在後面
+    // tail 空 => 空通道 => 直接為第一個
+    if (lane->tail) lane->tail->next = ev;
+    else lane->head = ev;
+    lane->tail = ev;
+    lane->count++;
+    q->count++;
+}
+
+/* 從指定通道頭取出（呼叫端持有 mutex） */
+static ServerEvent* take_locked(ServerEventQueue* q, ServerEventLane l)
+{
+    EventLane* lane = &q->lanes[l];
+    ServerEvent* ev = lane->head;
+    if (!ev) return NULL;
+    lane->head = ev->next;
+    if (lane->head == NULL) lane->tail = NULL;
+    ev->next = NULL;
+    lane->count--;
+    q->count--;
+    q->popped[l]++;
+    return ev;
+}
+
+/* 取出優先度最高的非空通道的頭（呼叫端持有 mutex） */
+static ServerEvent* take_first_locked(ServerEventQueue* q)
+{
+    for (int l = 0; l < EVT_LANE_COUNT; ++l) {
+        if (q->lanes[l].head) return take_locked(q, (ServerEventLane)l);
+    }
+    return NULL;
+}
+
 /* 遞送關閉事件，喚醒等待中的執行緒，並設置 shutdown 標記 */
-void server_events_shutdown(void)
+void event_queue_shutdown(ServerEventQueue* q)
 {
-    platform_mutex_lock(g_mutex);
-    g_shutdown = 1;
+    if (!q || !q->mutex) return;
+    platform_mutex_lock(q->mutex);
+    q->shutdown = 1;
 
     // 建立一個新事件
     ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
     if(ev){
         ev->type = EVT_SHUTDOWN;
-        // tail 非空 => 接在後面
-        // tail 空 => 空佇列 => 直接為第一個
-        if(g_tail) g_tail->next = ev;
-        else g_head = ev;
-        g_tail = ev;
-        g_count++;
+        append_locked(q, ev);
     }
     // 喚醒所有呼叫 server_events_pop() 並在等待中的執行緒
-    platform_cond_broadcast(g_cond);
-    
-    platform_mutex_unlock(g_mutex);
+    platform_cond_broadcast(q->cond);
+
+    platform_mutex_unlock(q->mutex);
 }
 
 /* 將事件加入佇列中 */
-static int push_event(ServerEvent* ev)
+static int push_event(ServerEventQueue* q, ServerEvent* ev)
 {
     if(!ev) return -1;
+    if(!q || !q->mutex){
+        free(ev);
+        return -1;
+    }
     ev->next = NULL;
-    platform_mutex_lock(g_mutex);
+    platform_mutex_lock(q->mutex);
 
-    if(g_shutdown){
-        platform_mutex_unlock(g_mutex);
+    if(q->shutdown){
+        platform_mutex_unlock(q->mutex);
         free(ev);
         return -1;
     }
-    if(g_tail) g_tail->next = ev;
-    else g_head = ev;
-    g_tail = ev;
-    g_count++;
+    // 按鈕通道有上限：寧可在入口拒絕，也不要收下之後做不完
+    ServerEventLane lane = server_events_lane_of(ev->type);
+    if((lane == EVT_LANE_CAR || lane == EVT_LANE_HALL) && q->lanes[lane].count >= SERVER_EVENTS_LANE_CAPACITY){
+        platform_mutex_unlock(q->mutex);
+        free(ev);
+        return ELEV_ERR_FULL;
+    }
+    append_locked(q, ev);
     // 喚醒單一等待中的執行緒
-    platform_cond_signal(g_cond);
+    platform_cond_signal(q->cond);
 
-    platform_mutex_unlock(g_mutex);
+    platform_mutex_unlock(q->mutex);
     return 0;
 }
 
-/* 推入外呼事件（樓層 + 方向 + client id） */
-int server_events_push_outside(int floor, int direction, int client_id)
+/* 推入帶請求 ID 的外呼事件（樓層 + 方向 + client id；ID 非 0 => 要回報生命週期） */
+int event_queue_push_outside(ServerEventQueue* q, int floor, int direction, int client_id, unsigned request_id)
 {
     ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
     if(!ev) return -1;
@@ -88,11 +200,27 @@ int server_events_push_outside(int floor, int direction, int client_id)
     ev->v.outside_call.floor = floor;
     ev->v.outside_call.direction = direction;
     ev->v.outside_call.client_id = client_id;
-    return push_event(ev);
+    ev->v.outside_call.request_id = request_id;
+    ev->v.outside_call.to_floor = -1;
+    return push_event(q, ev);
+}
+
+/* 推入目的樓層外呼（方向由起訖樓層決定） */
+int event_queue_push_destination(ServerEventQueue* q, int floor, int to_floor, int client_id, unsigned request_id)
+{
+    ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
+    if(!ev) return -1;
+    ev->type = EVT_OUTSIDE_CALL;
+    ev->v.outside_call.floor = floor;
+    ev->v.outside_call.direction = (to_floor > floor) ? DIR_UP : DIR_DOWN;
+    ev->v.outside_call.client_id = client_id;
+    ev->v.outside_call.request_id = request_id;
+    ev->v.outside_call.to_floor = to_floor;
+    return push_event(q, ev);
 }
 
 /* 推入內呼事件（電梯 id + 目的樓層 + client id） */
-int server_events_push_inside(int elevator_id, int dest_floor, int client_id)
+int event_queue_push_inside(ServerEventQueue* q, int elevator_id, int dest_floor, int client_id)
 {
     ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
     if(!ev) return -1;
@@ -100,12 +228,13 @@ int server_events_push_inside(int elevator_id, int dest_floor, int client_id)
     ev->v.inside_call.elevator_id = elevator_id;
     ev->v.inside_call.dest_floor = dest_floor;
     ev->v.inside_call.client_id = client_id;
-    return push_event(ev);
+    return push_event(q, ev);
 }
 
 /* 推入警衛指令事件（強制移動、額外資訊等） */
-int server_events_push_guard(int elevator_id, int floor, int force, int client_id, const char* extra)
+int event_queue_push_guard(ServerEventQueue* q, int elevator_id, int floor, int force, int client_id, const char* extra)
 {
+    (void)extra;
     ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
     if(!ev) return -1;
     ev->type = EVT_GUARD_COMMAND;
@@ -113,64 +242,82 @@ int server_events_push_guard(int elevator_id, int floor, int force, int client_i
     ev->v.guard_cmd.floor = floor;
     ev->v.guard_cmd.force = force;
     ev->v.guard_cmd.client_id = client_id;
-    return push_event(ev);
+    return push_event(q, ev);
+}
+
+/* 推入車隊調整事件（FleetOp + 電梯 id + client id） */
+int event_queue_push_fleet(ServerEventQueue* q, int op, int elevator_id, int client_id)
+{
+    ServerEvent* ev = (ServerEvent*)calloc(1, sizeof(ServerEvent));
+    if(!ev) return -1;
+    ev->type = EVT_FLEET_COMMAND;
+    ev->v.fleet_cmd.op = op;
+    ev->v.fleet_cmd.elevator_id = elevator_id;
+    ev->v.fleet_cmd.client_id = client_id;
+    return push_event(q, ev);
 }
 
 /* 阻塞式取出事件 */
 // 若事件為空 => 等待
 // 若 shutdown => 回傳錯誤（-1）
-int server_events_pop(ServerEvent** out_event)
+int event_queue_pop(ServerEventQueue* q, ServerEvent** out_event)
 {
-    if(!out_event) return -1;
-    platform_mutex_lock(g_mutex);
+    if(!q || !q->mutex || !out_event) return -1;
+    platform_mutex_lock(q->mutex);
 
     // 沒有事件 + 沒有要關閉 => 等
-    while(g_count == 0 && !g_shutdown){
-        platform_cond_wait(g_cond, g_mutex);
+    while(q->count == 0 && !q->shutdown){
+        platform_cond_wait(q->cond, q->mutex);
     }
 
-    if(g_count == 0 && g_shutdown){
-        platform_mutex_unlock(g_mutex);
+    if(q->count == 0 && q->shutdown){
+        platform_mutex_unlock(q->mutex);
         return -1;
     }
 
-    ServerEvent* ev = g_head;
+    ServerEvent* ev = take_first_locked(q);
     if(!ev){
-        platform_mutex_unlock(g_mutex);
+        platform_mutex_unlock(q->mutex);
         return -1;
     }
-    g_head = ev->next;
-    if(g_head == NULL) g_tail = NULL;
-    ev->next = NULL;
-    g_count--;
 
-    platform_mutex_unlock(g_mutex);
+    platform_mutex_unlock(q->mutex);
     *out_event = ev;
     return 0;
 }
 
 /* 非阻塞取出事件 */
-int server_events_try_pop(ServerEvent** out_event)
+int event_queue_try_pop(ServerEventQueue* q, ServerEvent** out_event)
 {
-    if(!out_event) return -1;
-    platform_mutex_lock(g_mutex);
+    if(!q || !q->mutex || !out_event) return -1;
+    platform_mutex_lock(q->mutex);
 
-    if(g_count == 0){
-        platform_mutex_unlock(g_mutex);
+    if(q->count == 0){
+        platform_mutex_unlock(q->mutex);
         return -1;
     }
 
-    ServerEvent* ev = g_head;
+    ServerEvent* ev = take_first_locked(q);
     if(!ev){
-        platform_mutex_unlock(g_mutex);
+        platform_mutex_unlock(q->mutex);
         return -1;
     }
-    g_head = ev->next;
-    if(g_head == NULL) g_tail = NULL;
-    ev->next = NULL;
-    g_count--;
 
-    platform_mutex_unlock(g_mutex);
+    platform_mutex_unlock(q->mutex);
+    *out_event = ev;
+    return 0;
+}
+
+/* 只從指定通道非阻塞取出（核心依通道預算分批處理用） */
+int event_queue_try_pop_lane(ServerEventQueue* q, ServerEventLane lane, ServerEvent** out_event)
+{
+    if(!q || !q->mutex || !out_event || lane < 0 || lane >= EVT_LANE_COUNT) return -1;
+    platform_mutex_lock(q->mutex);
+
+    ServerEvent* ev = take_locked(q, lane);
+
+    platform_mutex_unlock(q->mutex);
+    if(!ev) return -1;
     *out_event = ev;
     return 0;
 }
@@ -183,13 +330,107 @@ void server_events_free(ServerEvent* ev)
 }
 
 /* 查詢目前佇列內事件數量 */
-int server_events_count(void)
+int event_queue_count(ServerEventQueue* q)
+{
+    if(!q || !q->mutex) return 0;
+    // 避免讀 count 時被另一個執行緒同時 push/pop
+    platform_mutex_lock(q->mutex);
+
+    int c = q->count;
+
+    platform_mutex_unlock(q->mutex);
+    return c;
+}
+
+/* 查詢單一通道內事件數量 */
+int event_queue_lane_count(ServerEventQueue* q, ServerEventLane lane)
+{
+    if(!q || !q->mutex || lane < 0 || lane >= EVT_LANE_COUNT) return 0;
+    platform_mutex_lock(q->mutex);
+
+    int c = q->lanes[lane].count;
+
+    platform_mutex_unlock(q->mutex);
+    return c;
+}
+
+/* 查詢單一通道累計取出數 */
+unsigned long event_queue_lane_popped(ServerEventQueue* q, ServerEventLane lane)
 {
-    // 避免讀 g_count 時被另一個執行緒同時 push/pop
-    platform_mutex_lock(g_mutex);
+    if(!q || !q->mutex || lane < 0 || lane >= EVT_LANE_COUNT) return 0;
+    platform_mutex_lock(q->mutex);
 
-    int c = g_count;
+    unsigned long c = q->popped[lane];
 
-    platform_mutex_unlock(g_mutex);
+    platform_mutex_unlock(q->mutex);
     return c;
 }
+
+/* ---------------------------
+   Default queue (single building)
+   --------------------------- */
+
+void server_events_shutdown(void)
+{
+    event_queue_shutdown(&g_default);
+}
+
+int server_events_push_outside(int floor, int direction, int client_id)
+{
+    return event_queue_push_outside(&g_default, floor, direction, client_id, 0);
+}
+
+int server_events_push_outside_tracked(int floor, int direction, int client_id, unsigned request_id)
+{
+    return event_queue_push_outside(&g_default, floor, direction, client_id, request_id);
+}
+
+int server_events_push_destination(int floor, int to_floor, int client_id, unsigned request_id)
+{
+    return event_queue_push_destination(&g_default, floor, to_floor, client_id, request_id);
+}
+
+int server_events_push_inside(int elevator_id, int dest_floor, int client_id)
+{
+    return event_queue_push_inside(&g_default, elevator_id, dest_floor, client_id);
+}
+
+int server_events_push_guard(int elevator_id, int floor, int force, int client_id, const char* extra)
+{
+    return event_queue_push_guard(&g_default, elevator_id, floor, force, client_id, extra);
+}
+
+int server_events_push_fleet(int op, int elevator_id, int client_id)
+{
+    return event_queue_push_fleet(&g_default, op, elevator_id, client_id);
+}
+
+int server_events_pop(ServerEvent** out_event)
+{
+    return event_queue_pop(&g_default, out_event);
+}
+
+int server_events_try_pop(ServerEvent** out_event)
+{
+    return event_queue_try_pop(&g_default, out_event);
+}
+
+int server_events_try_pop_lane(ServerEventLane lane, ServerEvent** out_event)
+{
+    return event_queue_try_pop_lane(&g_default, lane, out_event);
+}
+
+int server_events_count(void)
+{
+    return event_queue_count(&g_default);
+}
+
+int server_events_lane_count(ServerEventLane lane)
+{
+    return event_queue_lane_count(&g_default, lane);
+}
+
+unsigned long server_events_lane_popped(ServerEventLane lane)
+{
+    return event_queue_lane_popped(&g_default, lane);
+}
@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifndef SERVER_EVENTS_H
@@ -22,9 +22,24 @@ typedef enum {
     EVT_OUTSIDE_CALL,   // 外呼：呼叫樓層、呼叫方向、client id
     EVT_INSIDE_CALL,    // 內呼：電梯 ID、目標樓層、client id
     EVT_GUARD_COMMAND,  // Guard 指令（force assign, maintenance, etc.）: 使用 payload
-    EVT_SHUTDOWN        // 用來通知 consumer 停止
+    EVT_SHUTDOWN,       // 用來通知 consumer 停止
+    EVT_FLEET_COMMAND   // 車隊調整：加入 / 移除電梯、停用 / 恢復（走警衛通道）
 } ServerEventType;
 
+/* 內呼／外呼通道的容量上限，滿了 push 回傳 ELEV_ERR_FULL（關閉與警衛通道不設限） */
+#ifndef SERVER_EVENTS_LANE_CAPACITY
+#define SERVER_EVENTS_LANE_CAPACITY 1024
+#endif
+
+/* 優先通道：數字越小越先被取出 */
+typedef enum {
+    EVT_LANE_SHUTDOWN = 0,  // 關閉
+    EVT_LANE_GUARD,         // 警衛／緊急指令
+    EVT_LANE_CAR,           // 內呼
+    EVT_LANE_HALL,          // 外呼
+    EVT_LANE_COUNT
+} ServerEventLane;
+
 /* 警衛指令 */
 typedef struct {
     int elevator_id;
@@ -33,6 +48,20 @@ typedef struct {
     int client_id;
 } GuardCommand;
 
+/* 車隊調整指令 */
+typedef enum {
+    FLEET_ADD_CAR = 1,     // 啟用下一個預留的電梯井
+    FLEET_REMOVE_CAR,      // 移除最後一台（須已停用且閒置）
+    FLEET_OUT_OF_SERVICE,  // 停用：外呼立即改派給其他電梯
+    FLEET_IN_SERVICE       // 恢復服務
+} FleetOp;
+
+typedef struct {
+    int op;           // FleetOp
+    int elevator_id;  // ADD 時忽略
+    int client_id;
+} FleetCommand;
+
 // 通用事件結構
 typedef struct ServerEvent {
     ServerEventType type;
@@ -41,6 +70,8 @@ typedef struct ServerEvent {
             int floor;      // 在幾樓
             int direction;  // 按上／按下
             int client_id;
+            unsigned request_id;  // 非 0 => client 有訂閱生命週期通知（目的樓層外呼：回報要搭哪台）
+            int to_floor;   // 目的樓層（-1 = 只按方向）
         } outside_call;
         struct {
             int elevator_id;  // 哪台電梯
@@ -48,6 +79,7 @@ typedef struct ServerEvent {
             int client_id;
         } inside_call;
         GuardCommand guard_cmd;
+        FleetCommand fleet_cmd;
     } v;
 
     // 串列節點
@@ -57,16 +89,70 @@ typedef struct ServerEvent {
 int server_events_init(void);
 void server_events_shutdown(void);
 
+/* Push helpers return 0 (ELEV_OK), ELEV_ERR_FULL when the car-call or
+ * hall-call lane already holds SERVER_EVENTS_LANE_CAPACITY events, or -1
+ * after shutdown / on allocation failure. An accepted event is never dropped.
+ */
 int server_events_push_outside(int floor, int direction, int client_id);
+/* Same, tagged with a network-assigned request id; the core then reports
+ * ASSIGNED / ARRIVING / SERVED for it through core_notify. */
+int server_events_push_outside_tracked(int floor, int direction, int client_id, unsigned request_id);
+/* Destination call (CALL <from> <to>): the direction follows from the two
+ * floors; the core groups such calls by destination and, for request_id != 0,
+ * answers with NOTICE_BOARD (core_notify.h). */
+int server_events_push_destination(int floor, int to_floor, int client_id, unsigned request_id);
 int server_events_push_inside(int elevator_id, int dest_floor, int client_id);
 int server_events_push_guard(int elevator_id, int floor, int force, int client_id, const char* extra);
+/* Fleet change (FleetOp) on the guard lane; the core answers with a
+ * NOTICE_FLEET through core_notify. */
+int server_events_push_fleet(int op, int elevator_id, int client_id);
 
+/* Events are kept in one FIFO per lane. pop/try_pop take the head of the
+ * highest-priority non-empty lane, so a guard command never waits behind
+ * queued button presses; order within a lane is preserved.
+ */
 int server_events_pop(ServerEvent** out_event);      // 阻塞式
 int server_events_try_pop(ServerEvent** out_event);  // 非阻塞式
 
+/* Non-blocking pop from one lane only. Returns 0 or -1 if that lane is empty. */
+int server_events_try_pop_lane(ServerEventLane lane, ServerEvent** out_event);
+
+/* Lane an event type is queued on. */
+ServerEventLane server_events_lane_of(ServerEventType type);
+
 void server_events_free(ServerEvent* ev);
 
-int server_events_count(void);
+int server_events_count(void);                       // 所有通道合計
+int server_events_lane_count(ServerEventLane lane);
+
+/* Events popped from a lane since init (drain-rate estimates). */
+unsigned long server_events_lane_popped(ServerEventLane lane);
+
+/* ---------------------------
+   Per-building queues
+   ---------------------------
+ * The server_events_* functions above operate on one process-wide default
+ * queue (building 0). A campus core owns one ServerEventQueue per building;
+ * the event_queue_* functions are the same operations on an explicit queue.
+ */
+typedef struct ServerEventQueue ServerEventQueue;
+
+ServerEventQueue* event_queue_create(void);
+void event_queue_destroy(ServerEventQueue* q);      // default queue is ignored
+ServerEventQueue* server_events_default_queue(void);
+
+void event_queue_shutdown(ServerEventQueue* q);
+int event_queue_push_outside(ServerEventQueue* q, int floor, int direction, int client_id, unsigned request_id);
+int event_queue_push_destination(ServerEventQueue* q, int floor, int to_floor, int client_id, unsigned request_id);
+int event_queue_push_inside(ServerEventQueue* q, int elevator_id, int dest_floor, int client_id);
+int event_queue_push_guard(ServerEventQueue* q, int elevator_id, int floor, int force, int client_id, const char* extra);
+int event_queue_push_fleet(ServerEventQueue* q, int op, int elevator_id, int client_id);
+int event_queue_pop(ServerEventQueue* q, ServerEvent** out_event);
+int event_queue_try_pop(ServerEventQueue* q, ServerEvent** out_event);
+int event_queue_try_pop_lane(ServerEventQueue* q, ServerEventLane lane, ServerEvent** out_event);
+int event_queue_count(ServerEventQueue* q);
+int event_queue_lane_count(ServerEventQueue* q, ServerEventLane lane);
+unsigned long event_queue_lane_popped(ServerEventQueue* q, ServerEventLane lane);
 
 #ifdef __cplusplus
 }
@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/12/02
-// Update Date: 2025/12/02
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 /* Return code convention:
@@ -23,6 +23,7 @@ typedef enum {
 typedef enum {
     ELEV_ERR_INVALID   = -1,  /* invalid argument (null pointer, out-of-range) */
     ELEV_ERR_FULL      = -2,  /* queue full or no resource */
-    ELEV_ERR_INTERNAL  = -3   /* internal error */
+    ELEV_ERR_INTERNAL  = -3,  /* internal error */
+    ELEV_ERR_BUSY      = -4   /* resource still in use (e.g. car carrying passengers) */
     /* ... add other negative error codes ... */
 } ElevStatus_Neg;
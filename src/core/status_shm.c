@@ -0,0 +1,187 @@
+/* ----- ----- ----- ----- */
+// status_shm.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include "status_shm.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+#define STATUS_SHM_READ_RETRIES 64
+
+struct StatusShm {
+    PlatformMap* map;
+    StatusShmSegment* seg;
+    char name[64];
+};
+
+struct StatusShmReader {
+    PlatformMap* map;
+    const StatusShmSegment* seg;
+    uint32_t last_seq;
+};
+
+/* ---------------------------
+   Writer
+   --------------------------- */
+
+/* 將 bool 旗標陣列壓成位元集合 */
+static void pack_bits(uint8_t* out, const bool* flags, int floors) {
+    memset(out, 0, STATUS_SHM_FLOOR_BYTES);
+    for (int f = 0; f < floors; ++f) {
+        if (flags[f]) out[f >> 3] |= (uint8_t)(1u << (f & 7));
+    }
+}
+
+/* 建立共享記憶體區段並寫好檔頭 */
+StatusShm* status_shm_create(const char* name)
+{
+    if (!name) name = STATUS_SHM_DEFAULT_NAME;
+    if (strlen(name) >= sizeof(((StatusShm*)0)->name)) return NULL;
+
+    PlatformMap* map = platform_shm_open(name, sizeof(StatusShmSegment), 1);
+    if (!map) return NULL;
+
+    StatusShm* shm = (StatusShm*)calloc(1, sizeof(StatusShm));
+    if (!shm) {
+        platform_map_close(map);
+        return NULL;
+    }
+    shm->map = map;
+    shm->seg = (StatusShmSegment*)platform_map_data(map);
+    strcpy(shm->name, name);
+
+    // 先讓 seq 變奇數，讀者在檔頭寫好之前不會讀到半成品
+    StatusShmHeader* h = &shm->seg->header;
+    h->seq = (h->seq | 1u);
+    platform_memory_fence();
+    h->magic = STATUS_SHM_MAGIC;
+    h->version = STATUS_SHM_VERSION;
+    h->header_size = (uint32_t)sizeof(StatusShmHeader);
+    h->record_size = (uint32_t)sizeof(StatusShmCar);
+    h->car_count = 0;
+    h->floor_count = MAX_FLOORS;
+    h->tick = 0;
+    h->publish_ms = 0;
+    platform_memory_fence();
+    h->seq = h->seq + 1;
+    return shm;
+}
+
+/* 發布一次快照（seqlock 寫入） */
+void status_shm_publish(StatusShm* shm, const Elevator* elevators, int count, uint32_t tick)
+{
+    if (!shm || !elevators) return;
+    if (count < 0) count = 0;
+    if (count > MAX_ELEVATORS) count = MAX_ELEVATORS;
+
+    StatusShmSegment* seg = shm->seg;
+    seg->header.seq = seg->header.seq + 1;  // 奇數：寫入中
+    platform_memory_fence();
+
+    for (int i = 0; i < count; ++i) {
+        const Elevator* e = &elevators[i];
+        StatusShmCar* c = &seg->cars[i];
+        c->id = e->id;
+        c->current_floor = e->current_floor;
+        c->target_floor = e->target_floor;
+        c->task_state = (int32_t)e->task_state;
+        c->direction = (int32_t)e->direction;
+        c->door_remaining_ms = (int32_t)(e->door_timer_s * 1000.0);
+        pack_bits(c->call_up, e->call_up, e->floors);
+        pack_bits(c->call_down, e->call_down, e->floors);
+        pack_bits(c->inside, e->inside, e->floors);
+    }
+    seg->header.car_count = (uint32_t)count;
+    if (count > 0) seg->header.floor_count = (uint32_t)elevators[0].floors;  // 大樓實際樓層數
+    seg->header.tick = tick;
+    seg->header.publish_ms = platform_time_ms();
+
+    platform_memory_fence();
+    seg->header.seq = seg->header.seq + 1;  // 偶數：完成
+}
+
+void status_shm_destroy(StatusShm* shm)
+{
+    if (!shm) return;
+    platform_map_close(shm->map);
+    platform_shm_unlink(shm->name);
+    free(shm);
+}
+
+/* 只解除對應，區段留給接手的行程 */
+void status_shm_detach(StatusShm* shm)
+{
+    if (!shm) return;
+    platform_map_close(shm->map);
+    free(shm);
+}
+
+/* ---------------------------
+   Reader
+   --------------------------- */
+
+/* 以唯讀方式開啟既有區段並檢查版本 */
+StatusShmReader* status_shm_reader_open(const char* name)
+{
+    if (!name) name = STATUS_SHM_DEFAULT_NAME;
+    PlatformMap* map = platform_shm_open(name, sizeof(StatusShmSegment), 0);
+    if (!map) return NULL;
+
+    const StatusShmSegment* seg = (const StatusShmSegment*)platform_map_data(map);
+    if (seg->header.magic != STATUS_SHM_MAGIC ||
+        seg->header.version != STATUS_SHM_VERSION ||
+        seg->header.header_size != sizeof(StatusShmHeader) ||
+        seg->header.record_size != sizeof(StatusShmCar)) {
+        platform_map_close(map);
+        return NULL;
+    }
+
+    StatusShmReader* r = (StatusShmReader*)calloc(1, sizeof(StatusShmReader));
+    if (!r) {
+        platform_map_close(map);
+        return NULL;
+    }
+    r->map = map;
+    r->seg = seg;
+    r->last_seq = 0;
+    return r;
+}
+
+/* 讀取一致的快照（seqlock 讀取） */
+int status_shm_read(StatusShmReader* r, StatusShmSegment* out)
+{
+    if (!r || !out) return -1;
+    for (int attempt = 0; attempt < STATUS_SHM_READ_RETRIES; ++attempt) {
+        uint32_t s1 = r->seg->header.seq;
+        platform_memory_fence();
+        if (s1 & 1u) continue;            // 正在寫入
+        if (s1 == r->last_seq) return 0;  // 沒有新資料
+
+        uint32_t n = r->seg->header.car_count;
+        if (n > MAX_ELEVATORS) n = MAX_ELEVATORS;
+        memcpy(&out->header, (const void*)&r->seg->header, sizeof(StatusShmHeader));
+        memcpy(out->cars, r->seg->cars, n * sizeof(StatusShmCar));
+
+        platform_memory_fence();
+        if (r->seg->header.seq != s1) continue;  // 讀取期間被改寫 => 重試
+
+        out->header.car_count = n;
+        r->last_seq = s1;
+        return 1;
+    }
+    return -1;
+}
+
+void status_shm_reader_close(StatusShmReader* r)
+{
+    if (!r) return;
+    platform_map_close(r->map);
+    free(r);
+}
@@ -0,0 +1,115 @@
+/* ----- ----- ----- ----- */
+// status_shm.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#ifndef STATUS_SHM_H
+#define STATUS_SHM_H
+
+#include <stdint.h>
+
+#include "elevator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-tick car status published into a named shared-memory segment, so
+ * displays and hall lanterns on the same host can poll it without a TCP
+ * connection. The segment is written by the core thread only; any number of
+ * processes may read it.
+ *
+ * Consistency uses a seqlock: the writer makes `seq` odd, updates the
+ * records, then makes it even again. A reader copies the segment and retries
+ * if `seq` was odd or changed during the copy.
+ *
+ * The layout is fixed and versioned. Readers must check magic, version and
+ * the two size fields before trusting the records.
+ */
+
+#define STATUS_SHM_DEFAULT_NAME "/elevator_status"
+#define STATUS_SHM_MAGIC 0x4D485345u  /* "ESHM" */
+#define STATUS_SHM_VERSION 2  /* v2: raised car / floor ceilings, floor_count from the building */
+#define STATUS_SHM_FLOOR_BYTES (((MAX_FLOORS + 63) / 64) * 8)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;     /* sizeof(StatusShmHeader) */
+    uint32_t record_size;     /* sizeof(StatusShmCar) */
+    volatile uint32_t seq;    /* seqlock counter, odd while writing */
+    uint32_t car_count;
+    uint32_t floor_count;     /* floors of the building (bits beyond are 0) */
+    uint32_t tick;
+    int64_t publish_ms;       /* platform_time_ms() of the writer */
+} StatusShmHeader;
+
+typedef struct {
+    int32_t id;
+    int32_t current_floor;
+    int32_t target_floor;
+    int32_t task_state;       /* TaskState */
+    int32_t direction;        /* Direction */
+    int32_t door_remaining_ms;
+    uint8_t call_up[STATUS_SHM_FLOOR_BYTES];    /* bit f = floor f */
+    uint8_t call_down[STATUS_SHM_FLOOR_BYTES];
+    uint8_t inside[STATUS_SHM_FLOOR_BYTES];
+} StatusShmCar;
+
+typedef struct {
+    StatusShmHeader header;
+    StatusShmCar cars[MAX_ELEVATORS];
+} StatusShmSegment;
+
+/* Test one floor bit of a call_up / call_down / inside bitset. */
+#define STATUS_SHM_BIT(bits, floor) (((bits)[(floor) >> 3] >> ((floor) & 7)) & 1u)
+
+/* ---------------------------
+   Writer (core side)
+   --------------------------- */
+
+typedef struct StatusShm StatusShm;
+
+/* Create (or reuse) the segment. Returns NULL on error. */
+StatusShm* status_shm_create(const char* name);
+
+/* Publish one snapshot. */
+void status_shm_publish(StatusShm* shm, const Elevator* elevators, int count, uint32_t tick);
+
+/* Unmap and remove the segment. */
+void status_shm_destroy(StatusShm* shm);
+
+/* Unmap but keep the segment: after a hot upgrade the new process publishes
+ * into the same name, so the old one must not remove it.
+ */
+void status_shm_detach(StatusShm* shm);
+
+/* ---------------------------
+   Reader (display side)
+   --------------------------- */
+
+typedef struct StatusShmReader StatusShmReader;
+
+/* Open an existing segment read-only. Returns NULL if it does not exist or
+ * has an incompatible layout.
+ */
+StatusShmReader* status_shm_reader_open(const char* name);
+
+/* Copy a consistent snapshot into `out`.
+ * Returns 1 if the snapshot is newer than the previous call, 0 if nothing
+ * changed (out is left untouched), -1 if the writer did not settle within the
+ * retry budget.
+ */
+int status_shm_read(StatusShmReader* r, StatusShmSegment* out);
+
+void status_shm_reader_close(StatusShmReader* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATUS_SHM_H */
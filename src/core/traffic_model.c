@@ -0,0 +1,238 @@
+/* ----- ----- ----- ----- */
+// traffic_model.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "traffic_model.h"
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+#include "server_events.h"
+
+#define TRAFFIC_PI 3.14159265358979323846
+#define TRAFFIC_BASE_SHAPE 0.2  /* 曲線外（或離峰）時的到達率比例 */
+
+/* ---------------------------
+   PRNG（splitmix64 播種 + xorshift64*）
+   --------------------------- */
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t rng_next(uint64_t* s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+/* [0, 1) 均勻分布 */
+static double rng_uniform(uint64_t* s) {
+    return (double)(rng_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ---------------------------
+   Pattern tables
+   --------------------------- */
+
+/* 起點為大廳的比例 */
+static double lobby_origin_share(TrafficPattern p) {
+    switch (p) {
+        case TRAFFIC_UP_PEAK:   return 0.85;
+        case TRAFFIC_DOWN_PEAK: return 0.05;
+        case TRAFFIC_LUNCH:     return 0.40;
+        default:                return -1.0;  // 均勻
+    }
+}
+
+/* 非大廳乘客前往大廳的比例 */
+static double lobby_dest_share(TrafficPattern p) {
+    switch (p) {
+        case TRAFFIC_UP_PEAK:   return 0.30;
+        case TRAFFIC_DOWN_PEAK: return 0.90;
+        case TRAFFIC_LUNCH:     return 0.60;
+        default:                return -1.0;  // 均勻
+    }
+}
+
+/* 到達率曲線形狀（0..1） */
+static double rate_shape(TrafficPattern p, double t, double duration) {
+    if (p == TRAFFIC_INTERFLOOR) return 1.0;
+    if (duration <= 0.0 || t < 0.0 || t > duration) return TRAFFIC_BASE_SHAPE;
+    return TRAFFIC_BASE_SHAPE + (1.0 - TRAFFIC_BASE_SHAPE) * sin(TRAFFIC_PI * t / duration);
+}
+
+/* ---------------------------
+   Model
+   --------------------------- */
+
+/* 初始化產生器並建立起點累積分布 */
+void traffic_init(TrafficModel* m, TrafficPattern pattern, int floors, int lobby,
+                  double rate_per_min, double duration_s, uint64_t seed)
+{
+    if (!m) return;
+    memset(m, 0, sizeof(*m));
+    if (floors < 2) floors = 2;
+    if (floors > MAX_FLOORS) floors = MAX_FLOORS;
+    if (lobby < 0 || lobby >= floors) lobby = 0;
+
+    m->pattern = pattern;
+    m->floors = floors;
+    m->lobby = lobby;
+    m->peak_rate_s = (rate_per_min > 0.0) ? rate_per_min / 60.0 : 0.0;
+    m->duration_s = duration_s;
+    m->rng = splitmix64(seed);
+    if (m->rng == 0) m->rng = 1;  // xorshift 不能是 0
+    m->t = 0.0;
+
+    double share = lobby_origin_share(pattern);
+    double acc = 0.0;
+    for (int f = 0; f < floors; ++f) {
+        double w;
+        if (share < 0.0) w = 1.0 / floors;
+        else if (f == lobby) w = share;
+        else w = (1.0 - share) / (floors - 1);
+        acc += w;
+        m->origin_cdf[f] = acc;
+    }
+    m->origin_cdf[floors - 1] = 1.0;
+}
+
+double traffic_rate(const TrafficModel* m, double t)
+{
+    if (!m) return 0.0;
+    return m->peak_rate_s * rate_shape(m->pattern, t, m->duration_s);
+}
+
+/* 起訖矩陣的一個元素 */
+double traffic_od_probability(const TrafficModel* m, int from, int to)
+{
+    if (!m || from < 0 || to < 0 || from >= m->floors || to >= m->floors || from == to) return 0.0;
+    int others = m->floors - 1;  // 可前往的樓層數
+
+    double share = lobby_dest_share(m->pattern);
+    if (from == m->lobby || share < 0.0 || others == 1) return 1.0 / others;
+    // 非大廳出發：一部分去大廳，其餘平均分到其他樓層
+    if (to == m->lobby) return share;
+    return (1.0 - share) / (others - 1);
+}
+
+/* 依起點抽目的樓層 */
+static int sample_destination(TrafficModel* m, int from)
+{
+    double u = rng_uniform(&m->rng);
+    double acc = 0.0;
+    int last = -1;
+    for (int to = 0; to < m->floors; ++to) {
+        double p = traffic_od_probability(m, from, to);
+        if (p <= 0.0) continue;
+        acc += p;
+        last = to;
+        if (u < acc) return to;
+    }
+    return last;  // 浮點誤差
+}
+
+/* 產生下一位乘客（thinning 法處理隨時間變化的到達率） */
+void traffic_next(TrafficModel* m, TrafficArrival* out)
+{
+    if (!m || !out) return;
+    double lambda_max = m->peak_rate_s;
+    if (lambda_max <= 0.0) lambda_max = 1e-9;
+
+    for (;;) {
+        double u = rng_uniform(&m->rng);
+        m->t += -log(1.0 - u) / lambda_max;
+        if (rng_uniform(&m->rng) * lambda_max <= traffic_rate(m, m->t)) break;
+    }
+
+    double u = rng_uniform(&m->rng);
+    int from = 0;
+    while (from < m->floors - 1 && u >= m->origin_cdf[from]) from++;
+
+    out->time_s = m->t;
+    out->from_floor = from;
+    out->to_floor = sample_destination(m, from);
+}
+
+/* 把 until_s 之前的所有到達送給 sink */
+int traffic_drive_until(TrafficModel* m, double until_s, traffic_sink_fn sink, void* user)
+{
+    if (!m) return 0;
+    int n = 0;
+    for (;;) {
+        if (!m->has_lookahead) {
+            traffic_next(m, &m->lookahead);
+            m->has_lookahead = 1;
+        }
+        if (m->lookahead.time_s > until_s) break;
+        if (sink) sink(&m->lookahead, user);
+        m->has_lookahead = 0;
+        n++;
+    }
+    return n;
+}
+
+/* ---------------------------
+   Sinks and recorded streams
+   --------------------------- */
+
+/* 直接推入核心事件佇列（外呼只帶方向） */
+void traffic_sink_push_events(const TrafficArrival* a, void* user)
+{
+    if (!a || a->from_floor == a->to_floor) return;
+    int client_id = user ? *(const int*)user : -1;
+    int dir = (a->to_floor > a->from_floor) ? DIR_UP : DIR_DOWN;
+    server_events_push_outside(a->from_floor, dir, client_id);
+}
+
+void traffic_sink_record(const TrafficArrival* a, void* user)
+{
+    traffic_write_arrival((FILE*)user, a);
+}
+
+int traffic_write_arrival(FILE* fp, const TrafficArrival* a)
+{
+    if (!fp || !a) return -1;
+    return (fprintf(fp, "%.3f %d %d\n", a->time_s, a->from_floor, a->to_floor) > 0) ? 0 : -1;
+}
+
+int traffic_read_arrival(FILE* fp, TrafficArrival* a)
+{
+    if (!fp || !a) return 0;
+    return (fscanf(fp, "%lf %d %d", &a->time_s, &a->from_floor, &a->to_floor) == 3) ? 1 : 0;
+}
+
+/* ---------------------------
+   Names
+   --------------------------- */
+
+static const char* const k_pattern_names[TRAFFIC_PATTERN_COUNT] = {
+    "uppeak", "downpeak", "lunch", "interfloor"
+};
+
+const char* traffic_pattern_name(TrafficPattern p)
+{
+    if ((int)p < 0 || p >= TRAFFIC_PATTERN_COUNT) return "unknown";
+    return k_pattern_names[p];
+}
+
+int traffic_pattern_from_name(const char* name)
+{
+    if (!name) return -1;
+    for (int i = 0; i < TRAFFIC_PATTERN_COUNT; ++i) {
+        if (platform_stricmp(name, k_pattern_names[i]) == 0) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,113 @@
+/* ----- ----- ----- ----- */
+// traffic_model.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef TRAFFIC_MODEL_H
+#define TRAFFIC_MODEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "elevator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Seeded passenger-arrival generator for the standard lift traffic patterns.
+ *
+ * Arrivals form a non-homogeneous Poisson process: the building-wide rate
+ * follows a peak-shaped profile over the run, each arrival's origin floor is
+ * drawn from the pattern's origin distribution and its destination from the
+ * matching row of the origin/destination matrix. Together this is equivalent
+ * to one Poisson process per floor with time-varying rate.
+ *
+ * Same seed + same parameters => same arrival sequence on every platform.
+ */
+
+typedef enum {
+    TRAFFIC_UP_PEAK = 0,    // 上班尖峰：大多從大廳往上
+    TRAFFIC_DOWN_PEAK,      // 下班尖峰：大多往大廳
+    TRAFFIC_LUNCH,          // 午餐：往返大廳兩個方向都多
+    TRAFFIC_INTERFLOOR,     // 樓層間：起訖均勻分布
+    TRAFFIC_PATTERN_COUNT
+} TrafficPattern;
+
+/* 一位乘客到達 */
+typedef struct {
+    double time_s;    // 到達時間（從模型開始算起的虛擬秒數）
+    int from_floor;
+    int to_floor;
+} TrafficArrival;
+
+typedef struct {
+    TrafficPattern pattern;
+    int floors;             // 使用的樓層 [0, floors)
+    int lobby;              // 大廳樓層
+    double peak_rate_s;     // 尖峰時全棟到達率（人 / 秒）
+    double duration_s;      // 到達率曲線長度（超過後維持最低到達率）
+    uint64_t rng;           // PRNG 狀態
+    double t;               // 最後一次候選到達時間
+    double origin_cdf[MAX_FLOORS];
+    int has_lookahead;      // traffic_drive_until 保留的下一筆到達
+    TrafficArrival lookahead;
+} TrafficModel;
+
+/* Sink receiving generated arrivals (push into the core, record, ...). */
+typedef void (*traffic_sink_fn)(const TrafficArrival* a, void* user);
+
+/* Initialise a generator.
+ * - floors: floors in use (2..MAX_FLOORS), lobby: entrance floor
+ * - rate_per_min: building-wide arrival rate at the peak of the profile
+ * - duration_s: length of the rate profile (e.g. 3600 for a one-hour peak)
+ */
+void traffic_init(TrafficModel* m, TrafficPattern pattern, int floors, int lobby,
+                  double rate_per_min, double duration_s, uint64_t seed);
+
+/* Building-wide arrival rate (passengers / s) at time t. */
+double traffic_rate(const TrafficModel* m, double t);
+
+/* Probability that a passenger starting at `from` travels to `to` (one row of
+ * the origin/destination matrix; each row sums to 1, the diagonal is 0).
+ */
+double traffic_od_probability(const TrafficModel* m, int from, int to);
+
+/* Generate the next arrival. Always succeeds for a valid model. */
+void traffic_next(TrafficModel* m, TrafficArrival* out);
+
+/* Emit every arrival with time_s <= until_s to `sink`, in time order.
+ * Meant to be called once per core tick when driving in virtual time.
+ * Returns the number of arrivals emitted.
+ */
+int traffic_drive_until(TrafficModel* m, double until_s, traffic_sink_fn sink, void* user);
+
+/* Ready-made sinks.
+ * traffic_sink_push_events: server_events_push_outside with the travel
+ *   direction; `user` points to an int client id (or NULL for -1).
+ * traffic_sink_record: append the arrival as a text line to the FILE* `user`.
+ */
+void traffic_sink_push_events(const TrafficArrival* a, void* user);
+void traffic_sink_record(const TrafficArrival* a, void* user);
+
+/* Recorded streams: one "time_s from to" line per arrival, so recorded
+ * traffic can be fed back to benchmarks and simulations unchanged.
+ * traffic_read_arrival returns 1 on success, 0 at end of stream.
+ */
+int traffic_write_arrival(FILE* fp, const TrafficArrival* a);
+int traffic_read_arrival(FILE* fp, TrafficArrival* a);
+
+const char* traffic_pattern_name(TrafficPattern p);
+
+/* Parse "uppeak" / "downpeak" / "lunch" / "interfloor". Returns -1 if unknown. */
+int traffic_pattern_from_name(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRAFFIC_MODEL_H */
@@ -0,0 +1,159 @@
+/* ----- ----- ----- ----- */
+// hot_upgrade.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#include "hot_upgrade.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <sys/un.h>
+#include <unistd.h>
+
+/* 填入 Unix domain socket 位址 */
+static int make_addr(const char* path, struct sockaddr_un* addr) {
+    if (!path || strlen(path) >= sizeof(addr->sun_path)) return -1;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+/* 舊行程：在 path 上等待新行程連線 */
+platform_socket_t hot_upgrade_listen(const char* path) {
+    struct sockaddr_un addr;
+    if (make_addr(path, &addr) != 0) return INVALID_SOCKET;
+
+    platform_socket_t s = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (s < 0) return INVALID_SOCKET;
+    unlink(path);  // 清掉上次留下的 socket 檔
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 1) != 0) {
+        close(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+platform_socket_t hot_upgrade_accept(platform_socket_t listen_sock) {
+    platform_socket_t c = accept(listen_sock, NULL, NULL);
+    return (c < 0) ? INVALID_SOCKET : c;
+}
+
+/* 新行程：連到舊行程 */
+platform_socket_t hot_upgrade_connect(const char* path) {
+    struct sockaddr_un addr;
+    if (make_addr(path, &addr) != 0) return INVALID_SOCKET;
+
+    platform_socket_t s = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (s < 0) return INVALID_SOCKET;
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+/* 送出一則訊息（可附帶 socket，透過 SCM_RIGHTS 傳遞） */
+int hot_upgrade_send(platform_socket_t ch, const void* data, int len,
+                     const platform_socket_t* fds, int nfds) {
+    if (nfds < 0 || nfds > HOT_UPGRADE_MAX_FDS || len <= 0) return -1;
+
+    struct iovec iov;
+    iov.iov_base = (void*)data;
+    iov.iov_len = (size_t)len;
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * HOT_UPGRADE_MAX_FDS)];
+    } ctrl;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (nfds > 0) {
+        memset(&ctrl, 0, sizeof(ctrl));
+        msg.msg_control = ctrl.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)nfds);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)nfds);
+        memcpy(CMSG_DATA(cm), fds, sizeof(int) * (size_t)nfds);
+    }
+    return (sendmsg(ch, &msg, 0) == (ssize_t)len) ? 0 : -1;
+}
+
+/* 接收一則訊息與附帶的 socket */
+int hot_upgrade_recv(platform_socket_t ch, void* data, int cap,
+                     platform_socket_t* fds, int max_fds, int* nfds) {
+    if (nfds) *nfds = 0;
+
+    struct iovec iov;
+    iov.iov_base = data;
+    iov.iov_len = (size_t)cap;
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * HOT_UPGRADE_MAX_FDS)];
+    } ctrl;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    ssize_t n = recvmsg(ch, &msg, 0);
+    if (n <= 0 || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) return -1;
+
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < count; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (fds && nfds && *nfds < max_fds) fds[(*nfds)++] = fd;
+            else close(fd);
+        }
+    }
+    return (int)n;
+}
+
+void hot_upgrade_unlisten(platform_socket_t listen_sock, const char* path) {
+    if (listen_sock >= 0) close(listen_sock);
+    if (path) unlink(path);
+}
+
+#else  /* _WIN32 */
+
+/* Windows 沒有 SCM_RIGHTS：不支援熱升級 */
+platform_socket_t hot_upgrade_listen(const char* path) { (void)path; return INVALID_SOCKET; }
+platform_socket_t hot_upgrade_accept(platform_socket_t listen_sock) { (void)listen_sock; return INVALID_SOCKET; }
+platform_socket_t hot_upgrade_connect(const char* path) { (void)path; return INVALID_SOCKET; }
+
+int hot_upgrade_send(platform_socket_t ch, const void* data, int len,
+                     const platform_socket_t* fds, int nfds) {
+    (void)ch; (void)data; (void)len; (void)fds; (void)nfds;
+    return -1;
+}
+
+int hot_upgrade_recv(platform_socket_t ch, void* data, int cap,
+                     platform_socket_t* fds, int max_fds, int* nfds) {
+    (void)ch; (void)data; (void)cap; (void)fds; (void)max_fds;
+    if (nfds) *nfds = 0;
+    return -1;
+}
+
+void hot_upgrade_unlisten(platform_socket_t listen_sock, const char* path) {
+    (void)listen_sock; (void)path;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/* ----- ----- ----- ----- */
+// hot_upgrade.h
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.0
+/* ----- ----- ----- ----- */
+
+#ifndef HOT_UPGRADE_H
+#define HOT_UPGRADE_H
+
+#include "../core/platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Transport for zero-downtime upgrades: a local Unix domain socket
+ * (SOCK_SEQPACKET, so every send is received as one message) over which the
+ * running server hands its core state and open sockets (SCM_RIGHTS) to the
+ * replacing process. The message layout itself lives in remote_server.c.
+ *
+ * Only available on POSIX; on Windows every call fails and returns
+ * INVALID_SOCKET / -1.
+ */
+
+/* Max descriptors attached to one message. */
+#define HOT_UPGRADE_MAX_FDS 64
+
+/* Listening side (running server). Replaces a stale socket file at path. */
+platform_socket_t hot_upgrade_listen(const char* path);
+
+/* Accept the replacing process. */
+platform_socket_t hot_upgrade_accept(platform_socket_t listen_sock);
+
+/* Connecting side (replacing process). */
+platform_socket_t hot_upgrade_connect(const char* path);
+
+/* Send one message with up to HOT_UPGRADE_MAX_FDS descriptors attached.
+ * Returns 0 on success, -1 on error.
+ */
+int hot_upgrade_send(platform_socket_t ch, const void* data, int len,
+                     const platform_socket_t* fds, int nfds);
+
+/* Receive one message. On success returns the payload length and stores the
+ * received descriptors in fds / *nfds; returns -1 on error or if the peer
+ * closed the channel.
+ */
+int hot_upgrade_recv(platform_socket_t ch, void* data, int cap,
+                     platform_socket_t* fds, int max_fds, int* nfds);
+
+/* Close a listening socket and remove its socket file. */
+void hot_upgrade_unlisten(platform_socket_t listen_sock, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOT_UPGRADE_H */
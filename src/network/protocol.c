@@ -0,0 +1,173 @@
+/* ----- ----- ----- ----- */
+// protocol.c
+// Do not distribute or modify
+// Author: DragonTaki (https://github.com/DragonTaki)
+// Create Date: 2026/10/18
+// Update Date: 2026/10/18
+// Version: v1.1
+/* ----- ----- ----- ----- */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../core/elevator.h"
+#include "../core/platform.h"
+#include "../core/server_events.h"
+#include "protocol.h"
+
+/* 解析 CALL 之後的參數 */
+static ProtocolCommandType parse_call(const char* args, ProtocolCommand* out) {
+    int from, to;
+    char dirstr[16] = {0};
+
+    // CALL <from> <to>
+    if (sscanf(args, "%d %d", &from, &to) == 2) {
+        out->a = from;
+        out->b = to;
+        return PROTO_CALL_FLOORS;
+    }
+    // CALL <哪層樓按的> UP/DOWN
+    if (sscanf(args, "%d %15s", &from, dirstr) == 2) {
+        out->a = from;
+        if (platform_stricmp(dirstr, "UP") == 0) {
+            out->b = DIR_UP;
+            return PROTO_CALL_DIR;
+        }
+        if (platform_stricmp(dirstr, "DOWN") == 0) {
+            out->b = DIR_DOWN;
+            return PROTO_CALL_DIR;
+        }
+        return PROTO_CALL_BAD_DIR;
+    }
+    return PROTO_CALL_BAD;
+}
+
+/* 解析 ETA 之後的參數：ETA <floor> UP|DOWN */
+static ProtocolCommandType parse_eta(const char* args, ProtocolCommand* out) {
+    int floor;
+    char dirstr[16] = {0};
+
+    if (sscanf(args, "%d %15s", &floor, dirstr) != 2) return PROTO_ETA_BAD;
+    out->a = floor;
+    if (platform_stricmp(dirstr, "UP") == 0) {
+        out->b = DIR_UP;
+        return PROTO_ETA;
+    }
+    if (platform_stricmp(dirstr, "DOWN") == 0) {
+        out->b = DIR_DOWN;
+        return PROTO_ETA;
+    }
+    return PROTO_ETA_BAD;
+}
+
+/* 解析 CAR 之後的參數：ADD | REMOVE [id] | OUT <id> | IN <id> */
+static ProtocolCommandType parse_car(const char* args, ProtocolCommand* out) {
+    char op[16] = {0};
+    int id = -1;
+    int n = sscanf(args, "%15s %d", op, &id);
+    if (n < 1) return PROTO_CAR_BAD;
+    out->b = (n == 2) ? id : -1;
+
+    if (platform_stricmp(op, "ADD") == 0) {
+        out->a = FLEET_ADD_CAR;
+        return (n == 1) ? PROTO_CAR : PROTO_CAR_BAD;
+    }
+    if (platform_stricmp(op, "REMOVE") == 0) {
+        out->a = FLEET_REMOVE_CAR;
+        return PROTO_CAR;
+    }
+    if (platform_stricmp(op, "OUT") == 0) out->a = FLEET_OUT_OF_SERVICE;
+    else if (platform_stricmp(op, "IN") == 0) out->a = FLEET_IN_SERVICE;
+    else return PROTO_CAR_BAD;
+    return (n == 2 && id >= 0) ? PROTO_CAR : PROTO_CAR_BAD;
+}
+
+/* 選用的大樓代號 B<n>：有 => 1 並前進 *p，沒有 => 0，B 後面不是數字 => -1 */
+static int parse_building(const char** p, int* building) {
+    const char* s = *p;
+    while (*s == ' ' || *s == '\t') ++s;
+    if (*s != 'B' && *s != 'b') return 0;
+    int id, n = 0;
+    if (sscanf(s + 1, "%d%n", &id, &n) != 1 || (s[1 + n] != '\0' && s[1 + n] != ' ' && s[1 + n] != '\t')) return -1;
+    *building = id;
+    *p = s + 1 + n;
+    return 1;
+}
+
+/* 解析 ROLE 之後的參數 */
+static ProtocolCommandType parse_role(const char* args, ProtocolCommand* out) {
+    char role[64];
+    int n = 0;
+    if (sscanf(args, "%63s%n", role, &n) != 1) return PROTO_ROLE_BAD;
+    const char* rest = args + n;
+    int building = 0;
+
+    if (platform_stricmp(role, "GUARD") == 0) {
+        if (parse_building(&rest, &building) < 0) return PROTO_ROLE_BAD;
+        out->a = building;
+        return PROTO_ROLE_GUARD;
+    }
+    if (platform_stricmp(role, "BUTTON") == 0) {
+        int floor = -1;
+        if (parse_building(&rest, &building) < 0) return PROTO_ROLE_BUTTON_BAD;
+        out->b = building;
+        if (sscanf(rest, "%d", &floor) == 1) {
+            out->a = floor;
+            return PROTO_ROLE_BUTTON;
+        }
+        return PROTO_ROLE_BUTTON_BAD;
+    }
+    return PROTO_ROLE_BAD;
+}
+
+/* 解析一行用戶端指令（只檢查語法） */
+ProtocolCommandType protocol_parse_line(const char* line, ProtocolCommand* out) {
+    char cmd[64];  // 指令的第一個 token
+    int n = 0;
+
+    out->a = 0;
+    out->b = 0;
+    if (!line || sscanf(line, "%63s%n", cmd, &n) != 1) return out->type = PROTO_EMPTY;
+    const char* args = line + n;
+
+    if (platform_stricmp(cmd, "CALL") == 0) {
+        out->type = parse_call(args, out);
+    } else if (platform_stricmp(cmd, "INSIDE") == 0) {
+        int eid, dest;
+        if (sscanf(args, "%d %d", &eid, &dest) == 2) {
+            out->a = eid;
+            out->b = dest;
+            out->type = PROTO_INSIDE;
+        } else {
+            out->type = PROTO_INSIDE_BAD;
+        }
+    } else if (platform_stricmp(cmd, "ROLE") == 0) {
+        out->type = parse_role(args, out);
+    } else if (platform_stricmp(cmd, "STATUS") == 0) {
+        out->type = PROTO_STATUS;
+    } else if (platform_stricmp(cmd, "WATCH") == 0) {
+        out->type = PROTO_WATCH;
+    } else if (platform_stricmp(cmd, "UNWATCH") == 0) {
+        out->type = PROTO_UNWATCH;
+    } else if (platform_stricmp(cmd, "ETA") == 0) {
+        out->type = parse_eta(args, out);
+    } else if (platform_stricmp(cmd, "SUBSCRIBE") == 0) {
+        out->type = PROTO_SUBSCRIBE;
+    } else if (platform_stricmp(cmd, "UNSUBSCRIBE") == 0) {
+        out->type = PROTO_UNSUBSCRIBE;
+    } else if (platform_stricmp(cmd, "CAR") == 0) {
+        out->type = parse_car(args, out);
+    } else if (platform_stricmp(cmd, "FORCE") == 0) {
+        int eid, floor;
+        if (sscanf(args, "%d %d", &eid, &floor) == 2) {
+            out->a = eid;
+            out->b = floor;
+            out->type = PROTO_FORCE;
+        } else {
+            out->type = PROTO_FORCE_BAD;
+        }
+    } else {
+        out->type = PROTO_UNKNOWN;
+    }
+    return out->type;
+}
@@ -3,14 +3,64 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/29
-// Update Date: 2025/11/29
-// Version: v1.0
+// Update Date: 2026/10/18
+// Version: v1.1
 /* ----- ----- ----- ----- */
 
 #ifndef NETWORK_PROTOCOL_H
 #define NETWORK_PROTOCOL_H
 
-#define MAX_CLIENTS 64
+/* 同時連線上限（poll 沒有 FD_SETSIZE 限制；可在編譯時覆寫） */
+#ifndef MAX_CLIENTS
+#define MAX_CLIENTS 4096
+#endif
 #define MAX_LINE 512
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 已解析的用戶端指令種類 */
+typedef enum {
+    PROTO_EMPTY = 0,        // 空白行
+    PROTO_UNKNOWN,          // 無法辨識的指令
+    PROTO_ROLE_GUARD,       // ROLE GUARD [B<n>]          a = building（預設 0）
+    PROTO_ROLE_BUTTON,      // ROLE BUTTON [B<n>] <floor> a = floor, b = building（預設 0）
+    PROTO_ROLE_BUTTON_BAD,  // ROLE BUTTON（缺樓層）
+    PROTO_ROLE_BAD,         // ROLE <其他>
+    PROTO_CALL_FLOORS,      // CALL <from> <to>           a = from, b = to
+    PROTO_CALL_DIR,         // CALL <from> UP|DOWN        a = from, b = Direction
+    PROTO_CALL_BAD_DIR,     // CALL <from> <非 UP/DOWN>   a = from
+    PROTO_CALL_BAD,         // CALL 參數格式錯誤
+    PROTO_INSIDE,           // INSIDE <elevator> <dest>   a = elevator, b = dest
+    PROTO_INSIDE_BAD,       // INSIDE 參數格式錯誤
+    PROTO_STATUS,
+    PROTO_WATCH,
+    PROTO_UNWATCH,
+    PROTO_ETA,              // ETA <floor> UP|DOWN        a = floor, b = Direction
+    PROTO_ETA_BAD,          // ETA 參數格式錯誤
+    PROTO_FORCE,            // FORCE <elevator> <floor>   a = elevator, b = floor
+    PROTO_FORCE_BAD,        // FORCE 參數格式錯誤
+    PROTO_SUBSCRIBE,        // SUBSCRIBE：之後的 CALL 回報 ASSIGNED / ARRIVING / SERVED
+    PROTO_UNSUBSCRIBE,
+    PROTO_CAR,              // CAR ADD | REMOVE [id] | OUT <id> | IN <id>   a = FleetOp, b = id（-1 = 未指定）
+    PROTO_CAR_BAD           // CAR 參數格式錯誤
+} ProtocolCommandType;
+
+typedef struct {
+    ProtocolCommandType type;
+    int a;
+    int b;
+} ProtocolCommand;
+
+/* Parse one client line (without the line terminator). Only syntax is
+ * checked here; range checks and role permissions are up to the caller.
+ * Returns the parsed type (also stored in out->type).
+ */
+ProtocolCommandType protocol_parse_line(const char* line, ProtocolCommand* out);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* NETWORK_PROTOCOL_H */
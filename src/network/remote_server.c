@@ -3,29 +3,50 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #define _WINSOCK_DEPRECATED_NO_WARNINGS
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
 
+#ifdef _WIN32
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  #pragma comment(lib, "ws2_32.lib")
+#else
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+#endif
+
+#include "../core/checkpoint.h"
+#include "../core/core_log.h"
+#include "../core/core_notify.h"
 #include "../core/elevator.h"
 #include "../core/server_core.h"
 #include "../core/server_events.h"
 #include "../core/status.h"
+#include "hot_upgrade.h"
 #include "protocol.h"
 
-#pragma comment(lib, "ws2_32.lib")
-
 #define SIM_TICK_MS 300    // 多久跑一次
-#define LISTEN_BACKLOG 16  // 等待連線數量上限
+#define LISTEN_BACKLOG 1024  // 等待連線數量上限（大量按鈕面板同時連線）
 #define MAX_LINE_LEN 512
 
+/* 入場控制（admission control） */
+#define ADMIT_RATE_PER_S   2.0   // 每個 BUTTON 每秒補充的呼叫額度
+#define ADMIT_BURST        8.0   // 額度上限（可連續送出的呼叫數）
+#define ADMIT_RETRY_MIN_MS 200   // retry_after 下限
+#define ADMIT_RETRY_MAX_MS 5000  // retry_after 上限（核心停擺時也用這個）
+#define ADMIT_DRAIN_SAMPLE_MS 1000  // 通道消化速率取樣間隔
+
+/* 對已斷線的 client send 時不要觸發 SIGPIPE（Linux） */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 /* 用戶端種類 */
 typedef enum {
     CLIENT_UNKNOWN = 0,
@@ -35,30 +56,72 @@ typedef enum {
 
 /* 用戶端資料 */
 typedef struct {
-    SOCKET sock;
+    platform_socket_t sock;
     ClientType type;
+    int building;  // 所屬大樓（ROLE ... B<n>，預設 0）
     int floor;     // for BUTTON
     int watching;  // for GUARD
+    int subscribed;  // 訂閱自己外呼的 ASSIGNED / ARRIVING / SERVED
     int id;
+    double tokens;        // 令牌桶剩餘額度（BUTTON 用）
+    long long tokens_ms;  // 上次補充額度的時間
     char inbuf[1024];
     int inbuf_len;
 } ClientInfo;
 
 static ClientInfo clients[MAX_CLIENTS];
 static int client_count = 0;
+static int g_next_client_id = 0;  // 單調遞增，斷線後不重複使用
+static unsigned g_next_request_id = 1;  // 外呼請求 ID（CALL_OK id=<n>），0 保留給「沒訂閱」
+static platform_pollfd_t g_pollfds[MAX_CLIENTS + 2];
 
 static Elevator* g_elevators = NULL;
 static int g_elevator_count = 0;
 
 
-static DWORD g_last_broadcast_ms = 0;  // 上次廣播時間（毫秒）
+static long long g_last_broadcast_ms = 0;  // 上次廣播時間（毫秒）
+
+/* 各大樓內呼／外呼通道的消化速率（每秒事件數，平滑後），用來估計 retry_after */
+static double g_drain_per_s[MAX_BUILDINGS][EVT_LANE_COUNT];
+static unsigned long g_drain_popped[MAX_BUILDINGS][EVT_LANE_COUNT];
+static long long g_drain_sample_ms = 0;
+
+static FILE* g_trace = NULL;          // 連線流量紀錄（NULL = 關閉）
+static long long g_trace_t0 = 0;
+
+/* 記錄一行流量：<ms> <client id> <方向> <內容>；'>' 收到、'<' 回覆、'+' 連線、'-' 斷線 */
+static void trace_line(int client_id, char dir, const char* line) {
+    if (!g_trace) return;
+    fprintf(g_trace, "%lld %d %c %s\n", platform_time_ms() - g_trace_t0, client_id, dir, line ? line : "");
+}
 
 /* 發送字串 */
-static void send_line(SOCKET s, const char* line) {
+static void send_line(platform_socket_t s, const char* line) {
     if (s == INVALID_SOCKET) return;
     char buf[MAX_LINE_LEN];
     int n = snprintf(buf, sizeof(buf), "%s\r\n", line);
-    send(s, buf, n, 0);
+    send(s, buf, n, MSG_NOSIGNAL);
+}
+
+/* 回覆指定用戶端（會記入流量紀錄） */
+static void reply_line(const ClientInfo* c, const char* line) {
+    trace_line(c->id, '<', line);
+    send_line(c->sock, line);
+}
+
+/* client 所屬大樓的核心 */
+static ServerCore* client_core(const ClientInfo* c) {
+    return server_core_get(c->building);
+}
+
+/* 樓層在 client 所屬大樓內 */
+static int floor_in_building(const ClientInfo* c, int floor) {
+    return floor >= 0 && floor < server_core_floor_count_of(client_core(c));
+}
+
+/* 外呼樓層：在大樓內且有電梯停靠 */
+static int hall_floor_ok(const ClientInfo* c, int floor) {
+    return server_core_floor_served_of(client_core(c), floor);
 }
 
 /* 將所有電梯狀態發送給所有警衛端 */
@@ -74,366 +137,895 @@ void broadcast_status_to_guards(Elevator elevators[], int elevator_count, int on
     for (int i = 0; i < client_count; ++i) {
         if (clients[i].type == CLIENT_GUARD) {
             if (only_watchers && !clients[i].watching) continue;
-            send(clients[i].sock, big, (int)strlen(big), 0);
+            send(clients[i].sock, big, (int)strlen(big), MSG_NOSIGNAL);
         }
     }
 }
 
-// 由 server_core 每個 tick 呼叫，把狀態推給所有 WATCH 的 GUARD
-static void on_core_status(const char* snapshot) {
-    (void)snapshot; // 我們不用 core 給的文字，改用既有的格式重算
-    printf("[REMOTE] on_core_status called.\n");
+/* 每棟大樓的狀態只送給該大樓有 WATCH 的警衛端 */
+static void broadcast_campus_status(void) {
+    char line[128];
+    char big[2048];
+    for (int b = 0; b < server_core_building_count(); ++b) {
+        int has_watcher = 0;
+        for (int i = 0; i < client_count && !has_watcher; ++i) {
+            has_watcher = (clients[i].type == CLIENT_GUARD && clients[i].watching && clients[i].building == b);
+        }
+        // 沒人看就不廣播
+        if (!has_watcher) continue;
 
-    if (!g_elevators || g_elevator_count <= 0) return;
+        ServerCore* core = server_core_get(b);
+        Elevator* elevators = server_core_elevators_of(core);
+        big[0] = '\0';
+        for (int i = 0; i < server_core_elevator_count_of(core); ++i) {
+            Elevator_status_line(&elevators[i], line, sizeof(line));
+            strncat(big, line, sizeof(big) - strlen(big) - 1);
+            strncat(big, "\r\n", sizeof(big) - strlen(big) - 1);
+        }
+        for (int i = 0; i < client_count; ++i) {
+            if (clients[i].type == CLIENT_GUARD && clients[i].watching && clients[i].building == b) {
+                send(clients[i].sock, big, (int)strlen(big), MSG_NOSIGNAL);
+            }
+        }
+    }
+}
+
+/* 把核心送來的通知轉成文字送給警衛端 */
+// ALERT WAIT <floor> UP|DOWN E<car> <等待秒數>
+// FLEET ADD|REMOVE|OUT|IN E<car> OK | REJECTED <原因>
+/* clients 依 id 遞增排列（新連線接在尾端、斷線往前補），用二分搜尋找 */
+static ClientInfo* find_client_by_id(int id) {
+    int lo = 0, hi = client_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (clients[mid].id == id) return &clients[mid];
+        if (clients[mid].id < id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
 
-    // 只把狀態推給有 WATCH 的 GUARD
-    broadcast_status_to_guards(g_elevators, g_elevator_count, 1);
+/* 呼叫生命週期通知 => 送回發出請求的 client（已斷線或取消訂閱就丟掉） */
+static void deliver_lifecycle(const CoreNotice* n) {
+    ClientInfo* c = find_client_by_id(n->client_id);
+    if (!c) return;
+    char line[96];
+    // 目的樓層外呼的搭乘指示：面板一定要知道搭哪台，不看訂閱
+    if (n->type == NOTICE_BOARD) {
+        snprintf(line, sizeof(line), "BOARD %u E%d to=%d", n->request_id, n->car, n->to_floor);
+        reply_line(c, line);
+        return;
+    }
+    if (!c->subscribed) return;
+    switch (n->type) {
+        case NOTICE_ASSIGNED:
+            if (n->eta_s >= 0.0) snprintf(line, sizeof(line), "ASSIGNED %u E%d eta=%.1f", n->request_id, n->car, n->eta_s);
+            else snprintf(line, sizeof(line), "ASSIGNED %u E%d", n->request_id, n->car);
+            break;
+        case NOTICE_ARRIVING:
+            snprintf(line, sizeof(line), "ARRIVING %u E%d", n->request_id, n->car);
+            break;
+        case NOTICE_SERVED:
+            snprintf(line, sizeof(line), "SERVED %u E%d", n->request_id, n->car);
+            break;
+        default:
+            return;
+    }
+    reply_line(c, line);
+}
+
+/* 車隊調整結果：FLEET ADD|REMOVE|OUT|IN E<car> OK | REJECTED <原因> */
+static void format_fleet(const CoreNotice* n, char* line, int size) {
+    const char* op;
+    switch (n->op) {
+        case FLEET_ADD_CAR:        op = "ADD"; break;
+        case FLEET_REMOVE_CAR:     op = "REMOVE"; break;
+        case FLEET_OUT_OF_SERVICE: op = "OUT"; break;
+        case FLEET_IN_SERVICE:     op = "IN"; break;
+        default:                   op = "?"; break;
+    }
+    const char* why;
+    switch (n->result) {
+        case ELEV_OK:
+        case ELEV_IGNORED:     why = NULL; break;
+        case ELEV_ERR_FULL:    why = "no free shaft"; break;
+        case ELEV_ERR_BUSY:    why = "busy"; break;
+        default:               why = "invalid car"; break;
+    }
+    if (why) snprintf(line, size, "FLEET %s E%d REJECTED %s", op, n->car, why);
+    else snprintf(line, size, "FLEET %s E%d OK", op, n->car);
+}
+
+static void deliver_core_notices(void) {
+    CoreNotice n;
+    while (core_notify_pop(&n) == 0) {
+        if (n.type != NOTICE_WAIT_SLO && n.type != NOTICE_FLEET) {
+            deliver_lifecycle(&n);
+            continue;
+        }
+        char line[96];
+        if (n.type == NOTICE_FLEET) {
+            format_fleet(&n, line, sizeof(line));
+        } else {
+            snprintf(line, sizeof(line), "ALERT WAIT %d %s E%d %.1f", n.floor,
+                     (n.dir == DIR_UP) ? "UP" : "DOWN", n.car, n.wait_s);
+        }
+        printf("[SERVER] B%d %s\n", n.building, line);
+        // 只通知該大樓的警衛
+        for (int i = 0; i < client_count; ++i) {
+            if (clients[i].type == CLIENT_GUARD && clients[i].building == n.building) reply_line(&clients[i], line);
+        }
+    }
 }
 
 /* 接受新用戶端連線 */
-static void accept_new_client(SOCKET listen_sock) {
+static void accept_new_client(platform_socket_t listen_sock) {
     struct sockaddr_in addr;
-    int addrlen = sizeof(addr);
-    SOCKET c = accept(listen_sock, (struct sockaddr*)&addr, &addrlen);
+    socklen_t addrlen = sizeof(addr);
+    platform_socket_t c = accept(listen_sock, (struct sockaddr*)&addr, &addrlen);
 
     // 如果無效或失敗 => 顯示錯誤並跳出
     if (c == INVALID_SOCKET) {
-        printf("[SERVER] accept failed: %d\n", WSAGetLastError());
+        printf("[SERVER] accept failed: %d\n", platform_socket_last_error());
         return;
     }
     if (client_count >= MAX_CLIENTS) {
         send_line(c, "SERVER_BUSY");
-        closesocket(c);
+        platform_socket_close(c);
         return;
     }
 
     // 成功 => 加入至 clients 陣列尾端
     clients[client_count].sock = c;
     clients[client_count].type = CLIENT_UNKNOWN;
+    clients[client_count].building = 0;
     clients[client_count].floor = -1;
     clients[client_count].watching = 0;
-    clients[client_count].id = client_count;
+    clients[client_count].subscribed = 0;
+    clients[client_count].id = g_next_client_id++;
     clients[client_count].inbuf_len = 0;
+    clients[client_count].tokens = ADMIT_BURST;
+    clients[client_count].tokens_ms = platform_time_ms();
     client_count++;
-    printf("[SERVER] Client connected (id=%d)\n", client_count-1);
-    send_line(c, "WELCOME");
-    send_line(c, "Please declare role: ROLE GUARD  OR  ROLE BUTTON <floor>");
+    CORE_LOG("[SERVER] Client connected (id=%d)\n", clients[client_count-1].id);
+    trace_line(clients[client_count-1].id, '+', NULL);
+    reply_line(&clients[client_count-1], "WELCOME");
+    reply_line(&clients[client_count-1], "Please declare role: ROLE GUARD [B<building>]  OR  ROLE BUTTON [B<building>] <floor>");
 }
 
 /* 移除已離線或失效的用戶端 */
 static void remove_client(int idx) {
     if (idx < 0 || idx >= client_count) return;
-    closesocket(clients[idx].sock);
-    printf("[SERVER] Client %d disconnected\n", clients[idx].id);
+    platform_socket_close(clients[idx].sock);
+    CORE_LOG("[SERVER] Client %d disconnected\n", clients[idx].id);
+    trace_line(clients[idx].id, '-', NULL);
 
     // 移動 clients 陣列（後面往前補）
     for (int j = idx; j + 1 < client_count; ++j) clients[j] = clients[j+1];
     client_count--;
 }
 
+/* ETA <floor> UP|DOWN：回覆目前預估最快到的電梯（核心每 tick 更新的 ETA 表） */
+static void reply_eta(const ClientInfo* c, ProtocolCommandType cmd, const ProtocolCommand* pc) {
+    char buf[96];
+    int car = -1;
+    double seconds = 0.0;
+
+    if (cmd == PROTO_ETA_BAD) {
+        reply_line(c, "ETA_BAD usage: ETA <floor> UP|DOWN");
+    } else if (!floor_in_building(c, pc->a)) {
+        reply_line(c, "ETA_BAD floor out of range");
+    } else if (server_core_query_eta_of(client_core(c), pc->a, (Direction)pc->b, &car, &seconds) != 0) {
+        reply_line(c, "ETA_NONE");
+    } else {
+        snprintf(buf, sizeof(buf), "ETA %d %s E%d %.1f", pc->a,
+                 (pc->b == DIR_UP) ? "UP" : "DOWN", car, seconds);
+        reply_line(c, buf);
+    }
+}
+
+/* 每秒取樣一次各大樓各按鈕通道取出數，更新消化速率 */
+static void sample_drain_rate(long long now)
+{
+    int first = (g_drain_sample_ms == 0);
+    long long span = now - g_drain_sample_ms;
+    if (!first && span < ADMIT_DRAIN_SAMPLE_MS) return;
+    for (int b = 0; b < server_core_building_count(); ++b) {
+        ServerEventQueue* q = server_core_events_of(server_core_get(b));
+        for (int l = 0; l < EVT_LANE_COUNT; ++l) {
+            unsigned long popped = event_queue_lane_popped(q, (ServerEventLane)l);
+            if (!first) {
+                double rate = (double)(popped - g_drain_popped[b][l]) * 1000.0 / (double)span;
+                g_drain_per_s[b][l] = 0.5 * g_drain_per_s[b][l] + 0.5 * rate;
+            }
+            g_drain_popped[b][l] = popped;
+        }
+    }
+    g_drain_sample_ms = now;
+}
+
+/* 依通道積壓量與消化速率估計多久後再送比較可能被接受 */
+static int retry_after_ms(const ClientInfo* c, ServerEventLane lane)
+{
+    int depth = event_queue_lane_count(server_core_events_of(client_core(c)), lane);
+    double rate = g_drain_per_s[c->building][lane];
+    if (rate < 1.0) return ADMIT_RETRY_MAX_MS;
+    double ms = (double)depth * 1000.0 / rate;
+    if (ms < ADMIT_RETRY_MIN_MS) return ADMIT_RETRY_MIN_MS;
+    if (ms > ADMIT_RETRY_MAX_MS) return ADMIT_RETRY_MAX_MS;
+    return (int)ms;
+}
+
+/* 入場控制：每個 BUTTON 一個令牌桶，單一面板狂按不會擠掉其他人 */
+// 有額度 => 扣一個並回傳 1；沒額度 => 回覆 <prefix>_REJECT retry_after=<ms> rate_limit，回傳 0
+// GUARD 不受令牌桶限制，只受通道容量限制
+static int admit_client(ClientInfo* c, const char* prefix)
+{
+    if (c->type != CLIENT_BUTTON) return 1;
+    long long now = platform_time_ms();
+    c->tokens += (double)(now - c->tokens_ms) * ADMIT_RATE_PER_S / 1000.0;
+    if (c->tokens > ADMIT_BURST) c->tokens = ADMIT_BURST;
+    c->tokens_ms = now;
+    if (c->tokens >= 1.0) {
+        c->tokens -= 1.0;
+        return 1;
+    }
+    char buf[64];
+    int ms = (int)((1.0 - c->tokens) * 1000.0 / ADMIT_RATE_PER_S) + 1;
+    snprintf(buf, sizeof(buf), "%s_REJECT retry_after=%d rate_limit", prefix, ms);
+    reply_line(c, buf);
+    return 0;
+}
+
+/* 送出外呼事件；有訂閱的 client 才把請求 ID 帶進核心（沒人訂閱時核心不多做事） */
+static int push_call(ClientInfo* c, int floor, int dir) {
+    unsigned id = g_next_request_id;
+    int rc = event_queue_push_outside(server_core_events_of(client_core(c)), floor, dir, c->id, c->subscribed ? id : 0);
+    if (rc == 0) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "CALL_OK id=%u", id);
+        reply_line(c, buf);
+        if (++g_next_request_id == 0) g_next_request_id = 1;
+    }
+    return rc;
+}
+
+/* 送出目的樓層外呼；一定帶請求 ID，核心派車後回 BOARD <id> E<car> to=<floor> */
+static int push_destination(ClientInfo* c, int floor, int to_floor) {
+    unsigned id = g_next_request_id;
+    int rc = event_queue_push_destination(server_core_events_of(client_core(c)), floor, to_floor, c->id, id);
+    if (rc == 0) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "CALL_OK id=%u", id);
+        reply_line(c, buf);
+        if (++g_next_request_id == 0) g_next_request_id = 1;
+    }
+    return rc;
+}
+
+/* 事件推不進去時的回覆，並退還令牌 */
+static void reply_push_failed(ClientInfo* c, const char* prefix, ServerEventLane lane, int rc)
+{
+    char buf[64];
+    if (c->type == CLIENT_BUTTON) c->tokens += 1.0;
+    if (rc == ELEV_ERR_FULL) {
+        snprintf(buf, sizeof(buf), "%s_REJECT retry_after=%d queue_full", prefix, retry_after_ms(c, lane));
+    } else {
+        snprintf(buf, sizeof(buf), "%s_REJECT unavailable", prefix);
+    }
+    reply_line(c, buf);
+}
+
 /* 剖析並處理用戶端文字指令 */
 static void handle_client_command(int idx, const char* line) {
     ClientInfo* c = &clients[idx];
-    char cmd[64];  // 指令的第一個 token
-    if (sscanf(line, "%63s", cmd) != 1) return;
+    trace_line(c->id, '>', line);
+    ProtocolCommand pc;
+    ProtocolCommandType cmd = protocol_parse_line(line, &pc);
+    if (cmd == PROTO_EMPTY) return;
 
     // 未知身分
     if (c->type == CLIENT_UNKNOWN) {
         // 先看是不是指定 ROLE
-        if (platform_stricmp(cmd, "ROLE") == 0) {
-            char role[64];
-            if (sscanf(line, "ROLE %63s", role) == 1) {
-                if (platform_stricmp(role, "GUARD") == 0) {
-                    c->type = CLIENT_GUARD;
-                    c->watching = 0;
-                    send_line(c->sock, "ROLE_OK GUARD");
-                    printf("[SERVER] Client %d set ROLE GUARD\n", c->id);
-                } else if (platform_stricmp(role, "BUTTON") == 0) {
-                    int floor = -1;
-                    if (sscanf(line, "ROLE BUTTON %d", &floor) >= 1) {
-                        c->type = CLIENT_BUTTON;
-                        c->floor = floor;
-                        send_line(c->sock, "ROLE_OK BUTTON");
-                        printf("[SERVER] Client %d set ROLE BUTTON floor=%d\n", c->id, floor);
-                    } else {
-                        send_line(c->sock, "ROLE_BAD BUTTON usage: ROLE BUTTON <floor>");
-                    }
-                } else {
-                    send_line(c->sock, "ROLE_BAD");
+        switch (cmd) {
+            case PROTO_ROLE_GUARD:
+                if (!server_core_get(pc.a)) {
+                    reply_line(c, "ROLE_BAD building out of range");
+                    return;
                 }
-            } else {
-                send_line(c->sock, "ROLE_BAD");
-            }
-            return;
+                c->type = CLIENT_GUARD;
+                c->building = pc.a;
+                c->watching = 0;
+                reply_line(c, "ROLE_OK GUARD");
+                CORE_LOG("[SERVER] Client %d set ROLE GUARD B%d\n", c->id, pc.a);
+                return;
+            case PROTO_ROLE_BUTTON:
+                if (!server_core_get(pc.b)) {
+                    reply_line(c, "ROLE_BAD building out of range");
+                    return;
+                }
+                c->type = CLIENT_BUTTON;
+                c->building = pc.b;
+                c->floor = pc.a;
+                reply_line(c, "ROLE_OK BUTTON");
+                CORE_LOG("[SERVER] Client %d set ROLE BUTTON B%d floor=%d\n", c->id, pc.b, pc.a);
+                return;
+            case PROTO_ROLE_BUTTON_BAD:
+                reply_line(c, "ROLE_BAD BUTTON usage: ROLE BUTTON [B<building>] <floor>");
+                return;
+            case PROTO_ROLE_BAD:
+                reply_line(c, "ROLE_BAD");
+                return;
+            default:
+                break;
         }
 
         // 未知身分 & 沒指定 ROLE => 當作按鈕 & 讀入 CALL 或 INSIDE
-        if (platform_stricmp(cmd, "CALL") == 0 || platform_stricmp(cmd, "INSIDE") == 0) {
+        if (cmd == PROTO_CALL_FLOORS || cmd == PROTO_CALL_DIR || cmd == PROTO_CALL_BAD_DIR ||
+            cmd == PROTO_CALL_BAD || cmd == PROTO_INSIDE || cmd == PROTO_INSIDE_BAD ||
+            cmd == PROTO_ETA || cmd == PROTO_ETA_BAD) {
             c->type = CLIENT_BUTTON;
         }
         // 未知身分 & 沒指定 ROLE & 未知指令 => 提示輸入
         else {
-            send_line(c->sock, "Please declare role: ROLE GUARD  OR  ROLE BUTTON <floor>");
+            reply_line(c, "Please declare role: ROLE GUARD [B<building>]  OR  ROLE BUTTON [B<building>] <floor>");
             return;
         }
     }
 
     // 已知身分
     if (c->type == CLIENT_BUTTON) {
-        // CALL => 外部呼叫（電梯上／下樓按鈕）
-        if (platform_stricmp(cmd, "CALL") == 0) {
-            int from, to;
-            char dirstr[16] = {0};
-
-            // CALL <from> <to>
-            if (sscanf(line, "CALL %d %d", &from, &to) == 2) {
-                if (from < 0 || from >= MAX_FLOORS || to < 0 || to >= MAX_FLOORS) {
-                    send_line(c->sock, "CALL_BAD floor out of range");
-                } else if (from == to) {
-                    send_line(c->sock, "CALL_BAD from==to");
+        switch (cmd) {
+            // CALL <from> <to> => 外部呼叫（電梯上／下樓按鈕）
+            case PROTO_CALL_FLOORS:
+                if (!hall_floor_ok(c, pc.a) || !floor_in_building(c, pc.b)) {
+                    reply_line(c, "CALL_BAD floor out of range");
+                } else if (pc.a == pc.b) {
+                    reply_line(c, "CALL_BAD from==to");
                 } else {
-                    int dir = (to > from) ? DIR_UP : DIR_DOWN;
-                    if (server_events_push_outside(from, dir, c->id) == 0) {
-                        send_line(c->sock, "CALL_OK");
-                        printf("[SERVER] Request queued from client %d: %d -> %d\n", c->id, from, to);
+                    int rc;
+                    if (!admit_client(c, "CALL")) {
+                        // 已回覆 rate_limit
+                    } else if ((rc = push_destination(c, pc.a, pc.b)) == 0) {
+                        CORE_LOG("[SERVER] Request queued from client %d: %d -> %d\n", c->id, pc.a, pc.b);
                     } else {
-                        send_line(c->sock, "CALL_REJECT queue_full");
+                        reply_push_failed(c, "CALL", EVT_LANE_HALL, rc);
                     }
                 }
-            }
+                break;
             // CALL <哪層樓按的> UP/DOWN
-            else if (sscanf(line, "CALL %d %15s", &from, dirstr) == 2) {
-                if (from < 0 || from >= MAX_FLOORS) {
-                    send_line(c->sock, "CALL_BAD floor out of range");
-                    return;
-                }
-                int dir;
-                if (platform_stricmp(dirstr, "UP") == 0) dir = DIR_UP;
-                else if (platform_stricmp(dirstr, "DOWN") == 0) dir = DIR_DOWN;
-                else {
-                    send_line(c->sock, "CALL_BAD usage: CALL <from> UP|DOWN");
-                    return;
-                }
-                if (server_events_push_outside(from, dir, c->id) == 0) {
-                    send_line(c->sock, "CALL_OK");
-                    printf("[SERVER] Directional CALL queued from client %d: %d %s\n",
-                        c->id, from, dirstr);
-                } else {
-                    send_line(c->sock, "CALL_REJECT queue_full");
+            case PROTO_CALL_DIR:
+            case PROTO_CALL_BAD_DIR:
+                if (!hall_floor_ok(c, pc.a)) {
+                    reply_line(c, "CALL_BAD floor out of range");
+                } else if (cmd == PROTO_CALL_BAD_DIR) {
+                    reply_line(c, "CALL_BAD usage: CALL <from> UP|DOWN");
+                } else if (admit_client(c, "CALL")) {
+                    int rc = push_call(c, pc.a, pc.b);
+                    if (rc == 0) {
+                        CORE_LOG("[SERVER] Directional CALL queued from client %d: %d %s\n",
+                            c->id, pc.a, (pc.b == DIR_UP) ? "UP" : "DOWN");
+                    } else {
+                        reply_push_failed(c, "CALL", EVT_LANE_HALL, rc);
+                    }
                 }
-            } else {
-                send_line(c->sock, "CALL_BAD usage: CALL <from> UP|DOWN");
-            }
-        }
-        // INSIDE => 內部呼叫（電梯內部按樓層）
-        else if (platform_stricmp(cmd, "INSIDE") == 0) {
-            int eid, dest;
-            // INSIDE <電梯 ID> <樓層>
-            if (sscanf(line, "INSIDE %d %d", &eid, &dest) == 2) {
+                break;
+            case PROTO_CALL_BAD:
+                reply_line(c, "CALL_BAD usage: CALL <from> UP|DOWN");
+                break;
+            // INSIDE <電梯 ID> <樓層> => 內部呼叫（電梯內部按樓層）
+            case PROTO_INSIDE:
                 /* validate elevator id */
-                if (eid >= 0) {
-                    int rc = server_events_push_inside(eid, dest, c->id);
+                if (pc.a >= 0) {
+                    if (!admit_client(c, "INSIDE")) break;
+                    int rc = event_queue_push_inside(server_core_events_of(client_core(c)), pc.a, pc.b, c->id);
                     if (rc == ELEV_OK) {
-                        send_line(c->sock, "INSIDE_OK");
+                        reply_line(c, "INSIDE_OK");
                     } else if (rc == ELEV_DUPLICATE) {
-                        send_line(c->sock, "INSIDE_DUPLICATE");
+                        reply_line(c, "INSIDE_DUPLICATE");
                     } else {
-                        send_line(c->sock, "INSIDE_REJECT");
+                        reply_push_failed(c, "INSIDE", EVT_LANE_CAR, rc);
                     }
                 } else {
-                    send_line(c->sock, "INSIDE_BAD elevator_id");
+                    reply_line(c, "INSIDE_BAD elevator_id");
                 }
-            } else {
-                send_line(c->sock, "INSIDE_BAD usage: INSIDE <elevator_id> <dest>");
-            }
-        } else {
-            send_line(c->sock, "UNKNOWN_CMD (BUTTON allowed: CALL, INSIDE)");
+                break;
+            case PROTO_INSIDE_BAD:
+                reply_line(c, "INSIDE_BAD usage: INSIDE <elevator_id> <dest>");
+                break;
+            // ETA <樓層> UP/DOWN => 查詢預估到達時間
+            case PROTO_ETA:
+            case PROTO_ETA_BAD:
+                reply_eta(c, cmd, &pc);
+                break;
+            case PROTO_SUBSCRIBE:
+                c->subscribed = 1;
+                reply_line(c, "SUBSCRIBE_OK");
+                break;
+            case PROTO_UNSUBSCRIBE:
+                c->subscribed = 0;
+                reply_line(c, "UNSUBSCRIBE_OK");
+                break;
+            default:
+                reply_line(c, "UNKNOWN_CMD (BUTTON allowed: CALL, INSIDE, ETA, SUBSCRIBE, UNSUBSCRIBE)");
+                break;
         }
     }
     // 已知身分（警衛）
     else if (c->type == CLIENT_GUARD) {
-        if (platform_stricmp(cmd, "STATUS") == 0) {
-            char buf[256];
-            for (int i = 0; i < g_elevator_count; ++i) {
-                Elevator_status_line(&g_elevators[i], buf, sizeof(buf));
-                send_line(c->sock, buf);
+        switch (cmd) {
+            case PROTO_STATUS: {
+                char buf[256];
+                ServerCore* core = client_core(c);
+                Elevator* elevators = server_core_elevators_of(core);
+                for (int i = 0; i < server_core_elevator_count_of(core); ++i) {
+                    Elevator_status_line(&elevators[i], buf, sizeof(buf));
+                    reply_line(c, buf);
+                }
+                snprintf(buf, sizeof(buf), "MODE %s", server_core_traffic_mode_of(core));
+                reply_line(c, buf);
+                break;
             }
-        } else if (platform_stricmp(cmd, "WATCH") == 0) {
-            c->watching = 1;
-            send_line(c->sock, "WATCH_OK");
-        } else if (platform_stricmp(cmd, "UNWATCH") == 0) {
-            c->watching = 0;
-            send_line(c->sock, "UNWATCH_OK");
-        } else if (platform_stricmp(cmd, "CALL") == 0) {
-            int from, to;
-            char dirstr[16] = {0};
-            if (sscanf(line, "CALL %d %d", &from, &to) == 2) {
-                if (from < 0 || from >= MAX_FLOORS || to < 0 || to >= MAX_FLOORS || from == to) {
-                    send_line(c->sock, "CALL_BAD");
+            case PROTO_WATCH:
+                c->watching = 1;
+                reply_line(c, "WATCH_OK");
+                break;
+            case PROTO_UNWATCH:
+                c->watching = 0;
+                reply_line(c, "UNWATCH_OK");
+                break;
+            case PROTO_CALL_FLOORS:
+                if (!hall_floor_ok(c, pc.a) || !floor_in_building(c, pc.b) || pc.a == pc.b) {
+                    reply_line(c, "CALL_BAD");
+                } else {
+                    int rc = push_destination(c, pc.a, pc.b);
+                    if (rc == 0) {
+                        CORE_LOG("[SERVER] Guard client %d queued CALL %d->%d\n", c->id, pc.a, pc.b);
+                    } else {
+                        reply_push_failed(c, "CALL", EVT_LANE_HALL, rc);
+                    }
+                }
+                break;
+            case PROTO_CALL_DIR:
+            case PROTO_CALL_BAD_DIR:
+                if (!hall_floor_ok(c, pc.a)) {
+                    reply_line(c, "CALL_BAD");
+                } else if (cmd == PROTO_CALL_BAD_DIR) {
+                    reply_line(c, "CALL_BAD usage: CALL <from> UP|DOWN");
                 } else {
-                    int dir = (to > from) ? DIR_UP : DIR_DOWN;
-                    if (server_events_push_outside(from, dir, c->id) == 0) {
-                        send_line(c->sock, "CALL_OK");
-                        printf("[SERVER] Guard client %d queued CALL %d->%d\n", c->id, from, to);
+                    int rc = push_call(c, pc.a, pc.b);
+                    if (rc == 0) {
+                        CORE_LOG("[SERVER] Guard directional CALL queued %d %s\n", pc.a, (pc.b == DIR_UP) ? "UP" : "DOWN");
                     } else {
-                        send_line(c->sock, "CALL_REJECT queue_full");
+                        reply_push_failed(c, "CALL", EVT_LANE_HALL, rc);
                     }
                 }
-            } else if (sscanf(line, "CALL %d %15s", &from, dirstr) == 2) {
-                if (from < 0 || from >= MAX_FLOORS) { send_line(c->sock, "CALL_BAD"); return; }
-                int dir;
-                if (platform_stricmp(dirstr, "UP") == 0) dir = DIR_UP;
-                else if (platform_stricmp(dirstr, "DOWN") == 0) dir = DIR_DOWN;
-                else { send_line(c->sock, "CALL_BAD usage: CALL <from> UP|DOWN"); return; }
-
-                if (server_events_push_outside(from, dir, c->id) == 0) {
-                    send_line(c->sock, "CALL_OK");
-                    printf("[SERVER] Guard directional CALL queued %d %s\n", from, dirstr);
+                break;
+            case PROTO_CALL_BAD:
+                reply_line(c, "CALL_BAD usage: CALL <from> <to>");
+                break;
+            case PROTO_ETA:
+            case PROTO_ETA_BAD:
+                reply_eta(c, cmd, &pc);
+                break;
+            // FORCE <電梯 ID> <樓層> => 警衛強制派車（走警衛通道，不會排在按鈕事件後面）
+            case PROTO_FORCE:
+                if (pc.a < 0 || pc.a >= server_core_elevator_count_of(client_core(c)) || !floor_in_building(c, pc.b)) {
+                    reply_line(c, "FORCE_BAD elevator or floor out of range");
+                } else if (event_queue_push_guard(server_core_events_of(client_core(c)), pc.a, pc.b, 1, c->id, NULL) == 0) {
+                    reply_line(c, "FORCE_OK");
+                    CORE_LOG("[SERVER] Guard client %d forced E%d to floor %d\n", c->id, pc.a, pc.b);
                 } else {
-                    send_line(c->sock, "CALL_REJECT queue_full");
+                    reply_line(c, "FORCE_REJECT");
                 }
-            } else {
-                send_line(c->sock, "CALL_BAD usage: CALL <from> <to>");
+                break;
+            case PROTO_FORCE_BAD:
+                reply_line(c, "FORCE_BAD usage: FORCE <elevator_id> <floor>");
+                break;
+            // CAR ADD | REMOVE [id] | OUT <id> | IN <id> => 車隊調整，結果由核心以 FLEET 通知所有警衛
+            case PROTO_CAR:
+                if (event_queue_push_fleet(server_core_events_of(client_core(c)), pc.a, pc.b, c->id) == 0) {
+                    reply_line(c, "CAR_OK");
+                    CORE_LOG("[SERVER] Guard client %d fleet op=%d E%d\n", c->id, pc.a, pc.b);
+                } else {
+                    reply_line(c, "CAR_REJECT");
+                }
+                break;
+            case PROTO_CAR_BAD:
+                reply_line(c, "CAR_BAD usage: CAR ADD | CAR REMOVE [id] | CAR OUT <id> | CAR IN <id>");
+                break;
+            case PROTO_SUBSCRIBE:
+                c->subscribed = 1;
+                reply_line(c, "SUBSCRIBE_OK");
+                break;
+            case PROTO_UNSUBSCRIBE:
+                c->subscribed = 0;
+                reply_line(c, "UNSUBSCRIBE_OK");
+                break;
+            default:
+                reply_line(c, "UNKNOWN_CMD (GUARD allowed: STATUS, WATCH, UNWATCH, CALL, ETA, FORCE, CAR, SUBSCRIBE, UNSUBSCRIBE)");
+                break;
+        }
+    }
+}
+
+/* ---------------------------
+   Hot upgrade (listening socket + client sockets + core state handoff)
+   --------------------------- */
+
+#define UPGRADE_MAGIC "EHUP"
+#define UPGRADE_VERSION 3  /* v2: 核心狀態帶著還在外呼通道裡的外呼（server_core_export_state）
+                              v3: 檔頭帶下一個請求 ID 與 client ID，接手後不重複發號 */
+#define UPGRADE_HDR_SIZE 24  /* magic | version | state_len | client_count | next_request_id | next_client_id */
+#define UPGRADE_CLIENT_HDR 20  /* type | floor | flags (watching | subscribed << 1) | id | inbuf_len */
+
+static const char* g_upgrade_path = NULL;
+static platform_socket_t g_upgrade_sock = INVALID_SOCKET;
+static platform_socket_t g_adopted_listen = INVALID_SOCKET;  /* 接手時取得的 listen socket */
+
+static void put_i32(unsigned char* p, int v) { memcpy(p, &v, sizeof(v)); }
+static int get_i32(const unsigned char* p) { int v; memcpy(&v, p, sizeof(v)); return v; }
+
+/* 開啟連線流量紀錄 */
+int remote_server_enable_trace(const char* path) {
+    if (g_trace) fclose(g_trace);
+    g_trace = fopen(path, "w");
+    if (!g_trace) return -1;
+    setvbuf(g_trace, NULL, _IOFBF, 1 << 16);
+    g_trace_t0 = platform_time_ms();
+    fprintf(g_trace, "# elevator trace v1: <ms> <client> <+|-|>|<> <line>\n");
+    return 0;
+}
+
+/* 設定熱升級用的 Unix socket 路徑 */
+void remote_server_enable_upgrade(const char* path) {
+    g_upgrade_path = path;
+}
+
+/* 舊行程：把核心狀態、listen socket 與所有 client socket 交給新行程 */
+static int handoff_to_new_process(platform_socket_t listen_sock) {
+    platform_socket_t ch = hot_upgrade_accept(g_upgrade_sock);
+    if (ch == INVALID_SOCKET) return -1;
+    long long t0 = platform_time_ms();
+
+    // 先釋放路徑讓新行程可以在交接後重新 listen
+    hot_upgrade_unlisten(g_upgrade_sock, g_upgrade_path);
+    g_upgrade_sock = INVALID_SOCKET;
+
+    // 停下核心（佇列中已接受的事件會在匯出時併入狀態）
+    server_core_pause();
+
+    int ok = 0;
+    unsigned char* buf = (unsigned char*)malloc(SERVER_CORE_HANDOFF_MAX + 16);
+    unsigned char* chunk = (unsigned char*)malloc(4 + HOT_UPGRADE_MAX_FDS * (UPGRADE_CLIENT_HDR + sizeof(clients[0].inbuf)));
+    int slen = buf ? server_core_export_state(buf + 16, SERVER_CORE_HANDOFF_MAX) : -1;
+
+    if (buf && chunk && slen > 0) {
+        // 1 檔頭 + listen socket
+        unsigned char hdr[UPGRADE_HDR_SIZE];
+        memcpy(hdr, UPGRADE_MAGIC, 4);
+        put_i32(hdr + 4, UPGRADE_VERSION);
+        put_i32(hdr + 8, slen);
+        put_i32(hdr + 12, client_count);
+        put_i32(hdr + 16, (int)g_next_request_id);
+        put_i32(hdr + 20, g_next_client_id);
+        ok = (hot_upgrade_send(ch, hdr, sizeof(hdr), &listen_sock, 1) == 0);
+
+        // 2 核心狀態
+        if (ok) ok = (hot_upgrade_send(ch, buf + 16, slen, NULL, 0) == 0);
+
+        // 3 client 資料，每則訊息最多 HOT_UPGRADE_MAX_FDS 個 socket
+        for (int base = 0; ok && base < client_count; base += HOT_UPGRADE_MAX_FDS) {
+            int n = client_count - base;
+            if (n > HOT_UPGRADE_MAX_FDS) n = HOT_UPGRADE_MAX_FDS;
+            platform_socket_t fds[HOT_UPGRADE_MAX_FDS];
+            unsigned char* p = chunk + 4;
+            put_i32(chunk, n);
+            for (int k = 0; k < n; ++k) {
+                ClientInfo* c = &clients[base + k];
+                fds[k] = c->sock;
+                put_i32(p, (int)c->type);
+                put_i32(p + 4, c->floor);
+                put_i32(p + 8, c->watching | (c->subscribed << 1));
+                put_i32(p + 12, c->id);
+                put_i32(p + 16, c->inbuf_len);
+                memcpy(p + UPGRADE_CLIENT_HDR, c->inbuf, (size_t)c->inbuf_len);
+                p += UPGRADE_CLIENT_HDR + c->inbuf_len;
             }
-        } else {
-            send_line(c->sock, "UNKNOWN_CMD (GUARD allowed: STATUS, WATCH, UNWATCH, CALL)");
+            ok = (hot_upgrade_send(ch, chunk, (int)(p - chunk), fds, n) == 0);
+        }
+
+        // 4 等新行程確認
+        if (ok) {
+            char ack[4];
+            ok = (hot_upgrade_recv(ch, ack, sizeof(ack), NULL, 0, NULL) == 2 && memcmp(ack, "OK", 2) == 0);
         }
     }
+    free(buf);
+    free(chunk);
+    platform_socket_close(ch);
+
+    if (!ok) {
+        // 交接失敗 => 繼續由本行程服務
+        printf("[SERVER] Upgrade handoff failed, resuming service\n");
+        server_core_start();
+        if (g_upgrade_path) g_upgrade_sock = hot_upgrade_listen(g_upgrade_path);
+        return -1;
+    }
+
+    printf("[SERVER] Upgrade handoff complete: %d clients in %lld ms\n", client_count, platform_time_ms() - t0);
+    server_core_mark_handed_off();
+    // 只關閉本行程持有的描述子，連線本身由新行程繼續使用
+    for (int i = 0; i < client_count; ++i) platform_socket_close(clients[i].sock);
+    client_count = 0;
+    return 0;
 }
 
-/* 伺服器主進入點 */
-void run_remote_server(int port) {
-    g_elevators = server_core_get_elevators();
-    g_elevator_count = server_core_get_elevator_count();
-    //server_core_set_status_callback(on_core_status);  // 狀態送給 WATCH 的警衛
-    g_last_broadcast_ms = GetTickCount(); // 初始化廣播時間
+/* 新行程：向舊行程取得核心狀態與所有 socket */
+int remote_server_takeover(const char* path) {
+    platform_socket_t ch = hot_upgrade_connect(path);
+    if (ch == INVALID_SOCKET) {
+        printf("[SERVER] takeover: cannot connect to %s\n", path);
+        return -1;
+    }
+    long long t0 = platform_time_ms();
 
-    if (platform_socket_init() != 0) {
-        printf("[SERVER] platform_socket_init failed: %d\n", platform_socket_last_error());
-        return;
+    int rc = -1;
+    size_t chunk_cap = 4 + HOT_UPGRADE_MAX_FDS * (UPGRADE_CLIENT_HDR + sizeof(clients[0].inbuf));
+    unsigned char* buf = (unsigned char*)malloc(chunk_cap > SERVER_CORE_HANDOFF_MAX ? chunk_cap : SERVER_CORE_HANDOFF_MAX);
+    platform_socket_t fds[HOT_UPGRADE_MAX_FDS];
+    int nfds = 0;
+
+    do {
+        if (!buf) break;
+
+        // 1 檔頭 + listen socket
+        unsigned char hdr[UPGRADE_HDR_SIZE];
+        if (hot_upgrade_recv(ch, hdr, sizeof(hdr), fds, 1, &nfds) != (int)sizeof(hdr) || nfds != 1) break;
+        g_adopted_listen = fds[0];
+        if (memcmp(hdr, UPGRADE_MAGIC, 4) != 0 || get_i32(hdr + 4) != UPGRADE_VERSION) break;
+        int slen = get_i32(hdr + 8);
+        int total = get_i32(hdr + 12);
+        if (total < 0 || total > MAX_CLIENTS) break;
+        // 接著舊行程的號碼發，已發出去的請求 ID（核心裡的訂閱）與 client ID 不會撞號
+        g_next_request_id = (unsigned)get_i32(hdr + 16);
+        if (g_next_request_id == 0) g_next_request_id = 1;
+        if (get_i32(hdr + 20) > g_next_client_id) g_next_client_id = get_i32(hdr + 20);
+
+        // 2 核心狀態
+        if (hot_upgrade_recv(ch, buf, SERVER_CORE_HANDOFF_MAX, NULL, 0, NULL) != slen) break;
+        if (server_core_import_state(buf, slen) != 0) break;
+
+        // 3 client 資料
+        client_count = 0;
+        int bad = 0;
+        while (!bad && client_count < total) {
+            int len = hot_upgrade_recv(ch, buf, (int)chunk_cap, fds, HOT_UPGRADE_MAX_FDS, &nfds);
+            int n = (len >= 4) ? get_i32(buf) : -1;
+            if (n <= 0 || n != nfds || client_count + n > total) {
+                for (int k = 0; k < nfds; ++k) platform_socket_close(fds[k]);
+                bad = 1;
+                break;
+            }
+            const unsigned char* p = buf + 4;
+            for (int k = 0; k < n; ++k) {
+                ClientInfo* c = &clients[client_count++];
+                c->sock = fds[k];
+                c->type = (ClientType)get_i32(p);
+                c->building = 0;  // 熱升級只支援單一大樓
+                c->floor = get_i32(p + 4);
+                c->watching = get_i32(p + 8) & 1;
+                c->subscribed = (get_i32(p + 8) >> 1) & 1;
+                c->id = get_i32(p + 12);
+                if (c->id >= g_next_client_id) g_next_client_id = c->id + 1;
+                c->tokens = ADMIT_BURST;
+                c->tokens_ms = platform_time_ms();
+                c->inbuf_len = get_i32(p + 16);
+                if (c->inbuf_len < 0 || c->inbuf_len >= (int)sizeof(c->inbuf)) c->inbuf_len = 0;
+                memcpy(c->inbuf, p + UPGRADE_CLIENT_HDR, (size_t)c->inbuf_len);
+                c->inbuf[c->inbuf_len] = '\0';
+                p += UPGRADE_CLIENT_HDR + c->inbuf_len;
+            }
+        }
+        if (bad) break;
+
+        // 4 確認，舊行程收到後即退出
+        if (hot_upgrade_send(ch, "OK", 2, NULL, 0) != 0) break;
+        rc = 0;
+    } while (0);
+
+    free(buf);
+    platform_socket_close(ch);
+
+    if (rc != 0) {
+        for (int i = 0; i < client_count; ++i) platform_socket_close(clients[i].sock);
+        client_count = 0;
+        if (g_adopted_listen != INVALID_SOCKET) platform_socket_close(g_adopted_listen);
+        g_adopted_listen = INVALID_SOCKET;
+        printf("[SERVER] takeover failed\n");
+        return -1;
     }
+    printf("[SERVER] takeover complete: %d clients, tick=%u (%lld ms)\n",
+           client_count, (unsigned)server_core_get_tick(), platform_time_ms() - t0);
+    return 0;
+}
 
+/* 建立 listen socket */
+static platform_socket_t open_listen_socket(int port) {
     platform_socket_t listen_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_sock == (platform_socket_t)-1
-    #ifdef _WIN32
-        || listen_sock == INVALID_SOCKET
-    #endif
-    ) {
+    if (listen_sock == INVALID_SOCKET) {
         printf("[SERVER] socket failed: %d\n", platform_socket_last_error());
-        platform_socket_cleanup();
-        return;
+        return INVALID_SOCKET;
     }
 
+#ifndef _WIN32
+    // 重啟後可立即重新綁定同一個 port
+    int yes = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+#endif
+
     struct sockaddr_in serv;
     memset(&serv, 0, sizeof(serv));
     serv.sin_family = AF_INET;  // IPv4
     serv.sin_addr.s_addr = htonl(INADDR_ANY);
-    serv.sin_port = htons((u_short)port);
+    serv.sin_port = htons((unsigned short)port);
 
     if (bind(listen_sock, (struct sockaddr*)&serv, sizeof(serv)) == SOCKET_ERROR) {
-        printf("[SERVER] bind failed: %d\n", WSAGetLastError());
-        closesocket(listen_sock);
-        WSACleanup();
-        return;
+        printf("[SERVER] bind failed: %d\n", platform_socket_last_error());
+        platform_socket_close(listen_sock);
+        return INVALID_SOCKET;
     }
     if (listen(listen_sock, LISTEN_BACKLOG) == SOCKET_ERROR) {
-        printf("[SERVER] listen failed: %d\n", WSAGetLastError());
-        closesocket(listen_sock);
-        WSACleanup();
+        printf("[SERVER] listen failed: %d\n", platform_socket_last_error());
+        platform_socket_close(listen_sock);
+        return INVALID_SOCKET;
+    }
+    return listen_sock;
+}
+
+/* 伺服器主進入點 */
+void run_remote_server(int port) {
+    g_elevators = server_core_get_elevators();
+    g_elevator_count = server_core_get_elevator_count();
+    g_last_broadcast_ms = platform_time_ms(); // 初始化廣播時間
+
+    if (platform_socket_init() != 0) {
+        printf("[SERVER] platform_socket_init failed: %d\n", platform_socket_last_error());
         return;
     }
 
+    // 熱升級接手 => 沿用舊行程的 listen socket
+    platform_socket_t listen_sock = g_adopted_listen;
+    if (listen_sock == INVALID_SOCKET) {
+        listen_sock = open_listen_socket(port);
+        if (listen_sock == INVALID_SOCKET) {
+            platform_socket_cleanup();
+            return;
+        }
+    }
+    g_adopted_listen = INVALID_SOCKET;
+
+    if (g_upgrade_path) {
+        g_upgrade_sock = hot_upgrade_listen(g_upgrade_path);
+        if (g_upgrade_sock == INVALID_SOCKET) {
+            printf("[SERVER] upgrade socket %s unavailable, hot upgrade disabled\n", g_upgrade_path);
+        }
+    }
+
     printf("[SERVER] Listening on port %d...\n", port);
 
-    while (1) {
-        fd_set readfds;                 // 要監聽的 socket 集合
-        FD_ZERO(&readfds);              // 清空
-        FD_SET(listen_sock, &readfds);  // 把監聽 socket 加入，監控是否有新連線
-        SOCKET maxfd = listen_sock;     // 最大 socket 值，供 select 使用
-        for (int i = 0; i < client_count; ++i) {
-            FD_SET(clients[i].sock, &readfds);
-            if (clients[i].sock > maxfd) maxfd = clients[i].sock;
+    int handed_off = 0;
+    while (!handed_off) {
+        // 要監聽的 socket：[0] listen、[1] 熱升級（可選）、其後依序為 clients
+        int npfd = 0;
+        g_pollfds[npfd].fd = listen_sock;  // 監控是否有新連線
+        g_pollfds[npfd].events = POLLIN;
+        g_pollfds[npfd].revents = 0;
+        npfd++;
+        int upgrade_idx = -1;
+        if (g_upgrade_sock != INVALID_SOCKET) {
+            upgrade_idx = npfd;  // 新版本行程要求接手
+            g_pollfds[npfd].fd = g_upgrade_sock;
+            g_pollfds[npfd].events = POLLIN;
+            g_pollfds[npfd].revents = 0;
+            npfd++;
+        }
+        const int client_base = npfd;
+        const int polled_clients = client_count;
+        for (int i = 0; i < polled_clients; ++i) {
+            g_pollfds[npfd].fd = clients[i].sock;
+            g_pollfds[npfd].events = POLLIN;
+            g_pollfds[npfd].revents = 0;
+            npfd++;
         }
 
         int wait_ms = SIM_TICK_MS;
 
-        struct timeval tv;  // select 沉睡需要使用 timeval 為單位
-        tv.tv_sec = wait_ms / 1000;
-        tv.tv_usec = (wait_ms % 1000) * 1000;
-
-        int ready = select((int)maxfd + 1, &readfds, NULL, NULL, &tv);
+        int ready = platform_poll(g_pollfds, npfd, wait_ms);
         if (ready == SOCKET_ERROR) {
-            printf("[SERVER] select failed: %d\n", WSAGetLastError());
+            printf("[SERVER] poll failed: %d\n", platform_socket_last_error());
             break;
         }
 
-        if (FD_ISSET(listen_sock, &readfds)) {  // 有新連線
+        if (upgrade_idx >= 0 && g_pollfds[upgrade_idx].revents) {
+            if (handoff_to_new_process(listen_sock) == 0) {
+                handed_off = 1;
+                continue;
+            }
+        }
+
+        if (g_pollfds[0].revents) {  // 有新連線
             accept_new_client(listen_sock);
         }
 
         /* handle client sockets */
-        for (int i = 0; i < client_count; ++i) {
-            if (FD_ISSET(clients[i].sock, &readfds)) {  // client[i] 有資料可讀
-                char buf[512];
-                int len = recv(clients[i].sock, buf, sizeof(buf)-1, 0);
-                if (len <= 0) {  // 出錯或失效的 => 移除
-                    remove_client(i);
-                    i--;
-                    continue;
-                }
-                buf[len] = '\0';
-                // 把收到的字串附加到 clients[i].inbuf 上
-                if (clients[i].inbuf_len + len < (int)sizeof(clients[i].inbuf) - 1) {
-                    memcpy(clients[i].inbuf + clients[i].inbuf_len, buf, len);
-                    clients[i].inbuf_len += len;
-                    clients[i].inbuf[clients[i].inbuf_len] = '\0';
-                } else {
-                    /* overflow: reset buffer */
-                    clients[i].inbuf_len = 0;
-                    clients[i].inbuf[0] = '\0';
-                }
-                /* process full lines */
-                char* start = clients[i].inbuf;  // 指向尚未處理的起點
-                char* eol;                       // 指向指令結尾
-                while ((eol = strstr(start, "\r\n")) != NULL || (eol = strchr(start, '\n')) != NULL) {  // 找指令結尾
-                    size_t linelen = eol - start;
-                    char line[512];  // 用於儲存指令
-                    if (linelen >= sizeof(line)) linelen = sizeof(line)-1;
-                    memcpy(line, start, linelen);
-                    line[linelen] = '\0';
-                    handle_client_command(i, line);
-                    // 處理完 => 起點指標移動至 "\r\n" 或 '\n' 後面 => 下個 while 繼續處理
-                    if (*eol == '\r' && *(eol+1) == '\n') start = eol + 2;
-                    else start = eol + 1;
-                }
-                // while 處理完 => 將後面殘留的移到前面 => 繼續拼接
-                int rem = strlen(start);
-                memmove(clients[i].inbuf, start, rem);
-                clients[i].inbuf_len = rem;
-                clients[i].inbuf[rem] = '\0';
+        // remove_client 會把後面的 client 往前補，用 removed 換算目前索引
+        int removed = 0;
+        for (int k = 0; k < polled_clients; ++k) {
+            if (!g_pollfds[client_base + k].revents) continue;
+            int i = k - removed;  // client[i] 有資料可讀（或已斷線）
+            char buf[512];
+            int len = recv(clients[i].sock, buf, sizeof(buf)-1, 0);
+            if (len <= 0) {  // 出錯或失效的 => 移除
+                remove_client(i);
+                removed++;
+                continue;
+            }
+            buf[len] = '\0';
+            // 把收到的字串附加到 clients[i].inbuf 上
+            size_t used = (size_t)clients[i].inbuf_len;  // 以無號數比較，memcpy 的位移必落在 inbuf 內
+            if (used + (size_t)len < sizeof(clients[i].inbuf) - 1) {
+                memcpy(clients[i].inbuf + used, buf, (size_t)len);
+                clients[i].inbuf_len += len;
+                clients[i].inbuf[clients[i].inbuf_len] = '\0';
+            } else {
+                /* overflow: reset buffer */
+                clients[i].inbuf_len = 0;
+                clients[i].inbuf[0] = '\0';
             }
+            /* process full lines */
+            char* start = clients[i].inbuf;  // 指向尚未處理的起點
+            char* eol;                       // 指向指令結尾
+            while ((eol = strstr(start, "\r\n")) != NULL || (eol = strchr(start, '\n')) != NULL) {  // 找指令結尾
+                size_t linelen = eol - start;
+                char line[512];  // 用於儲存指令
+                if (linelen >= sizeof(line)) linelen = sizeof(line)-1;
+                memcpy(line, start, linelen);
+                line[linelen] = '\0';
+                handle_client_command(i, line);
+                // 處理完 => 起點指標移動至 "\r\n" 或 '\n' 後面 => 下個 while 繼續處理
+                if (*eol == '\r' && *(eol+1) == '\n') start = eol + 2;
+                else start = eol + 1;
+            }
+            // while 處理完 => 將後面殘留的移到前面 => 繼續拼接
+            int rem = strlen(start);
+            memmove(clients[i].inbuf, start, rem);
+            clients[i].inbuf_len = rem;
+            clients[i].inbuf[rem] = '\0';
         }
 
+        // 核心的告警（外呼等待超過 SLO 等）
+        deliver_core_notices();
+
         // 定時廣播給 WATCH 的 GUARD
-        DWORD now = GetTickCount();
+        long long now = platform_time_ms();
+        sample_drain_rate(now);
         if (now - g_last_broadcast_ms >= SIM_TICK_MS) {
-            // 檢查有沒有 watcher，沒人看就不廣播
-            int has_watcher = 0;
-            for (int i = 0; i < client_count; ++i) {
-                if (clients[i].type == CLIENT_GUARD && clients[i].watching) {
-                    has_watcher = 1;
-                    break;
-                }
-            }
-
-            if (has_watcher && g_elevators && g_elevator_count > 0) {
-                broadcast_status_to_guards(g_elevators, g_elevator_count, 1);
-            }
+            broadcast_campus_status();
 
             g_last_broadcast_ms = now;
+            if (g_trace) fflush(g_trace);
         }
     }
 
-    closesocket(listen_sock);
-    WSACleanup();
+    if (g_upgrade_sock != INVALID_SOCKET) {
+        hot_upgrade_unlisten(g_upgrade_sock, g_upgrade_path);
+        g_upgrade_sock = INVALID_SOCKET;
+    }
+    platform_socket_close(listen_sock);
+    platform_socket_cleanup();
+    if (g_trace) {
+        fclose(g_trace);
+        g_trace = NULL;
+    }
 }
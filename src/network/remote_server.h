@@ -3,8 +3,8 @@
 // Do not distribute or modify
 // Author: DragonTaki (https://github.com/DragonTaki)
 // Create Date: 2025/11/22
-// Update Date: 2025/11/29
-// Version: v1.1
+// Update Date: 2026/10/18
+// Version: v1.2
 /* ----- ----- ----- ----- */
 
 #ifndef REMOTE_SERVER_H
@@ -26,6 +26,29 @@ extern "C" {
 
 void run_remote_server(int port);
 
+/* Zero-downtime upgrade (POSIX only).
+ *
+ * remote_server_enable_upgrade: make run_remote_server listen on a Unix
+ * domain socket at `path`. When a replacing process connects there, the
+ * core is paused, its state, the listening socket and every client socket
+ * are handed over, and run_remote_server returns.
+ *
+ * remote_server_takeover: run in the replacing process after
+ * server_core_init and before server_core_start / run_remote_server.
+ * Imports the core state and adopts all sockets from the process listening
+ * on `path`. Returns 0 on success, -1 on error.
+ */
+void remote_server_enable_upgrade(const char* path);
+int remote_server_takeover(const char* path);
+
+/* Capture client traffic seen by the server into a text trace, one line per
+ * event: "<ms> <client id> <kind> <text>" where kind is '+' (connected),
+ * '-' (disconnected), '>' (command received) or '<' (reply sent). Periodic
+ * WATCH broadcasts are not recorded. Call before run_remote_server.
+ * Returns 0 on success, -1 if the file cannot be created.
+ */
+int remote_server_enable_trace(const char* path);
+
 #ifdef __cplusplus
 }
 #endif